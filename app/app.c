@@ -69,6 +69,7 @@
 #include "errors.h"
 #include "sanity.h"
 #include "gimp-debug.h"
+#include "gimp-log.h"
 
 #include "gimp-intl.h"
 #include "gimp-update.h"
@@ -79,6 +80,9 @@
 static void       app_init_update_noop       (const gchar        *text1,
                                               const gchar        *text2,
                                               gdouble             percentage);
+static void       app_init_update_trace      (const gchar        *text1,
+                                              const gchar        *text2,
+                                              gdouble             percentage);
 static void       app_restore_after_callback (Gimp               *gimp,
                                               GimpInitStatusFunc  status_callback);
 static gboolean   app_exit_after_callback    (Gimp               *gimp,
@@ -93,7 +97,8 @@ GType gimp_convert_dither_type_compat_get_type (void); /* compat cruft */
 
 /*  local variables  */
 
-static GObject *initial_monitor = NULL;
+static GObject            *initial_monitor    = NULL;
+static GimpInitStatusFunc  trace_status_func  = NULL;
 
 
 /*  public functions  */
@@ -217,6 +222,10 @@ app_run (const gchar         *full_prog_name,
   /*  Create an instance of the "Gimp" object which is the root of the
    *  core object system
    */
+  gimp_log_trace_begin ("Startup");
+
+  gimp_log_trace_begin ("Core");
+
   gimp = gimp_new (full_prog_name,
                    session_name,
                    default_folder,
@@ -261,8 +270,14 @@ app_run (const gchar         *full_prog_name,
 
   g_object_unref (gimpdir);
 
+  gimp_log_trace_end ("Core");
+
+  gimp_log_trace_begin ("Configuration");
+
   gimp_load_config (gimp, alternate_system_gimprc, alternate_gimprc);
 
+  gimp_log_trace_end ("Configuration");
+
   /* Initialize the error handling after creating/migrating the config
    * directory because it will create some folders for backup and crash
    * logs in advance. Therefore running this before
@@ -284,8 +299,12 @@ app_run (const gchar         *full_prog_name,
     app_abort (no_interface, abort_message);
 
   /*  initialize lowlevel stuff  */
+  gimp_log_trace_begin ("GEGL");
+
   gimp_gegl_init (gimp);
 
+  gimp_log_trace_end ("GEGL");
+
   /*  Connect our restore_after callback before gui_init() connects
    *  theirs, so ours runs first and can grab the initial monitor
    *  before the GUI's restore_after callback resets it.
@@ -296,21 +315,39 @@ app_run (const gchar         *full_prog_name,
 
 #ifndef GIMP_CONSOLE_COMPILATION
   if (! no_interface)
-    update_status_func = gui_init (gimp, no_splash, NULL);
+    {
+      gimp_log_trace_begin ("GUI");
+
+      update_status_func = gui_init (gimp, no_splash, NULL);
+
+      gimp_log_trace_end ("GUI");
+    }
 #endif
 
   if (! update_status_func)
     update_status_func = app_init_update_noop;
 
+  /*  turn the status messages into phases of the startup trace  */
+  trace_status_func  = update_status_func;
+  update_status_func = app_init_update_trace;
+
   /*  Create all members of the global Gimp instance which need an already
    *  parsed gimprc, e.g. the data factories
    */
+  gimp_log_trace_begin ("Initialize");
+
   gimp_initialize (gimp, update_status_func);
 
+  gimp_log_trace_end ("Initialize");
+
   /*  Load all data files
    */
+  gimp_log_trace_begin ("Restore");
+
   gimp_restore (gimp, update_status_func, &font_error);
 
+  gimp_log_trace_end ("Restore");
+
   /*  enable autosave late so we don't autosave when the
    *  monitor resolution is set in gui_init()
    */
@@ -388,6 +425,8 @@ app_run (const gchar         *full_prog_name,
     {
       gint i;
 
+      gimp_log_trace_begin ("Open images");
+
       for (i = 0; filenames[i] != NULL; i++)
         {
           if (run_loop)
@@ -400,6 +439,8 @@ app_run (const gchar         *full_prog_name,
               g_object_unref (file);
             }
         }
+
+      gimp_log_trace_end ("Open images");
     }
 
   /* The software is now fully loaded and ready to be used and get
@@ -407,6 +448,9 @@ app_run (const gchar         *full_prog_name,
    */
   gimp->initialized = TRUE;
 
+  gimp_log_trace_end ("Startup");
+  gimp_log_trace_mark ("Startup complete");
+
   if (font_error)
     {
       gimp_message_literal (gimp, NULL,
@@ -426,6 +470,8 @@ app_run (const gchar         *full_prog_name,
 
   g_main_loop_unref (loop);
 
+  gimp_log_trace_finish ();
+
   gimp_gegl_exit (gimp);
 
   errors_exit ();
@@ -448,6 +494,16 @@ app_init_update_noop (const gchar *text1,
   /*  deliberately do nothing  */
 }
 
+static void
+app_init_update_trace (const gchar *text1,
+                       const gchar *text2,
+                       gdouble      percentage)
+{
+  gimp_log_trace_status (text1, text2);
+
+  trace_status_func (text1, text2, percentage);
+}
+
 static void
 app_restore_after_callback (Gimp               *gimp,
                             GimpInitStatusFunc  status_callback)
@@ -488,6 +544,8 @@ app_exit_after_callback (Gimp       *gimp,
 
 #else
 
+  gimp_log_trace_finish ();
+
   gimp_gegl_exit (gimp);
 
   gegl_exit ();
@@ -109,6 +109,7 @@ enum
   PROP_UNDO_PREVIEW_SIZE,
   PROP_FILTER_HISTORY_SIZE,
   PROP_PLUGINRC_PATH,
+  PROP_PLUG_IN_WORKERS,
   PROP_LAYER_PREVIEWS,
   PROP_GROUP_LAYER_PREVIEWS,
   PROP_LAYER_PREVIEW_SIZE,
@@ -642,6 +643,13 @@ gimp_core_config_class_init (GimpCoreConfigClass *klass)
                          GIMP_PARAM_STATIC_STRINGS |
                          GIMP_CONFIG_PARAM_RESTART);
 
+  GIMP_CONFIG_PROP_INT (object_class, PROP_PLUG_IN_WORKERS,
+                        "plug-in-workers",
+                        "Plug-in workers",
+                        PLUG_IN_WORKERS_BLURB,
+                        0, 64, 0,
+                        GIMP_PARAM_STATIC_STRINGS);
+
   GIMP_CONFIG_PROP_BOOLEAN (object_class, PROP_LAYER_PREVIEWS,
                             "layer-previews",
                             "Layer previews",
@@ -1117,6 +1125,9 @@ gimp_core_config_set_property (GObject      *object,
       g_free (core_config->plug_in_rc_path);
       core_config->plug_in_rc_path = g_value_dup_string (value);
       break;
+    case PROP_PLUG_IN_WORKERS:
+      core_config->plug_in_workers = g_value_get_int (value);
+      break;
     case PROP_LAYER_PREVIEWS:
       core_config->layer_previews = g_value_get_boolean (value);
       break;
@@ -1381,6 +1392,9 @@ gimp_core_config_get_property (GObject    *object,
     case PROP_PLUGINRC_PATH:
       g_value_set_string (value, core_config->plug_in_rc_path);
       break;
+    case PROP_PLUG_IN_WORKERS:
+      g_value_set_int (value, core_config->plug_in_workers);
+      break;
     case PROP_LAYER_PREVIEWS:
       g_value_set_boolean (value, core_config->layer_previews);
       break;
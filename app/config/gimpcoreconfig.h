@@ -84,6 +84,7 @@ struct _GimpCoreConfig
   GimpViewSize            undo_preview_size;
   gint                    filter_history_size;
   gchar                  *plug_in_rc_path;
+  gint                    plug_in_workers;
   gboolean                layer_previews;
   gboolean                group_layer_previews;
   GimpViewSize            layer_preview_size;
@@ -344,6 +344,10 @@ _("Sets how many threads GIMP should use for operations that support it.")
 #define PLUGINRC_PATH_BLURB \
 "Sets the pluginrc search path."
 
+#define PLUG_IN_WORKERS_BLURB \
+"How many idle plug-in processes to keep around for reuse by " \
+"non-interactive procedure calls.  Zero disables plug-in workers."
+
 #define LAYER_PREVIEWS_BLURB \
 _("Sets whether GIMP should create previews of layers and channels. " \
   "Previews in the layers and channels dialog are nice to have but they " \
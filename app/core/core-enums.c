@@ -1091,6 +1091,7 @@ gimp_undo_event_get_type (void)
     { GIMP_UNDO_EVENT_UNDO_FREE, "GIMP_UNDO_EVENT_UNDO_FREE", "undo-free" },
     { GIMP_UNDO_EVENT_UNDO_FREEZE, "GIMP_UNDO_EVENT_UNDO_FREEZE", "undo-freeze" },
     { GIMP_UNDO_EVENT_UNDO_THAW, "GIMP_UNDO_EVENT_UNDO_THAW", "undo-thaw" },
+    { GIMP_UNDO_EVENT_UNDO_SPILLED, "GIMP_UNDO_EVENT_UNDO_SPILLED", "undo-spilled" },
     { 0, NULL, NULL }
   };
 
@@ -1104,6 +1105,7 @@ gimp_undo_event_get_type (void)
     { GIMP_UNDO_EVENT_UNDO_FREE, "GIMP_UNDO_EVENT_UNDO_FREE", NULL },
     { GIMP_UNDO_EVENT_UNDO_FREEZE, "GIMP_UNDO_EVENT_UNDO_FREEZE", NULL },
     { GIMP_UNDO_EVENT_UNDO_THAW, "GIMP_UNDO_EVENT_UNDO_THAW", NULL },
+    { GIMP_UNDO_EVENT_UNDO_SPILLED, "GIMP_UNDO_EVENT_UNDO_SPILLED", NULL },
     { 0, NULL, NULL }
   };
 
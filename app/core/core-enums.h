@@ -494,7 +494,8 @@ typedef enum  /*< pdb-skip >*/
   GIMP_UNDO_EVENT_REDO,         /* a redo has been executed                    */
   GIMP_UNDO_EVENT_UNDO_FREE,    /* all undo and redo info has been cleared     */
   GIMP_UNDO_EVENT_UNDO_FREEZE,  /* undo has been frozen                        */
-  GIMP_UNDO_EVENT_UNDO_THAW     /* undo has been thawn                         */
+  GIMP_UNDO_EVENT_UNDO_THAW,    /* undo has been thawn                         */
+  GIMP_UNDO_EVENT_UNDO_SPILLED  /* an undo has been spilled to disk            */
 } GimpUndoEvent;
 
 
@@ -47,6 +47,7 @@
 #include "gimpmybrush.h"
 #include "gimppalette-load.h"
 #include "gimppalette.h"
+#include "gimppattern-index.h"
 #include "gimppattern-load.h"
 #include "gimppattern.h"
 #include "gimppatternclipboard.h"
@@ -104,6 +105,7 @@ gimp_data_factories_init (Gimp *gimp)
                                        gimp_brush_pipe_load,
                                        GIMP_BRUSH_PIPE_FILE_EXTENSION,
                                        TRUE);
+  gimp_data_loader_factory_set_parallel (gimp->brush_factory, TRUE);
 
   gimp->dynamics_factory =
     gimp_data_loader_factory_new (gimp,
@@ -136,6 +138,7 @@ gimp_data_factories_init (Gimp *gimp)
                                        gimp_mybrush_load,
                                        GIMP_MYBRUSH_FILE_EXTENSION,
                                        FALSE);
+  gimp_data_loader_factory_set_parallel (gimp->mybrush_factory, TRUE);
 
   gimp->pattern_factory =
     gimp_data_loader_factory_new (gimp,
@@ -155,6 +158,11 @@ gimp_data_factories_init (Gimp *gimp)
   gimp_data_loader_factory_add_fallback (gimp->pattern_factory,
                                          "Pattern from GdkPixbuf",
                                          gimp_pattern_load_pixbuf);
+  gimp_data_loader_factory_set_parallel (gimp->pattern_factory, TRUE);
+  gimp_data_loader_factory_set_index (gimp->pattern_factory,
+                                      "pattern-index",
+                                      gimp_pattern_index_load,
+                                      gimp_pattern_index_save);
 
   gimp->gradient_factory =
     gimp_data_loader_factory_new (gimp,
@@ -176,6 +184,7 @@ gimp_data_factories_init (Gimp *gimp)
                                        gimp_gradient_load_svg,
                                        GIMP_GRADIENT_SVG_FILE_EXTENSION,
                                        FALSE);
+  gimp_data_loader_factory_set_parallel (gimp->gradient_factory, TRUE);
 
   gimp->palette_factory =
     gimp_data_loader_factory_new (gimp,
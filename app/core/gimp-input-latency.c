@@ -0,0 +1,195 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-input-latency.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#include <glib/gstdio.h>
+#include <gegl.h>
+
+#include "libgimpmath/gimpmath.h"
+
+#include "core-types.h"
+
+#include "gimp-input-latency.h"
+
+
+/* the histogram has one bin per millisecond, the last bin collecting all
+ * longer latencies.  once it holds MAX_SAMPLES samples, all bins are
+ * halved, so that the statistics follow recent input.
+ */
+#define N_BINS         256
+#define MAX_SAMPLES    4096
+#define SMOOTH_FACTOR  0.1
+
+
+/*  local variables  */
+
+G_LOCK_DEFINE_STATIC (input_latency);
+
+static guint     input_latency_histogram[N_BINS];
+static guint     input_latency_n_samples = 0;
+static gdouble   input_latency_average   = 0.0;
+
+static FILE     *input_latency_log       = NULL;
+static gboolean  input_latency_log_init  = FALSE;
+
+
+/*  public functions  */
+
+/* closes the latency log, if one was opened.  called when GIMP exits.
+ */
+void
+gimp_input_latency_exit (void)
+{
+  if (input_latency_log)
+    {
+      fclose (input_latency_log);
+      input_latency_log = NULL;
+    }
+}
+
+/* records the latency, in microseconds, between the arrival of an input
+ * event, and the first frame drawn after the event was handled.
+ *
+ * if the GIMP_INPUT_LATENCY_LOG environment variable is set, each
+ * latency is also appended, as CSV, to the file it names.  the file is
+ * buffered, and flushed when gimp_input_latency_exit() closes it.
+ *
+ * may only be called on the main thread.
+ */
+void
+gimp_input_latency_record (gint64 latency)
+{
+  gint bin;
+
+  g_return_if_fail (latency >= 0);
+
+  if (! input_latency_log_init)
+    {
+      const gchar *filename = g_getenv ("GIMP_INPUT_LATENCY_LOG");
+
+      input_latency_log_init = TRUE;
+
+      if (filename)
+        {
+          input_latency_log = g_fopen (filename, "w");
+
+          if (input_latency_log)
+            fprintf (input_latency_log, "time,latency\n");
+          else
+            g_printerr ("Failed to open input latency log '%s'\n", filename);
+        }
+    }
+
+  if (input_latency_log)
+    {
+      fprintf (input_latency_log,
+               "%" G_GINT64_FORMAT ",%" G_GINT64_FORMAT "\n",
+               g_get_monotonic_time (), latency);
+    }
+
+  bin = MIN (latency / 1000, N_BINS - 1);
+
+  G_LOCK (input_latency);
+
+  if (input_latency_n_samples == MAX_SAMPLES)
+    {
+      gint i;
+
+      input_latency_n_samples = 0;
+
+      for (i = 0; i < N_BINS; i++)
+        {
+          input_latency_histogram[i] /= 2;
+
+          input_latency_n_samples += input_latency_histogram[i];
+        }
+    }
+
+  input_latency_histogram[bin]++;
+  input_latency_n_samples++;
+
+  if (input_latency_n_samples == 1)
+    {
+      input_latency_average = latency / 1000000.0;
+    }
+  else
+    {
+      input_latency_average = input_latency_average * (1.0 - SMOOTH_FACTOR) +
+                              latency / 1000000.0   * SMOOTH_FACTOR;
+    }
+
+  G_UNLOCK (input_latency);
+}
+
+/* returns the smoothed recent input latency, in seconds */
+gdouble
+gimp_input_latency_get_average (void)
+{
+  gdouble average;
+
+  G_LOCK (input_latency);
+
+  average = input_latency_average;
+
+  G_UNLOCK (input_latency);
+
+  return average;
+}
+
+/* returns the input latency, in seconds, below which 'percentile' of the
+ * recorded latencies fall.
+ */
+gdouble
+gimp_input_latency_get_percentile (gdouble percentile)
+{
+  guint   target;
+  guint   count  = 0;
+  gdouble result = 0.0;
+  gint    i;
+
+  G_LOCK (input_latency);
+
+  target = ceil (CLAMP (percentile, 0.0, 1.0) * input_latency_n_samples);
+
+  if (input_latency_n_samples > 0)
+    {
+      for (i = 0; i < N_BINS; i++)
+        {
+          count += input_latency_histogram[i];
+
+          if (count >= MAX (target, 1))
+            break;
+        }
+
+      result = (MIN (i, N_BINS - 1) + 1) / 1000.0;
+    }
+
+  G_UNLOCK (input_latency);
+
+  return result;
+}
+
+gdouble
+gimp_input_latency_get_95th_percentile (void)
+{
+  return gimp_input_latency_get_percentile (0.95);
+}
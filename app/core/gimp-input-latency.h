@@ -0,0 +1,33 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimp-input-latency.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_INPUT_LATENCY_H__
+#define __GIMP_INPUT_LATENCY_H__
+
+
+void      gimp_input_latency_exit                (void);
+
+void      gimp_input_latency_record              (gint64   latency);
+
+gdouble   gimp_input_latency_get_average         (void);
+gdouble   gimp_input_latency_get_percentile      (gdouble  percentile);
+gdouble   gimp_input_latency_get_95th_percentile (void);
+
+
+#endif  /*  __GIMP_INPUT_LATENCY_H__  */
@@ -48,6 +48,7 @@
 #include "gimp-contexts.h"
 #include "gimp-data-factories.h"
 #include "gimp-filter-history.h"
+#include "gimp-input-latency.h"
 #include "gimp-memsize.h"
 #include "gimp-modules.h"
 #include "gimp-parasites.h"
@@ -585,6 +586,8 @@ gimp_real_exit (Gimp     *gimp,
   gimp_parasiterc_save (gimp);
   gimp_unitrc_save (gimp);
 
+  gimp_input_latency_exit ();
+
   return FALSE; /* continue exiting */
 }
 
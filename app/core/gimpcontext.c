@@ -2946,6 +2946,9 @@ gimp_context_real_set_pattern (GimpContext *context,
 
       if (pattern != GIMP_PATTERN (gimp_pattern_get_standard (context)))
         context->pattern_name = g_strdup (gimp_object_get_name (pattern));
+
+      /*  the pattern is likely to be used soon  */
+      gimp_pattern_prefetch (pattern);
     }
 
   g_object_notify (G_OBJECT (context), "pattern");
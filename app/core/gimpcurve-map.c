@@ -185,6 +185,132 @@ gimp_curve_map_pixels (GimpCurve *curve_colors,
     }
 }
 
+/**
+ * gimp_curve_map_fill_lut:
+ * @curve_colors: the value curve
+ * @curve_red:    the red curve
+ * @curve_green:  the green curve
+ * @curve_blue:   the blue curve
+ * @curve_alpha:  the alpha curve
+ * @n_entries:    256 for an 8-bit table, 65536 for a 16-bit table
+ * @lut:          4 * @n_entries guint8 or guint16 entries
+ *
+ * Bakes the curves into a lookup table, which can be applied to
+ * integer pixels using gimp_curve_map_pixels_lut(). Each channel's
+ * table is the composition of the value curve and the channel curve,
+ * the same way gimp_curve_map_pixels() applies them.
+ **/
+void
+gimp_curve_map_fill_lut (GimpCurve *curve_colors,
+                         GimpCurve *curve_red,
+                         GimpCurve *curve_green,
+                         GimpCurve *curve_blue,
+                         GimpCurve *curve_alpha,
+                         gint       n_entries,
+                         gpointer   lut)
+{
+  GimpCurve *curves[3] = { curve_red, curve_green, curve_blue };
+  gdouble    max       = n_entries - 1;
+  gint       c;
+  gint       i;
+
+  g_return_if_fail (GIMP_IS_CURVE (curve_colors));
+  g_return_if_fail (GIMP_IS_CURVE (curve_red));
+  g_return_if_fail (GIMP_IS_CURVE (curve_green));
+  g_return_if_fail (GIMP_IS_CURVE (curve_blue));
+  g_return_if_fail (GIMP_IS_CURVE (curve_alpha));
+  g_return_if_fail (n_entries == 256 || n_entries == 65536);
+  g_return_if_fail (lut != NULL);
+
+  for (c = 0; c < 4; c++)
+    {
+      for (i = 0; i < n_entries; i++)
+        {
+          gdouble value = i / max;
+
+          if (c < 3)
+            {
+              value = gimp_curve_map_value_inline (curves[c], value);
+              value = gimp_curve_map_value_inline (curve_colors, value);
+            }
+          else
+            {
+              /* don't apply the colors curve to the alpha channel */
+              value = gimp_curve_map_value_inline (curve_alpha, value);
+            }
+
+          value = CLAMP (value, 0.0, 1.0) * max + 0.5;
+
+          if (n_entries == 256)
+            ((guint8 *) lut)[c * n_entries + i] = value;
+          else
+            ((guint16 *) lut)[c * n_entries + i] = value;
+        }
+    }
+}
+
+/**
+ * gimp_curve_map_pixels_lut:
+ * @lut:       a lookup table filled by gimp_curve_map_fill_lut()
+ * @n_entries: the number of entries per channel of @lut
+ * @src:       RGBA pixels, u8 if @n_entries is 256, u16 otherwise
+ * @dest:      RGBA pixels of the same type as @src
+ * @samples:   the number of pixels
+ *
+ * Maps integer pixels through a baked lookup table.
+ **/
+void
+gimp_curve_map_pixels_lut (gconstpointer  lut,
+                           gint           n_entries,
+                           gconstpointer  src,
+                           gpointer       dest,
+                           glong          samples)
+{
+  g_return_if_fail (lut != NULL);
+  g_return_if_fail (n_entries == 256 || n_entries == 65536);
+
+  if (n_entries == 256)
+    {
+      const guint8 *lut_r = (const guint8 *) lut;
+      const guint8 *lut_g = lut_r + 256;
+      const guint8 *lut_b = lut_g + 256;
+      const guint8 *lut_a = lut_b + 256;
+      const guint8 *s     = src;
+      guint8       *d     = dest;
+
+      while (samples--)
+        {
+          d[0] = lut_r[s[0]];
+          d[1] = lut_g[s[1]];
+          d[2] = lut_b[s[2]];
+          d[3] = lut_a[s[3]];
+
+          s += 4;
+          d += 4;
+        }
+    }
+  else
+    {
+      const guint16 *lut_r = (const guint16 *) lut;
+      const guint16 *lut_g = lut_r + 65536;
+      const guint16 *lut_b = lut_g + 65536;
+      const guint16 *lut_a = lut_b + 65536;
+      const guint16 *s     = src;
+      guint16       *d     = dest;
+
+      while (samples--)
+        {
+          d[0] = lut_r[s[0]];
+          d[1] = lut_g[s[1]];
+          d[2] = lut_b[s[2]];
+          d[3] = lut_a[s[3]];
+
+          s += 4;
+          d += 4;
+        }
+    }
+}
+
 static guint
 gimp_curve_get_apply_mask (GimpCurve *curve_colors,
                            GimpCurve *curve_red,
@@ -30,5 +30,18 @@ void            gimp_curve_map_pixels        (GimpCurve     *curve_colors,
                                               gfloat        *dest,
                                               glong          samples);
 
+void            gimp_curve_map_fill_lut      (GimpCurve     *curve_colors,
+                                              GimpCurve     *curve_red,
+                                              GimpCurve     *curve_green,
+                                              GimpCurve     *curve_blue,
+                                              GimpCurve     *curve_alpha,
+                                              gint           n_entries,
+                                              gpointer       lut);
+void            gimp_curve_map_pixels_lut    (gconstpointer  lut,
+                                              gint           n_entries,
+                                              gconstpointer  src,
+                                              gpointer       dest,
+                                              glong          samples);
+
 
 #endif /* __GIMP_CURVE_MAP_H__ */
@@ -20,6 +20,7 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <string.h>
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
@@ -43,8 +44,20 @@
  */
 #define GIMP_OBSOLETE_DATA_DIR_NAME "gimp-obsolete-files"
 
+/* The minimal number of files each thread decodes when loading in
+ * parallel
+ */
+#define GIMP_DATA_LOADER_FACTORY_FILES_PER_THREAD 4
+
+/* The data index maps each file's URI to its mtime and to an entry
+ * created by the factory's GimpDataIndexSaveFunc
+ */
+#define GIMP_DATA_INDEX_VERSION 1
+#define GIMP_DATA_INDEX_TYPE    "(ua{s(tv)})"
 
-typedef struct _GimpDataLoader GimpDataLoader;
+
+typedef struct _GimpDataLoader  GimpDataLoader;
+typedef struct _GimpDataLoadJob GimpDataLoadJob;
 
 struct _GimpDataLoader
 {
@@ -54,11 +67,40 @@ struct _GimpDataLoader
   gboolean          writable;
 };
 
+struct _GimpDataLoadJob
+{
+  GimpDataLoader *loader;
+  GFile          *file;
+  GFile          *top_directory;
+  guint64         mtime;
+  gboolean        dir_writable;
+  gboolean        cached;
+  gboolean        indexed;
+  GVariant       *entry;
+
+  GList          *data_list;
+  GError         *error;
+};
+
+typedef struct
+{
+  GimpContext     *context;
+  GimpDataLoadJob *jobs;
+} GimpDataLoadParallelData;
+
 
 struct _GimpDataLoaderFactoryPrivate
 {
-  GList          *loaders;
-  GimpDataLoader *fallback;
+  GList                 *loaders;
+  GimpDataLoader        *fallback;
+  gboolean               parallel;
+
+  gchar                 *index_name;
+  GimpDataIndexLoadFunc  index_load_func;
+  GimpDataIndexSaveFunc  index_save_func;
+
+  /*  the index read from disk, only while loading  */
+  GHashTable            *index;
 };
 
 #define GET_PRIVATE(obj) (((GimpDataLoaderFactory *) (obj))->priv)
@@ -79,18 +121,33 @@ static void   gimp_data_loader_factory_load           (GimpDataFactory *factory,
                                                        GimpContext     *context,
                                                        GHashTable      *cache);
 static void   gimp_data_loader_factory_load_directory (GimpDataFactory *factory,
-                                                       GimpContext     *context,
                                                        GHashTable      *cache,
+                                                       GArray          *jobs,
                                                        gboolean         dir_writable,
                                                        GFile           *directory,
                                                        GFile           *top_directory);
-static void   gimp_data_loader_factory_load_data      (GimpDataFactory *factory,
-                                                       GimpContext     *context,
+static void   gimp_data_loader_factory_queue_data     (GimpDataFactory *factory,
                                                        GHashTable      *cache,
+                                                       GArray          *jobs,
                                                        gboolean         dir_writable,
                                                        GFile           *file,
                                                        GFileInfo       *info,
                                                        GFile           *top_directory);
+static void   gimp_data_loader_factory_decode_range   (gsize            offset,
+                                                       gsize            size,
+                                                       gpointer         user_data);
+static void   gimp_data_loader_factory_decode_data    (GimpContext     *context,
+                                                       GimpDataLoadJob *job);
+static void   gimp_data_loader_factory_add_data       (GimpDataFactory *factory,
+                                                       GimpDataLoadJob *job);
+
+static gchar      * gimp_data_loader_factory_get_index_file (GimpDataFactory *factory);
+static GHashTable * gimp_data_loader_factory_read_index     (GimpDataFactory *factory);
+static void         gimp_data_loader_factory_write_index    (GimpDataFactory *factory,
+                                                             GHashTable      *index);
+static gboolean     gimp_data_loader_factory_index_data     (GimpDataFactory *factory,
+                                                             GHashTable      *index,
+                                                             GimpDataLoadJob *job);
 
 static GimpDataLoader * gimp_data_loader_new          (const gchar     *name,
                                                        GimpDataLoadFunc load_func,
@@ -133,6 +190,8 @@ gimp_data_loader_factory_finalize (GObject *object)
 
   g_clear_pointer (&priv->fallback, gimp_data_loader_free);
 
+  g_clear_pointer (&priv->index_name, g_free);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -289,6 +348,66 @@ gimp_data_loader_factory_add_fallback (GimpDataFactory  *factory,
   priv->fallback = gimp_data_loader_new (name, load_func, NULL, FALSE);
 }
 
+/**
+ * gimp_data_loader_factory_set_parallel:
+ * @factory:  a #GimpDataLoaderFactory
+ * @parallel: whether data files may be decoded in parallel
+ *
+ * Allows the factory to run its loaders' #GimpDataLoadFunc on worker
+ * threads.  Only enable this when all the factory's loaders are
+ * thread-safe, in particular when they don't report anything using
+ * g_message() or gimp_message().  Everything else, like adding the
+ * data to the factory's container, still happens in the main thread,
+ * in the same order as when loading serially.
+ **/
+void
+gimp_data_loader_factory_set_parallel (GimpDataFactory *factory,
+                                       gboolean         parallel)
+{
+  g_return_if_fail (GIMP_IS_DATA_LOADER_FACTORY (factory));
+
+  GET_PRIVATE (factory)->parallel = parallel ? TRUE : FALSE;
+}
+
+/**
+ * gimp_data_loader_factory_set_index:
+ * @factory:    a #GimpDataLoaderFactory
+ * @index_name: the name of the index file in GIMP's cache directory
+ * @load_func:  creates a data object from a file's index entry
+ * @save_func:  creates the index entry of a data object
+ *
+ * Makes the factory keep a persistent index of its data files, keyed
+ * by their mtime.  Files which didn't change since they were indexed
+ * are not decoded when loading; instead, @load_func creates their data
+ * object from the index entry, and is expected to decode the actual
+ * data on first use.  The index is updated incrementally whenever the
+ * factory loads or refreshes its data.
+ *
+ * Only files which contain a single data object are indexed.
+ * @save_func may return %NULL for data objects which can't be indexed.
+ **/
+void
+gimp_data_loader_factory_set_index (GimpDataFactory       *factory,
+                                    const gchar           *index_name,
+                                    GimpDataIndexLoadFunc  load_func,
+                                    GimpDataIndexSaveFunc  save_func)
+{
+  GimpDataLoaderFactoryPrivate *priv;
+
+  g_return_if_fail (GIMP_IS_DATA_LOADER_FACTORY (factory));
+  g_return_if_fail (index_name != NULL);
+  g_return_if_fail (load_func != NULL);
+  g_return_if_fail (save_func != NULL);
+
+  priv = GET_PRIVATE (factory);
+
+  g_free (priv->index_name);
+
+  priv->index_name      = g_strdup (index_name);
+  priv->index_load_func = load_func;
+  priv->index_save_func = save_func;
+}
+
 
 /*  private functions  */
 
@@ -315,15 +434,32 @@ gimp_data_loader_factory_load (GimpDataFactory *factory,
                                GimpContext     *context,
                                GHashTable      *cache)
 {
-  const GList *ext_path;
-  GList       *path;
-  GList       *writable_path;
-  GList       *list;
+  GimpDataLoaderFactoryPrivate *priv = GET_PRIVATE (factory);
+  const GList                  *ext_path;
+  GList                        *path;
+  GList                        *writable_path;
+  GList                        *list;
+  GArray                       *jobs;
+  GimpDataLoadParallelData      data;
+  GHashTable                   *new_index   = NULL;
+  gboolean                      index_dirty = FALSE;
+  gint                          i;
+
+  if (priv->index_name)
+    {
+      priv->index = gimp_data_loader_factory_read_index (factory);
+
+      new_index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         g_free,
+                                         (GDestroyNotify) g_variant_unref);
+    }
 
   path          = gimp_data_factory_get_data_path          (factory);
   writable_path = gimp_data_factory_get_data_path_writable (factory);
   ext_path      = gimp_data_factory_get_data_path_ext      (factory);
 
+  jobs = g_array_new (FALSE, FALSE, sizeof (GimpDataLoadJob));
+
   for (list = (GList *) ext_path; list; list = g_list_next (list))
     {
       /* Adding data from extensions.
@@ -331,7 +467,7 @@ gimp_data_loader_factory_load (GimpDataFactory *factory,
        * writable, since writability of extension is only taken into
        * account for extension update).
        */
-      gimp_data_loader_factory_load_directory (factory, context, cache,
+      gimp_data_loader_factory_load_directory (factory, cache, jobs,
                                                FALSE,
                                                list->data,
                                                list->data);
@@ -345,7 +481,7 @@ gimp_data_loader_factory_load (GimpDataFactory *factory,
                               (GCompareFunc) gimp_file_compare))
         dir_writable = TRUE;
 
-      gimp_data_loader_factory_load_directory (factory, context, cache,
+      gimp_data_loader_factory_load_directory (factory, cache, jobs,
                                                dir_writable,
                                                list->data,
                                                list->data);
@@ -353,12 +489,63 @@ gimp_data_loader_factory_load (GimpDataFactory *factory,
 
   g_list_free_full (path,          (GDestroyNotify) g_object_unref);
   g_list_free_full (writable_path, (GDestroyNotify) g_object_unref);
+
+  /*  Decode all files which are neither cached nor indexed, possibly
+   *  in parallel, and only then add the data in the order the files
+   *  were found
+   */
+  data.context = context;
+  data.jobs    = (GimpDataLoadJob *) jobs->data;
+
+  if (priv->parallel)
+    {
+      gegl_parallel_distribute_range (
+        jobs->len, GIMP_DATA_LOADER_FACTORY_FILES_PER_THREAD,
+        gimp_data_loader_factory_decode_range,
+        &data);
+    }
+  else
+    {
+      gimp_data_loader_factory_decode_range (0, jobs->len, &data);
+    }
+
+  for (i = 0; i < jobs->len; i++)
+    {
+      GimpDataLoadJob *job = &g_array_index (jobs, GimpDataLoadJob, i);
+
+      if (new_index &&
+          gimp_data_loader_factory_index_data (factory, new_index, job))
+        {
+          index_dirty = TRUE;
+        }
+
+      gimp_data_loader_factory_add_data (factory, job);
+
+      g_clear_pointer (&job->entry, g_variant_unref);
+      g_object_unref (job->file);
+      g_object_unref (job->top_directory);
+    }
+
+  g_array_free (jobs, TRUE);
+
+  /*  files which went away are dropped from the index  */
+  if (new_index)
+    {
+      if (index_dirty ||
+          g_hash_table_size (new_index) != g_hash_table_size (priv->index))
+        {
+          gimp_data_loader_factory_write_index (factory, new_index);
+        }
+
+      g_hash_table_unref (new_index);
+      g_clear_pointer (&priv->index, g_hash_table_unref);
+    }
 }
 
 static void
 gimp_data_loader_factory_load_directory (GimpDataFactory *factory,
-                                         GimpContext     *context,
                                          GHashTable      *cache,
+                                         GArray          *jobs,
                                          gboolean         dir_writable,
                                          GFile           *directory,
                                          GFile           *top_directory)
@@ -393,17 +580,17 @@ gimp_data_loader_factory_load_directory (GimpDataFactory *factory,
 
           if (file_type == G_FILE_TYPE_DIRECTORY)
             {
-              gimp_data_loader_factory_load_directory (factory, context, cache,
+              gimp_data_loader_factory_load_directory (factory, cache, jobs,
                                                        dir_writable,
                                                        child,
                                                        top_directory);
             }
           else if (file_type == G_FILE_TYPE_REGULAR)
             {
-              gimp_data_loader_factory_load_data (factory, context, cache,
-                                                  dir_writable,
-                                                  child, info,
-                                                  top_directory);
+              gimp_data_loader_factory_queue_data (factory, cache, jobs,
+                                                   dir_writable,
+                                                   child, info,
+                                                   top_directory);
             }
 
           g_object_unref (child);
@@ -415,35 +602,32 @@ gimp_data_loader_factory_load_directory (GimpDataFactory *factory,
 }
 
 static void
-gimp_data_loader_factory_load_data (GimpDataFactory *factory,
-                                    GimpContext     *context,
-                                    GHashTable      *cache,
-                                    gboolean         dir_writable,
-                                    GFile           *file,
-                                    GFileInfo       *info,
-                                    GFile           *top_directory)
+gimp_data_loader_factory_queue_data (GimpDataFactory *factory,
+                                     GHashTable      *cache,
+                                     GArray          *jobs,
+                                     gboolean         dir_writable,
+                                     GFile           *file,
+                                     GFileInfo       *info,
+                                     GFile           *top_directory)
 {
-  GimpDataLoader *loader;
-  GimpContainer  *container;
-  GimpContainer  *container_obsolete;
-  GList          *data_list = NULL;
-  GInputStream   *input;
-  guint64         mtime;
-  GError         *error = NULL;
+  GimpDataLoaderFactoryPrivate *priv = GET_PRIVATE (factory);
+  GimpDataLoader               *loader;
+  GimpDataLoadJob               job  = { 0, };
 
   loader = gimp_data_loader_factory_get_loader (factory, file);
 
   if (! loader)
     return;
 
-  container          = gimp_data_factory_get_container          (factory);
-  container_obsolete = gimp_data_factory_get_container_obsolete (factory);
-
   if (gimp_data_factory_get_gimp (factory)->be_verbose)
     g_print ("  Loading %s\n", gimp_file_get_utf8_name (file));
 
-  mtime = g_file_info_get_attribute_uint64 (info,
-                                            G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  job.loader        = loader;
+  job.file          = g_object_ref (file);
+  job.top_directory = g_object_ref (top_directory);
+  job.dir_writable  = dir_writable;
+  job.mtime         = g_file_info_get_attribute_uint64 (info,
+                                                        G_FILE_ATTRIBUTE_TIME_MODIFIED);
 
   if (cache)
     {
@@ -451,36 +635,97 @@ gimp_data_loader_factory_load_data (GimpDataFactory *factory,
 
       if (cached_data &&
           gimp_data_get_mtime (cached_data->data) != 0 &&
-          gimp_data_get_mtime (cached_data->data) == mtime)
+          gimp_data_get_mtime (cached_data->data) == job.mtime)
+        {
+          job.cached    = TRUE;
+          job.data_list = cached_data;
+        }
+    }
+
+  if (priv->index)
+    {
+      gchar    *uri   = g_file_get_uri (file);
+      GVariant *value = g_hash_table_lookup (priv->index, uri);
+
+      if (value)
         {
-          GList *list;
+          guint64   mtime;
+          GVariant *entry;
 
-          for (list = cached_data; list; list = g_list_next (list))
-            gimp_container_add (container, list->data);
+          g_variant_get (value, "(tv)", &mtime, &entry);
 
-          return;
+          if (mtime == job.mtime)
+            job.entry = entry;
+          else
+            g_variant_unref (entry);
         }
+
+      g_free (uri);
     }
 
-  input = G_INPUT_STREAM (g_file_read (file, NULL, &error));
+  /*  create the data of unchanged files from their index entry,
+   *  instead of decoding them
+   */
+  if (! job.cached && job.entry)
+    {
+      GimpData *data = priv->index_load_func (file, job.entry);
+
+      if (data)
+        {
+          job.indexed   = TRUE;
+          job.data_list = g_list_prepend (NULL, data);
+        }
+      else
+        {
+          g_clear_pointer (&job.entry, g_variant_unref);
+        }
+    }
+
+  g_array_append_val (jobs, job);
+}
+
+static void
+gimp_data_loader_factory_decode_range (gsize    offset,
+                                       gsize    size,
+                                       gpointer user_data)
+{
+  GimpDataLoadParallelData *data = user_data;
+  gsize                     i;
+
+  for (i = offset; i < offset + size; i++)
+    {
+      if (! data->jobs[i].cached && ! data->jobs[i].indexed)
+        gimp_data_loader_factory_decode_data (data->context, &data->jobs[i]);
+    }
+}
+
+/*  this may run in a worker thread, don't touch the factory here  */
+static void
+gimp_data_loader_factory_decode_data (GimpContext     *context,
+                                      GimpDataLoadJob *job)
+{
+  GInputStream *input;
+
+  input = G_INPUT_STREAM (g_file_read (job->file, NULL, &job->error));
 
   if (input)
     {
       GInputStream *buffered = g_buffered_input_stream_new (input);
 
-      data_list = loader->load_func (context, file, buffered, &error);
+      job->data_list = job->loader->load_func (context, job->file, buffered,
+                                               &job->error);
 
-      if (error)
+      if (job->error)
         {
-          g_prefix_error (&error,
+          g_prefix_error (&job->error,
                           _("Error loading '%s': "),
-                          gimp_file_get_utf8_name (file));
+                          gimp_file_get_utf8_name (job->file));
         }
-      else if (! data_list)
+      else if (! job->data_list)
         {
-          g_set_error (&error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
+          g_set_error (&job->error, GIMP_DATA_ERROR, GIMP_DATA_ERROR_READ,
                        _("Error loading '%s'"),
-                       gimp_file_get_utf8_name (file));
+                       gimp_file_get_utf8_name (job->file));
         }
 
       g_object_unref (buffered);
@@ -488,12 +733,33 @@ gimp_data_loader_factory_load_data (GimpDataFactory *factory,
     }
   else
     {
-      g_prefix_error (&error,
+      g_prefix_error (&job->error,
                       _("Could not open '%s' for reading: "),
-                      gimp_file_get_utf8_name (file));
+                      gimp_file_get_utf8_name (job->file));
     }
+}
+
+static void
+gimp_data_loader_factory_add_data (GimpDataFactory *factory,
+                                   GimpDataLoadJob *job)
+{
+  GimpContainer *container;
+  GimpContainer *container_obsolete;
 
-  if (G_LIKELY (data_list))
+  container          = gimp_data_factory_get_container          (factory);
+  container_obsolete = gimp_data_factory_get_container_obsolete (factory);
+
+  if (job->cached)
+    {
+      GList *list;
+
+      for (list = job->data_list; list; list = g_list_next (list))
+        gimp_container_add (container, list->data);
+
+      return;
+    }
+
+  if (G_LIKELY (job->data_list))
     {
       GList    *list;
       gchar    *uri;
@@ -501,7 +767,7 @@ gimp_data_loader_factory_load_data (GimpDataFactory *factory,
       gboolean  writable  = FALSE;
       gboolean  deletable = FALSE;
 
-      uri = g_file_get_uri (file);
+      uri = g_file_get_uri (job->file);
 
       obsolete = (strstr (uri, GIMP_OBSOLETE_DATA_DIR_NAME) != 0);
 
@@ -510,16 +776,17 @@ gimp_data_loader_factory_load_data (GimpDataFactory *factory,
       /* obsolete files are immutable, don't check their writability */
       if (! obsolete)
         {
-          deletable = (g_list_length (data_list) == 1 && dir_writable);
-          writable  = (deletable && loader->writable);
+          deletable = (g_list_length (job->data_list) == 1 &&
+                       job->dir_writable);
+          writable  = (deletable && job->loader->writable);
         }
 
-      for (list = data_list; list; list = g_list_next (list))
+      for (list = job->data_list; list; list = g_list_next (list))
         {
           GimpData *data = list->data;
 
-          gimp_data_set_file (data, file, writable, deletable);
-          gimp_data_set_mtime (data, mtime);
+          gimp_data_set_file (data, job->file, writable, deletable);
+          gimp_data_set_mtime (data, job->mtime);
           gimp_data_clean (data);
 
           if (obsolete)
@@ -529,7 +796,7 @@ gimp_data_loader_factory_load_data (GimpDataFactory *factory,
             }
           else
             {
-              gimp_data_set_folder_tags (data, top_directory);
+              gimp_data_set_folder_tags (data, job->top_directory);
 
               gimp_container_add (container,
                                   GIMP_OBJECT (data));
@@ -538,20 +805,166 @@ gimp_data_loader_factory_load_data (GimpDataFactory *factory,
           g_object_unref (data);
         }
 
-      g_list_free (data_list);
+      g_list_free (job->data_list);
     }
 
   /*  not else { ... } because loader->load_func() can return a list
    *  of data objects *and* an error message if loading failed after
    *  something was already loaded
    */
-  if (G_UNLIKELY (error))
+  if (G_UNLIKELY (job->error))
     {
       gimp_message (gimp_data_factory_get_gimp (factory), NULL,
                     GIMP_MESSAGE_ERROR,
-                    _("Failed to load data:\n\n%s"), error->message);
+                    _("Failed to load data:\n\n%s"), job->error->message);
+      g_clear_error (&job->error);
+    }
+}
+
+static gchar *
+gimp_data_loader_factory_get_index_file (GimpDataFactory *factory)
+{
+  return g_build_filename (gimp_cache_directory (),
+                           GET_PRIVATE (factory)->index_name,
+                           NULL);
+}
+
+static GHashTable *
+gimp_data_loader_factory_read_index (GimpDataFactory *factory)
+{
+  GHashTable *index;
+  gchar      *filename;
+  gchar      *contents;
+  gsize       length;
+
+  index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                 g_free,
+                                 (GDestroyNotify) g_variant_unref);
+
+  filename = gimp_data_loader_factory_get_index_file (factory);
+
+  if (g_file_get_contents (filename, &contents, &length, NULL))
+    {
+      GVariant *variant;
+      GVariant *entries;
+      guint32   version;
+
+      variant = g_variant_new_from_data (G_VARIANT_TYPE (GIMP_DATA_INDEX_TYPE),
+                                         contents, length, FALSE,
+                                         g_free, contents);
+      g_variant_ref_sink (variant);
+
+      g_variant_get (variant, "(u@a{s(tv)})", &version, &entries);
+
+      /*  an index of another version is simply rebuilt  */
+      if (version == GIMP_DATA_INDEX_VERSION)
+        {
+          GVariantIter  iter;
+          const gchar  *uri;
+          GVariant     *value;
+
+          g_variant_iter_init (&iter, entries);
+
+          while (g_variant_iter_next (&iter, "{&s@(tv)}", &uri, &value))
+            g_hash_table_insert (index, g_strdup (uri), value);
+        }
+
+      g_variant_unref (entries);
+      g_variant_unref (variant);
+    }
+
+  g_free (filename);
+
+  return index;
+}
+
+static void
+gimp_data_loader_factory_write_index (GimpDataFactory *factory,
+                                      GHashTable      *index)
+{
+  GVariantBuilder  builder;
+  GHashTableIter   iter;
+  gpointer         uri;
+  gpointer         value;
+  GVariant        *variant;
+  gchar           *filename;
+  GError          *error = NULL;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{s(tv)}"));
+
+  g_hash_table_iter_init (&iter, index);
+
+  while (g_hash_table_iter_next (&iter, &uri, &value))
+    g_variant_builder_add (&builder, "{s@(tv)}", uri, value);
+
+  variant = g_variant_new ("(u@a{s(tv)})",
+                           GIMP_DATA_INDEX_VERSION,
+                           g_variant_builder_end (&builder));
+  g_variant_ref_sink (variant);
+
+  filename = gimp_data_loader_factory_get_index_file (factory);
+
+  /*  the index is only a cache, failing to write it is not fatal  */
+  if (g_mkdir_with_parents (gimp_cache_directory (), 0700) != 0 ||
+      ! g_file_set_contents (filename,
+                             g_variant_get_data (variant),
+                             g_variant_get_size (variant),
+                             &error))
+    {
+      if (gimp_data_factory_get_gimp (factory)->be_verbose)
+        {
+          g_printerr ("Failed to write data index '%s': %s\n",
+                      gimp_filename_to_utf8 (filename),
+                      error ? error->message : g_strerror (errno));
+        }
+
       g_clear_error (&error);
     }
+
+  g_free (filename);
+  g_variant_unref (variant);
+}
+
+/*  adds the job's file to the new index.  returns TRUE if the file
+ *  wasn't indexed before.
+ */
+static gboolean
+gimp_data_loader_factory_index_data (GimpDataFactory *factory,
+                                     GHashTable      *index,
+                                     GimpDataLoadJob *job)
+{
+  GimpDataLoaderFactoryPrivate *priv  = GET_PRIVATE (factory);
+  GVariant                     *entry = NULL;
+  gboolean                      added = FALSE;
+
+  if (job->entry)
+    {
+      entry = g_variant_ref (job->entry);
+    }
+  else if (job->data_list && ! job->data_list->next && ! job->error)
+    {
+      entry = priv->index_save_func (job->data_list->data);
+
+      if (entry)
+        {
+          g_variant_ref_sink (entry);
+
+          added = TRUE;
+        }
+    }
+
+  if (entry)
+    {
+      g_hash_table_insert (index,
+                           g_file_get_uri (job->file),
+                           g_variant_ref_sink (g_variant_new ("(tv)",
+                                                              job->mtime,
+                                                              entry)));
+
+      g_variant_unref (entry);
+    }
+
+  return added;
 }
 
 static GimpDataLoader *
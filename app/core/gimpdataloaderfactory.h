@@ -25,10 +25,14 @@
 #include "gimpdatafactory.h"
 
 
-typedef GList * (* GimpDataLoadFunc) (GimpContext   *context,
-                                      GFile         *file,
-                                      GInputStream  *input,
-                                      GError       **error);
+typedef GList    * (* GimpDataLoadFunc)      (GimpContext   *context,
+                                              GFile         *file,
+                                              GInputStream  *input,
+                                              GError       **error);
+
+typedef GimpData * (* GimpDataIndexLoadFunc) (GFile         *file,
+                                              GVariant      *entry);
+typedef GVariant * (* GimpDataIndexSaveFunc) (GimpData      *data);
 
 
 #define GIMP_TYPE_DATA_LOADER_FACTORY            (gimp_data_loader_factory_get_type ())
@@ -74,5 +78,12 @@ void              gimp_data_loader_factory_add_fallback (GimpDataFactory
                                                          const gchar             *name,
                                                          GimpDataLoadFunc         load_func);
 
+void              gimp_data_loader_factory_set_parallel (GimpDataFactory         *factory,
+                                                         gboolean                 parallel);
+void              gimp_data_loader_factory_set_index    (GimpDataFactory         *factory,
+                                                         const gchar             *index_name,
+                                                         GimpDataIndexLoadFunc    load_func,
+                                                         GimpDataIndexSaveFunc    save_func);
+
 
 #endif  /*  __GIMP_DATA_LOADER_FACTORY_H__  */
@@ -23,6 +23,7 @@
 
 #include "libgimpbase/gimpbase.h"
 #include "libgimpcolor/gimpcolor.h"
+#include "libgimpmath/gimpmath.h"
 
 #include "core-types.h"
 
@@ -45,6 +46,23 @@
 #include "gimp-intl.h"
 
 
+/*  local function prototypes  */
+
+static GimpPickable * gimp_drawable_get_bucket_fill_pickable        (GimpDrawable     *drawable,
+                                                                     gboolean          show_all,
+                                                                     gboolean          sample_merged);
+static GeglBuffer   * gimp_drawable_get_bucket_fill_buffer_internal (GimpDrawable     *drawable,
+                                                                     GimpFillOptions  *options,
+                                                                     gboolean          sample_merged,
+                                                                     gint              level,
+                                                                     GeglBuffer       *new_mask,
+                                                                     GeglBuffer      **mask_buffer,
+                                                                     gdouble          *mask_x,
+                                                                     gdouble          *mask_y,
+                                                                     gint             *mask_width,
+                                                                     gint             *mask_height);
+
+
 /*  public functions  */
 
 void
@@ -146,20 +164,67 @@ gimp_drawable_get_bucket_fill_buffer (GimpDrawable         *drawable,
                                       gdouble              *mask_y,
                                       gint                 *mask_width,
                                       gint                 *mask_height)
+{
+  return gimp_drawable_get_bucket_fill_preview (drawable, options,
+                                                fill_transparent,
+                                                fill_criterion,
+                                                threshold,
+                                                show_all,
+                                                sample_merged,
+                                                diagonal_neighbors,
+                                                0,
+                                                seed_x, seed_y,
+                                                mask_buffer,
+                                                mask_x, mask_y,
+                                                mask_width, mask_height);
+}
+
+/**
+ * gimp_drawable_get_bucket_fill_preview:
+ * @drawable: the #GimpDrawable to edit.
+ * @level: the mipmap level to compute the fill at.
+ * @mask_buffer: mask of the fill in-progress, at the same @level.
+ *
+ * Like gimp_drawable_get_bucket_fill_buffer(), but computes the fill
+ * on a copy of the source downscaled by a factor of 2^@level.  This is
+ * meant for showing a fast, approximate fill while the full-resolution
+ * fill is computed using gimp_drawable_get_bucket_fill_mask_async().
+ *
+ * The returned buffer is at the reduced resolution, and has to be
+ * scaled by 2^@level when used; @mask_x and @mask_y are returned in
+ * full-resolution drawable coordinates, while @mask_width and
+ * @mask_height are the dimensions of the returned buffer.
+ *
+ * Returns: a downscaled fill buffer.
+ */
+GeglBuffer *
+gimp_drawable_get_bucket_fill_preview (GimpDrawable         *drawable,
+                                       GimpFillOptions      *options,
+                                       gboolean              fill_transparent,
+                                       GimpSelectCriterion   fill_criterion,
+                                       gdouble               threshold,
+                                       gboolean              show_all,
+                                       gboolean              sample_merged,
+                                       gboolean              diagonal_neighbors,
+                                       gint                  level,
+                                       gdouble               seed_x,
+                                       gdouble               seed_y,
+                                       GeglBuffer          **mask_buffer,
+                                       gdouble              *mask_x,
+                                       gdouble              *mask_y,
+                                       gint                 *mask_width,
+                                       gint                 *mask_height)
 {
   GimpImage    *image;
   GimpPickable *pickable;
   GeglBuffer   *buffer;
   GeglBuffer   *new_mask;
-  gboolean      antialias;
-  gint          x, y, width, height;
-  gint          mask_offset_x = 0;
-  gint          mask_offset_y = 0;
   gint          sel_x, sel_y, sel_width, sel_height;
 
   g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
   g_return_val_if_fail (gimp_item_is_attached (GIMP_ITEM (drawable)), NULL);
   g_return_val_if_fail (GIMP_IS_FILL_OPTIONS (options), NULL);
+  g_return_val_if_fail (level >= 0, NULL);
 
   image = gimp_item_get_image (GIMP_ITEM (drawable));
 
@@ -171,8 +236,10 @@ gimp_drawable_get_bucket_fill_buffer (GimpDrawable         *drawable,
     {
       gfloat pixel;
 
-      gegl_buffer_sample (*mask_buffer, seed_x, seed_y, NULL, &pixel,
-                          babl_format ("Y float"),
+      gegl_buffer_sample (*mask_buffer,
+                          floor (seed_x / (1 << level)),
+                          floor (seed_y / (1 << level)),
+                          NULL, &pixel, babl_format ("Y float"),
                           GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
 
       if (pixel != 0.0)
@@ -182,127 +249,131 @@ gimp_drawable_get_bucket_fill_buffer (GimpDrawable         *drawable,
 
   gimp_set_busy (image->gimp);
 
-  if (sample_merged)
-    {
-      if (! show_all)
-        pickable = GIMP_PICKABLE (image);
-      else
-        pickable = GIMP_PICKABLE (gimp_image_get_projection (image));
-    }
-  else
-    {
-      pickable = GIMP_PICKABLE (drawable);
-    }
-
-  antialias = gimp_fill_options_get_antialias (options);
+  pickable = gimp_drawable_get_bucket_fill_pickable (drawable,
+                                                     show_all, sample_merged);
 
   /*  Do a seed bucket fill...To do this, calculate a new
    *  contiguous region.
    */
-  new_mask = gimp_pickable_contiguous_region_by_seed (pickable,
-                                                      antialias,
-                                                      threshold,
-                                                      fill_transparent,
-                                                      fill_criterion,
-                                                      diagonal_neighbors,
-                                                      (gint) seed_x,
-                                                      (gint) seed_y);
-  if (mask_buffer && *mask_buffer)
-    {
-      gimp_gegl_mask_combine_buffer (new_mask, *mask_buffer,
-                                     GIMP_CHANNEL_OP_ADD, 0, 0);
-      g_object_unref (*mask_buffer);
-    }
-
-  if (mask_buffer)
-    *mask_buffer = new_mask;
-
-  gimp_gegl_mask_bounds (new_mask, &x, &y, &width, &height);
-  width  -= x;
-  height -= y;
-
-  /*  If there is a selection, intersect the region bounds
-   *  with the selection bounds, to avoid processing areas
-   *  that are going to be masked out anyway.  The actual
-   *  intersection of the fill region with the mask data
-   *  happens when combining the fill buffer, in
-   *  gimp_drawable_apply_buffer().
-   */
-  if (! gimp_channel_is_empty (gimp_image_get_mask (image)))
-    {
-      gint off_x = 0;
-      gint off_y = 0;
-
-      if (sample_merged)
-        gimp_item_get_offset (GIMP_ITEM (drawable), &off_x, &off_y);
-
-      if (! gimp_rectangle_intersect (x, y, width, height,
-
-                                      sel_x + off_x, sel_y + off_y,
-                                      sel_width,     sel_height,
-
-                                      &x, &y, &width, &height))
-        {
-          /*  The fill region and the selection are disjoint; bail.  */
-
-          if (! mask_buffer)
-            g_object_unref (new_mask);
-
-          gimp_unset_busy (image->gimp);
-
-          return NULL;
-        }
-    }
-
-  /*  make sure we handle the mask correctly if it was sample-merged  */
-  if (sample_merged)
-    {
-      GimpItem *item = GIMP_ITEM (drawable);
-      gint      off_x, off_y;
+  new_mask = gimp_pickable_contiguous_region_by_seed_at_level (
+    pickable,
+    gimp_fill_options_get_antialias (options),
+    threshold,
+    fill_transparent,
+    fill_criterion,
+    diagonal_neighbors,
+    level,
+    (gint) seed_x,
+    (gint) seed_y);
+
+  buffer = gimp_drawable_get_bucket_fill_buffer_internal (drawable, options,
+                                                          sample_merged,
+                                                          level, new_mask,
+                                                          mask_buffer,
+                                                          mask_x, mask_y,
+                                                          mask_width,
+                                                          mask_height);
+
+  g_object_unref (new_mask);
 
-      /*  Limit the channel bounds to the drawable's extents  */
-      gimp_item_get_offset (item, &off_x, &off_y);
+  gimp_unset_busy (image->gimp);
 
-      gimp_rectangle_intersect (x, y, width, height,
+  return buffer;
+}
 
-                                off_x, off_y,
-                                gimp_item_get_width (item),
-                                gimp_item_get_height (item),
+/**
+ * gimp_drawable_get_bucket_fill_mask_async:
+ * @drawable: the #GimpDrawable to edit.
+ * @seeds: the fill's seed points, in the same coordinates as the
+ *         @seed_x and @seed_y arguments of
+ *         gimp_drawable_get_bucket_fill_buffer().
+ * @n_seeds: the number of seed points.
+ *
+ * Computes the full-resolution fill mask of all @seeds on the thread
+ * pool.  The result can be turned into a fill buffer using
+ * gimp_drawable_get_bucket_fill_buffer_from_mask().
+ *
+ * Returns: a #GimpAsync, whose result is the fill mask.
+ */
+GimpAsync *
+gimp_drawable_get_bucket_fill_mask_async (GimpDrawable         *drawable,
+                                          gboolean              antialias,
+                                          gboolean              fill_transparent,
+                                          GimpSelectCriterion   fill_criterion,
+                                          gdouble               threshold,
+                                          gboolean              show_all,
+                                          gboolean              sample_merged,
+                                          gboolean              diagonal_neighbors,
+                                          const GimpVector2    *seeds,
+                                          gint                  n_seeds)
+{
+  GimpPickable *pickable;
 
-                                &x, &y, &width, &height);
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
+  g_return_val_if_fail (gimp_item_is_attached (GIMP_ITEM (drawable)), NULL);
+  g_return_val_if_fail (seeds != NULL, NULL);
+  g_return_val_if_fail (n_seeds > 0, NULL);
+
+  pickable = gimp_drawable_get_bucket_fill_pickable (drawable,
+                                                     show_all, sample_merged);
+
+  return gimp_pickable_contiguous_region_by_seeds_async (pickable,
+                                                         antialias,
+                                                         threshold,
+                                                         fill_transparent,
+                                                         fill_criterion,
+                                                         diagonal_neighbors,
+                                                         seeds, n_seeds);
+}
 
-      mask_offset_x = x;
-      mask_offset_y = y;
+/**
+ * gimp_drawable_get_bucket_fill_buffer_from_mask:
+ * @drawable: the #GimpDrawable to edit.
+ * @new_mask: a fill mask, as computed by
+ *            gimp_drawable_get_bucket_fill_mask_async().
+ * @mask_buffer: mask of the fill in-progress, or NULL.
+ *
+ * Creates the fill buffer for the precomputed fill mask @new_mask.
+ * If @mask_buffer is not NULL, its contents are added to @new_mask.
+ * The arguments and return value are otherwise the same as for
+ * gimp_drawable_get_bucket_fill_buffer().
+ *
+ * Returns: a fill buffer, or NULL if there is nothing to fill.
+ */
+GeglBuffer *
+gimp_drawable_get_bucket_fill_buffer_from_mask (GimpDrawable     *drawable,
+                                                GimpFillOptions  *options,
+                                                gboolean          sample_merged,
+                                                GeglBuffer       *new_mask,
+                                                GeglBuffer      **mask_buffer,
+                                                gdouble          *mask_x,
+                                                gdouble          *mask_y,
+                                                gint             *mask_width,
+                                                gint             *mask_height)
+{
+  GimpImage  *image;
+  GeglBuffer *buffer;
 
-      /*  translate mask bounds to drawable coords  */
-      x -= off_x;
-      y -= off_y;
-    }
-  else
-    {
-      mask_offset_x = x;
-      mask_offset_y = y;
-    }
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
+  g_return_val_if_fail (gimp_item_is_attached (GIMP_ITEM (drawable)), NULL);
+  g_return_val_if_fail (GIMP_IS_FILL_OPTIONS (options), NULL);
+  g_return_val_if_fail (GEGL_IS_BUFFER (new_mask), NULL);
 
-  buffer = gimp_fill_options_create_buffer (options, drawable,
-                                            GEGL_RECTANGLE (0, 0,
-                                                            width, height),
-                                            -x, -y);
+  image = gimp_item_get_image (GIMP_ITEM (drawable));
 
-  gimp_gegl_apply_opacity (buffer, NULL, NULL, buffer, new_mask,
-                           -mask_offset_x, -mask_offset_y, 1.0);
+  if (! gimp_item_mask_intersect (GIMP_ITEM (drawable),
+                                  NULL, NULL, NULL, NULL))
+    return NULL;
 
-  if (mask_x)
-    *mask_x = x;
-  if (mask_y)
-    *mask_y = y;
-  if (mask_width)
-    *mask_width = width;
-  if (mask_height)
-    *mask_height = height;
+  gimp_set_busy (image->gimp);
 
-  if (! mask_buffer)
-    g_object_unref (new_mask);
+  buffer = gimp_drawable_get_bucket_fill_buffer_internal (drawable, options,
+                                                          sample_merged,
+                                                          0, new_mask,
+                                                          mask_buffer,
+                                                          mask_x, mask_y,
+                                                          mask_width,
+                                                          mask_height);
 
   gimp_unset_busy (image->gimp);
 
@@ -496,3 +567,133 @@ gimp_drawable_get_line_art_fill_buffer (GimpDrawable     *drawable,
 
   return buffer;
 }
+
+
+/*  private functions  */
+
+static GimpPickable *
+gimp_drawable_get_bucket_fill_pickable (GimpDrawable *drawable,
+                                        gboolean      show_all,
+                                        gboolean      sample_merged)
+{
+  GimpImage *image = gimp_item_get_image (GIMP_ITEM (drawable));
+
+  if (sample_merged)
+    {
+      if (! show_all)
+        return GIMP_PICKABLE (image);
+      else
+        return GIMP_PICKABLE (gimp_image_get_projection (image));
+    }
+
+  return GIMP_PICKABLE (drawable);
+}
+
+static GeglBuffer *
+gimp_drawable_get_bucket_fill_buffer_internal (GimpDrawable     *drawable,
+                                               GimpFillOptions  *options,
+                                               gboolean          sample_merged,
+                                               gint              level,
+                                               GeglBuffer       *new_mask,
+                                               GeglBuffer      **mask_buffer,
+                                               gdouble          *mask_x,
+                                               gdouble          *mask_y,
+                                               gint             *mask_width,
+                                               gint             *mask_height)
+{
+  GimpImage  *image  = gimp_item_get_image (GIMP_ITEM (drawable));
+  gdouble     factor = 1 << level;
+  GeglBuffer *buffer;
+  gint        x, y, width, height;
+  gint        mask_offset_x = 0;
+  gint        mask_offset_y = 0;
+  gint        off_x         = 0;
+  gint        off_y         = 0;
+  gint        sel_x, sel_y, sel_width, sel_height;
+
+  gimp_item_mask_intersect (GIMP_ITEM (drawable),
+                            &sel_x, &sel_y, &sel_width, &sel_height);
+
+  if (sample_merged)
+    gimp_item_get_offset (GIMP_ITEM (drawable), &off_x, &off_y);
+
+  if (mask_buffer && *mask_buffer)
+    gimp_gegl_mask_combine_buffer (new_mask, *mask_buffer,
+                                   GIMP_CHANNEL_OP_ADD, 0, 0);
+
+  if (mask_buffer)
+    g_set_object (mask_buffer, new_mask);
+
+  gimp_gegl_mask_bounds (new_mask, &x, &y, &width, &height);
+  width  -= x;
+  height -= y;
+
+  /*  If there is a selection, intersect the region bounds
+   *  with the selection bounds, to avoid processing areas
+   *  that are going to be masked out anyway.  The actual
+   *  intersection of the fill region with the mask data
+   *  happens when combining the fill buffer, in
+   *  gimp_drawable_apply_buffer().
+   */
+  if (! gimp_channel_is_empty (gimp_image_get_mask (image)))
+    {
+      gint x1 = floor ((sel_x + off_x)              / factor);
+      gint y1 = floor ((sel_y + off_y)              / factor);
+      gint x2 = ceil  ((sel_x + off_x + sel_width)  / factor);
+      gint y2 = ceil  ((sel_y + off_y + sel_height) / factor);
+
+      if (! gimp_rectangle_intersect (x, y, width, height,
+
+                                      x1,      y1,
+                                      x2 - x1, y2 - y1,
+
+                                      &x, &y, &width, &height))
+        {
+          /*  The fill region and the selection are disjoint; bail.  */
+
+          return NULL;
+        }
+    }
+
+  /*  make sure we handle the mask correctly if it was sample-merged  */
+  if (sample_merged)
+    {
+      GimpItem *item = GIMP_ITEM (drawable);
+      gint      x1   = floor (off_x                              / factor);
+      gint      y1   = floor (off_y                              / factor);
+      gint      x2   = ceil  ((off_x + gimp_item_get_width  (item)) / factor);
+      gint      y2   = ceil  ((off_y + gimp_item_get_height (item)) / factor);
+
+      /*  Limit the channel bounds to the drawable's extents  */
+      gimp_rectangle_intersect (x, y, width, height,
+
+                                x1,      y1,
+                                x2 - x1, y2 - y1,
+
+                                &x, &y, &width, &height);
+    }
+
+  mask_offset_x = x;
+  mask_offset_y = y;
+
+  buffer = gimp_fill_options_create_buffer (options, drawable,
+                                            GEGL_RECTANGLE (0, 0,
+                                                            width, height),
+                                            -(x * factor - off_x),
+                                            -(y * factor - off_y));
+
+  gimp_gegl_apply_opacity (buffer, NULL, NULL, buffer, new_mask,
+                           -mask_offset_x, -mask_offset_y, 1.0);
+
+  /*  translate mask bounds to full-resolution drawable coords  */
+  if (mask_x)
+    *mask_x = x * factor - off_x;
+  if (mask_y)
+    *mask_y = y * factor - off_y;
+  if (mask_width)
+    *mask_width = width;
+  if (mask_height)
+    *mask_height = height;
+
+  return buffer;
+}
@@ -43,6 +43,43 @@ GeglBuffer * gimp_drawable_get_bucket_fill_buffer   (GimpDrawable         *drawa
                                                      gdouble              *mask_y,
                                                      gint                 *mask_width,
                                                      gint                 *mask_height);
+GeglBuffer * gimp_drawable_get_bucket_fill_preview  (GimpDrawable         *drawable,
+                                                     GimpFillOptions      *options,
+                                                     gboolean              fill_transparent,
+                                                     GimpSelectCriterion   fill_criterion,
+                                                     gdouble               threshold,
+                                                     gboolean              show_all,
+                                                     gboolean              sample_merged,
+                                                     gboolean              diagonal_neighbors,
+                                                     gint                  level,
+                                                     gdouble               seed_x,
+                                                     gdouble               seed_y,
+                                                     GeglBuffer          **mask_buffer,
+                                                     gdouble              *mask_x,
+                                                     gdouble              *mask_y,
+                                                     gint                 *mask_width,
+                                                     gint                 *mask_height);
+GimpAsync  * gimp_drawable_get_bucket_fill_mask_async
+                                                    (GimpDrawable         *drawable,
+                                                     gboolean              antialias,
+                                                     gboolean              fill_transparent,
+                                                     GimpSelectCriterion   fill_criterion,
+                                                     gdouble               threshold,
+                                                     gboolean              show_all,
+                                                     gboolean              sample_merged,
+                                                     gboolean              diagonal_neighbors,
+                                                     const GimpVector2    *seeds,
+                                                     gint                  n_seeds);
+GeglBuffer * gimp_drawable_get_bucket_fill_buffer_from_mask
+                                                    (GimpDrawable         *drawable,
+                                                     GimpFillOptions      *options,
+                                                     gboolean              sample_merged,
+                                                     GeglBuffer           *new_mask,
+                                                     GeglBuffer          **mask_buffer,
+                                                     gdouble              *mask_x,
+                                                     gdouble              *mask_y,
+                                                     gint                 *mask_width,
+                                                     gint                 *mask_height);
 
 GeglBuffer * gimp_drawable_get_line_art_fill_buffer (GimpDrawable         *drawable,
                                                      GimpLineArt          *line_art,
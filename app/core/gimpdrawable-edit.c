@@ -85,12 +85,10 @@ gimp_drawable_edit_can_fill_direct (GimpDrawable    *drawable,
         case GIMP_FILL_STYLE_PATTERN:
           {
             GimpPattern *pattern;
-            GimpTempBuf *mask;
             const Babl  *format;
 
             pattern = gimp_context_get_pattern (context);
-            mask    = gimp_pattern_get_mask (pattern);
-            format  = gimp_temp_buf_get_format (mask);
+            format  = gimp_pattern_get_format (pattern);
 
             return ! babl_format_has_alpha (format);
           }
@@ -22,7 +22,9 @@
 #include <cairo.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
+#include <glib/gstdio.h>
 
+#include "libgimpbase/gimpbase.h"
 #include "libgimpcolor/gimpcolor.h"
 #include "libgimpmath/gimpmath.h"
 
@@ -50,6 +52,15 @@
 #include "gimp-priorities.h"
 
 
+#define PREVIEW_CACHE_MAGIC       "GIMPPRV1"
+#define PREVIEW_CACHE_HEADER_SIZE 16
+
+/*  the on-disk preview cache is trimmed to 3/4 of this size, least
+ *  recently used entries first, whenever it grows past it
+ */
+#define PREVIEW_CACHE_MAX_SIZE    (64 * 1024 * 1024)
+
+
 typedef struct
 {
   const Babl        *format;
@@ -60,14 +71,80 @@ typedef struct
   GimpChunkIterator *iter;
 } SubPreviewData;
 
+typedef struct
+{
+  GimpImage   *image;
+  guint64      mtime;
+  gchar       *path;
+
+  GimpTempBuf *preview;
+} PreviewCacheEntry;
+
+typedef struct
+{
+  gchar       *path;
+  gint64       size;
+  gint64       atime;
+} PreviewCacheFile;
+
+typedef struct
+{
+  SubPreviewData    *data;
+  PreviewCacheEntry *cache;
+
+  /*  the asyncs returned for the coalesced requests  */
+  GSList            *asyncs;
+
+  /*  the job's link in the pending queue, NULL once it's started  */
+  GList             *link;
+} PreviewJob;
+
 
 /*  local function prototypes  */
 
-static SubPreviewData * sub_preview_data_new  (const Babl          *format,
-                                               GeglBuffer          *buffer,
-                                               const GeglRectangle *rect,
-                                               gdouble              scale);
-static void             sub_preview_data_free (SubPreviewData      *data);
+static SubPreviewData    * sub_preview_data_new          (const Babl           *format,
+                                                          GeglBuffer           *buffer,
+                                                          const GeglRectangle  *rect,
+                                                          gdouble               scale);
+static void                sub_preview_data_free         (SubPreviewData       *data);
+static guint               sub_preview_data_hash         (const SubPreviewData *data);
+static gboolean            sub_preview_data_equal        (const SubPreviewData *data1,
+                                                          const SubPreviewData *data2);
+
+static void                preview_cache_trim            (const gchar          *dir);
+static gint                preview_cache_file_compare    (const PreviewCacheFile *file1,
+                                                          const PreviewCacheFile *file2);
+static PreviewCacheEntry * preview_cache_entry_new       (GimpDrawable         *drawable,
+                                                          SubPreviewData       *data);
+static void                preview_cache_entry_free      (PreviewCacheEntry    *entry);
+static GimpTempBuf       * preview_cache_entry_load      (PreviewCacheEntry    *entry,
+                                                          SubPreviewData       *data);
+static void                preview_cache_entry_save_func (GimpAsync            *async,
+                                                          PreviewCacheEntry    *entry);
+static gboolean            preview_cache_entry_idle      (PreviewCacheEntry    *entry);
+
+static void                preview_queue_add             (GimpDrawable         *drawable,
+                                                          SubPreviewData       *data,
+                                                          GimpAsync            *async);
+static void                preview_queue_worker_func     (GimpAsync            *async,
+                                                          gpointer              user_data);
+static void                preview_queue_async_cancel    (GimpAsync            *async);
+static void                preview_queue_async_waiting   (GimpAsync            *async);
+
+/*  local variables  */
+
+/*  previews of drawables whose buffers don't need validation are rendered
+ *  by a bounded number of workers, draining a shared queue.  new requests
+ *  are pushed to the head of the queue, since they come from views that
+ *  were just exposed, and identical pending requests are coalesced into a
+ *  single job.  the queue, the job table, and the async table are
+ *  protected by preview_queue_mutex.
+ */
+static GMutex      preview_queue_mutex;
+static GQueue      preview_queue     = G_QUEUE_INIT;
+static GHashTable *preview_jobs      = NULL;
+static GHashTable *preview_asyncs    = NULL;
+static gint        preview_n_workers = 0;
 
 
 
@@ -103,6 +180,567 @@ sub_preview_data_free (SubPreviewData *data)
   g_slice_free (SubPreviewData, data);
 }
 
+static guint
+sub_preview_data_hash (const SubPreviewData *data)
+{
+  guint hash;
+
+  hash = g_direct_hash (data->buffer) ^ g_direct_hash (data->format);
+
+  hash = hash * 31 + data->rect.x;
+  hash = hash * 31 + data->rect.y;
+  hash = hash * 31 + data->rect.width;
+  hash = hash * 31 + data->rect.height;
+
+  return hash;
+}
+
+static gboolean
+sub_preview_data_equal (const SubPreviewData *data1,
+                        const SubPreviewData *data2)
+{
+  return data1->buffer == data2->buffer                    &&
+         data1->format == data2->format                    &&
+         gegl_rectangle_equal (&data1->rect, &data2->rect) &&
+         data1->scale  == data2->scale;
+}
+
+/*  deletes the least recently used entries of the cache in 'dir' once
+ *  it grows too large.  loading an entry updates its access time.
+ */
+static void
+preview_cache_trim (const gchar *dir)
+{
+  GDir   *gdir;
+  GArray *files;
+  gint64  total = 0;
+  gint    i;
+
+  gdir = g_dir_open (dir, 0, NULL);
+
+  if (! gdir)
+    return;
+
+  files = g_array_new (FALSE, FALSE, sizeof (PreviewCacheFile));
+
+  while (TRUE)
+    {
+      const gchar      *name = g_dir_read_name (gdir);
+      PreviewCacheFile  file;
+      GStatBuf          st;
+
+      if (! name)
+        break;
+
+      file.path = g_build_filename (dir, name, NULL);
+
+      if (g_stat (file.path, &st) == 0 && S_ISREG (st.st_mode))
+        {
+          file.size  = st.st_size;
+          file.atime = MAX (st.st_atime, st.st_mtime);
+
+          total += file.size;
+
+          g_array_append_val (files, file);
+        }
+      else
+        {
+          g_free (file.path);
+        }
+    }
+
+  g_dir_close (gdir);
+
+  if (total > PREVIEW_CACHE_MAX_SIZE)
+    {
+      g_array_sort (files, (GCompareFunc) preview_cache_file_compare);
+
+      for (i = 0;
+           i < files->len && total > PREVIEW_CACHE_MAX_SIZE / 4 * 3;
+           i++)
+        {
+          PreviewCacheFile *file = &g_array_index (files, PreviewCacheFile, i);
+
+          if (g_unlink (file->path) == 0)
+            total -= file->size;
+        }
+    }
+
+  for (i = 0; i < files->len; i++)
+    g_free (g_array_index (files, PreviewCacheFile, i).path);
+
+  g_array_free (files, TRUE);
+}
+
+static gint
+preview_cache_file_compare (const PreviewCacheFile *file1,
+                            const PreviewCacheFile *file2)
+{
+  if (file1->atime < file2->atime)
+    return -1;
+  else if (file1->atime > file2->atime)
+    return 1;
+  else
+    return 0;
+}
+
+/*  previews are only cached for drawables of clean images that were
+ *  loaded from, or saved to, a file.  the drawable's content is then
+ *  identified by the file, its modification time as recorded when the
+ *  image was loaded or saved, and the drawable's tattoo, which together
+ *  key the cache entry, without having to read the drawable's data.
+ */
+static PreviewCacheEntry *
+preview_cache_entry_new (GimpDrawable   *drawable,
+                         SubPreviewData *data)
+{
+  static gint        no_drawable_preview_cache = -1;
+  GimpItem          *item                      = GIMP_ITEM (drawable);
+  GimpImage         *image                     = gimp_item_get_image (item);
+  PreviewCacheEntry *entry;
+  GFile             *file;
+  guint64            mtime;
+  gchar             *uri;
+  gchar             *key;
+  gchar             *checksum;
+
+  if (no_drawable_preview_cache < 0)
+    {
+      no_drawable_preview_cache =
+        (g_getenv ("GIMP_NO_DRAWABLE_PREVIEW_CACHE") != NULL);
+    }
+
+  if (no_drawable_preview_cache)
+    return NULL;
+
+  file = gimp_image_get_file (image);
+
+  if (! file                         ||
+      ! gimp_item_is_attached (item) ||
+      gimp_image_is_dirty (image))
+    {
+      return NULL;
+    }
+
+  /*  the file's mtime when the image's content last matched it.  the
+   *  file may have been changed by someone else since.
+   */
+  mtime = gimp_image_get_file_mtime (image);
+
+  if (! mtime)
+    return NULL;
+
+  uri = g_file_get_uri (file);
+  key = g_strdup_printf ("%s\n%" G_GUINT64_FORMAT "\n%u\n%d %d %d %d %.17g\n%s",
+                         uri, mtime, gimp_item_get_tattoo (item),
+                         data->rect.x, data->rect.y,
+                         data->rect.width, data->rect.height,
+                         data->scale,
+                         babl_format_get_encoding (data->format));
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA256, key, -1);
+
+  entry = g_slice_new0 (PreviewCacheEntry);
+
+  entry->image = g_object_ref (image);
+  entry->mtime = mtime;
+  entry->path  = g_build_filename (gimp_cache_directory (), "previews",
+                                   checksum, NULL);
+
+  g_free (checksum);
+  g_free (key);
+  g_free (uri);
+
+  return entry;
+}
+
+static void
+preview_cache_entry_free (PreviewCacheEntry *entry)
+{
+  g_clear_object (&entry->image);
+
+  g_clear_pointer (&entry->preview, gimp_temp_buf_unref);
+
+  g_free (entry->path);
+
+  g_slice_free (PreviewCacheEntry, entry);
+}
+
+static GimpTempBuf *
+preview_cache_entry_load (PreviewCacheEntry *entry,
+                          SubPreviewData    *data)
+{
+  GimpTempBuf *preview = NULL;
+  gchar       *contents;
+  gsize        length;
+  gsize        size;
+
+  if (! g_file_get_contents (entry->path, &contents, &length, NULL))
+    return NULL;
+
+  /*  keep recently used entries when trimming the cache  */
+  g_utime (entry->path, NULL);
+
+  size = (gsize) babl_format_get_bytes_per_pixel (data->format) *
+                 data->rect.width * data->rect.height;
+
+  if (length == PREVIEW_CACHE_HEADER_SIZE + size &&
+      ! memcmp (contents, PREVIEW_CACHE_MAGIC, 8))
+    {
+      guint32 width;
+      guint32 height;
+
+      memcpy (&width,  contents + 8,  4);
+      memcpy (&height, contents + 12, 4);
+
+      if (GUINT32_FROM_LE (width)  == data->rect.width &&
+          GUINT32_FROM_LE (height) == data->rect.height)
+        {
+          preview = gimp_temp_buf_new (data->rect.width, data->rect.height,
+                                       data->format);
+
+          memcpy (gimp_temp_buf_get_data (preview),
+                  contents + PREVIEW_CACHE_HEADER_SIZE, size);
+        }
+    }
+
+  g_free (contents);
+
+  return preview;
+}
+
+static void
+preview_cache_entry_save_func (GimpAsync         *async,
+                               PreviewCacheEntry *entry)
+{
+  static GMutex  trim_mutex;
+  static gint64  written = -1;
+  gchar         *dir;
+  gchar         *contents;
+  gsize          size;
+  guint32        width;
+  guint32        height;
+
+  dir = g_path_get_dirname (entry->path);
+
+  if (g_mkdir_with_parents (dir, 0700) == 0)
+    {
+      size = gimp_temp_buf_get_data_size (entry->preview);
+
+      width  = GUINT32_TO_LE (gimp_temp_buf_get_width  (entry->preview));
+      height = GUINT32_TO_LE (gimp_temp_buf_get_height (entry->preview));
+
+      contents = g_malloc (PREVIEW_CACHE_HEADER_SIZE + size);
+
+      memcpy (contents,      PREVIEW_CACHE_MAGIC, 8);
+      memcpy (contents + 8,  &width,              4);
+      memcpy (contents + 12, &height,             4);
+      memcpy (contents + PREVIEW_CACHE_HEADER_SIZE,
+              gimp_temp_buf_get_data (entry->preview), size);
+
+      if (g_file_set_contents (entry->path,
+                               contents, PREVIEW_CACHE_HEADER_SIZE + size,
+                               NULL))
+        {
+          /*  check the cache's size on the first save of the session,
+           *  and then whenever enough has been added to it
+           */
+          g_mutex_lock (&trim_mutex);
+
+          if (written >= 0)
+            written += PREVIEW_CACHE_HEADER_SIZE + size;
+
+          if (written < 0 || written >= PREVIEW_CACHE_MAX_SIZE / 16)
+            {
+              preview_cache_trim (dir);
+
+              written = 0;
+            }
+
+          g_mutex_unlock (&trim_mutex);
+        }
+
+      g_free (contents);
+    }
+
+  g_free (dir);
+
+  preview_cache_entry_free (entry);
+
+  gimp_async_finish (async, NULL);
+}
+
+/*  runs on the main thread once the job is done, storing its preview if
+ *  the image still matches its file, and releasing the image otherwise
+ */
+static gboolean
+preview_cache_entry_idle (PreviewCacheEntry *entry)
+{
+  if (entry->preview                       &&
+      ! gimp_image_is_dirty (entry->image) &&
+      gimp_image_get_file_mtime (entry->image) == entry->mtime)
+    {
+      GimpAsync *async;
+
+      g_clear_object (&entry->image);
+
+      async = gimp_parallel_run_async_full (
+        +1,
+        (GimpRunAsyncFunc) preview_cache_entry_save_func,
+        entry,
+        (GDestroyNotify) preview_cache_entry_free);
+
+      g_object_unref (async);
+    }
+  else
+    {
+      preview_cache_entry_free (entry);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+preview_queue_add (GimpDrawable   *drawable,
+                   SubPreviewData *data,
+                   GimpAsync      *async)
+{
+  GimpImage  *image = gimp_item_get_image (GIMP_ITEM (drawable));
+  PreviewJob *job;
+  gint        max_workers;
+  gboolean    new_worker = FALSE;
+
+  max_workers = MAX (GIMP_GEGL_CONFIG (image->gimp->config)->num_processors / 2,
+                     1);
+
+  g_signal_connect (async, "cancel",
+                    G_CALLBACK (preview_queue_async_cancel),
+                    NULL);
+  g_signal_connect (async, "waiting",
+                    G_CALLBACK (preview_queue_async_waiting),
+                    NULL);
+
+  g_mutex_lock (&preview_queue_mutex);
+
+  if (! preview_jobs)
+    {
+      preview_jobs   = g_hash_table_new ((GHashFunc)  sub_preview_data_hash,
+                                         (GEqualFunc) sub_preview_data_equal);
+      preview_asyncs = g_hash_table_new (NULL, NULL);
+    }
+
+  job = g_hash_table_lookup (preview_jobs, data);
+
+  if (job)
+    {
+      sub_preview_data_free (data);
+
+      g_queue_unlink         (&preview_queue, job->link);
+      g_queue_push_head_link (&preview_queue, job->link);
+    }
+  else
+    {
+      job = g_slice_new0 (PreviewJob);
+
+      job->data  = data;
+      job->cache = preview_cache_entry_new (drawable, data);
+
+      g_queue_push_head (&preview_queue, job);
+      job->link = g_queue_peek_head_link (&preview_queue);
+
+      g_hash_table_insert (preview_jobs, job->data, job);
+    }
+
+  job->asyncs = g_slist_prepend (job->asyncs, g_object_ref (async));
+
+  g_hash_table_insert (preview_asyncs, async, job);
+
+  if (preview_n_workers < max_workers)
+    {
+      preview_n_workers++;
+
+      new_worker = TRUE;
+    }
+
+  g_mutex_unlock (&preview_queue_mutex);
+
+  if (new_worker)
+    {
+      GimpAsync *worker;
+
+      worker = gimp_parallel_run_async_full (+1,
+                                             preview_queue_worker_func,
+                                             NULL, NULL);
+
+      g_object_unref (worker);
+    }
+}
+
+static void
+preview_queue_worker_func (GimpAsync *async,
+                           gpointer   user_data)
+{
+  g_mutex_lock (&preview_queue_mutex);
+
+  while (! g_queue_is_empty (&preview_queue) &&
+         ! gimp_async_is_canceled (async))
+    {
+      PreviewJob     *job  = g_queue_pop_head (&preview_queue);
+      SubPreviewData *data = job->data;
+      GimpTempBuf    *preview;
+      GSList         *asyncs;
+      GSList         *iter;
+
+      /*  requests arriving from now on might follow a change to the
+       *  drawable, and are therefore not coalesced into this job
+       */
+      job->link = NULL;
+
+      g_hash_table_remove (preview_jobs, data);
+
+      g_mutex_unlock (&preview_queue_mutex);
+
+      preview = NULL;
+
+      if (job->cache)
+        preview = preview_cache_entry_load (job->cache, data);
+
+      if (! preview)
+        {
+          preview = gimp_temp_buf_new (data->rect.width, data->rect.height,
+                                       data->format);
+
+          /*  downscaled reads are served from the buffer's mipmap levels,
+           *  which GEGL keeps up to date as the drawable changes
+           */
+          gegl_buffer_get (data->buffer, &data->rect, data->scale,
+                           gimp_temp_buf_get_format (preview),
+                           gimp_temp_buf_get_data (preview),
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_CLAMP);
+
+          if (job->cache)
+            job->cache->preview = gimp_temp_buf_ref (preview);
+        }
+
+      g_mutex_lock (&preview_queue_mutex);
+
+      asyncs      = job->asyncs;
+      job->asyncs = NULL;
+
+      for (iter = asyncs; iter; iter = g_slist_next (iter))
+        g_hash_table_remove (preview_asyncs, iter->data);
+
+      g_mutex_unlock (&preview_queue_mutex);
+
+      for (iter = asyncs; iter; iter = g_slist_next (iter))
+        {
+          gimp_async_finish_full (iter->data,
+                                  gimp_temp_buf_ref (preview),
+                                  (GDestroyNotify) gimp_temp_buf_unref);
+        }
+
+      if (job->cache)
+        {
+          /*  don't cache the preview if all its requests were canceled,
+           *  since the drawable might have changed in the meantime
+           */
+          if (! asyncs)
+            g_clear_pointer (&job->cache->preview, gimp_temp_buf_unref);
+
+          g_idle_add_full (GIMP_PRIORITY_VIEWABLE_IDLE,
+                           (GSourceFunc) preview_cache_entry_idle,
+                           job->cache, NULL);
+        }
+
+      g_slist_free_full (asyncs, g_object_unref);
+
+      gimp_temp_buf_unref (preview);
+
+      sub_preview_data_free (data);
+
+      g_slice_free (PreviewJob, job);
+
+      g_mutex_lock (&preview_queue_mutex);
+    }
+
+  preview_n_workers--;
+
+  g_mutex_unlock (&preview_queue_mutex);
+
+  gimp_async_finish (async, NULL);
+}
+
+static void
+preview_queue_async_cancel (GimpAsync *async)
+{
+  PreviewJob *job;
+  gboolean    stop  = FALSE;
+
+  g_mutex_lock (&preview_queue_mutex);
+
+  job = g_hash_table_lookup (preview_asyncs, async);
+
+  if (job)
+    {
+      g_hash_table_remove (preview_asyncs, async);
+
+      job->asyncs = g_slist_remove (job->asyncs, async);
+
+      if (! job->asyncs && job->link)
+        {
+          g_queue_delete_link (&preview_queue, job->link);
+
+          g_hash_table_remove (preview_jobs, job->data);
+        }
+      else
+        {
+          job = NULL;
+        }
+
+      stop = TRUE;
+    }
+
+  g_mutex_unlock (&preview_queue_mutex);
+
+  if (stop)
+    {
+      gimp_async_abort (async);
+
+      g_object_unref (async);
+    }
+
+  if (job)
+    {
+      if (job->cache)
+        preview_cache_entry_free (job->cache);
+
+      sub_preview_data_free (job->data);
+
+      g_slice_free (PreviewJob, job);
+    }
+}
+
+static void
+preview_queue_async_waiting (GimpAsync *async)
+{
+  PreviewJob *job;
+
+  g_mutex_lock (&preview_queue_mutex);
+
+  job = g_hash_table_lookup (preview_asyncs, async);
+
+  /*  the queue is never left pending without a worker, so moving the job
+   *  to the head of the queue is enough for it to be picked up next
+   */
+  if (job && job->link)
+    {
+      g_queue_unlink         (&preview_queue, job->link);
+      g_queue_push_head_link (&preview_queue, job->link);
+    }
+
+  g_mutex_unlock (&preview_queue_mutex);
+}
+
 
 /*  public functions  */
 
@@ -480,10 +1118,10 @@ gimp_drawable_get_sub_preview_async (GimpDrawable *drawable,
     }
   else
     {
-      return gimp_parallel_run_async_full (
-        +1,
-        (GimpRunAsyncFunc) gimp_drawable_get_sub_preview_async_func,
-        data,
-        (GDestroyNotify) sub_preview_data_free);
+      GimpAsync *async = gimp_async_new ();
+
+      preview_queue_add (drawable, data, async);
+
+      return async;
     }
 }
@@ -41,6 +41,14 @@ struct _GimpDrawablePrivate
   GeglBuffer       *paint_buffer;
   cairo_region_t   *paint_copy_region;
   cairo_region_t   *paint_update_region;
+
+  GimpAsync        *scale_async;
+  GeglBuffer       *scale_source;
+  gint              scale_width;
+  gint              scale_height;
+  GimpInterpolationType scale_interpolation;
+  GDestroyNotify    scale_done_func;
+  gpointer          scale_done_data;
 };
 
 #endif /* __GIMP_DRAWABLE_PRIVATE_H__ */
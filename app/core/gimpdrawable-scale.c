@@ -0,0 +1,256 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+#include <cairo.h>
+
+#include "core-types.h"
+
+#include "gimp-parallel.h"
+#include "gimpasync.h"
+#include "gimpdrawable.h"
+#include "gimpdrawable-private.h"
+#include "gimpdrawable-scale.h"
+#include "gimpwaitable.h"
+
+
+/*  a prepared scale computes the scaled contents of a drawable in the
+ *  background, ahead of the actual gimp_item_scale() call, so that
+ *  whole-image operations can scale many drawables concurrently.
+ *  gimp_drawable_scale() picks up the result if it matches the
+ *  requested size.
+ *
+ *  the optional done_func is called with done_data once the prepared
+ *  scale is consumed or canceled, whichever comes first.
+ */
+
+
+/*  the number of rows scaled between checks for cancellation  */
+#define SCALE_STRIP_HEIGHT 128
+
+
+typedef struct
+{
+  GeglBuffer            *src_buffer;
+  GeglBuffer            *dest_buffer;
+  GimpInterpolationType  interpolation_type;
+  gdouble                x_factor;
+  gdouble                y_factor;
+} ScaleData;
+
+
+/*  local function prototypes  */
+
+static void   gimp_drawable_prepare_scale_func (GimpAsync *async,
+                                                ScaleData *data);
+
+static void   scale_data_free                  (ScaleData *data);
+
+
+/*  public functions  */
+
+void
+gimp_drawable_prepare_scale (GimpDrawable          *drawable,
+                             gint                   new_width,
+                             gint                   new_height,
+                             GimpInterpolationType  interpolation_type,
+                             GDestroyNotify         done_func,
+                             gpointer               done_data)
+{
+  GimpDrawablePrivate *private;
+  ScaleData           *data;
+
+  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+  g_return_if_fail (new_width > 0 && new_height > 0);
+
+  private = drawable->private;
+
+  gimp_drawable_cancel_prepared_scale (drawable);
+
+  data = g_slice_new (ScaleData);
+
+  data->src_buffer         = g_object_ref (gimp_drawable_get_buffer (drawable));
+  data->dest_buffer        = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
+                                                              new_width,
+                                                              new_height),
+                                              gimp_drawable_get_format (drawable));
+  data->interpolation_type = interpolation_type;
+  data->x_factor           = ((gdouble) new_width /
+                              gimp_item_get_width  (GIMP_ITEM (drawable)));
+  data->y_factor           = ((gdouble) new_height /
+                              gimp_item_get_height (GIMP_ITEM (drawable)));
+
+  private->scale_source        = data->src_buffer;
+  private->scale_width         = new_width;
+  private->scale_height        = new_height;
+  private->scale_interpolation = interpolation_type;
+  private->scale_done_func     = done_func;
+  private->scale_done_data     = done_data;
+
+  private->scale_async = gimp_parallel_run_async_full (
+    0,
+    (GimpRunAsyncFunc) gimp_drawable_prepare_scale_func,
+    data,
+    (GDestroyNotify) scale_data_free);
+}
+
+gboolean
+gimp_drawable_has_prepared_scale (GimpDrawable *drawable)
+{
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), FALSE);
+
+  return drawable->private->scale_async != NULL;
+}
+
+/*  returns the prepared buffer if it matches the requested scale, and
+ *  NULL otherwise.  either way, the prepared scale is consumed.
+ */
+GeglBuffer *
+gimp_drawable_take_prepared_scale (GimpDrawable          *drawable,
+                                   gint                   new_width,
+                                   gint                   new_height,
+                                   GimpInterpolationType  interpolation_type)
+{
+  GimpDrawablePrivate *private;
+  GeglBuffer          *buffer = NULL;
+
+  g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
+
+  private = drawable->private;
+
+  if (! private->scale_async)
+    return NULL;
+
+  if (private->scale_source        == gimp_drawable_get_buffer (drawable) &&
+      private->scale_width         == new_width                          &&
+      private->scale_height        == new_height                         &&
+      private->scale_interpolation == interpolation_type)
+    {
+      gimp_waitable_wait (GIMP_WAITABLE (private->scale_async));
+
+      if (gimp_async_is_finished (private->scale_async))
+        buffer = g_object_ref (gimp_async_get_result (private->scale_async));
+    }
+
+  gimp_drawable_cancel_prepared_scale (drawable);
+
+  return buffer;
+}
+
+void
+gimp_drawable_cancel_prepared_scale (GimpDrawable *drawable)
+{
+  GimpDrawablePrivate *private;
+
+  g_return_if_fail (GIMP_IS_DRAWABLE (drawable));
+
+  private = drawable->private;
+
+  if (private->scale_async)
+    {
+      GDestroyNotify done_func = private->scale_done_func;
+      gpointer       done_data = private->scale_done_data;
+
+      gimp_async_cancel_and_wait (private->scale_async);
+      g_clear_object (&private->scale_async);
+
+      private->scale_source    = NULL;
+      private->scale_done_func = NULL;
+      private->scale_done_data = NULL;
+
+      /*  called last, so that done_func may prepare a new scale  */
+      if (done_func)
+        done_func (done_data);
+    }
+}
+
+
+/*  private functions  */
+
+static void
+gimp_drawable_prepare_scale_func (GimpAsync *async,
+                                  ScaleData *data)
+{
+  GeglBuffer *buffer = g_object_ref (data->dest_buffer);
+  gint        width  = gegl_buffer_get_width  (buffer);
+  gint        height = gegl_buffer_get_height (buffer);
+  GeglNode   *graph;
+  GeglNode   *source;
+  GeglNode   *scale;
+  gint        y;
+
+  /*  the same graph gimp_gegl_apply_scale() uses, rendered in strips,
+   *  so that gimp_drawable_cancel_prepared_scale() doesn't have to wait
+   *  for the whole drawable to be scaled
+   */
+  graph  = gegl_node_new ();
+
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    data->src_buffer,
+                                NULL);
+  scale  = gegl_node_new_child (graph,
+                                "operation",    "gegl:scale-ratio",
+                                "origin-x",     0.0,
+                                "origin-y",     0.0,
+                                "sampler",      data->interpolation_type,
+                                "abyss-policy", GEGL_ABYSS_CLAMP,
+                                "x",            data->x_factor,
+                                "y",            data->y_factor,
+                                NULL);
+
+  gegl_node_connect_to (source, "output",
+                        scale,  "input");
+
+  for (y = 0; y < height; y += SCALE_STRIP_HEIGHT)
+    {
+      GeglRectangle strip = { 0, y,
+                              width, MIN (SCALE_STRIP_HEIGHT, height - y) };
+
+      if (gimp_async_is_canceled (async))
+        break;
+
+      gegl_node_blit_buffer (scale, buffer, &strip, 0, GEGL_ABYSS_NONE);
+    }
+
+  g_object_unref (graph);
+
+  scale_data_free (data);
+
+  if (y < height)
+    {
+      g_object_unref (buffer);
+
+      gimp_async_abort (async);
+    }
+  else
+    {
+      gimp_async_finish_full (async, buffer, g_object_unref);
+    }
+}
+
+static void
+scale_data_free (ScaleData *data)
+{
+  g_object_unref (data->src_buffer);
+  g_object_unref (data->dest_buffer);
+
+  g_slice_free (ScaleData, data);
+}
@@ -0,0 +1,38 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpdrawable-scale.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_DRAWABLE_SCALE_H__
+#define __GIMP_DRAWABLE_SCALE_H__
+
+
+void         gimp_drawable_prepare_scale         (GimpDrawable          *drawable,
+                                                  gint                   new_width,
+                                                  gint                   new_height,
+                                                  GimpInterpolationType  interpolation_type,
+                                                  GDestroyNotify         done_func,
+                                                  gpointer               done_data);
+gboolean     gimp_drawable_has_prepared_scale    (GimpDrawable          *drawable);
+GeglBuffer * gimp_drawable_take_prepared_scale   (GimpDrawable          *drawable,
+                                                  gint                   new_width,
+                                                  gint                   new_height,
+                                                  GimpInterpolationType  interpolation_type);
+void         gimp_drawable_cancel_prepared_scale (GimpDrawable          *drawable);
+
+
+#endif /* __GIMP_DRAWABLE_SCALE_H__ */
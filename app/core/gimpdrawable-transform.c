@@ -31,6 +31,7 @@
 #include "core-types.h"
 
 #include "gegl/gimp-gegl-apply-operation.h"
+#include "gegl/gimp-gegl-loops.h"
 #include "gegl/gimp-gegl-utils.h"
 
 #include "gimp.h"
@@ -138,17 +139,14 @@ gimp_drawable_transform_buffer_flip (GimpDrawable         *drawable,
                                      gint                 *new_offset_x,
                                      gint                 *new_offset_y)
 {
-  const Babl         *format;
-  GeglBuffer         *new_buffer;
-  GeglBufferIterator *iter;
-  GeglRectangle       src_rect;
-  GeglRectangle       dest_rect;
-  gint                bpp;
-  gint                orig_x, orig_y;
-  gint                orig_width, orig_height;
-  gint                new_x, new_y;
-  gint                new_width, new_height;
-  gint                x, y;
+  const Babl    *format;
+  GeglBuffer    *new_buffer;
+  GeglRectangle  src_rect;
+  GeglRectangle  dest_rect;
+  gint           orig_x, orig_y;
+  gint           orig_width, orig_height;
+  gint           new_x, new_y;
+  gint           new_width, new_height;
 
   g_return_val_if_fail (GIMP_IS_DRAWABLE (drawable), NULL);
   g_return_val_if_fail (gimp_item_is_attached (GIMP_ITEM (drawable)), NULL);
@@ -189,7 +187,6 @@ gimp_drawable_transform_buffer_flip (GimpDrawable         *drawable,
     }
 
   format = gegl_buffer_get_format (orig_buffer);
-  bpp    = babl_format_get_bytes_per_pixel (format);
 
   new_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
                                                 new_width, new_height),
@@ -249,94 +246,19 @@ gimp_drawable_transform_buffer_flip (GimpDrawable         *drawable,
   if (new_width == 0 && new_height == 0)
     return new_buffer;
 
+  src_rect.x      = orig_x;
+  src_rect.y      = orig_y;
+  src_rect.width  = orig_width;
+  src_rect.height = orig_height;
+
   dest_rect.x      = new_x;
   dest_rect.y      = new_y;
   dest_rect.width  = new_width;
   dest_rect.height = new_height;
 
-  iter = gegl_buffer_iterator_new (new_buffer, &dest_rect, 0, NULL,
-                                   GEGL_BUFFER_WRITE, GEGL_ABYSS_NONE, 1);
-
-  switch (flip_type)
-    {
-    case GIMP_ORIENTATION_HORIZONTAL:
-      while (gegl_buffer_iterator_next (iter))
-        {
-          gint stride = iter->items[0].roi.width * bpp;
-
-          src_rect = iter->items[0].roi;
-
-          src_rect.x = (orig_x + orig_width)          -
-                       (iter->items[0].roi.x - dest_rect.x) -
-                       iter->items[0].roi.width;
-
-          gegl_buffer_get (orig_buffer, &src_rect, 1.0, NULL, iter->items[0].data,
-                           stride, GEGL_ABYSS_NONE);
-
-          for (y = 0; y < iter->items[0].roi.height; y++)
-            {
-              guint8 *left  = iter->items[0].data;
-              guint8 *right = iter->items[0].data;
-
-              left  += y * stride;
-              right += y * stride + (iter->items[0].roi.width - 1) * bpp;
-
-              for (x = 0; x < iter->items[0].roi.width / 2; x++)
-                {
-                  guint8 temp[bpp];
-
-                  memcpy (temp,  left,  bpp);
-                  memcpy (left,  right, bpp);
-                  memcpy (right, temp,  bpp);
-
-                  left  += bpp;
-                  right -= bpp;
-                }
-            }
-        }
-      break;
-
-    case GIMP_ORIENTATION_VERTICAL:
-      while (gegl_buffer_iterator_next (iter))
-        {
-          gint stride = iter->items[0].roi.width * bpp;
-
-          src_rect = iter->items[0].roi;
-
-          src_rect.y = (orig_y + orig_height)         -
-                       (iter->items[0].roi.y - dest_rect.y) -
-                       iter->items[0].roi.height;
-
-          gegl_buffer_get (orig_buffer, &src_rect, 1.0, NULL, iter->items[0].data,
-                           stride, GEGL_ABYSS_NONE);
-
-          for (x = 0; x < iter->items[0].roi.width; x++)
-            {
-              guint8 *top    = iter->items[0].data;
-              guint8 *bottom = iter->items[0].data;
-
-              top    += x * bpp;
-              bottom += x * bpp + (iter->items[0].roi.height - 1) * stride;
-
-              for (y = 0; y < iter->items[0].roi.height / 2; y++)
-                {
-                  guint8 temp[bpp];
-
-                  memcpy (temp,   top,    bpp);
-                  memcpy (top,    bottom, bpp);
-                  memcpy (bottom, temp,   bpp);
-
-                  top    += stride;
-                  bottom -= stride;
-                }
-            }
-        }
-      break;
-
-    case GIMP_ORIENTATION_UNKNOWN:
-      gegl_buffer_iterator_stop (iter);
-      break;
-    }
+  gimp_gegl_buffer_flip (orig_buffer, &src_rect,
+                         new_buffer, &dest_rect,
+                         flip_type);
 
   return new_buffer;
 }
@@ -397,7 +319,6 @@ gimp_drawable_transform_buffer_rotate (GimpDrawable      *drawable,
   GeglRectangle  dest_rect;
   gint           orig_x, orig_y;
   gint           orig_width, orig_height;
-  gint           orig_bpp;
   gint           new_x, new_y;
   gint           new_width, new_height;
 
@@ -416,7 +337,6 @@ gimp_drawable_transform_buffer_rotate (GimpDrawable      *drawable,
   orig_y      = orig_offset_y;
   orig_width  = gegl_buffer_get_width (orig_buffer);
   orig_height = gegl_buffer_get_height (orig_buffer);
-  orig_bpp    = babl_format_get_bytes_per_pixel (gegl_buffer_get_format (orig_buffer));
 
   switch (rotate_type)
     {
@@ -574,118 +494,9 @@ gimp_drawable_transform_buffer_rotate (GimpDrawable      *drawable,
   dest_rect.width  = new_width;
   dest_rect.height = new_height;
 
-  switch (rotate_type)
-    {
-    case GIMP_ROTATE_90:
-      {
-        guchar *buf = g_new (guchar, new_height * orig_bpp);
-        gint    i;
-
-        /* Not cool, we leak memory if we return, but anyway that is
-         * never supposed to happen. If we see this warning, a bug has
-         * to be fixed!
-         */
-        g_return_val_if_fail (new_height == orig_width, NULL);
-
-        src_rect.y      = orig_y + orig_height - 1;
-        src_rect.height = 1;
-
-        dest_rect.x     = new_x;
-        dest_rect.width = 1;
-
-        for (i = 0; i < orig_height; i++)
-          {
-            src_rect.y  = orig_y + orig_height - 1 - i;
-            dest_rect.x = new_x + i;
-
-            gegl_buffer_get (orig_buffer, &src_rect, 1.0, NULL, buf,
-                             GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-            gegl_buffer_set (new_buffer, &dest_rect, 0, NULL, buf,
-                             GEGL_AUTO_ROWSTRIDE);
-          }
-
-        g_free (buf);
-      }
-      break;
-
-    case GIMP_ROTATE_180:
-      {
-        guchar *buf = g_new (guchar, new_width * orig_bpp);
-        gint    i, j, k;
-
-        /* Not cool, we leak memory if we return, but anyway that is
-         * never supposed to happen. If we see this warning, a bug has
-         * to be fixed!
-         */
-        g_return_val_if_fail (new_width == orig_width, NULL);
-
-        src_rect.y      = orig_y + orig_height - 1;
-        src_rect.height = 1;
-
-        dest_rect.y      = new_y;
-        dest_rect.height = 1;
-
-        for (i = 0; i < orig_height; i++)
-          {
-            src_rect.y  = orig_y + orig_height - 1 - i;
-            dest_rect.y = new_y + i;
-
-            gegl_buffer_get (orig_buffer, &src_rect, 1.0, NULL, buf,
-                             GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-
-            for (j = 0; j < orig_width / 2; j++)
-              {
-                guchar *left  = buf + j * orig_bpp;
-                guchar *right = buf + (orig_width - 1 - j) * orig_bpp;
-
-                for (k = 0; k < orig_bpp; k++)
-                  {
-                    guchar tmp = left[k];
-                    left[k]    = right[k];
-                    right[k]   = tmp;
-                  }
-              }
-
-            gegl_buffer_set (new_buffer, &dest_rect, 0, NULL, buf,
-                             GEGL_AUTO_ROWSTRIDE);
-          }
-
-        g_free (buf);
-      }
-      break;
-
-    case GIMP_ROTATE_270:
-      {
-        guchar *buf = g_new (guchar, new_width * orig_bpp);
-        gint    i;
-
-        /* Not cool, we leak memory if we return, but anyway that is
-         * never supposed to happen. If we see this warning, a bug has
-         * to be fixed!
-         */
-        g_return_val_if_fail (new_width == orig_height, NULL);
-
-        src_rect.x     = orig_x + orig_width - 1;
-        src_rect.width = 1;
-
-        dest_rect.y      = new_y;
-        dest_rect.height = 1;
-
-        for (i = 0; i < orig_width; i++)
-          {
-            src_rect.x  = orig_x + orig_width - 1 - i;
-            dest_rect.y = new_y + i;
-
-            gegl_buffer_get (orig_buffer, &src_rect, 1.0, NULL, buf,
-                             GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
-            gegl_buffer_set (new_buffer, &dest_rect, 0, NULL, buf,
-                             GEGL_AUTO_ROWSTRIDE);
-          }
-
-        g_free (buf);
-      }
-      break;
-    }
+  gimp_gegl_buffer_rotate (orig_buffer, &src_rect,
+                           new_buffer, &dest_rect,
+                           rotate_type);
 
   return new_buffer;
 }
@@ -41,11 +41,14 @@
 #include "gimpdrawable-floating-selection.h"
 #include "gimpdrawable-preview.h"
 #include "gimpdrawable-private.h"
+#include "gimpdrawable-scale.h"
 #include "gimpdrawable-shadow.h"
 #include "gimpdrawable-transform.h"
+#include "gimpdrawableundo.h"
 #include "gimpfilterstack.h"
 #include "gimpimage.h"
 #include "gimpimage-colormap.h"
+#include "gimpimage-undo.h"
 #include "gimpimage-undo-push.h"
 #include "gimpmarshal.h"
 #include "gimppickable.h"
@@ -211,6 +214,12 @@ static GeglNode * gimp_drawable_real_get_source_node (GimpDrawable    *drawable)
 static void       gimp_drawable_format_changed     (GimpDrawable      *drawable);
 static void       gimp_drawable_alpha_changed      (GimpDrawable      *drawable);
 
+static cairo_region_t * gimp_drawable_get_changed_tiles
+                                                   (GimpDrawable      *drawable,
+                                                    GeglBuffer        *buffer,
+                                                    gint               x,
+                                                    gint               y);
+
 
 G_DEFINE_TYPE_WITH_CODE (GimpDrawable, gimp_drawable, GIMP_TYPE_ITEM,
                          G_ADD_PRIVATE (GimpDrawable)
@@ -352,6 +361,8 @@ gimp_drawable_dispose (GObject *object)
   if (gimp_drawable_get_floating_sel (drawable))
     gimp_drawable_detach_floating_sel (drawable);
 
+  gimp_drawable_cancel_prepared_scale (drawable);
+
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
@@ -537,18 +548,26 @@ gimp_drawable_scale (GimpItem              *item,
   GimpDrawable *drawable = GIMP_DRAWABLE (item);
   GeglBuffer   *new_buffer;
 
-  new_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
-                                                new_width, new_height),
-                                gimp_drawable_get_format (drawable));
+  /*  use the result of gimp_drawable_prepare_scale(), if any  */
+  new_buffer = gimp_drawable_take_prepared_scale (drawable,
+                                                  new_width, new_height,
+                                                  interpolation_type);
 
-  gimp_gegl_apply_scale (gimp_drawable_get_buffer (drawable),
-                         progress, C_("undo-type", "Scale"),
-                         new_buffer,
-                         interpolation_type,
-                         ((gdouble) new_width /
-                          gimp_item_get_width  (item)),
-                         ((gdouble) new_height /
-                          gimp_item_get_height (item)));
+  if (! new_buffer)
+    {
+      new_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0,
+                                                    new_width, new_height),
+                                    gimp_drawable_get_format (drawable));
+
+      gimp_gegl_apply_scale (gimp_drawable_get_buffer (drawable),
+                             progress, C_("undo-type", "Scale"),
+                             new_buffer,
+                             interpolation_type,
+                             ((gdouble) new_width /
+                              gimp_item_get_width  (item)),
+                             ((gdouble) new_height /
+                              gimp_item_get_height (item)));
+    }
 
   gimp_drawable_set_buffer_full (drawable, gimp_item_is_attached (item), NULL,
                                  new_buffer,
@@ -950,7 +969,8 @@ gimp_drawable_real_push_undo (GimpDrawable *drawable,
                               gint          width,
                               gint          height)
 {
-  GimpImage *image;
+  GimpImage      *image;
+  cairo_region_t *region = NULL;
 
   if (! buffer)
     {
@@ -979,16 +999,91 @@ gimp_drawable_real_push_undo (GimpDrawable *drawable,
     }
   else
     {
-      g_object_ref (buffer);
+      /*  the operation has already been applied, so only keep the
+       *  tiles it actually changed
+       */
+      region = gimp_drawable_get_changed_tiles (drawable, buffer, x, y);
+
+      if (region)
+        {
+          GeglBuffer *drawable_buffer = gimp_drawable_get_buffer (drawable);
+          GeglBuffer *sparse_buffer;
+          gint        n_rects         = cairo_region_num_rectangles (region);
+          gint        shift_x;
+          gint        shift_y;
+          gint        tile_width;
+          gint        tile_height;
+          gint        i;
+
+          g_object_get (drawable_buffer,
+                        "shift-x",     &shift_x,
+                        "shift-y",     &shift_y,
+                        "tile-width",  &tile_width,
+                        "tile-height", &tile_height,
+                        NULL);
+
+          /*  put the sparse buffer's tiles on the drawable's tile grid,
+           *  which is the grid the region's rectangles are aligned to,
+           *  so that the unchanged tiles are never allocated
+           */
+          sparse_buffer = g_object_new (GEGL_TYPE_BUFFER,
+                                        "format",      gegl_buffer_get_format (buffer),
+                                        "x",           0,
+                                        "y",           0,
+                                        "width",       gegl_buffer_get_width  (buffer),
+                                        "height",      gegl_buffer_get_height (buffer),
+                                        "shift-x",     x + shift_x,
+                                        "shift-y",     y + shift_y,
+                                        "tile-width",  tile_width,
+                                        "tile-height", tile_height,
+                                        NULL);
+
+          for (i = 0; i < n_rects; i++)
+            {
+              cairo_rectangle_int_t rect;
+
+              cairo_region_get_rectangle (region, i, &rect);
+
+              gimp_gegl_buffer_copy (buffer,
+                                     (const GeglRectangle *) &rect,
+                                     GEGL_ABYSS_NONE,
+                                     sparse_buffer,
+                                     (const GeglRectangle *) &rect);
+            }
+
+          buffer = sparse_buffer;
+        }
+      else
+        {
+          g_object_ref (buffer);
+        }
     }
 
   image = gimp_item_get_image (GIMP_ITEM (drawable));
 
-  gimp_image_undo_push_drawable (image,
-                                 undo_desc, drawable,
-                                 buffer, x, y);
+  if (region)
+    {
+      gimp_image_undo_push (image, GIMP_TYPE_DRAWABLE_UNDO,
+                            GIMP_UNDO_DRAWABLE, undo_desc,
+                            GIMP_DIRTY_ITEM | GIMP_DIRTY_DRAWABLE,
+                            "item",   drawable,
+                            "buffer", buffer,
+                            "region", region,
+                            "x",      x,
+                            "y",      y,
+                            NULL);
+    }
+  else
+    {
+      gimp_image_undo_push_drawable (image,
+                                     undo_desc, drawable,
+                                     buffer, x, y);
+    }
 
   g_object_unref (buffer);
+
+  if (region)
+    cairo_region_destroy (region);
 }
 
 static void
@@ -1043,6 +1138,108 @@ gimp_drawable_alpha_changed (GimpDrawable *drawable)
   g_signal_emit (drawable, gimp_drawable_signals[ALPHA_CHANGED], 0);
 }
 
+/*  compares the pre-operation contents in buffer, located at (x, y),
+ *  against the current drawable contents, tile by tile.  returns the
+ *  region of changed tiles, in buffer coordinates, or NULL if all
+ *  tiles changed, or if the buffers can't be compared.
+ */
+static cairo_region_t *
+gimp_drawable_get_changed_tiles (GimpDrawable *drawable,
+                                 GeglBuffer   *buffer,
+                                 gint          x,
+                                 gint          y)
+{
+  GeglBuffer     *drawable_buffer = gimp_drawable_get_buffer (drawable);
+  const Babl     *format          = gegl_buffer_get_format (buffer);
+  gint            bpp             = babl_format_get_bytes_per_pixel (format);
+  gint            width           = gegl_buffer_get_width  (buffer);
+  gint            height          = gegl_buffer_get_height (buffer);
+  cairo_region_t *region;
+  guchar         *old_data;
+  guchar         *new_data;
+  gint            shift_x;
+  gint            shift_y;
+  gint            tile_width;
+  gint            tile_height;
+  gint            n_tiles         = 0;
+  gint            n_changed       = 0;
+  gint            tx, ty;
+
+  if (format != gegl_buffer_get_format (drawable_buffer) ||
+      gegl_buffer_get_x (buffer) != 0                     ||
+      gegl_buffer_get_y (buffer) != 0)
+    {
+      return NULL;
+    }
+
+  g_object_get (drawable_buffer,
+                "shift-x",     &shift_x,
+                "shift-y",     &shift_y,
+                "tile-width",  &tile_width,
+                "tile-height", &tile_height,
+                NULL);
+
+  /*  the drawable's tile grid, in buffer coordinates  */
+  shift_x = (x + shift_x) % tile_width;
+  shift_y = (y + shift_y) % tile_height;
+
+  if (shift_x < 0) shift_x += tile_width;
+  if (shift_y < 0) shift_y += tile_height;
+
+  region = cairo_region_create ();
+
+  old_data = gegl_scratch_new (guchar, tile_width * tile_height * bpp);
+  new_data = gegl_scratch_new (guchar, tile_width * tile_height * bpp);
+
+  /*  step along the drawable's tile grid, which is also the grid of the
+   *  sparse buffer gimp_drawable_real_push_undo() keeps the changed
+   *  tiles in, so that each rectangle of the region covers whole tiles
+   *  of that buffer, except at its edges
+   */
+  for (ty = -shift_y; ty < height; ty += tile_height)
+    {
+      for (tx = -shift_x; tx < width; tx += tile_width)
+        {
+          cairo_rectangle_int_t rect;
+          gsize                 size;
+
+          gimp_rectangle_intersect (tx, ty, tile_width, tile_height,
+                                    0, 0, width, height,
+                                    &rect.x, &rect.y,
+                                    &rect.width, &rect.height);
+
+          size = (gsize) rect.width * rect.height * bpp;
+
+          gegl_buffer_get (buffer,
+                           (const GeglRectangle *) &rect, 1.0,
+                           format, old_data,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+          gegl_buffer_get (drawable_buffer,
+                           GEGL_RECTANGLE (x + rect.x, y + rect.y,
+                                           rect.width, rect.height), 1.0,
+                           format, new_data,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+          n_tiles++;
+
+          if (memcmp (old_data, new_data, size))
+            {
+              cairo_region_union_rectangle (region, &rect);
+
+              n_changed++;
+            }
+        }
+    }
+
+  gegl_scratch_free (new_data);
+  gegl_scratch_free (old_data);
+
+  if (n_changed == n_tiles)
+    g_clear_pointer (&region, cairo_region_destroy);
+
+  return region;
+}
+
 
 /*  public functions  */
 
@@ -40,6 +40,8 @@
 #include "gegl/gimpapplicator.h"
 #include "gegl/gimp-gegl-utils.h"
 
+#include "operations/gimpoperationpointfilter.h"
+
 #include "gimpchannel.h"
 #include "gimpdrawable-filters.h"
 #include "gimpdrawablefilter.h"
@@ -115,6 +117,7 @@ static void       gimp_drawable_filter_sync_affect           (GimpDrawableFilter
 static void       gimp_drawable_filter_sync_format           (GimpDrawableFilter  *filter);
 static void       gimp_drawable_filter_sync_mask             (GimpDrawableFilter  *filter);
 static void       gimp_drawable_filter_sync_gamma_hack       (GimpDrawableFilter  *filter);
+static void       gimp_drawable_filter_sync_point_filter     (GimpDrawableFilter  *filter);
 
 static gboolean   gimp_drawable_filter_is_added              (GimpDrawableFilter  *filter);
 static gboolean   gimp_drawable_filter_is_active             (GimpDrawableFilter  *filter);
@@ -628,6 +631,8 @@ static void
 gimp_drawable_filter_sync_active (GimpDrawableFilter *filter)
 {
   gimp_applicator_set_active (filter->applicator, filter->preview_enabled);
+
+  gimp_drawable_filter_sync_point_filter (filter);
 }
 
 static void
@@ -839,6 +844,8 @@ gimp_drawable_filter_sync_crop (GimpDrawableFilter  *filter,
 
   gimp_applicator_set_crop (filter->applicator, enabled ? &new_rect : NULL);
 
+  gimp_drawable_filter_sync_point_filter (filter);
+
   if (update                                     &&
       gimp_drawable_filter_is_active (filter) &&
       ! gegl_rectangle_equal (&old_rect, &new_rect))
@@ -861,6 +868,8 @@ gimp_drawable_filter_sync_opacity (GimpDrawableFilter *filter)
 {
   gimp_applicator_set_opacity (filter->applicator,
                                filter->opacity);
+
+  gimp_drawable_filter_sync_point_filter (filter);
 }
 
 static void
@@ -882,6 +891,8 @@ gimp_drawable_filter_sync_mode (GimpDrawableFilter *filter)
                             filter->blend_space,
                             filter->composite_space,
                             filter->composite_mode);
+
+  gimp_drawable_filter_sync_point_filter (filter);
 }
 
 static void
@@ -897,6 +908,8 @@ gimp_drawable_filter_sync_affect (GimpDrawableFilter *filter)
       GIMP_COMPONENT_MASK_ALPHA :
 
       gimp_drawable_get_active_mask (filter->drawable));
+
+  gimp_drawable_filter_sync_point_filter (filter);
 }
 
 static void
@@ -916,6 +929,8 @@ gimp_drawable_filter_sync_format (GimpDrawableFilter *filter)
     }
 
   gimp_applicator_set_output_format (filter->applicator, format);
+
+  gimp_drawable_filter_sync_point_filter (filter);
 }
 
 static void
@@ -947,6 +962,8 @@ gimp_drawable_filter_sync_mask (GimpDrawableFilter *filter)
                             &filter->filter_area.y,
                             &filter->filter_area.width,
                             &filter->filter_area.height);
+
+  gimp_drawable_filter_sync_point_filter (filter);
 }
 
 static void
@@ -1003,6 +1020,41 @@ gimp_drawable_filter_sync_gamma_hack (GimpDrawableFilter *filter)
                      "operation", "gegl:nop",
                      NULL);
     }
+
+  gimp_drawable_filter_sync_point_filter (filter);
+}
+
+/*  if the filter amounts to applying a GIMP point filter to the whole
+ *  drawable, let the filter stack fuse it with its neighbors
+ */
+static void
+gimp_drawable_filter_sync_point_filter (GimpDrawableFilter *filter)
+{
+  GimpImage     *image;
+  GeglOperation *operation;
+  GeglNode      *point_filter = NULL;
+
+  image     = gimp_item_get_image (GIMP_ITEM (filter->drawable));
+  operation = gegl_node_get_gegl_operation (filter->operation);
+
+  if (filter->has_input                                &&
+      GIMP_IS_OPERATION_POINT_FILTER (operation)       &&
+      filter->preview_enabled                          &&
+      ! filter->preview_split_enabled                  &&
+      ! filter->crop_enabled                           &&
+      filter->opacity    == GIMP_OPACITY_OPAQUE        &&
+      filter->paint_mode == GIMP_LAYER_MODE_REPLACE    &&
+      ! filter->add_alpha                              &&
+      ! filter->gamma_hack                             &&
+      (filter->override_constraints ||
+       gimp_drawable_get_active_mask (filter->drawable) ==
+       GIMP_COMPONENT_MASK_ALL)                        &&
+      gimp_channel_is_empty (gimp_image_get_mask (image)))
+    {
+      point_filter = filter->operation;
+    }
+
+  gimp_filter_set_point_filter (GIMP_FILTER (filter), point_filter);
 }
 
 static gboolean
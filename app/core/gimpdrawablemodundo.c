@@ -17,6 +17,7 @@
 
 #include "config.h"
 
+#include <cairo.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
@@ -30,6 +31,7 @@
 #include "gimpimage.h"
 #include "gimpdrawable.h"
 #include "gimpdrawablemodundo.h"
+#include "gimpspilledbuffer.h"
 
 
 enum
@@ -39,24 +41,33 @@ enum
 };
 
 
-static void     gimp_drawable_mod_undo_constructed  (GObject             *object);
-static void     gimp_drawable_mod_undo_set_property (GObject             *object,
-                                                     guint                property_id,
-                                                     const GValue        *value,
-                                                     GParamSpec          *pspec);
-static void     gimp_drawable_mod_undo_get_property (GObject             *object,
-                                                     guint                property_id,
-                                                     GValue              *value,
-                                                     GParamSpec          *pspec);
+static void     gimp_drawable_mod_undo_constructed      (GObject             *object);
+static void     gimp_drawable_mod_undo_set_property     (GObject             *object,
+                                                         guint                property_id,
+                                                         const GValue        *value,
+                                                         GParamSpec          *pspec);
+static void     gimp_drawable_mod_undo_get_property     (GObject             *object,
+                                                         guint                property_id,
+                                                         GValue              *value,
+                                                         GParamSpec          *pspec);
 
-static gint64   gimp_drawable_mod_undo_get_memsize  (GimpObject          *object,
-                                                     gint64              *gui_size);
+static gint64   gimp_drawable_mod_undo_get_memsize      (GimpObject          *object,
+                                                         gint64              *gui_size);
 
-static void     gimp_drawable_mod_undo_pop          (GimpUndo            *undo,
-                                                     GimpUndoMode         undo_mode,
-                                                     GimpUndoAccumulator *accum);
-static void     gimp_drawable_mod_undo_free         (GimpUndo            *undo,
-                                                     GimpUndoMode         undo_mode);
+static void     gimp_drawable_mod_undo_pop              (GimpUndo            *undo,
+                                                         GimpUndoMode         undo_mode,
+                                                         GimpUndoAccumulator *accum);
+static void     gimp_drawable_mod_undo_free             (GimpUndo            *undo,
+                                                         GimpUndoMode         undo_mode);
+static gint64   gimp_drawable_mod_undo_spill            (GimpUndo            *undo);
+static void     gimp_drawable_mod_undo_prefetch         (GimpUndo            *undo);
+static gboolean gimp_drawable_mod_undo_unspill          (GimpUndo            *undo,
+                                                         GError             **error);
+static gint64   gimp_drawable_mod_undo_get_spilled_size (GimpUndo            *undo,
+                                                         gint64              *pending_size);
+
+static void     gimp_drawable_mod_undo_spilled          (GimpSpilledBuffer   *spilled,
+                                                         GimpUndo            *undo);
 
 
 G_DEFINE_TYPE (GimpDrawableModUndo, gimp_drawable_mod_undo, GIMP_TYPE_ITEM_UNDO)
@@ -79,6 +90,10 @@ gimp_drawable_mod_undo_class_init (GimpDrawableModUndoClass *klass)
 
   undo_class->pop                = gimp_drawable_mod_undo_pop;
   undo_class->free               = gimp_drawable_mod_undo_free;
+  undo_class->spill              = gimp_drawable_mod_undo_spill;
+  undo_class->prefetch           = gimp_drawable_mod_undo_prefetch;
+  undo_class->unspill            = gimp_drawable_mod_undo_unspill;
+  undo_class->get_spilled_size   = gimp_drawable_mod_undo_get_spilled_size;
 
   g_object_class_install_property (object_class, PROP_COPY_BUFFER,
                                    g_param_spec_boolean ("copy-buffer",
@@ -171,6 +186,8 @@ gimp_drawable_mod_undo_get_memsize (GimpObject *object,
   gint64               memsize           = 0;
 
   memsize += gimp_gegl_buffer_get_memsize (drawable_mod_undo->buffer);
+  memsize += gimp_spilled_buffer_get_memsize (drawable_mod_undo->spilled,
+                                              NULL, NULL);
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -186,6 +203,18 @@ gimp_drawable_mod_undo_pop (GimpUndo            *undo,
   GeglBuffer          *buffer;
   gint                 offset_x;
   gint                 offset_y;
+  GError              *error             = NULL;
+
+  /*  gimp_image_undo_pop_stack() unspills undo steps before popping
+   *  them, and refuses to pop them if that fails
+   */
+  if (! gimp_drawable_mod_undo_unspill (undo, &error))
+    {
+      g_warning ("%s: %s", G_STRFUNC, error->message);
+      g_clear_error (&error);
+
+      return;
+    }
 
   GIMP_UNDO_CLASS (parent_class)->pop (undo, undo_mode, accum);
 
@@ -213,6 +242,78 @@ gimp_drawable_mod_undo_free (GimpUndo     *undo,
   GimpDrawableModUndo *drawable_mod_undo = GIMP_DRAWABLE_MOD_UNDO (undo);
 
   g_clear_object (&drawable_mod_undo->buffer);
+  g_clear_pointer (&drawable_mod_undo->spilled, gimp_spilled_buffer_free);
 
   GIMP_UNDO_CLASS (parent_class)->free (undo, undo_mode);
 }
+
+static gint64
+gimp_drawable_mod_undo_spill (GimpUndo *undo)
+{
+  GimpDrawableModUndo *drawable_mod_undo = GIMP_DRAWABLE_MOD_UNDO (undo);
+  gint64               size;
+
+  if (! drawable_mod_undo->buffer)
+    return 0;
+
+  size = gimp_gegl_buffer_get_memsize (drawable_mod_undo->buffer);
+
+  drawable_mod_undo->spilled = gimp_spilled_buffer_new (
+    undo->image->gimp,
+    drawable_mod_undo->buffer, NULL, size,
+    (GimpSpilledBufferCallback) gimp_drawable_mod_undo_spilled,
+    undo);
+  g_clear_object (&drawable_mod_undo->buffer);
+
+  return size;
+}
+
+static void
+gimp_drawable_mod_undo_prefetch (GimpUndo *undo)
+{
+  GimpDrawableModUndo *drawable_mod_undo = GIMP_DRAWABLE_MOD_UNDO (undo);
+
+  if (drawable_mod_undo->spilled)
+    gimp_spilled_buffer_prefetch (drawable_mod_undo->spilled);
+}
+
+static gboolean
+gimp_drawable_mod_undo_unspill (GimpUndo  *undo,
+                                GError   **error)
+{
+  GimpDrawableModUndo *drawable_mod_undo = GIMP_DRAWABLE_MOD_UNDO (undo);
+
+  if (drawable_mod_undo->spilled)
+    {
+      /*  on failure, keep the spilled buffer for another attempt  */
+      drawable_mod_undo->buffer =
+        gimp_spilled_buffer_restore (drawable_mod_undo->spilled, error);
+
+      if (! drawable_mod_undo->buffer)
+        return FALSE;
+
+      g_clear_pointer (&drawable_mod_undo->spilled, gimp_spilled_buffer_free);
+    }
+
+  return TRUE;
+}
+
+static gint64
+gimp_drawable_mod_undo_get_spilled_size (GimpUndo *undo,
+                                         gint64   *pending_size)
+{
+  GimpDrawableModUndo *drawable_mod_undo = GIMP_DRAWABLE_MOD_UNDO (undo);
+  gint64               spilled_size;
+
+  gimp_spilled_buffer_get_memsize (drawable_mod_undo->spilled,
+                                   &spilled_size, pending_size);
+
+  return spilled_size;
+}
+
+static void
+gimp_drawable_mod_undo_spilled (GimpSpilledBuffer *spilled,
+                                GimpUndo          *undo)
+{
+  gimp_image_undo_event (undo->image, GIMP_UNDO_EVENT_UNDO_SPILLED, undo);
+}
@@ -37,10 +37,11 @@ struct _GimpDrawableModUndo
 {
   GimpItemUndo   parent_instance;
 
-  GeglBuffer    *buffer;
-  gboolean       copy_buffer;
-  gint           offset_x;
-  gint           offset_y;
+  GeglBuffer        *buffer;
+  GimpSpilledBuffer *spilled;
+  gboolean           copy_buffer;
+  gint               offset_x;
+  gint               offset_y;
 };
 
 struct _GimpDrawableModUndoClass
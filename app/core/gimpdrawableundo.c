@@ -17,6 +17,7 @@
 
 #include "config.h"
 
+#include <cairo.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
@@ -28,6 +29,7 @@
 #include "gimpimage.h"
 #include "gimpdrawable.h"
 #include "gimpdrawableundo.h"
+#include "gimpspilledbuffer.h"
 
 
 enum
@@ -35,28 +37,39 @@ enum
   PROP_0,
   PROP_BUFFER,
   PROP_X,
-  PROP_Y
+  PROP_Y,
+  PROP_REGION
 };
 
 
-static void     gimp_drawable_undo_constructed  (GObject             *object);
-static void     gimp_drawable_undo_set_property (GObject             *object,
-                                                 guint                property_id,
-                                                 const GValue        *value,
-                                                 GParamSpec          *pspec);
-static void     gimp_drawable_undo_get_property (GObject             *object,
-                                                 guint                property_id,
-                                                 GValue              *value,
-                                                 GParamSpec          *pspec);
-
-static gint64   gimp_drawable_undo_get_memsize  (GimpObject          *object,
-                                                 gint64              *gui_size);
-
-static void     gimp_drawable_undo_pop          (GimpUndo            *undo,
-                                                 GimpUndoMode         undo_mode,
-                                                 GimpUndoAccumulator *accum);
-static void     gimp_drawable_undo_free         (GimpUndo            *undo,
-                                                 GimpUndoMode         undo_mode);
+static void     gimp_drawable_undo_constructed      (GObject             *object);
+static void     gimp_drawable_undo_set_property     (GObject             *object,
+                                                     guint                property_id,
+                                                     const GValue        *value,
+                                                     GParamSpec          *pspec);
+static void     gimp_drawable_undo_get_property     (GObject             *object,
+                                                     guint                property_id,
+                                                     GValue              *value,
+                                                     GParamSpec          *pspec);
+
+static gint64   gimp_drawable_undo_get_memsize      (GimpObject          *object,
+                                                     gint64              *gui_size);
+
+static void     gimp_drawable_undo_pop              (GimpUndo            *undo,
+                                                     GimpUndoMode         undo_mode,
+                                                     GimpUndoAccumulator *accum);
+static void     gimp_drawable_undo_free             (GimpUndo            *undo,
+                                                     GimpUndoMode         undo_mode);
+static gint64   gimp_drawable_undo_spill            (GimpUndo            *undo);
+static void     gimp_drawable_undo_prefetch         (GimpUndo            *undo);
+static gboolean gimp_drawable_undo_unspill          (GimpUndo            *undo,
+                                                     GError             **error);
+static gint64   gimp_drawable_undo_get_spilled_size (GimpUndo            *undo,
+                                                     gint64              *pending_size);
+
+static gint64   gimp_drawable_undo_get_buffer_size  (GimpDrawableUndo    *drawable_undo);
+static void     gimp_drawable_undo_spilled          (GimpSpilledBuffer   *spilled,
+                                                     GimpUndo            *undo);
 
 
 G_DEFINE_TYPE (GimpDrawableUndo, gimp_drawable_undo, GIMP_TYPE_ITEM_UNDO)
@@ -79,6 +92,10 @@ gimp_drawable_undo_class_init (GimpDrawableUndoClass *klass)
 
   undo_class->pop                = gimp_drawable_undo_pop;
   undo_class->free               = gimp_drawable_undo_free;
+  undo_class->spill              = gimp_drawable_undo_spill;
+  undo_class->prefetch           = gimp_drawable_undo_prefetch;
+  undo_class->unspill            = gimp_drawable_undo_unspill;
+  undo_class->get_spilled_size   = gimp_drawable_undo_get_spilled_size;
 
   g_object_class_install_property (object_class, PROP_BUFFER,
                                    g_param_spec_object ("buffer", NULL, NULL,
@@ -97,6 +114,11 @@ gimp_drawable_undo_class_init (GimpDrawableUndoClass *klass)
                                                      0, GIMP_MAX_IMAGE_SIZE, 0,
                                                      GIMP_PARAM_READWRITE |
                                                      G_PARAM_CONSTRUCT_ONLY));
+
+  g_object_class_install_property (object_class, PROP_REGION,
+                                   g_param_spec_pointer ("region", NULL, NULL,
+                                                         GIMP_PARAM_READWRITE |
+                                                         G_PARAM_CONSTRUCT_ONLY));
 }
 
 static void
@@ -134,6 +156,14 @@ gimp_drawable_undo_set_property (GObject      *object,
     case PROP_Y:
       drawable_undo->y = g_value_get_int (value);
       break;
+    case PROP_REGION:
+      {
+        cairo_region_t *region = g_value_get_pointer (value);
+
+        if (region)
+          drawable_undo->region = cairo_region_copy (region);
+      }
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -152,6 +182,7 @@ gimp_drawable_undo_get_property (GObject    *object,
   switch (property_id)
     {
     case PROP_BUFFER:
+      gimp_drawable_undo_unspill (GIMP_UNDO (drawable_undo), NULL);
       g_value_set_object (value, drawable_undo->buffer);
       break;
     case PROP_X:
@@ -160,6 +191,9 @@ gimp_drawable_undo_get_property (GObject    *object,
     case PROP_Y:
       g_value_set_int (value, drawable_undo->y);
       break;
+    case PROP_REGION:
+      g_value_set_pointer (value, drawable_undo->region);
+      break;
 
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -174,7 +208,9 @@ gimp_drawable_undo_get_memsize (GimpObject *object,
   GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (object);
   gint64            memsize       = 0;
 
-  memsize += gimp_gegl_buffer_get_memsize (drawable_undo->buffer);
+  memsize += gimp_drawable_undo_get_buffer_size (drawable_undo);
+  memsize += gimp_spilled_buffer_get_memsize (drawable_undo->spilled,
+                                              NULL, NULL);
 
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
@@ -186,13 +222,59 @@ gimp_drawable_undo_pop (GimpUndo            *undo,
                         GimpUndoAccumulator *accum)
 {
   GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
+  GError           *error         = NULL;
+
+  /*  gimp_image_undo_pop_stack() unspills undo steps before popping
+   *  them, and refuses to pop them if that fails
+   */
+  if (! gimp_drawable_undo_unspill (undo, &error))
+    {
+      g_warning ("%s: %s", G_STRFUNC, error->message);
+      g_clear_error (&error);
+
+      return;
+    }
 
   GIMP_UNDO_CLASS (parent_class)->pop (undo, undo_mode, accum);
 
-  gimp_drawable_swap_pixels (GIMP_DRAWABLE (GIMP_ITEM_UNDO (undo)->item),
-                             drawable_undo->buffer,
-                             drawable_undo->x,
-                             drawable_undo->y);
+  if (drawable_undo->region)
+    {
+      gint n_rects = cairo_region_num_rectangles (drawable_undo->region);
+      gint i;
+
+      /*  only swap the tiles that were actually changed  */
+      for (i = 0; i < n_rects; i++)
+        {
+          cairo_rectangle_int_t  rect;
+          GeglBuffer            *sub_buffer;
+
+          cairo_region_get_rectangle (drawable_undo->region, i, &rect);
+
+          sub_buffer = g_object_new (GEGL_TYPE_BUFFER,
+                                     "source",  drawable_undo->buffer,
+                                     "x",       0,
+                                     "y",       0,
+                                     "width",   rect.width,
+                                     "height",  rect.height,
+                                     "shift-x", rect.x,
+                                     "shift-y", rect.y,
+                                     NULL);
+
+          gimp_drawable_swap_pixels (GIMP_DRAWABLE (GIMP_ITEM_UNDO (undo)->item),
+                                     sub_buffer,
+                                     drawable_undo->x + rect.x,
+                                     drawable_undo->y + rect.y);
+
+          g_object_unref (sub_buffer);
+        }
+    }
+  else
+    {
+      gimp_drawable_swap_pixels (GIMP_DRAWABLE (GIMP_ITEM_UNDO (undo)->item),
+                                 drawable_undo->buffer,
+                                 drawable_undo->x,
+                                 drawable_undo->y);
+    }
 }
 
 static void
@@ -202,6 +284,124 @@ gimp_drawable_undo_free (GimpUndo     *undo,
   GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
 
   g_clear_object (&drawable_undo->buffer);
+  g_clear_pointer (&drawable_undo->spilled, gimp_spilled_buffer_free);
+  g_clear_pointer (&drawable_undo->region, cairo_region_destroy);
 
   GIMP_UNDO_CLASS (parent_class)->free (undo, undo_mode);
 }
+
+static gint64
+gimp_drawable_undo_spill (GimpUndo *undo)
+{
+  GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
+  gint64            size;
+
+  if (! drawable_undo->buffer)
+    return 0;
+
+  size = gimp_drawable_undo_get_buffer_size (drawable_undo);
+
+  drawable_undo->spilled = gimp_spilled_buffer_new (
+    undo->image->gimp,
+    drawable_undo->buffer, drawable_undo->region, size,
+    (GimpSpilledBufferCallback) gimp_drawable_undo_spilled,
+    undo);
+  g_clear_object (&drawable_undo->buffer);
+
+  return size;
+}
+
+static void
+gimp_drawable_undo_prefetch (GimpUndo *undo)
+{
+  GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
+
+  if (drawable_undo->spilled)
+    gimp_spilled_buffer_prefetch (drawable_undo->spilled);
+}
+
+static gboolean
+gimp_drawable_undo_unspill (GimpUndo  *undo,
+                            GError   **error)
+{
+  GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
+
+  if (drawable_undo->spilled)
+    {
+      /*  on failure, keep the spilled buffer for another attempt  */
+      drawable_undo->buffer =
+        gimp_spilled_buffer_restore (drawable_undo->spilled, error);
+
+      if (! drawable_undo->buffer)
+        return FALSE;
+
+      g_clear_pointer (&drawable_undo->spilled, gimp_spilled_buffer_free);
+    }
+
+  return TRUE;
+}
+
+static gint64
+gimp_drawable_undo_get_spilled_size (GimpUndo *undo,
+                                     gint64   *pending_size)
+{
+  GimpDrawableUndo *drawable_undo = GIMP_DRAWABLE_UNDO (undo);
+  gint64            spilled_size;
+
+  gimp_spilled_buffer_get_memsize (drawable_undo->spilled,
+                                   &spilled_size, pending_size);
+
+  return spilled_size;
+}
+
+static gint64
+gimp_drawable_undo_get_buffer_size (GimpDrawableUndo *drawable_undo)
+{
+  const Babl *format;
+  gint        tile_width;
+  gint        tile_height;
+  gint64      n_pixels = 0;
+  gint        n_rects;
+  gint        i;
+
+  if (! drawable_undo->buffer || ! drawable_undo->region)
+    return gimp_gegl_buffer_get_memsize (drawable_undo->buffer);
+
+  /*  only the tiles of a sparse buffer which hold changed pixels are
+   *  allocated, and they are allocated whole, even at the buffer's
+   *  edges
+   */
+  format = gegl_buffer_get_format (drawable_undo->buffer);
+
+  g_object_get (drawable_undo->buffer,
+                "tile-width",  &tile_width,
+                "tile-height", &tile_height,
+                NULL);
+
+  n_rects = cairo_region_num_rectangles (drawable_undo->region);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_rectangle_int_t rect;
+      GeglRectangle         tiles;
+
+      cairo_region_get_rectangle (drawable_undo->region, i, &rect);
+
+      gegl_rectangle_align_to_buffer (&tiles,
+                                      (const GeglRectangle *) &rect,
+                                      drawable_undo->buffer,
+                                      GEGL_RECTANGLE_ALIGNMENT_SUPERSET);
+
+      n_pixels += (gint64) tiles.width * tiles.height;
+    }
+
+  return (n_pixels * babl_format_get_bytes_per_pixel (format) +
+          gimp_g_object_get_memsize (G_OBJECT (drawable_undo->buffer)));
+}
+
+static void
+gimp_drawable_undo_spilled (GimpSpilledBuffer *spilled,
+                            GimpUndo          *undo)
+{
+  gimp_image_undo_event (undo->image, GIMP_UNDO_EVENT_UNDO_SPILLED, undo);
+}
@@ -37,9 +37,15 @@ struct _GimpDrawableUndo
 {
   GimpItemUndo  parent_instance;
 
-  GeglBuffer   *buffer;
-  gint          x;
-  gint          y;
+  GeglBuffer        *buffer;
+  GimpSpilledBuffer *spilled;
+  gint               x;
+  gint               y;
+
+  /*  the tiles of buffer that hold changed pixels, in buffer
+   *  coordinates, or NULL if all of buffer is used
+   */
+  cairo_region_t    *region;
 };
 
 struct _GimpDrawableUndoClass
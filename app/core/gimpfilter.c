@@ -34,6 +34,7 @@
 enum
 {
   ACTIVE_CHANGED,
+  POINT_FILTER_CHANGED,
   LAST_SIGNAL
 };
 
@@ -55,6 +56,7 @@ struct _GimpFilterPrivate
   guint           is_last_node : 1;
 
   GimpApplicator *applicator;
+  GeglNode       *point_filter;
 };
 
 #define GET_PRIVATE(filter) ((GimpFilterPrivate *) gimp_filter_get_instance_private ((GimpFilter *) (filter)))
@@ -99,6 +101,14 @@ gimp_filter_class_init (GimpFilterClass *klass)
                   NULL, NULL, NULL,
                   G_TYPE_NONE, 0);
 
+  gimp_filter_signals[POINT_FILTER_CHANGED] =
+    g_signal_new ("point-filter-changed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_FIRST,
+                  G_STRUCT_OFFSET (GimpFilterClass, point_filter_changed),
+                  NULL, NULL, NULL,
+                  G_TYPE_NONE, 0);
+
   object_class->finalize         = gimp_filter_finalize;
   object_class->set_property     = gimp_filter_set_property;
   object_class->get_property     = gimp_filter_get_property;
@@ -106,6 +116,7 @@ gimp_filter_class_init (GimpFilterClass *klass)
   gimp_object_class->get_memsize = gimp_filter_get_memsize;
 
   klass->active_changed          = NULL;
+  klass->point_filter_changed    = NULL;
   klass->get_node                = gimp_filter_real_get_node;
 
   g_object_class_install_property (object_class, PROP_ACTIVE,
@@ -313,3 +324,35 @@ gimp_filter_get_applicator (GimpFilter *filter)
 
   return GET_PRIVATE (filter)->applicator;
 }
+
+/*  a filter whose node does nothing but apply a single GIMP point
+ *  filter to its whole input sets that point filter's node here, so
+ *  that the filter stack can fuse it with adjacent point filters.
+ *  the node is not referenced.
+ */
+void
+gimp_filter_set_point_filter (GimpFilter *filter,
+                              GeglNode   *point_filter)
+{
+  GimpFilterPrivate *private;
+
+  g_return_if_fail (GIMP_IS_FILTER (filter));
+  g_return_if_fail (point_filter == NULL || GEGL_IS_NODE (point_filter));
+
+  private = GET_PRIVATE (filter);
+
+  if (point_filter != private->point_filter)
+    {
+      private->point_filter = point_filter;
+
+      g_signal_emit (filter, gimp_filter_signals[POINT_FILTER_CHANGED], 0);
+    }
+}
+
+GeglNode *
+gimp_filter_get_point_filter (GimpFilter *filter)
+{
+  g_return_val_if_fail (GIMP_IS_FILTER (filter), NULL);
+
+  return GET_PRIVATE (filter)->point_filter;
+}
@@ -44,10 +44,11 @@ struct _GimpFilterClass
   GimpViewableClass  parent_class;
 
   /*  signals  */
-  void       (* active_changed) (GimpFilter *filter);
+  void       (* active_changed)       (GimpFilter *filter);
+  void       (* point_filter_changed) (GimpFilter *filter);
 
   /*  virtual functions  */
-  GeglNode * (* get_node)       (GimpFilter *filter);
+  GeglNode * (* get_node)             (GimpFilter *filter);
 };
 
 
@@ -69,5 +70,9 @@ void             gimp_filter_set_applicator   (GimpFilter     *filter,
                                                GimpApplicator *applicator);
 GimpApplicator * gimp_filter_get_applicator   (GimpFilter     *filter);
 
+void             gimp_filter_set_point_filter (GimpFilter     *filter,
+                                               GeglNode       *point_filter);
+GeglNode       * gimp_filter_get_point_filter (GimpFilter     *filter);
+
 
 #endif /* __GIMP_FILTER_H__ */
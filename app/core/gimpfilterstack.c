@@ -20,36 +20,54 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
 #include "core-types.h"
 
+#include "operations/gimpoperationpointfilter.h"
+
 #include "gimpfilter.h"
 #include "gimpfilterstack.h"
 
 
 /*  local function prototypes  */
 
-static void   gimp_filter_stack_constructed      (GObject         *object);
-static void   gimp_filter_stack_finalize         (GObject         *object);
-
-static void   gimp_filter_stack_add              (GimpContainer   *container,
-                                                  GimpObject      *object);
-static void   gimp_filter_stack_remove           (GimpContainer   *container,
-                                                  GimpObject      *object);
-static void   gimp_filter_stack_reorder          (GimpContainer   *container,
-                                                  GimpObject      *object,
-                                                  gint             new_index);
-
-static void   gimp_filter_stack_add_node         (GimpFilterStack *stack,
-                                                  GimpFilter      *filter);
-static void   gimp_filter_stack_remove_node      (GimpFilterStack *stack,
-                                                  GimpFilter      *filter);
-static void   gimp_filter_stack_update_last_node (GimpFilterStack *stack);
-
-static void   gimp_filter_stack_filter_active    (GimpFilter      *filter,
-                                                  GimpFilterStack *stack);
+static void       gimp_filter_stack_constructed         (GObject          *object);
+static void       gimp_filter_stack_finalize            (GObject          *object);
+
+static void       gimp_filter_stack_add                 (GimpContainer    *container,
+                                                         GimpObject       *object);
+static void       gimp_filter_stack_remove              (GimpContainer    *container,
+                                                         GimpObject       *object);
+static void       gimp_filter_stack_reorder             (GimpContainer    *container,
+                                                         GimpObject       *object,
+                                                         gint              new_index);
+
+static void       gimp_filter_stack_add_node            (GimpFilterStack  *stack,
+                                                         GimpFilter       *filter);
+static void       gimp_filter_stack_remove_node         (GimpFilterStack  *stack,
+                                                         GimpFilter       *filter);
+static void       gimp_filter_stack_relink              (GimpFilterStack  *stack);
+static GeglNode * gimp_filter_stack_link_run            (GimpFilterStack  *stack,
+                                                         GList            *run,
+                                                         GeglNode         *input);
+static void       gimp_filter_stack_clear_fused         (GimpFilterStack  *stack);
+static void       gimp_filter_stack_update_last_node    (GimpFilterStack  *stack);
+
+static void       gimp_filter_stack_filter_active       (GimpFilter       *filter,
+                                                         GimpFilterStack  *stack);
+static void       gimp_filter_stack_filter_point_filter (GimpFilter       *filter,
+                                                         GimpFilterStack  *stack);
+static void       gimp_filter_stack_watch_point_filter  (GeglOperation    *operation,
+                                                         GeglNode         *fused);
+static void       gimp_filter_stack_watch_config        (GeglOperation    *operation,
+                                                         GeglNode         *fused);
+static void       gimp_filter_stack_point_filter_notify (GObject          *object,
+                                                         const GParamSpec *pspec,
+                                                         GeglNode         *fused);
 
 
 G_DEFINE_TYPE (GimpFilterStack, gimp_filter_stack, GIMP_TYPE_LIST);
@@ -89,6 +107,9 @@ gimp_filter_stack_constructed (GObject *object)
   gimp_container_add_handler (container, "active-changed",
                               G_CALLBACK (gimp_filter_stack_filter_active),
                               container);
+  gimp_container_add_handler (container, "point-filter-changed",
+                              G_CALLBACK (gimp_filter_stack_filter_point_filter),
+                              container);
 }
 
 static void
@@ -96,6 +117,7 @@ gimp_filter_stack_finalize (GObject *object)
 {
   GimpFilterStack *stack = GIMP_FILTER_STACK (object);
 
+  g_clear_pointer (&stack->fused_nodes, g_list_free);
   g_clear_object (&stack->graph);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -114,8 +136,8 @@ gimp_filter_stack_add (GimpContainer *container,
     {
       if (stack->graph)
         {
-          gegl_node_add_child (stack->graph, gimp_filter_get_node (filter));
           gimp_filter_stack_add_node (stack, filter);
+          gimp_filter_stack_relink (stack);
         }
 
       gimp_filter_stack_update_last_node (stack);
@@ -128,17 +150,18 @@ gimp_filter_stack_remove (GimpContainer *container,
 {
   GimpFilterStack *stack  = GIMP_FILTER_STACK (container);
   GimpFilter      *filter = GIMP_FILTER (object);
+  gboolean         active = gimp_filter_get_active (filter);
 
-  if (stack->graph && gimp_filter_get_active (filter))
-    {
-      gimp_filter_stack_remove_node (stack, filter);
-      gegl_node_remove_child (stack->graph, gimp_filter_get_node (filter));
-    }
+  if (stack->graph && active)
+    gimp_filter_stack_remove_node (stack, filter);
 
   GIMP_CONTAINER_CLASS (parent_class)->remove (container, object);
 
-  if (gimp_filter_get_active (filter))
+  if (active)
     {
+      if (stack->graph)
+        gimp_filter_stack_relink (stack);
+
       gimp_filter_set_is_last_node (filter, FALSE);
       gimp_filter_stack_update_last_node (stack);
     }
@@ -152,9 +175,6 @@ gimp_filter_stack_reorder (GimpContainer *container,
   GimpFilterStack *stack  = GIMP_FILTER_STACK (container);
   GimpFilter      *filter = GIMP_FILTER (object);
 
-  if (stack->graph && gimp_filter_get_active (filter))
-    gimp_filter_stack_remove_node (stack, filter);
-
   GIMP_CONTAINER_CLASS (parent_class)->reorder (container, object, new_index);
 
   if (gimp_filter_get_active (filter))
@@ -162,7 +182,7 @@ gimp_filter_stack_reorder (GimpContainer *container,
       gimp_filter_stack_update_last_node (stack);
 
       if (stack->graph)
-        gimp_filter_stack_add_node (stack, filter);
+        gimp_filter_stack_relink (stack);
     }
 }
 
@@ -184,9 +204,7 @@ gimp_filter_stack_new (GType filter_type)
 GeglNode *
 gimp_filter_stack_get_graph (GimpFilterStack *stack)
 {
-  GList    *list;
-  GeglNode *previous;
-  GeglNode *output;
+  GList *list;
 
   g_return_val_if_fail (GIMP_IS_FILTER_STACK (stack), NULL);
 
@@ -195,32 +213,17 @@ gimp_filter_stack_get_graph (GimpFilterStack *stack)
 
   stack->graph = gegl_node_new ();
 
-  previous = gegl_node_get_input_proxy (stack->graph, "input");
-
   for (list = GIMP_LIST (stack)->queue->tail;
        list;
        list = g_list_previous (list))
     {
       GimpFilter *filter = list->data;
-      GeglNode   *node;
-
-      if (! gimp_filter_get_active (filter))
-        continue;
-
-      node = gimp_filter_get_node (filter);
-
-      gegl_node_add_child (stack->graph, node);
 
-      gegl_node_connect_to (previous, "output",
-                            node,     "input");
-
-      previous = node;
+      if (gimp_filter_get_active (filter))
+        gimp_filter_stack_add_node (stack, filter);
     }
 
-  output = gegl_node_get_output_proxy (stack->graph, "output");
-
-  gegl_node_connect_to (previous, "output",
-                        output,   "input");
+  gimp_filter_stack_relink (stack);
 
   return stack->graph;
 }
@@ -232,73 +235,146 @@ static void
 gimp_filter_stack_add_node (GimpFilterStack *stack,
                             GimpFilter      *filter)
 {
-  GeglNode *node;
-  GeglNode *node_above = NULL;
-  GeglNode *node_below = NULL;
-  GList    *iter;
+  gegl_node_add_child (stack->graph, gimp_filter_get_node (filter));
+}
 
-  node = gimp_filter_get_node (filter);
+static void
+gimp_filter_stack_remove_node (GimpFilterStack *stack,
+                               GimpFilter      *filter)
+{
+  GeglNode *node = gimp_filter_get_node (filter);
 
+  gegl_node_disconnect (node, "input");
 
-  iter = g_list_find (GIMP_LIST (stack)->queue->head, filter);
+  gegl_node_remove_child (stack->graph, node);
+}
 
-  while ((iter = g_list_previous (iter)))
+/*  links the active filters, bottom to top.  runs of consecutive
+ *  filters that amount to GIMP point filters are applied by a single
+ *  gimp:fused-point-filter node.
+ */
+static void
+gimp_filter_stack_relink (GimpFilterStack *stack)
+{
+  GeglNode *previous;
+  GeglNode *output;
+  GList    *run = NULL;
+  GList    *list;
+
+  gimp_filter_stack_clear_fused (stack);
+
+  previous = gegl_node_get_input_proxy (stack->graph, "input");
+
+  for (list = GIMP_LIST (stack)->queue->tail;
+       list;
+       list = g_list_previous (list))
     {
-      GimpFilter *filter_above = iter->data;
+      GimpFilter *filter = list->data;
+      GeglNode   *node;
+
+      if (! gimp_filter_get_active (filter))
+        continue;
 
-      if (gimp_filter_get_active (filter_above))
+      if (gimp_filter_get_point_filter (filter))
         {
-          node_above = gimp_filter_get_node (filter_above);
+          run = g_list_append (run, filter);
 
-          break;
+          continue;
         }
+
+      previous = gimp_filter_stack_link_run (stack, run, previous);
+      g_clear_pointer (&run, g_list_free);
+
+      node = gimp_filter_get_node (filter);
+
+      gegl_node_connect_to (previous, "output",
+                            node,     "input");
+
+      previous = node;
     }
 
-  if (! node_above)
-    node_above = gegl_node_get_output_proxy (stack->graph, "output");
+  previous = gimp_filter_stack_link_run (stack, run, previous);
+  g_list_free (run);
 
-  node_below = gegl_node_get_producer (node_above, "input", NULL);
+  output = gegl_node_get_output_proxy (stack->graph, "output");
 
-  gegl_node_connect_to (node_below, "output",
-                        node,       "input");
-  gegl_node_connect_to (node,       "output",
-                        node_above, "input");
+  gegl_node_connect_to (previous, "output",
+                        output,   "input");
 }
 
-static void
-gimp_filter_stack_remove_node (GimpFilterStack *stack,
-                               GimpFilter      *filter)
+/*  the filters of a run are still linked to each other, so that each
+ *  of them can be applied on its own, like gimp_drawable_merge_filter()
+ *  does.  the graph's output only goes through the fused node, though.
+ */
+static GeglNode *
+gimp_filter_stack_link_run (GimpFilterStack *stack,
+                            GList           *run,
+                            GeglNode        *input)
 {
-  GeglNode *node;
-  GeglNode *node_above = NULL;
-  GeglNode *node_below = NULL;
-  GList    *iter;
+  GeglNode  *previous = input;
+  GeglNode  *fused;
+  GPtrArray *filters;
+  GList     *list;
 
-  node = gimp_filter_get_node (filter);
+  for (list = run; list; list = g_list_next (list))
+    {
+      GeglNode *node = gimp_filter_get_node (list->data);
 
-  iter = g_list_find (GIMP_LIST (stack)->queue->head, filter);
+      gegl_node_connect_to (previous, "output",
+                            node,     "input");
 
-  while ((iter = g_list_previous (iter)))
+      previous = node;
+    }
+
+  if (g_list_length (run) < 2)
+    return previous;
+
+  filters = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (list = run; list; list = g_list_next (list))
     {
-      GimpFilter *filter_above = iter->data;
+      g_ptr_array_add (filters,
+                       g_object_ref (gimp_filter_get_point_filter (list->data)));
+    }
 
-      if (gimp_filter_get_active (filter_above))
-        {
-          node_above = gimp_filter_get_node (filter_above);
+  fused = gegl_node_new_child (stack->graph,
+                               "operation", "gimp:fused-point-filter",
+                               "filters",   filters,
+                               NULL);
 
-          break;
-        }
+  /*  the fused operation copies the filters' settings, pick up their
+   *  changes
+   */
+  for (list = run; list; list = g_list_next (list))
+    {
+      GeglNode *point_filter = gimp_filter_get_point_filter (list->data);
+
+      gimp_filter_stack_watch_point_filter (
+        gegl_node_get_gegl_operation (point_filter), fused);
     }
 
-  if (! node_above)
-    node_above = gegl_node_get_output_proxy (stack->graph, "output");
+  g_ptr_array_unref (filters);
 
-  node_below = gegl_node_get_producer (node, "input", NULL);
+  gegl_node_connect_to (input, "output",
+                        fused, "input");
 
-  gegl_node_disconnect (node, "input");
+  stack->fused_nodes = g_list_prepend (stack->fused_nodes, fused);
+
+  return fused;
+}
+
+static void
+gimp_filter_stack_clear_fused (GimpFilterStack *stack)
+{
+  GList *list;
+
+  /*  the graph holds the only reference to the fused nodes, removing
+   *  them also disconnects them, and their notify handlers
+   */
+  for (list = stack->fused_nodes; list; list = g_list_next (list))
+    gegl_node_remove_child (stack->graph, list->data);
 
-  gegl_node_connect_to (node_below, "output",
-                        node_above, "input");
+  g_clear_pointer (&stack->fused_nodes, g_list_free);
 }
 
 static void
@@ -332,15 +408,11 @@ gimp_filter_stack_filter_active (GimpFilter      *filter,
   if (stack->graph)
     {
       if (gimp_filter_get_active (filter))
-        {
-          gegl_node_add_child (stack->graph, gimp_filter_get_node (filter));
-          gimp_filter_stack_add_node (stack, filter);
-        }
+        gimp_filter_stack_add_node (stack, filter);
       else
-        {
-          gimp_filter_stack_remove_node (stack, filter);
-          gegl_node_remove_child (stack->graph, gimp_filter_get_node (filter));
-        }
+        gimp_filter_stack_remove_node (stack, filter);
+
+      gimp_filter_stack_relink (stack);
     }
 
   gimp_filter_stack_update_last_node (stack);
@@ -348,3 +420,61 @@ gimp_filter_stack_filter_active (GimpFilter      *filter,
   if (! gimp_filter_get_active (filter))
     gimp_filter_set_is_last_node (filter, FALSE);
 }
+
+static void
+gimp_filter_stack_filter_point_filter (GimpFilter      *filter,
+                                       GimpFilterStack *stack)
+{
+  if (stack->graph && gimp_filter_get_active (filter))
+    gimp_filter_stack_relink (stack);
+}
+
+/*  the handlers are connected to the fused node, and go away with it  */
+static void
+gimp_filter_stack_watch_point_filter (GeglOperation *operation,
+                                      GeglNode      *fused)
+{
+  g_signal_connect_object (operation, "notify",
+                           G_CALLBACK (gimp_filter_stack_point_filter_notify),
+                           fused, 0);
+
+  gimp_filter_stack_watch_config (operation, fused);
+}
+
+/*  tools modify their config in place while previewing, without
+ *  touching the operation
+ */
+static void
+gimp_filter_stack_watch_config (GeglOperation *operation,
+                                GeglNode      *fused)
+{
+  GObject *config = GIMP_OPERATION_POINT_FILTER (operation)->config;
+
+  if (config)
+    {
+      g_signal_connect_object (config, "notify",
+                               G_CALLBACK (gimp_filter_stack_point_filter_notify),
+                               fused, 0);
+    }
+}
+
+static void
+gimp_filter_stack_point_filter_notify (GObject          *object,
+                                       const GParamSpec *pspec,
+                                       GeglNode         *fused)
+{
+  GPtrArray *filters;
+
+  if (GEGL_IS_OPERATION (object) && ! strcmp (pspec->name, "config"))
+    gimp_filter_stack_watch_config (GEGL_OPERATION (object), fused);
+
+  /*  setting the filters again rebuilds the fused operation  */
+  gegl_node_get (fused,
+                 "filters", &filters,
+                 NULL);
+  gegl_node_set (fused,
+                 "filters", filters,
+                 NULL);
+
+  g_ptr_array_unref (filters);
+}
@@ -38,6 +38,7 @@ struct _GimpFilterStack
   GimpList  parent_instance;
 
   GeglNode *graph;
+  GList    *fused_nodes;
 };
 
 struct _GimpFilterStackClass
@@ -143,10 +143,13 @@
 
 #include "core-types.h"
 
+#include "config/gimpcoreconfig.h"
+
 #include "gegl/gimp-babl.h"
 #include "gegl/gimp-gegl-utils.h"
 
 #include "gimp.h"
+#include "gimp-atomic.h"
 #include "gimpcontainer.h"
 #include "gimpdrawable.h"
 #include "gimperror.h"
@@ -192,6 +195,32 @@
 #define G_SCALE 24              /*  scale G (a*) distances by this much  */
 #define B_SCALE 26              /*  and B (b*) by this much              */
 
+#define HIST_N_ELEMS (HIST_R_ELEMS * HIST_G_ELEMS * HIST_B_ELEMS)
+
+/* per-thread histograms are merged in blocks of this many entries (a
+ * 4 KiB page), skipping the blocks a thread never touched
+ */
+#define HIST_BLOCK_SHIFT 9
+#define HIST_BLOCK_SIZE  (1 << HIST_BLOCK_SHIFT)
+#define HIST_N_BLOCKS    (HIST_N_ELEMS >> HIST_BLOCK_SHIFT)
+
+/* an extra thread needs its own histogram, which is zeroed on first
+ * touch and merged back at the end, costing about as much as counting
+ * one pixel per histogram entry.  a thread should have at least that
+ * many pixels to count.
+ */
+#define HISTOGRAM_PIXELS_PER_THREAD ((gdouble) HIST_N_ELEMS)
+
+/* the layer is counted in at most this many bands, updating the
+ * progress in between
+ */
+#define HISTOGRAM_MAX_BANDS 16
+
+/* below this many colors, the plain colormap scan is as fast as
+ * walking the k-d tree
+ */
+#define KD_TREE_MIN_COLORS 16
+
 
 typedef struct _Color Color;
 typedef struct _QuantizeObj QuantizeObj;
@@ -468,6 +497,15 @@ struct _Color
   gint blue;
 };
 
+typedef struct
+{
+  gint    point[3];  /*  colormap entry, in scaled linear space     */
+  gint    index;     /*  its index in the colormap                  */
+  gint    axis;      /*  the axis this node splits its children on  */
+  gint    left;      /*  node indices of the children, or -1        */
+  gint    right;
+} KDNode;
+
 struct _QuantizeObj
 {
   Pass1Func     first_pass;       /* first pass over image data creates colormap  */
@@ -483,6 +521,8 @@ struct _QuantizeObj
   Color         clin[256];                /* .. converted back to linear space */
   guint64       index_used_count[256];    /* how many times an index was used  */
   CFHistogram   histogram;                /* holds the histogram               */
+  KDNode        kd_nodes[256];            /* k-d tree of clin, for remapping   */
+  gint          kd_root;
 
   gboolean      want_dither_alpha;
   gint          error_freedom;            /* 0=much bleed, 1=controlled bleed */
@@ -515,6 +555,44 @@ typedef struct
 
 } box, *boxptr;
 
+typedef struct
+{
+  CFHistogram    histogram;
+  guchar         touched[HIST_N_BLOCKS];  /*  blocks with nonzero counts  */
+} HistogramSlot;
+
+typedef struct
+{
+  GeglRectangle  area;
+
+  guchar         found_cols[MAXNUMCOLORS][3];
+  gint           num_found_cols;
+  gboolean       needs_quantize;
+  gboolean       had_white;
+  gboolean       had_black;
+} HistogramArea;
+
+typedef struct
+{
+  GeglBuffer     *buffer;
+  const Babl     *format;
+  gint            bpp;
+  gboolean        has_alpha;
+  gboolean        dither_alpha;
+  gint            offsetx;
+  gint            offsety;
+  gint            col_limit;
+  gboolean        needs_quantize;
+
+  CFHistogram     histogram;
+
+  HistogramSlot   main_slot;    /*  counts straight into 'histogram'  */
+  GSList         *free_slots;   /*  slots not used by an area         */
+  GSList         *extra_slots;  /*  slots with their own histogram    */
+
+  GSList         *areas;
+} HistogramData;
+
 
 static void          zero_histogram_gray     (CFHistogram   histogram);
 static void          zero_histogram_rgb      (CFHistogram   histogram);
@@ -1169,222 +1247,347 @@ generate_histogram_gray (CFHistogram  histogram,
 }
 
 static void
-check_white_or_black (const guchar *data)
-{
-  if (data[RED]   == 255 &&
-      data[GREEN] == 255 &&
-      data[BLUE]  == 255)
-    had_white = TRUE;
-  if (data[RED]  ==0 &&
-      data[GREEN]==0 &&
-      data[BLUE] ==0)
-    had_black = TRUE;
-}
-
-static void
-generate_histogram_rgb (CFHistogram   histogram,
-                        GimpLayer    *layer,
-                        gint          col_limit,
-                        gboolean      dither_alpha,
-                        GimpProgress *progress)
+generate_histogram_rgb_area (const GeglRectangle *area,
+                             HistogramData       *data)
 {
+  HistogramSlot      *slot;
+  HistogramArea      *harea;
   GeglBufferIterator *iter;
-  const Babl         *format;
   GeglRectangle      *roi;
   ColorFreq          *colfreq;
+  CFHistogram         histogram;
   gint                nfc_iter;
   gint                row, col, coledge;
-  gint                offsetx, offsety;
-  gint64              layer_size;
-  gint64              total_size = 0;
-  gint                count      = 0;
-  gint                bpp;
-  gboolean            has_alpha;
 
-  format = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
+  /*  counting goes into a histogram no other area is using right now,
+   *  the main one first.  extra ones are only allocated while all the
+   *  others are busy, and are kept for the next bands.
+   */
+  slot = gimp_atomic_slist_pop_head (&data->free_slots);
 
-  g_return_if_fail (format == babl_format_with_space ("R'G'B' u8", format) ||
-                    format == babl_format_with_space ("R'G'B'A u8", format));
+  if (! slot)
+    {
+      slot = g_slice_new0 (HistogramSlot);
 
-  bpp       = babl_format_get_bytes_per_pixel (format);
-  has_alpha = babl_format_has_alpha (format);
+      slot->histogram = g_new0 (ColorFreq, HIST_N_ELEMS);
 
-  gimp_item_get_offset (GIMP_ITEM (layer), &offsetx, &offsety);
+      gimp_atomic_slist_push_head (&data->extra_slots, slot);
+    }
 
-  layer_size = (gimp_item_get_width  (GIMP_ITEM (layer)) *
-                gimp_item_get_height (GIMP_ITEM (layer)));
+  histogram = slot->histogram;
 
-  /*  g_printerr ("col_limit = %d, nfc = %d\n", col_limit, num_found_cols); */
+  harea = g_slice_new0 (HistogramArea);
 
-  iter = gegl_buffer_iterator_new (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
-                                   NULL, 0, format,
+  harea->area           = *area;
+  harea->needs_quantize = data->needs_quantize;
+
+  iter = gegl_buffer_iterator_new (data->buffer, area, 0, data->format,
                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
   roi = &iter->items[0].roi;
 
-  if (progress)
-    gimp_progress_set_value (progress, 0.0);
-
   while (gegl_buffer_iterator_next (iter))
     {
-      const guchar *data   = iter->items[0].data;
+      const guchar *src    = iter->items[0].data;
       gint          length = iter->length;
 
-      total_size += length;
+      /* if alpha-dithering, we need to be deterministic w.r.t. offsets */
+      col = roi->x + data->offsetx;
+      coledge = col + roi->width;
+      row = roi->y + data->offsety;
 
-      /* g_printerr (" [%d,%d - %d,%d]", srcPR.x, src_roi->y, offsetx, offsety); */
-
-      if (needs_quantize)
+      while (length--)
         {
-          if (dither_alpha)
-            {
-              /* if alpha-dithering,
-                 we need to be deterministic w.r.t. offsets */
+          gboolean transparent = FALSE;
 
-              col = roi->x + offsetx;
-              coledge = col + roi->width;
-              row = roi->y + offsety;
-
-              while (length--)
+          if (data->has_alpha)
+            {
+              if (data->dither_alpha)
                 {
-                  gboolean transparent = FALSE;
-
-                  if (has_alpha &&
-                      data[ALPHA] <
+                  if (src[ALPHA] <
                       DM[col & DM_WIDTHMASK][row & DM_HEIGHTMASK])
                     transparent = TRUE;
+                }
+              else
+                {
+                  if (src[ALPHA] <= 127)
+                    transparent = TRUE;
+                }
+            }
 
-                  if (! transparent)
+          if (! transparent)
+            {
+              colfreq = HIST_RGB (histogram,
+                                  src[RED],
+                                  src[GREEN],
+                                  src[BLUE]);
+              (*colfreq)++;
+
+              slot->touched[(colfreq - histogram) >> HIST_BLOCK_SHIFT] = TRUE;
+
+              if (src[RED]   == 255 &&
+                  src[GREEN] == 255 &&
+                  src[BLUE]  == 255)
+                harea->had_white = TRUE;
+              if (src[RED]   == 0 &&
+                  src[GREEN] == 0 &&
+                  src[BLUE]  == 0)
+                harea->had_black = TRUE;
+
+              if (! harea->needs_quantize)
+                {
+                  for (nfc_iter = 0;
+                       nfc_iter < harea->num_found_cols;
+                       nfc_iter++)
                     {
-                      colfreq = HIST_RGB (histogram,
-                                          data[RED],
-                                          data[GREEN],
-                                          data[BLUE]);
-                      check_white_or_black (data);
-                      (*colfreq)++;
+                      if ((src[RED]   == harea->found_cols[nfc_iter][0]) &&
+                          (src[GREEN] == harea->found_cols[nfc_iter][1]) &&
+                          (src[BLUE]  == harea->found_cols[nfc_iter][2]))
+                        goto already_found;
                     }
 
-                  col++;
-                  if (col == coledge)
+                  /* Color was not in the table of
+                   * existing colors
+                   */
+
+                  if (harea->num_found_cols == data->col_limit)
                     {
-                      col = roi->x + offsetx;
-                      row++;
+                      /* There are more colors in this area alone than
+                       *  were allowed.  We switch to plain histogram
+                       *  calculation with a view to quantizing at a
+                       *  later stage.
+                       */
+                      harea->needs_quantize = TRUE;
                     }
+                  else
+                    {
+                      /* Remember the new color we just found.
+                       */
+                      harea->found_cols[harea->num_found_cols][0] = src[RED];
+                      harea->found_cols[harea->num_found_cols][1] = src[GREEN];
+                      harea->found_cols[harea->num_found_cols][2] = src[BLUE];
 
-                  data += bpp;
+                      harea->num_found_cols++;
+                    }
                 }
             }
-          else
-            {
-              while (length--)
-                {
-                  if ((has_alpha && ((data[ALPHA] > 127)))
-                      || (!has_alpha))
-                    {
-                      colfreq = HIST_RGB (histogram,
-                                          data[RED],
-                                          data[GREEN],
-                                          data[BLUE]);
-                      check_white_or_black (data);
-                      (*colfreq)++;
-                    }
+        already_found:
 
-                  data += bpp;
-                }
+          col++;
+          if (col == coledge)
+            {
+              col = roi->x + data->offsetx;
+              row++;
             }
+
+          src += data->bpp;
         }
-      else
+    }
+
+  gimp_atomic_slist_push_head (&data->areas,      harea);
+  gimp_atomic_slist_push_head (&data->free_slots, slot);
+}
+
+static gint
+histogram_area_compare (const HistogramArea *area1,
+                        const HistogramArea *area2)
+{
+  if (area1->area.y != area2->area.y)
+    return area1->area.y - area2->area.y;
+
+  return area1->area.x - area2->area.x;
+}
+
+/*  merges the colors found in the areas counted so far, in image order,
+ *  so that the colormap is deterministic when no quantization is needed
+ */
+static void
+merge_histogram_areas (HistogramData *data)
+{
+  GSList *list;
+  gint    nfc_iter;
+
+  data->areas = g_slist_sort (data->areas,
+                              (GCompareFunc) histogram_area_compare);
+
+  for (list = data->areas; list; list = g_slist_next (list))
+    {
+      HistogramArea *harea = list->data;
+      gint           i;
+
+      had_white |= harea->had_white;
+      had_black |= harea->had_black;
+
+      if (harea->needs_quantize)
+        needs_quantize = TRUE;
+
+      for (i = 0; ! needs_quantize && i < harea->num_found_cols; i++)
         {
-          /* if alpha-dithering, we need to be deterministic w.r.t. offsets */
-          col = roi->x + offsetx;
-          coledge = col + roi->width;
-          row = roi->y + offsety;
+          for (nfc_iter = 0; nfc_iter < num_found_cols; nfc_iter++)
+            {
+              if ((harea->found_cols[i][0] == found_cols[nfc_iter][0]) &&
+                  (harea->found_cols[i][1] == found_cols[nfc_iter][1]) &&
+                  (harea->found_cols[i][2] == found_cols[nfc_iter][2]))
+                break;
+            }
 
-          while (length--)
+          if (nfc_iter < num_found_cols)
+            continue;
+
+          if (num_found_cols == data->col_limit)
             {
-              gboolean transparent = FALSE;
+              /* There are more colors in the image than were allowed.
+               */
+              needs_quantize = TRUE;
+              /* g_print ("\nmax colors exceeded - needs quantize.\n");*/
+            }
+          else
+            {
+              found_cols[num_found_cols][0] = harea->found_cols[i][0];
+              found_cols[num_found_cols][1] = harea->found_cols[i][1];
+              found_cols[num_found_cols][2] = harea->found_cols[i][2];
 
-              if (has_alpha)
-                {
-                  if (dither_alpha)
-                    {
-                      if (data[ALPHA] <
-                          DM[col & DM_WIDTHMASK][row & DM_HEIGHTMASK])
-                        transparent = TRUE;
-                    }
-                  else
-                    {
-                      if (data[ALPHA] <= 127)
-                        transparent = TRUE;
-                    }
-                }
+              num_found_cols++;
+            }
+        }
 
-              if (! transparent)
-                {
-                  colfreq = HIST_RGB (histogram,
-                                      data[RED],
-                                      data[GREEN],
-                                      data[BLUE]);
-                  (*colfreq)++;
+      g_slice_free (HistogramArea, harea);
+    }
 
-                  if (!needs_quantize)
-                    {
-                      for (nfc_iter = 0;
-                           nfc_iter < num_found_cols;
-                           nfc_iter++)
-                        {
-                          if ((data[RED]   == found_cols[nfc_iter][0]) &&
-                              (data[GREEN] == found_cols[nfc_iter][1]) &&
-                              (data[BLUE]  == found_cols[nfc_iter][2]))
-                            goto already_found;
-                        }
+  g_slist_free (data->areas);
+  data->areas = NULL;
 
-                      /* Color was not in the table of
-                       * existing colors
-                       */
+  data->needs_quantize = needs_quantize;
+}
 
-                      num_found_cols++;
+/*  adds the touched blocks of the extra histograms to the main one,
+ *  each thread taking a range of blocks
+ */
+static void
+merge_histogram_blocks (gsize          offset,
+                        gsize          size,
+                        HistogramData *data)
+{
+  gsize block;
 
-                      if (num_found_cols > col_limit)
-                        {
-                          /* There are more colors in the image than
-                           *  were allowed.  We switch to plain
-                           *  histogram calculation with a view to
-                           *  quantizing at a later stage.
-                           */
-                          needs_quantize = TRUE;
-                          /* g_print ("\nmax colors exceeded - needs quantize.\n");*/
-                          goto already_found;
-                        }
-                      else
-                        {
-                          /* Remember the new color we just found.
-                           */
-                          found_cols[num_found_cols-1][0] = data[RED];
-                          found_cols[num_found_cols-1][1] = data[GREEN];
-                          found_cols[num_found_cols-1][2] = data[BLUE];
+  for (block = offset; block < offset + size; block++)
+    {
+      ColorFreq *dest = data->histogram + (block << HIST_BLOCK_SHIFT);
+      GSList    *list;
 
-                          check_white_or_black (data);
-                        }
-                    }
-                }
-            already_found:
+      for (list = data->extra_slots; list; list = g_slist_next (list))
+        {
+          HistogramSlot   *slot = list->data;
+          const ColorFreq *src;
+          gint             i;
 
-              col++;
-              if (col == coledge)
-                {
-                  col = roi->x + offsetx;
-                  row++;
-                }
+          if (! slot->touched[block])
+            continue;
 
-              data += bpp;
-            }
+          src = slot->histogram + (block << HIST_BLOCK_SHIFT);
+
+          for (i = 0; i < HIST_BLOCK_SIZE; i++)
+            dest[i] += src[i];
         }
+    }
+}
+
+static void
+generate_histogram_rgb (CFHistogram   histogram,
+                        GimpLayer    *layer,
+                        gint          col_limit,
+                        gboolean      dither_alpha,
+                        GimpProgress *progress)
+{
+  GimpImage           *image = gimp_item_get_image (GIMP_ITEM (layer));
+  HistogramData        data  = { 0, };
+  const Babl          *format;
+  const GeglRectangle *extent;
+  GSList              *list;
+  gint                 n_threads;
+  gint                 band_height;
+  gint                 y;
+
+  format = gimp_drawable_get_format (GIMP_DRAWABLE (layer));
+
+  g_return_if_fail (format == babl_format_with_space ("R'G'B' u8", format) ||
+                    format == babl_format_with_space ("R'G'B'A u8", format));
+
+  data.buffer         = gimp_drawable_get_buffer (GIMP_DRAWABLE (layer));
+  data.format         = format;
+  data.bpp            = babl_format_get_bytes_per_pixel (format);
+  data.has_alpha      = babl_format_has_alpha (format);
+  data.dither_alpha   = dither_alpha;
+  data.col_limit      = MIN (col_limit, MAXNUMCOLORS);
+  data.needs_quantize = needs_quantize;
+  data.histogram      = histogram;
+
+  data.main_slot.histogram = histogram;
+  data.free_slots          = g_slist_prepend (NULL, &data.main_slot);
+
+  gimp_item_get_offset (GIMP_ITEM (layer), &data.offsetx, &data.offsety);
+
+  extent = gegl_buffer_get_extent (data.buffer);
+
+  /*  make each band large enough to keep all threads busy, but split
+   *  large layers into several bands, for progress updates
+   */
+  n_threads   = MAX (GIMP_GEGL_CONFIG (image->gimp->config)->num_processors, 1);
+  band_height = ceil (HISTOGRAM_PIXELS_PER_THREAD * n_threads /
+                      MAX (extent->width, 1));
+  band_height = MAX (band_height,
+                     (extent->height + HISTOGRAM_MAX_BANDS - 1) /
+                     HISTOGRAM_MAX_BANDS);
+  band_height = MAX (band_height, 1);
+
+  /*  g_printerr ("col_limit = %d, nfc = %d\n", col_limit, num_found_cols); */
 
-      if (progress && (count % 16 == 0))
+  if (progress)
+    gimp_progress_set_value (progress, 0.0);
+
+  for (y = 0; y < extent->height; y += band_height)
+    {
+      GeglRectangle band = { extent->x, extent->y + y,
+                             extent->width,
+                             MIN (band_height, extent->height - y) };
+
+      gegl_parallel_distribute_area (
+        &band, HISTOGRAM_PIXELS_PER_THREAD,
+        GEGL_SPLIT_STRATEGY_HORIZONTAL,
+        (GeglParallelDistributeAreaFunc) generate_histogram_rgb_area,
+        &data);
+
+      /*  once quantizing is known to be needed, the next bands don't
+       *  have to look for distinct colors
+       */
+      merge_histogram_areas (&data);
+
+      if (progress)
         gimp_progress_set_value (progress,
-                                 (gdouble) total_size / (gdouble) layer_size);
+                                 (gdouble) (y + band.height) / extent->height);
     }
 
+  if (data.extra_slots)
+    {
+      gegl_parallel_distribute_range (
+        HIST_N_BLOCKS, 64,
+        (GeglParallelDistributeRangeFunc) merge_histogram_blocks,
+        &data);
+    }
+
+  for (list = data.extra_slots; list; list = g_slist_next (list))
+    {
+      HistogramSlot *slot = list->data;
+
+      g_free (slot->histogram);
+      g_slice_free (HistogramSlot, slot);
+    }
+
+  g_slist_free (data.extra_slots);
+  g_slist_free (data.free_slots);
+
+  if (progress)
+    gimp_progress_set_value (progress, 1.0);
+
 /*  g_print ("O: col_limit = %d, nfc = %d\n", col_limit, num_found_cols);*/
 }
 
@@ -2678,6 +2881,148 @@ find_best_colors (QuantizeObj *quantobj,
 }
 
 
+/* With single-cell update boxes, filling the inverse colormap comes
+ * down to a nearest-neighbour query, which a k-d tree over the colormap
+ * answers without scanning every colormap entry.  Ties are broken
+ * towards the lowest colormap index, like find_best_colors() does.
+ */
+
+static gint
+kd_node_compare (gconstpointer a,
+                 gconstpointer b,
+                 gpointer      data)
+{
+  const KDNode *node1 = a;
+  const KDNode *node2 = b;
+  gint          axis  = GPOINTER_TO_INT (data);
+
+  return node1->point[axis] - node2->point[axis];
+}
+
+static gint
+build_kd_tree_node (KDNode *nodes,
+                    gint    first,
+                    gint    n_nodes)
+{
+  gint min[3];
+  gint max[3];
+  gint axis;
+  gint median;
+  gint i, j;
+
+  if (n_nodes == 0)
+    return -1;
+
+  /* split along the axis with the largest spread */
+  for (j = 0; j < 3; j++)
+    min[j] = max[j] = nodes[first].point[j];
+
+  for (i = first + 1; i < first + n_nodes; i++)
+    {
+      for (j = 0; j < 3; j++)
+        {
+          min[j] = MIN (min[j], nodes[i].point[j]);
+          max[j] = MAX (max[j], nodes[i].point[j]);
+        }
+    }
+
+  axis = 0;
+
+  for (j = 1; j < 3; j++)
+    {
+      if (max[j] - min[j] > max[axis] - min[axis])
+        axis = j;
+    }
+
+  g_qsort_with_data (nodes + first, n_nodes, sizeof (KDNode),
+                     kd_node_compare, GINT_TO_POINTER (axis));
+
+  median = first + n_nodes / 2;
+
+  nodes[median].axis  = axis;
+  nodes[median].left  = build_kd_tree_node (nodes, first, median - first);
+  nodes[median].right = build_kd_tree_node (nodes, median + 1,
+                                            first + n_nodes - median - 1);
+
+  return median;
+}
+
+static void
+build_kd_tree (QuantizeObj *quantobj)
+{
+  gint i;
+
+  for (i = 0; i < quantobj->actual_number_of_colors; i++)
+    {
+      KDNode *node = &quantobj->kd_nodes[i];
+
+      node->point[0] = quantobj->clin[i].red   * R_SCALE;
+      node->point[1] = quantobj->clin[i].green * G_SCALE;
+      node->point[2] = quantobj->clin[i].blue  * B_SCALE;
+      node->index    = i;
+    }
+
+  quantobj->kd_root = build_kd_tree_node (quantobj->kd_nodes, 0,
+                                          quantobj->actual_number_of_colors);
+}
+
+static void
+search_kd_tree (const KDNode *nodes,
+                gint          node,
+                const gint    point[3],
+                gint         *best_dist,
+                gint         *best_index)
+{
+  while (node >= 0)
+    {
+      const KDNode *n = &nodes[node];
+      gint          dist;
+      gint          delta;
+      gint          i;
+
+      dist = 0;
+
+      for (i = 0; i < 3; i++)
+        {
+          gint d = point[i] - n->point[i];
+
+          dist += d * d;
+        }
+
+      if (dist < *best_dist ||
+          (dist == *best_dist && n->index < *best_index))
+        {
+          *best_dist  = dist;
+          *best_index = n->index;
+        }
+
+      delta = point[n->axis] - n->point[n->axis];
+
+      /* descend into the near side first; the far side can only hold
+       * an equal-or-better match if the splitting plane is close enough.
+       */
+      if (delta < 0)
+        {
+          search_kd_tree (nodes, n->left, point, best_dist, best_index);
+
+          if (delta * delta > *best_dist)
+            return;
+
+          node = n->right;
+        }
+      else
+        {
+          search_kd_tree (nodes, n->right, point, best_dist, best_index);
+
+          if (delta * delta > *best_dist)
+            return;
+
+          node = n->left;
+        }
+    }
+}
+
+
 /* Fill the inverse-colormap entries in the update box that contains
  * histogram cell R/G/B.  (Only that one cell MUST be filled, but we
  * can fill as many others as we wish.)
@@ -2748,6 +3093,25 @@ fill_inverse_cmap_rgb (QuantizeObj *quantobj,
   minG = (G << BOX_G_SHIFT) + ((1 << G_SHIFT) >> 1);
   minB = (B << BOX_B_SHIFT) + ((1 << B_SHIFT) >> 1);
 
+  if (BOX_R_ELEMS * BOX_G_ELEMS * BOX_B_ELEMS == 1 &&
+      quantobj->actual_number_of_colors >= KD_TREE_MIN_COLORS)
+    {
+      gint point[3];
+      gint best_dist  = G_MAXINT;
+      gint best_index = 0;
+
+      point[0] = minR * R_SCALE;
+      point[1] = minG * G_SCALE;
+      point[2] = minB * B_SCALE;
+
+      search_kd_tree (quantobj->kd_nodes, quantobj->kd_root, point,
+                      &best_dist, &best_index);
+
+      *HIST_LIN (histogram, R, G, B) = best_index + 1;
+
+      return;
+    }
+
   /* Determine which colormap entries are close enough to be candidates
    * for the nearest entry to some cell in the update box.
    */
@@ -3990,6 +4354,8 @@ median_cut_pass2_rgb_init (QuantizeObj *quantobj)
                             &quantobj->clin[i].green,
                             &quantobj->clin[i].blue);
     }
+
+  build_kd_tree (quantobj);
 }
 
 static void
@@ -80,6 +80,7 @@ struct _GimpImagePrivate
   GFile             *exported_file;         /*  the image's export file      */
   GFile             *save_a_copy_file;      /*  the image's save-a-copy file */
   GFile             *untitled_file;         /*  a file saying "Untitled"     */
+  guint64            file_mtime;            /*  file's mtime at load/save    */
 
   gboolean           xcf_compression;       /*  XCF compression enabled?     */
 
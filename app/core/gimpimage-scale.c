@@ -20,10 +20,16 @@
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
+#include "libgimpmath/gimpmath.h"
+
 #include "core-types.h"
 
+#include "config/gimpcoreconfig.h"
+
 #include "gimp.h"
+#include "gimpchannel.h"
 #include "gimpcontainer.h"
+#include "gimpdrawable-scale.h"
 #include "gimpguide.h"
 #include "gimpgrouplayer.h"
 #include "gimpimage.h"
@@ -32,7 +38,9 @@
 #include "gimpimage-scale.h"
 #include "gimpimage-undo.h"
 #include "gimpimage-undo-push.h"
+#include "gimpitemstack.h"
 #include "gimplayer.h"
+#include "gimplayermask.h"
 #include "gimpobjectqueue.h"
 #include "gimpprogress.h"
 #include "gimpprojection.h"
@@ -42,6 +50,59 @@
 #include "gimp-intl.h"
 
 
+typedef struct _ScaleScheduler ScaleScheduler;
+
+typedef struct
+{
+  ScaleScheduler *scheduler;
+  GimpDrawable   *drawable;
+  GeglBuffer     *source;
+  gint            new_width;
+  gint            new_height;
+  gint64          memsize;
+} ScaleJob;
+
+struct _ScaleScheduler
+{
+  GQueue                 pending;
+  GList                 *running;
+  gint64                 running_memsize;
+  gint64                 max_memsize;
+  GimpInterpolationType  interpolation_type;
+  gboolean               updating;
+  gboolean               clearing;
+};
+
+
+/*  local function prototypes  */
+
+static void     gimp_image_scale_scheduler_init     (ScaleScheduler        *scheduler,
+                                                     GimpImage             *image,
+                                                     gdouble                w_factor,
+                                                     gdouble                h_factor,
+                                                     GimpInterpolationType  interpolation_type);
+static void     gimp_image_scale_scheduler_add_tree (ScaleScheduler        *scheduler,
+                                                     GList                 *items,
+                                                     gdouble                w_factor,
+                                                     gdouble                h_factor,
+                                                     gint                   origin_x,
+                                                     gint                   origin_y,
+                                                     gint                   new_origin_x,
+                                                     gint                   new_origin_y);
+static void     gimp_image_scale_scheduler_add      (ScaleScheduler        *scheduler,
+                                                     GimpDrawable          *drawable,
+                                                     gint                   new_width,
+                                                     gint                   new_height);
+static void     gimp_image_scale_scheduler_update   (ScaleScheduler        *scheduler);
+static void     gimp_image_scale_scheduler_clear    (ScaleScheduler        *scheduler);
+
+static gboolean gimp_image_scale_job_is_stale       (ScaleJob              *job);
+static void     gimp_image_scale_job_done           (ScaleJob              *job);
+static void     gimp_image_scale_job_free           (ScaleJob              *job);
+
+
+/*  public functions  */
+
 void
 gimp_image_scale (GimpImage             *image,
                   gint                   new_width,
@@ -50,6 +111,7 @@ gimp_image_scale (GimpImage             *image,
                   GimpProgress          *progress)
 {
   GimpObjectQueue *queue;
+  ScaleScheduler   scheduler;
   GimpItem        *item;
   GList           *list;
   gint             old_width;
@@ -103,9 +165,18 @@ gimp_image_scale (GimpImage             *image,
                 "height", new_height,
                 NULL);
 
+  /*  Scale the drawables' contents concurrently, ahead of the items
+   *  being scaled below, within a bounded amount of memory
+   */
+  gimp_image_scale_scheduler_init (&scheduler, image,
+                                   img_scale_w, img_scale_h,
+                                   interpolation_type);
+
   /*  Scale all layers, channels (including selection mask), and vectors  */
   while ((item = gimp_object_queue_pop (queue)))
     {
+      gimp_image_scale_scheduler_update (&scheduler);
+
       if (! gimp_item_scale_by_factors (item,
                                         img_scale_w, img_scale_h,
                                         interpolation_type, progress))
@@ -120,6 +191,8 @@ gimp_image_scale (GimpImage             *image,
         }
     }
 
+  gimp_image_scale_scheduler_clear (&scheduler);
+
   /*  Scale all Guides  */
   for (list = gimp_image_get_guides (image);
        list;
@@ -258,3 +331,276 @@ gimp_image_scale_check (GimpImage *image,
 
   return GIMP_IMAGE_SCALE_OK;
 }
+
+
+/*  private functions  */
+
+static void
+gimp_image_scale_scheduler_init (ScaleScheduler        *scheduler,
+                                 GimpImage             *image,
+                                 gdouble                w_factor,
+                                 gdouble                h_factor,
+                                 GimpInterpolationType  interpolation_type)
+{
+  GList *masks = g_list_prepend (NULL, gimp_image_get_mask (image));
+
+  g_queue_init (&scheduler->pending);
+
+  scheduler->running            = NULL;
+  scheduler->running_memsize    = 0;
+  scheduler->interpolation_type = interpolation_type;
+  scheduler->updating           = FALSE;
+  scheduler->clearing           = FALSE;
+
+  /*  keep the prepared buffers within half the tile cache, so that
+   *  they don't get swapped out before they are used
+   */
+  scheduler->max_memsize =
+    GIMP_GEGL_CONFIG (image->gimp->config)->tile_cache_size / 2;
+
+  /*  add the drawables in the order in which they are scaled  */
+  gimp_image_scale_scheduler_add_tree (
+    scheduler,
+    gimp_item_stack_get_item_iter (
+      GIMP_ITEM_STACK (gimp_image_get_layers (image))),
+    w_factor, h_factor, 0, 0, 0, 0);
+
+  gimp_image_scale_scheduler_add_tree (scheduler, masks,
+                                       w_factor, h_factor, 0, 0, 0, 0);
+
+  gimp_image_scale_scheduler_add_tree (scheduler,
+                                       gimp_image_get_channel_iter (image),
+                                       w_factor, h_factor, 0, 0, 0, 0);
+
+  g_list_free (masks);
+
+  gimp_image_scale_scheduler_update (scheduler);
+}
+
+/*  this mirrors gimp_item_scale_by_factors_with_origin(), and the way
+ *  gimp_group_layer_scale() derives its children's factors from its own
+ *  new size.  if an item ends up being scaled to a different size after
+ *  all, its prepared buffer is simply discarded.
+ */
+static void
+gimp_image_scale_scheduler_add_tree (ScaleScheduler *scheduler,
+                                     GList          *items,
+                                     gdouble         w_factor,
+                                     gdouble         h_factor,
+                                     gint            origin_x,
+                                     gint            origin_y,
+                                     gint            new_origin_x,
+                                     gint            new_origin_y)
+{
+  GList *list;
+
+  for (list = items; list; list = g_list_next (list))
+    {
+      GimpItem      *item = list->data;
+      GimpContainer *children;
+      gint           offset_x;
+      gint           offset_y;
+      gint           new_offset_x;
+      gint           new_offset_y;
+      gint           new_width;
+      gint           new_height;
+
+      children = gimp_viewable_get_children (GIMP_VIEWABLE (item));
+
+      /*  empty layer groups are left alone  */
+      if (children && gimp_container_is_empty (children))
+        continue;
+
+      gimp_item_get_offset (item, &offset_x, &offset_y);
+
+      new_offset_x = SIGNED_ROUND (w_factor * (offset_x - origin_x));
+      new_offset_y = SIGNED_ROUND (h_factor * (offset_y - origin_y));
+      new_width    = SIGNED_ROUND (w_factor * (offset_x - origin_x +
+                                               gimp_item_get_width (item))) -
+                     new_offset_x;
+      new_height   = SIGNED_ROUND (h_factor * (offset_y - origin_y +
+                                               gimp_item_get_height (item))) -
+                     new_offset_y;
+
+      new_offset_x += new_origin_x;
+      new_offset_y += new_origin_y;
+
+      /*  the item is removed  */
+      if (new_width <= 0 || new_height <= 0)
+        continue;
+
+      if (children)
+        {
+          /*  the group's own buffer is updated from its children  */
+          gimp_image_scale_scheduler_add_tree (
+            scheduler,
+            gimp_item_stack_get_item_iter (GIMP_ITEM_STACK (children)),
+            (gdouble) new_width  / gimp_item_get_width  (item),
+            (gdouble) new_height / gimp_item_get_height (item),
+            offset_x, offset_y,
+            new_offset_x, new_offset_y);
+        }
+      else
+        {
+          gimp_image_scale_scheduler_add (scheduler, GIMP_DRAWABLE (item),
+                                          new_width, new_height);
+        }
+
+      if (GIMP_IS_LAYER (item) && gimp_layer_get_mask (GIMP_LAYER (item)))
+        {
+          gimp_image_scale_scheduler_add (
+            scheduler,
+            GIMP_DRAWABLE (gimp_layer_get_mask (GIMP_LAYER (item))),
+            new_width, new_height);
+        }
+    }
+}
+
+static void
+gimp_image_scale_scheduler_add (ScaleScheduler *scheduler,
+                                GimpDrawable   *drawable,
+                                gint            new_width,
+                                gint            new_height)
+{
+  ScaleJob *job;
+
+  /*  don't bother with empty channels, they aren't actually scaled  */
+  if (GIMP_IS_CHANNEL (drawable)              &&
+      GIMP_CHANNEL (drawable)->bounds_known &&
+      GIMP_CHANNEL (drawable)->empty)
+    {
+      return;
+    }
+
+  job = g_slice_new (ScaleJob);
+
+  job->scheduler  = scheduler;
+  job->drawable   = g_object_ref (drawable);
+  job->source     = g_object_ref (gimp_drawable_get_buffer (drawable));
+  job->new_width  = new_width;
+  job->new_height = new_height;
+  job->memsize    = gimp_drawable_estimate_memsize (
+                      drawable,
+                      gimp_drawable_get_component_type (drawable),
+                      new_width, new_height);
+
+  g_queue_push_tail (&scheduler->pending, job);
+}
+
+/*  called whenever a running job finishes, and between the top-level
+ *  items, to drop what became stale and to start more jobs
+ */
+static void
+gimp_image_scale_scheduler_update (ScaleScheduler *scheduler)
+{
+  GList *list;
+
+  if (scheduler->updating || scheduler->clearing)
+    return;
+
+  scheduler->updating = TRUE;
+
+  /*  cancel the running jobs of removed drawables.  jobs whose results
+   *  were consumed have already retired themselves.
+   */
+  for (list = scheduler->running; list; )
+    {
+      ScaleJob *job  = list->data;
+      GList    *next = g_list_next (list);
+
+      if (gimp_image_scale_job_is_stale (job))
+        gimp_drawable_cancel_prepared_scale (job->drawable);
+
+      list = next;
+    }
+
+  /*  start new jobs, as long as they fit in the memory budget.  always
+   *  keep at least one job running, however large.  jobs of drawables
+   *  that were scaled, or removed, before their turn came are dropped.
+   */
+  while (! g_queue_is_empty (&scheduler->pending))
+    {
+      ScaleJob *job = g_queue_peek_head (&scheduler->pending);
+
+      if (gimp_image_scale_job_is_stale (job))
+        {
+          g_queue_pop_head (&scheduler->pending);
+          gimp_image_scale_job_free (job);
+
+          continue;
+        }
+
+      if (scheduler->running &&
+          scheduler->running_memsize + job->memsize > scheduler->max_memsize)
+        {
+          break;
+        }
+
+      g_queue_pop_head (&scheduler->pending);
+
+      scheduler->running          = g_list_prepend (scheduler->running, job);
+      scheduler->running_memsize += job->memsize;
+
+      gimp_drawable_prepare_scale (job->drawable,
+                                   job->new_width, job->new_height,
+                                   scheduler->interpolation_type,
+                                   (GDestroyNotify) gimp_image_scale_job_done,
+                                   job);
+    }
+
+  scheduler->updating = FALSE;
+}
+
+static void
+gimp_image_scale_scheduler_clear (ScaleScheduler *scheduler)
+{
+  ScaleJob *job;
+
+  scheduler->clearing = TRUE;
+
+  /*  drop the results of drawables that weren't scaled after all  */
+  while ((job = g_queue_pop_head (&scheduler->pending)))
+    gimp_image_scale_job_free (job);
+
+  /*  each canceled job removes itself from the list  */
+  while (scheduler->running)
+    {
+      job = scheduler->running->data;
+
+      gimp_drawable_cancel_prepared_scale (job->drawable);
+    }
+
+  scheduler->clearing = FALSE;
+}
+
+static gboolean
+gimp_image_scale_job_is_stale (ScaleJob *job)
+{
+  return (! gimp_item_is_attached (GIMP_ITEM (job->drawable)) ||
+          gimp_drawable_get_buffer (job->drawable) != job->source);
+}
+
+/*  the prepared scale was consumed by gimp_drawable_scale(), or
+ *  canceled; either way its memory is released
+ */
+static void
+gimp_image_scale_job_done (ScaleJob *job)
+{
+  ScaleScheduler *scheduler = job->scheduler;
+
+  scheduler->running          = g_list_remove (scheduler->running, job);
+  scheduler->running_memsize -= job->memsize;
+
+  gimp_image_scale_job_free (job);
+
+  gimp_image_scale_scheduler_update (scheduler);
+}
+
+static void
+gimp_image_scale_job_free (ScaleJob *job)
+{
+  g_object_unref (job->drawable);
+  g_object_unref (job->source);
+
+  g_slice_free (ScaleJob, job);
+}
@@ -34,12 +34,18 @@
 #include "gimpundostack.h"
 
 
+/*  the number of most recent undo steps that are never spilled to disk  */
+#define N_RESIDENT_UNDO_STEPS 2
+
+
 /*  local function prototypes  */
 
-static void          gimp_image_undo_pop_stack       (GimpImage     *image,
+static gboolean      gimp_image_undo_pop_stack       (GimpImage     *image,
                                                       GimpUndoStack *undo_stack,
                                                       GimpUndoStack *redo_stack,
                                                       GimpUndoMode   undo_mode);
+static gint64        gimp_image_undo_get_stack_size  (GimpImage     *image);
+static void          gimp_image_undo_spill_space     (GimpImage     *image);
 static void          gimp_image_undo_free_space      (GimpImage     *image);
 static void          gimp_image_undo_free_redo       (GimpImage     *image);
 
@@ -123,12 +129,10 @@ gimp_image_undo (GimpImage *image)
   g_return_val_if_fail (private->pushing_undo_group == GIMP_UNDO_GROUP_NONE,
                         FALSE);
 
-  gimp_image_undo_pop_stack (image,
-                             private->undo_stack,
-                             private->redo_stack,
-                             GIMP_UNDO_MODE_UNDO);
-
-  return TRUE;
+  return gimp_image_undo_pop_stack (image,
+                                    private->undo_stack,
+                                    private->redo_stack,
+                                    GIMP_UNDO_MODE_UNDO);
 }
 
 gboolean
@@ -143,12 +147,10 @@ gimp_image_redo (GimpImage *image)
   g_return_val_if_fail (private->pushing_undo_group == GIMP_UNDO_GROUP_NONE,
                         FALSE);
 
-  gimp_image_undo_pop_stack (image,
-                             private->redo_stack,
-                             private->undo_stack,
-                             GIMP_UNDO_MODE_REDO);
-
-  return TRUE;
+  return gimp_image_undo_pop_stack (image,
+                                    private->redo_stack,
+                                    private->undo_stack,
+                                    GIMP_UNDO_MODE_REDO);
 }
 
 /*
@@ -262,6 +264,37 @@ gimp_image_undo_free (GimpImage *image)
    */
 }
 
+/**
+ * gimp_image_undo_get_memsize:
+ * @image:        a #GimpImage
+ * @spilled_size: return location for the size of undo data that has
+ *                been spilled to disk, or %NULL
+ *
+ * Returns: the memory used by the undo and redo stacks of @image,
+ *          excluding undo data that has been spilled to disk.
+ **/
+gint64
+gimp_image_undo_get_memsize (GimpImage *image,
+                             gint64    *spilled_size)
+{
+  GimpImagePrivate *private;
+  gint64            memsize;
+
+  g_return_val_if_fail (GIMP_IS_IMAGE (image), 0);
+
+  private = GIMP_IMAGE_GET_PRIVATE (image);
+
+  memsize = (gimp_object_get_memsize (GIMP_OBJECT (private->undo_stack), NULL) +
+             gimp_object_get_memsize (GIMP_OBJECT (private->redo_stack), NULL));
+
+  if (spilled_size)
+    *spilled_size =
+      gimp_undo_get_spilled_size (GIMP_UNDO (private->undo_stack), NULL) +
+      gimp_undo_get_spilled_size (GIMP_UNDO (private->redo_stack), NULL);
+
+  return memsize;
+}
+
 gint
 gimp_image_get_undo_group_count (GimpImage *image)
 {
@@ -463,7 +496,7 @@ gimp_image_undo_can_compress (GimpImage    *image,
 
 /*  private functions  */
 
-static void
+static gboolean
 gimp_image_undo_pop_stack (GimpImage     *image,
                            GimpUndoStack *undo_stack,
                            GimpUndoStack *redo_stack,
@@ -471,6 +504,22 @@ gimp_image_undo_pop_stack (GimpImage     *image,
 {
   GimpUndo            *undo;
   GimpUndoAccumulator  accum = { 0, };
+  GError              *error = NULL;
+
+  /*  bring the step back into memory first, so that it's either popped
+   *  completely or not at all.  a step that can't be read back stays
+   *  on the stack.
+   */
+  undo = gimp_undo_stack_peek (undo_stack);
+
+  if (undo && ! gimp_undo_unspill (undo, &error))
+    {
+      gimp_message_literal (image->gimp, NULL, GIMP_MESSAGE_ERROR,
+                            error->message);
+      g_clear_error (&error);
+
+      return FALSE;
+    }
 
   g_object_freeze_notify (G_OBJECT (image));
 
@@ -483,6 +532,22 @@ gimp_image_undo_pop_stack (GimpImage     *image,
 
       gimp_undo_stack_push_undo (redo_stack, undo);
 
+      /*  the user is stepping back through the history, start bringing
+       *  the next spilled steps back into memory
+       */
+      if (undo_mode == GIMP_UNDO_MODE_UNDO)
+        {
+          GList *list;
+          gint   i;
+
+          for (list = GIMP_LIST (undo_stack->undos)->queue->head, i = 0;
+               list && i < N_RESIDENT_UNDO_STEPS;
+               list = g_list_next (list), i++)
+            {
+              gimp_undo_prefetch (list->data);
+            }
+        }
+
       if (accum.mode_changed)
         gimp_image_mode_changed (image);
 
@@ -510,6 +575,57 @@ gimp_image_undo_pop_stack (GimpImage     *image,
     }
 
   g_object_thaw_notify (G_OBJECT (image));
+
+  return TRUE;
+}
+
+/*  returns the memory used by the undo stack, not counting buffers
+ *  that are still resident but already being spilled to disk
+ */
+static gint64
+gimp_image_undo_get_stack_size (GimpImage *image)
+{
+  GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
+  gint64            memsize;
+  gint64            pending_size;
+
+  memsize = gimp_object_get_memsize (GIMP_OBJECT (private->undo_stack->undos),
+                                     NULL);
+
+  gimp_undo_get_spilled_size (GIMP_UNDO (private->undo_stack), &pending_size);
+
+  return memsize - pending_size;
+}
+
+static void
+gimp_image_undo_spill_space (GimpImage *image)
+{
+  GimpImagePrivate *private = GIMP_IMAGE_GET_PRIVATE (image);
+  GimpContainer    *container;
+  GList            *list;
+  gint64            memsize;
+  gint64            undo_size;
+  gint              n_steps;
+
+  container = private->undo_stack->undos;
+
+  memsize   = gimp_image_undo_get_stack_size (image);
+  undo_size = image->gimp->config->undo_size;
+  n_steps   = gimp_container_get_n_children (container);
+
+  /*  move the oldest steps out of memory, keeping the most recent ones
+   *  resident so that the next few undos stay fast
+   */
+  for (list = GIMP_LIST (container)->queue->tail;
+       list && memsize > undo_size && n_steps > N_RESIDENT_UNDO_STEPS;
+       list = g_list_previous (list), n_steps--)
+    {
+      memsize -= gimp_undo_spill (list->data);
+    }
+
+#ifdef DEBUG_IMAGE_UNDO
+  g_printerr ("spilled undo steps: undo_bytes: %ld\n", (glong) memsize);
+#endif
 }
 
 static void
@@ -533,11 +649,14 @@ gimp_image_undo_free_space (GimpImage *image)
               (glong) gimp_object_get_memsize (GIMP_OBJECT (container), NULL));
 #endif
 
+  /*  first try to make room by spilling old steps to disk  */
+  gimp_image_undo_spill_space (image);
+
   /*  keep at least min_undo_levels undo steps  */
   if (gimp_container_get_n_children (container) <= min_undo_levels)
     return;
 
-  while ((gimp_object_get_memsize (GIMP_OBJECT (container), NULL) > undo_size) ||
+  while ((gimp_image_undo_get_stack_size (image) > undo_size) ||
          (gimp_container_get_n_children (container) > max_undo_levels))
     {
       GimpUndo *freed = gimp_undo_stack_free_bottom (private->undo_stack,
@@ -36,6 +36,9 @@ GimpUndoStack * gimp_image_get_redo_stack       (GimpImage     *image);
 
 void            gimp_image_undo_free            (GimpImage     *image);
 
+gint64          gimp_image_undo_get_memsize     (GimpImage     *image,
+                                                 gint64        *spilled_size);
+
 gint            gimp_image_get_undo_group_count (GimpImage     *image);
 gboolean        gimp_image_undo_group_start     (GimpImage     *image,
                                                  GimpUndoType   undo_type,
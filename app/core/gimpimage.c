@@ -2299,6 +2299,9 @@ gimp_image_set_file (GimpImage *image,
 
   private = GIMP_IMAGE_GET_PRIVATE (image);
 
+  /*  only known again once the image was loaded from, or saved to, it  */
+  private->file_mtime = 0;
+
   if (private->file != file)
     {
       gimp_object_take_name (GIMP_OBJECT (image),
@@ -2609,6 +2612,62 @@ gimp_image_format_display_uri (GimpImage *image,
   return display_uri;
 }
 
+/**
+ * gimp_image_update_file_mtime:
+ * @image: A #GimpImage.
+ *
+ * Records the modification time of @image's XCF file.  This is called
+ * right after the image was loaded from, or saved to, the file, when
+ * the image's content matches the file's.
+ **/
+void
+gimp_image_update_file_mtime (GimpImage *image)
+{
+  GimpImagePrivate *private;
+  GFileInfo        *info = NULL;
+
+  g_return_if_fail (GIMP_IS_IMAGE (image));
+
+  private = GIMP_IMAGE_GET_PRIVATE (image);
+
+  private->file_mtime = 0;
+
+  if (private->file)
+    info = g_file_query_info (private->file,
+                              G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                              G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                              G_FILE_QUERY_INFO_NONE,
+                              NULL, NULL);
+
+  if (info)
+    {
+      private->file_mtime =
+        g_file_info_get_attribute_uint64 (info,
+                                          G_FILE_ATTRIBUTE_TIME_MODIFIED) *
+        G_USEC_PER_SEC +
+        g_file_info_get_attribute_uint32 (info,
+                                          G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+
+      g_object_unref (info);
+    }
+}
+
+/**
+ * gimp_image_get_file_mtime:
+ * @image: A #GimpImage.
+ *
+ * Returns: the modification time of @image's XCF file, in microseconds,
+ *          as recorded when the image was last loaded or saved, or 0
+ *          if it is unknown.
+ **/
+guint64
+gimp_image_get_file_mtime (GimpImage *image)
+{
+  g_return_val_if_fail (GIMP_IS_IMAGE (image), 0);
+
+  return GIMP_IMAGE_GET_PRIVATE (image)->file_mtime;
+}
+
 const gchar *
 gimp_image_get_display_name (GimpImage *image)
 {
@@ -164,6 +164,9 @@ void            gimp_image_set_exported_file     (GimpImage          *image,
 void            gimp_image_set_save_a_copy_file  (GimpImage          *image,
                                                   GFile              *file);
 
+void            gimp_image_update_file_mtime     (GimpImage          *image);
+guint64         gimp_image_get_file_mtime        (GimpImage          *image);
+
 const gchar   * gimp_image_get_display_name      (GimpImage          *image);
 const gchar   * gimp_image_get_display_path      (GimpImage          *image);
 
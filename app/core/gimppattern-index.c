@@ -0,0 +1,153 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "core-types.h"
+
+#include "gimppattern.h"
+#include "gimppattern-index.h"
+#include "gimptagged.h"
+#include "gimptempbuf.h"
+
+
+/*  name, size, checksum, and the format, size and pixels of a preview
+ *  cropped from the pattern's top-left corner
+ */
+#define GIMP_PATTERN_INDEX_TYPE         "(siissiiay)"
+#define GIMP_PATTERN_INDEX_PREVIEW_SIZE 64
+
+
+/*  public functions  */
+
+GimpData *
+gimp_pattern_index_load (GFile    *file,
+                         GVariant *entry)
+{
+  GimpPattern  *pattern;
+  const gchar  *name;
+  const gchar  *checksum;
+  const gchar  *format_name;
+  gint32        width;
+  gint32        height;
+  gint32        preview_width;
+  gint32        preview_height;
+  GVariant     *pixels;
+  const guchar *data;
+  gsize         size;
+  const Babl   *format = NULL;
+
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (entry != NULL, NULL);
+
+  if (! g_variant_is_of_type (entry, G_VARIANT_TYPE (GIMP_PATTERN_INDEX_TYPE)))
+    return NULL;
+
+  g_variant_get (entry, "(&sii&s&sii@ay)",
+                 &name, &width, &height, &checksum,
+                 &format_name, &preview_width, &preview_height,
+                 &pixels);
+
+  data = g_variant_get_fixed_array (pixels, &size, 1);
+
+  if (babl_format_exists (format_name))
+    format = babl_format (format_name);
+
+  /*  a broken entry makes the factory decode the file instead  */
+  if (! format                                                      ||
+      width <= 0 || height <= 0                                     ||
+      preview_width  <= 0 || preview_width  > width                 ||
+      preview_height <= 0 || preview_height > height                ||
+      preview_width  > GIMP_PATTERN_INDEX_PREVIEW_SIZE              ||
+      preview_height > GIMP_PATTERN_INDEX_PREVIEW_SIZE              ||
+      size != ((gsize) preview_width * preview_height *
+               babl_format_get_bytes_per_pixel (format)))
+    {
+      g_variant_unref (pixels);
+
+      return NULL;
+    }
+
+  pattern = g_object_new (GIMP_TYPE_PATTERN,
+                          "name", name,
+                          NULL);
+
+  pattern->lazy   = TRUE;
+  pattern->width  = width;
+  pattern->height = height;
+
+  if (*checksum)
+    pattern->checksum = g_strdup (checksum);
+
+  pattern->preview = gimp_temp_buf_new (preview_width, preview_height, format);
+
+  memcpy (gimp_temp_buf_get_data (pattern->preview), data, size);
+
+  g_variant_unref (pixels);
+
+  return GIMP_DATA (pattern);
+}
+
+GVariant *
+gimp_pattern_index_save (GimpData *data)
+{
+  GimpPattern *pattern;
+  GimpTempBuf *preview;
+  gchar       *checksum;
+  gint         width;
+  gint         height;
+  GVariant    *entry;
+
+  g_return_val_if_fail (GIMP_IS_PATTERN (data), NULL);
+
+  pattern = GIMP_PATTERN (data);
+
+  gimp_viewable_get_size (GIMP_VIEWABLE (pattern), &width, &height);
+
+  preview = gimp_viewable_get_new_preview (GIMP_VIEWABLE (pattern), NULL,
+                                           GIMP_PATTERN_INDEX_PREVIEW_SIZE,
+                                           GIMP_PATTERN_INDEX_PREVIEW_SIZE);
+
+  if (! preview)
+    return NULL;
+
+  checksum = gimp_tagged_get_checksum (GIMP_TAGGED (pattern));
+
+  entry = g_variant_new ("(siissii@ay)",
+                         gimp_object_get_name (pattern),
+                         width, height,
+                         checksum ? checksum : "",
+                         babl_get_name (gimp_temp_buf_get_format (preview)),
+                         gimp_temp_buf_get_width  (preview),
+                         gimp_temp_buf_get_height (preview),
+                         g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+                                                    gimp_temp_buf_get_data (preview),
+                                                    gimp_temp_buf_get_data_size (preview),
+                                                    1));
+
+  g_free (checksum);
+  gimp_temp_buf_unref (preview);
+
+  return entry;
+}
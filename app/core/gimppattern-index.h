@@ -0,0 +1,30 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_PATTERN_INDEX_H__
+#define __GIMP_PATTERN_INDEX_H__
+
+
+/*  don't call these functions directly, they are used by the pattern
+ *  factory's data index
+ */
+GimpData * gimp_pattern_index_load (GFile    *file,
+                                    GVariant *entry);
+GVariant * gimp_pattern_index_save (GimpData *data);
+
+
+#endif  /*  __GIMP_PATTERN_INDEX_H__  */
@@ -28,15 +28,25 @@
 
 #include "gegl/gimp-gegl-loops.h"
 
+#include "gimp-memsize.h"
+#include "gimp-parallel.h"
+#include "gimpasync.h"
 #include "gimppattern.h"
 #include "gimppattern-load.h"
 #include "gimppattern-save.h"
 #include "gimptagged.h"
 #include "gimptempbuf.h"
+#include "gimpwaitable.h"
 
 #include "gimp-intl.h"
 
 
+/*  the amount of memory the decoded masks of lazy patterns may use,
+ *  before the least recently used ones are dropped again
+ */
+#define GIMP_PATTERN_MASK_BUDGET (64 * 1024 * 1024)
+
+
 static void          gimp_pattern_tagged_iface_init (GimpTaggedInterface  *iface);
 static void          gimp_pattern_finalize          (GObject              *object);
 
@@ -59,6 +69,14 @@ static void          gimp_pattern_copy              (GimpData             *data,
 
 static gchar       * gimp_pattern_get_checksum      (GimpTagged           *tagged);
 
+static GimpTempBuf * gimp_pattern_get_mask_unlocked (GimpPattern          *pattern);
+static void          gimp_pattern_start_decode      (GimpPattern          *pattern);
+static void          gimp_pattern_decode_mask       (GimpPattern          *pattern);
+static void          gimp_pattern_decode_func       (GimpAsync            *async,
+                                                     GFile                *file);
+static void          gimp_pattern_drop_lazy         (GimpPattern          *pattern);
+static gboolean      gimp_pattern_trim_masks        (gpointer              data);
+
 
 G_DEFINE_TYPE_WITH_CODE (GimpPattern, gimp_pattern, GIMP_TYPE_DATA,
                          G_IMPLEMENT_INTERFACE (GIMP_TYPE_TAGGED,
@@ -67,6 +85,15 @@ G_DEFINE_TYPE_WITH_CODE (GimpPattern, gimp_pattern, GIMP_TYPE_DATA,
 #define parent_class gimp_pattern_parent_class
 
 
+/*  protects the masks of lazy patterns, which may be decoded from the
+ *  paint thread.  'lazy_masks' holds the lazy patterns with a decoded
+ *  mask, from the most to the least recently used.
+ */
+static GMutex  lazy_mutex;
+static GList  *lazy_masks   = NULL;
+static guint   lazy_trim_id = 0;
+
+
 static void
 gimp_pattern_class_init (GimpPatternClass *klass)
 {
@@ -106,7 +133,11 @@ gimp_pattern_finalize (GObject *object)
 {
   GimpPattern *pattern = GIMP_PATTERN (object);
 
-  g_clear_pointer (&pattern->mask, gimp_temp_buf_unref);
+  gimp_pattern_drop_lazy (pattern);
+
+  g_clear_pointer (&pattern->mask,     gimp_temp_buf_unref);
+  g_clear_pointer (&pattern->preview,  gimp_temp_buf_unref);
+  g_clear_pointer (&pattern->checksum, g_free);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -118,8 +149,15 @@ gimp_pattern_get_memsize (GimpObject *object,
   GimpPattern *pattern = GIMP_PATTERN (object);
   gint64       memsize = 0;
 
+  g_mutex_lock (&lazy_mutex);
+
   memsize += gimp_temp_buf_get_memsize (pattern->mask);
 
+  g_mutex_unlock (&lazy_mutex);
+
+  memsize += gimp_temp_buf_get_memsize (pattern->preview);
+  memsize += gimp_string_get_memsize (pattern->checksum);
+
   return memsize + GIMP_OBJECT_CLASS (parent_class)->get_memsize (object,
                                                                   gui_size);
 }
@@ -131,8 +169,16 @@ gimp_pattern_get_size (GimpViewable *viewable,
 {
   GimpPattern *pattern = GIMP_PATTERN (viewable);
 
-  *width  = gimp_temp_buf_get_width  (pattern->mask);
-  *height = gimp_temp_buf_get_height (pattern->mask);
+  if (pattern->lazy)
+    {
+      *width  = pattern->width;
+      *height = pattern->height;
+    }
+  else
+    {
+      *width  = gimp_temp_buf_get_width  (pattern->mask);
+      *height = gimp_temp_buf_get_height (pattern->mask);
+    }
 
   return TRUE;
 }
@@ -144,19 +190,38 @@ gimp_pattern_get_new_preview (GimpViewable *viewable,
                               gint          height)
 {
   GimpPattern *pattern = GIMP_PATTERN (viewable);
+  GimpTempBuf *src;
   GimpTempBuf *temp_buf;
   GeglBuffer  *src_buffer;
   GeglBuffer  *dest_buffer;
+  gint         pattern_width;
+  gint         pattern_height;
   gint         copy_width;
   gint         copy_height;
 
-  copy_width  = MIN (width,  gimp_temp_buf_get_width  (pattern->mask));
-  copy_height = MIN (height, gimp_temp_buf_get_height (pattern->mask));
+  gimp_viewable_get_size (viewable, &pattern_width, &pattern_height);
+
+  copy_width  = MIN (width,  pattern_width);
+  copy_height = MIN (height, pattern_height);
+
+  /*  the preview is a crop of the mask too, so a lazy pattern's mask
+   *  is only decoded for large previews
+   */
+  if (pattern->lazy &&
+      copy_width  <= gimp_temp_buf_get_width  (pattern->preview) &&
+      copy_height <= gimp_temp_buf_get_height (pattern->preview))
+    {
+      src = pattern->preview;
+    }
+  else
+    {
+      src = gimp_pattern_get_mask (pattern);
+    }
 
   temp_buf = gimp_temp_buf_new (copy_width, copy_height,
-                                gimp_temp_buf_get_format (pattern->mask));
+                                gimp_temp_buf_get_format (src));
 
-  src_buffer  = gimp_temp_buf_create_buffer (pattern->mask);
+  src_buffer  = gimp_temp_buf_create_buffer (src);
   dest_buffer = gimp_temp_buf_create_buffer (temp_buf);
 
   gimp_gegl_buffer_copy (src_buffer,
@@ -175,11 +240,14 @@ gimp_pattern_get_description (GimpViewable  *viewable,
                               gchar        **tooltip)
 {
   GimpPattern *pattern = GIMP_PATTERN (viewable);
+  gint         width;
+  gint         height;
+
+  gimp_viewable_get_size (viewable, &width, &height);
 
   return g_strdup_printf ("%s (%d × %d)",
                           gimp_object_get_name (pattern),
-                          gimp_temp_buf_get_width  (pattern->mask),
-                          gimp_temp_buf_get_height (pattern->mask));
+                          width, height);
 }
 
 static const gchar *
@@ -195,8 +263,10 @@ gimp_pattern_copy (GimpData *data,
   GimpPattern *pattern     = GIMP_PATTERN (data);
   GimpPattern *src_pattern = GIMP_PATTERN (src_data);
 
+  gimp_pattern_drop_lazy (pattern);
+
   g_clear_pointer (&pattern->mask, gimp_temp_buf_unref);
-  pattern->mask = gimp_temp_buf_copy (src_pattern->mask);
+  pattern->mask = gimp_temp_buf_copy (gimp_pattern_get_mask (src_pattern));
 
   gimp_data_dirty (data);
 }
@@ -207,6 +277,10 @@ gimp_pattern_get_checksum (GimpTagged *tagged)
   GimpPattern *pattern         = GIMP_PATTERN (tagged);
   gchar       *checksum_string = NULL;
 
+  /*  don't decode a lazy pattern only to tag it  */
+  if (pattern->lazy)
+    return g_strdup (pattern->checksum);
+
   if (pattern->mask)
     {
       GChecksum *checksum = g_checksum_new (G_CHECKSUM_MD5);
@@ -270,18 +344,254 @@ gimp_pattern_get_standard (GimpContext *context)
   return standard_pattern;
 }
 
+/*  starts decoding a lazy pattern's mask in the background, so that a
+ *  following gimp_pattern_get_mask() doesn't have to wait for it
+ */
+void
+gimp_pattern_prefetch (GimpPattern *pattern)
+{
+  g_return_if_fail (GIMP_IS_PATTERN (pattern));
+
+  if (! pattern->lazy)
+    return;
+
+  g_mutex_lock (&lazy_mutex);
+
+  if (pattern->lazy && ! pattern->mask)
+    gimp_pattern_start_decode (pattern);
+
+  g_mutex_unlock (&lazy_mutex);
+}
+
+/*  returns the format of the pattern's mask, without decoding the mask
+ *  of a lazy pattern.  its preview is a crop of the mask, in the same
+ *  format.
+ */
+const Babl *
+gimp_pattern_get_format (GimpPattern *pattern)
+{
+  g_return_val_if_fail (GIMP_IS_PATTERN (pattern), NULL);
+
+  if (pattern->lazy)
+    return gimp_temp_buf_get_format (pattern->preview);
+
+  return gimp_temp_buf_get_format (pattern->mask);
+}
+
+/*  the returned mask is only valid until the next main loop
+ *  iteration, use gimp_pattern_create_buffer() to keep it around
+ */
 GimpTempBuf *
 gimp_pattern_get_mask (GimpPattern *pattern)
 {
+  GimpTempBuf *mask;
+
   g_return_val_if_fail (GIMP_IS_PATTERN (pattern), NULL);
 
-  return pattern->mask;
+  if (! pattern->lazy)
+    return pattern->mask;
+
+  g_mutex_lock (&lazy_mutex);
+
+  mask = gimp_pattern_get_mask_unlocked (pattern);
+
+  g_mutex_unlock (&lazy_mutex);
+
+  return mask;
 }
 
 GeglBuffer *
 gimp_pattern_create_buffer (GimpPattern *pattern)
 {
+  GeglBuffer *buffer;
+
   g_return_val_if_fail (GIMP_IS_PATTERN (pattern), NULL);
 
-  return gimp_temp_buf_create_buffer (pattern->mask);
+  if (! pattern->lazy)
+    return gimp_temp_buf_create_buffer (pattern->mask);
+
+  g_mutex_lock (&lazy_mutex);
+
+  buffer = gimp_temp_buf_create_buffer (
+    gimp_pattern_get_mask_unlocked (pattern));
+
+  g_mutex_unlock (&lazy_mutex);
+
+  return buffer;
+}
+
+
+/*  private functions  */
+
+static GimpTempBuf *
+gimp_pattern_get_mask_unlocked (GimpPattern *pattern)
+{
+  if (! pattern->mask)
+    {
+      gimp_pattern_decode_mask (pattern);
+
+      if (! lazy_trim_id)
+        lazy_trim_id = g_idle_add (gimp_pattern_trim_masks, NULL);
+    }
+
+  if (pattern->lazy && lazy_masks->data != pattern)
+    {
+      lazy_masks = g_list_remove (lazy_masks, pattern);
+      lazy_masks = g_list_prepend (lazy_masks, pattern);
+    }
+
+  return pattern->mask;
+}
+
+static void
+gimp_pattern_start_decode (GimpPattern *pattern)
+{
+  GFile *file = gimp_data_get_file (GIMP_DATA (pattern));
+
+  if (! pattern->mask_async && file)
+    {
+      pattern->mask_async = gimp_parallel_run_async_full (
+        0,
+        (GimpRunAsyncFunc) gimp_pattern_decode_func,
+        g_object_ref (file),
+        (GDestroyNotify) g_object_unref);
+    }
+}
+
+static void
+gimp_pattern_decode_mask (GimpPattern *pattern)
+{
+  gimp_pattern_start_decode (pattern);
+
+  if (pattern->mask_async)
+    {
+      gimp_waitable_wait (GIMP_WAITABLE (pattern->mask_async));
+
+      if (gimp_async_is_finished (pattern->mask_async))
+        {
+          pattern->mask =
+            gimp_temp_buf_ref (gimp_async_get_result (pattern->mask_async));
+        }
+
+      g_clear_object (&pattern->mask_async);
+    }
+
+  if (pattern->mask)
+    {
+      lazy_masks = g_list_prepend (lazy_masks, pattern);
+    }
+  else
+    {
+      /*  the file went away or broke since it was indexed, keep using
+       *  the preview, so callers always get a mask
+       */
+      pattern->lazy = FALSE;
+      pattern->mask = gimp_temp_buf_ref (pattern->preview);
+    }
+}
+
+/*  runs in a worker thread, and uses the same loaders as the pattern
+ *  factory
+ */
+static void
+gimp_pattern_decode_func (GimpAsync *async,
+                          GFile     *file)
+{
+  GInputStream *input;
+  GList        *list = NULL;
+
+  input = G_INPUT_STREAM (g_file_read (file, NULL, NULL));
+
+  if (input)
+    {
+      GInputStream *buffered = g_buffered_input_stream_new (input);
+
+      if (gimp_file_has_extension (file, GIMP_PATTERN_FILE_EXTENSION))
+        list = gimp_pattern_load (NULL, file, buffered, NULL);
+      else
+        list = gimp_pattern_load_pixbuf (NULL, file, buffered, NULL);
+
+      g_object_unref (buffered);
+      g_object_unref (input);
+    }
+
+  if (list && GIMP_PATTERN (list->data)->mask)
+    {
+      GimpPattern *pattern = list->data;
+
+      gimp_async_finish_full (async,
+                              g_steal_pointer (&pattern->mask),
+                              (GDestroyNotify) gimp_temp_buf_unref);
+    }
+  else
+    {
+      gimp_async_abort (async);
+    }
+
+  g_list_free_full (list, g_object_unref);
+}
+
+static void
+gimp_pattern_drop_lazy (GimpPattern *pattern)
+{
+  if (! pattern->lazy)
+    return;
+
+  g_mutex_lock (&lazy_mutex);
+
+  if (pattern->mask_async)
+    {
+      gimp_async_cancel_and_wait (pattern->mask_async);
+      g_clear_object (&pattern->mask_async);
+    }
+
+  lazy_masks = g_list_remove (lazy_masks, pattern);
+
+  pattern->lazy = FALSE;
+
+  g_mutex_unlock (&lazy_mutex);
+
+  g_clear_pointer (&pattern->preview,  gimp_temp_buf_unref);
+  g_clear_pointer (&pattern->checksum, g_free);
+}
+
+/*  drops the least recently used masks which exceed the budget.  this
+ *  runs from an idle, so masks returned by gimp_pattern_get_mask()
+ *  stay valid while they are being used.
+ */
+static gboolean
+gimp_pattern_trim_masks (gpointer data)
+{
+  GList  *list;
+  GList  *next;
+  gint64  memsize = 0;
+
+  g_mutex_lock (&lazy_mutex);
+
+  lazy_trim_id = 0;
+
+  for (list = lazy_masks; list; list = next)
+    {
+      GimpPattern *pattern      = list->data;
+      gint64       mask_memsize = gimp_temp_buf_get_memsize (pattern->mask);
+
+      next = g_list_next (list);
+
+      /*  always keep the most recently used mask  */
+      if (list != lazy_masks &&
+          memsize + mask_memsize > GIMP_PATTERN_MASK_BUDGET)
+        {
+          g_clear_pointer (&pattern->mask, gimp_temp_buf_unref);
+
+          lazy_masks = g_list_delete_link (lazy_masks, list);
+        }
+      else
+        {
+          memsize += mask_memsize;
+        }
+    }
+
+  g_mutex_unlock (&lazy_mutex);
+
+  return G_SOURCE_REMOVE;
 }
@@ -37,6 +37,16 @@ struct _GimpPattern
   GimpData     parent_instance;
 
   GimpTempBuf *mask;
+
+  /*  patterns created from the data index decode their mask on first
+   *  use, and drop it again when it wasn't used for a while
+   */
+  gboolean     lazy;
+  gint         width;
+  gint         height;
+  gchar       *checksum;
+  GimpTempBuf *preview;
+  GimpAsync   *mask_async;
 };
 
 struct _GimpPatternClass
@@ -51,6 +61,9 @@ GimpData    * gimp_pattern_new           (GimpContext *context,
                                           const gchar *name);
 GimpData    * gimp_pattern_get_standard  (GimpContext *context);
 
+void          gimp_pattern_prefetch      (GimpPattern *pattern);
+
+const Babl  * gimp_pattern_get_format    (GimpPattern *pattern);
 GimpTempBuf * gimp_pattern_get_mask      (GimpPattern *pattern);
 GeglBuffer  * gimp_pattern_create_buffer (GimpPattern *pattern);
 
@@ -32,6 +32,8 @@ extern "C"
 #include "core-types.h"
 
 #include "gegl/gimp-babl.h"
+#include "gegl/gimp-gegl-mask-combine.h"
+#include "gegl/gimp-gegl-utils.h"
 
 #include "gimp-parallel.h"
 #include "gimp-utils.h" /* GIMP_TIMER */
@@ -46,6 +48,11 @@ extern "C"
 #define PIXELS_PER_THREAD \
   (/* each thread costs as much as */ 64.0 * 64.0 /* pixels */)
 
+/* how many segments find_contiguous_region() processes between checks
+ * for cancellation
+ */
+#define SEGMENTS_PER_CANCEL_CHECK 256
+
 
 typedef struct
 {
@@ -54,9 +61,41 @@ typedef struct
   gint   level;
 } BorderPixel;
 
+typedef struct
+{
+  GeglBuffer          *src_buffer;
+  gboolean             antialias;
+  gfloat               threshold;
+  gboolean             select_transparent;
+  GimpSelectCriterion  select_criterion;
+  gboolean             diagonal_neighbors;
+  GimpVector2         *seeds;
+  gint                 n_seeds;
+} ContiguousRegionData;
+
 
 /*  local function prototypes  */
 
+static GeglBuffer * contiguous_region_by_seed (GeglBuffer          *src_buffer,
+                                               gint                 level,
+                                               gboolean             antialias,
+                                               gfloat               threshold,
+                                               gboolean             select_transparent,
+                                               GimpSelectCriterion  select_criterion,
+                                               gboolean             diagonal_neighbors,
+                                               gint                 x,
+                                               gint                 y,
+                                               GimpAsync           *async);
+static GeglBuffer * downscale_buffer      (GeglBuffer          *buffer,
+                                           const Babl          *format,
+                                           gint                 level);
+
+static void     contiguous_region_by_seeds_async_func
+                                          (GimpAsync            *async,
+                                           ContiguousRegionData *data);
+static void     contiguous_region_data_free
+                                          (ContiguousRegionData *data);
+
 static const Babl * choose_format         (GeglBuffer          *buffer,
                                            GimpSelectCriterion  select_criterion,
                                            gint                *n_components,
@@ -100,7 +139,7 @@ static gboolean find_contiguous_segment   (const gfloat        *col,
                                            gint                *start,
                                            gint                *end,
                                            gfloat              *row);
-static void     find_contiguous_region    (GeglBuffer          *src_buffer,
+static gboolean find_contiguous_region    (GeglBuffer          *src_buffer,
                                            GeglBuffer          *mask_buffer,
                                            const Babl          *format,
                                            gint                 n_components,
@@ -112,7 +151,8 @@ static void     find_contiguous_region    (GeglBuffer          *src_buffer,
                                            gboolean             diagonal_neighbors,
                                            gint                 x,
                                            gint                 y,
-                                           const gfloat        *col);
+                                           const gfloat        *col,
+                                           GimpAsync           *async);
 
 static void            line_art_queue_pixel (GQueue              *queue,
                                              gint                 x,
@@ -132,59 +172,106 @@ gimp_pickable_contiguous_region_by_seed (GimpPickable        *pickable,
                                          gint                 x,
                                          gint                 y)
 {
-  GeglBuffer    *src_buffer;
-  GeglBuffer    *mask_buffer;
-  const Babl    *format;
-  GeglRectangle  extent;
-  gint           n_components;
-  gboolean       has_alpha;
-  gfloat         start_col[MAX_CHANNELS];
-
   g_return_val_if_fail (GIMP_IS_PICKABLE (pickable), NULL);
 
-  gimp_pickable_flush (pickable);
-  src_buffer = gimp_pickable_get_buffer (pickable);
-
-  format = choose_format (src_buffer, select_criterion,
-                          &n_components, &has_alpha);
-  gegl_buffer_sample (src_buffer, x, y, NULL, start_col, format,
-                      GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
+  return gimp_pickable_contiguous_region_by_seed_at_level (pickable,
+                                                           antialias,
+                                                           threshold,
+                                                           select_transparent,
+                                                           select_criterion,
+                                                           diagonal_neighbors,
+                                                           0, x, y);
+}
 
-  if (has_alpha)
-    {
-      if (select_transparent)
-        {
-          /*  don't select transparent regions if the start pixel isn't
-           *  fully transparent
-           */
-          if (start_col[n_components - 1] > 0)
-            select_transparent = FALSE;
-        }
-    }
-  else
-    {
-      select_transparent = FALSE;
-    }
+/**
+ * gimp_pickable_contiguous_region_by_seed_at_level:
+ * @pickable: the #GimpPickable to sample.
+ * @level:    the mipmap level to compute the region at.
+ * @x:        the seed's X coordinate, at full resolution.
+ * @y:        the seed's Y coordinate, at full resolution.
+ *
+ * Like gimp_pickable_contiguous_region_by_seed(), but computes the
+ * region on a copy of @pickable downscaled by a factor of 2^@level,
+ * which is much cheaper for large pickables when only an approximate
+ * result is needed, e.g. for previews.
+ *
+ * Returns: a mask buffer whose extent is the extent of @pickable,
+ *          scaled by 1 / 2^@level.
+ **/
+GeglBuffer *
+gimp_pickable_contiguous_region_by_seed_at_level (GimpPickable        *pickable,
+                                                  gboolean             antialias,
+                                                  gfloat               threshold,
+                                                  gboolean             select_transparent,
+                                                  GimpSelectCriterion  select_criterion,
+                                                  gboolean             diagonal_neighbors,
+                                                  gint                 level,
+                                                  gint                 x,
+                                                  gint                 y)
+{
+  g_return_val_if_fail (GIMP_IS_PICKABLE (pickable), NULL);
+  g_return_val_if_fail (level >= 0, NULL);
 
-  extent = *gegl_buffer_get_extent (src_buffer);
+  gimp_pickable_flush (pickable);
 
-  mask_buffer = gegl_buffer_new (&extent, babl_format ("Y float"));
+  return contiguous_region_by_seed (gimp_pickable_get_buffer (pickable),
+                                    level,
+                                    antialias, threshold,
+                                    select_transparent, select_criterion,
+                                    diagonal_neighbors,
+                                    x, y, NULL);
+}
 
-  if (x >= extent.x && x < (extent.x + extent.width) &&
-      y >= extent.y && y < (extent.y + extent.height))
-    {
-      GIMP_TIMER_START();
+/**
+ * gimp_pickable_contiguous_region_by_seeds_async:
+ * @pickable: the #GimpPickable to sample.
+ * @seeds:    the seed points.
+ * @n_seeds:  the number of seed points.
+ *
+ * Computes the union of the contiguous regions of all @seeds on the
+ * thread pool.  @pickable is flushed and its buffer is copied before
+ * returning, so later changes to @pickable don't affect the result.
+ *
+ * The computation can be canceled through the returned #GimpAsync.
+ *
+ * Returns: a #GimpAsync, whose result is the mask buffer.
+ **/
+GimpAsync *
+gimp_pickable_contiguous_region_by_seeds_async (GimpPickable        *pickable,
+                                                gboolean             antialias,
+                                                gfloat               threshold,
+                                                gboolean             select_transparent,
+                                                GimpSelectCriterion  select_criterion,
+                                                gboolean             diagonal_neighbors,
+                                                const GimpVector2   *seeds,
+                                                gint                 n_seeds)
+{
+  ContiguousRegionData *data;
 
-      find_contiguous_region (src_buffer, mask_buffer,
-                              format, n_components, has_alpha,
-                              select_transparent, select_criterion,
-                              antialias, threshold, diagonal_neighbors,
-                              x, y, start_col);
+  g_return_val_if_fail (GIMP_IS_PICKABLE (pickable), NULL);
+  g_return_val_if_fail (seeds != NULL, NULL);
+  g_return_val_if_fail (n_seeds > 0, NULL);
 
-      GIMP_TIMER_END("foo");
-    }
+  gimp_pickable_flush (pickable);
 
-  return mask_buffer;
+  data = g_slice_new (ContiguousRegionData);
+
+  data->src_buffer         = gimp_gegl_buffer_dup (
+                               gimp_pickable_get_buffer (pickable));
+  data->antialias          = antialias;
+  data->threshold          = threshold;
+  data->select_transparent = select_transparent;
+  data->select_criterion   = select_criterion;
+  data->diagonal_neighbors = diagonal_neighbors;
+  data->seeds              = (GimpVector2 *) g_memdup2 (
+                               seeds, n_seeds * sizeof (GimpVector2));
+  data->n_seeds            = n_seeds;
+
+  return gimp_parallel_run_async_full (
+    +1,
+    (GimpRunAsyncFunc) contiguous_region_by_seeds_async_func,
+    data,
+    (GDestroyNotify) contiguous_region_data_free);
 }
 
 GeglBuffer *
@@ -622,6 +709,199 @@ gimp_pickable_contiguous_region_by_line_art (GimpPickable *pickable,
 
 /*  private functions  */
 
+static GeglBuffer *
+contiguous_region_by_seed (GeglBuffer          *src_buffer,
+                           gint                 level,
+                           gboolean             antialias,
+                           gfloat               threshold,
+                           gboolean             select_transparent,
+                           GimpSelectCriterion  select_criterion,
+                           gboolean             diagonal_neighbors,
+                           gint                 x,
+                           gint                 y,
+                           GimpAsync           *async)
+{
+  GeglBuffer    *mask_buffer;
+  const Babl    *format;
+  GeglRectangle  extent;
+  gint           n_components;
+  gboolean       has_alpha;
+  gfloat         start_col[MAX_CHANNELS];
+
+  format = choose_format (src_buffer, select_criterion,
+                          &n_components, &has_alpha);
+
+  if (level > 0)
+    {
+      src_buffer = downscale_buffer (src_buffer, format, level);
+
+      x = floor ((gdouble) x / (1 << level));
+      y = floor ((gdouble) y / (1 << level));
+    }
+  else
+    {
+      g_object_ref (src_buffer);
+    }
+
+  gegl_buffer_sample (src_buffer, x, y, NULL, start_col, format,
+                      GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
+
+  if (has_alpha)
+    {
+      if (select_transparent)
+        {
+          /*  don't select transparent regions if the start pixel isn't
+           *  fully transparent
+           */
+          if (start_col[n_components - 1] > 0)
+            select_transparent = FALSE;
+        }
+    }
+  else
+    {
+      select_transparent = FALSE;
+    }
+
+  extent = *gegl_buffer_get_extent (src_buffer);
+
+  mask_buffer = gegl_buffer_new (&extent, babl_format ("Y float"));
+
+  if (x >= extent.x && x < (extent.x + extent.width) &&
+      y >= extent.y && y < (extent.y + extent.height))
+    {
+      gboolean completed;
+
+      GIMP_TIMER_START();
+
+      completed = find_contiguous_region (src_buffer, mask_buffer,
+                                          format, n_components, has_alpha,
+                                          select_transparent, select_criterion,
+                                          antialias, threshold,
+                                          diagonal_neighbors,
+                                          x, y, start_col, async);
+
+      GIMP_TIMER_END("foo");
+
+      if (! completed)
+        g_clear_object (&mask_buffer);
+    }
+
+  g_object_unref (src_buffer);
+
+  return mask_buffer;
+}
+
+static GeglBuffer *
+downscale_buffer (GeglBuffer *buffer,
+                  const Babl *format,
+                  gint        level)
+{
+  const GeglRectangle *extent = gegl_buffer_get_extent (buffer);
+  gdouble              scale  = 1.0 / (1 << level);
+  GeglBuffer          *result;
+  GeglRectangle        rect;
+
+  rect.x      = floor (extent->x * scale);
+  rect.y      = floor (extent->y * scale);
+  rect.width  = ceil ((extent->x + extent->width)  * scale) - rect.x;
+  rect.height = ceil ((extent->y + extent->height) * scale) - rect.y;
+
+  result = gegl_buffer_new (&rect, format);
+
+  /* reading @buffer at a reduced scale lets GEGL use its mipmaps, or,
+   * for projections, render the corresponding level directly
+   */
+  gegl_parallel_distribute_area (
+    &rect, PIXELS_PER_THREAD,
+    [=] (const GeglRectangle *area)
+    {
+      GeglBufferIterator *iter;
+
+      iter = gegl_buffer_iterator_new (result, area, 0, format,
+                                       GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
+
+      while (gegl_buffer_iterator_next (iter))
+        {
+          gegl_buffer_get (buffer, &iter->items[0].roi, scale,
+                           format, iter->items[0].data,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+        }
+    });
+
+  return result;
+}
+
+static void
+contiguous_region_by_seeds_async_func (GimpAsync            *async,
+                                       ContiguousRegionData *data)
+{
+  GeglBuffer *mask_buffer = NULL;
+  gint        i;
+
+  for (i = 0; i < data->n_seeds; i++)
+    {
+      GeglBuffer *new_mask;
+      gint        x = data->seeds[i].x;
+      gint        y = data->seeds[i].y;
+
+      if (mask_buffer)
+        {
+          gfloat pixel;
+
+          gegl_buffer_sample (mask_buffer, x, y, NULL, &pixel,
+                              babl_format ("Y float"),
+                              GEGL_SAMPLER_NEAREST, GEGL_ABYSS_NONE);
+
+          /* already selected, this seed won't change the region */
+          if (pixel != 0.0)
+            continue;
+        }
+
+      new_mask = contiguous_region_by_seed (data->src_buffer, 0,
+                                            data->antialias,
+                                            data->threshold,
+                                            data->select_transparent,
+                                            data->select_criterion,
+                                            data->diagonal_neighbors,
+                                            x, y, async);
+
+      if (! new_mask)
+        {
+          g_clear_object (&mask_buffer);
+
+          gimp_async_abort (async);
+
+          contiguous_region_data_free (data);
+
+          return;
+        }
+
+      if (mask_buffer)
+        {
+          gimp_gegl_mask_combine_buffer (mask_buffer, new_mask,
+                                         GIMP_CHANNEL_OP_ADD, 0, 0);
+          g_object_unref (new_mask);
+        }
+      else
+        {
+          mask_buffer = new_mask;
+        }
+    }
+
+  gimp_async_finish_full (async, mask_buffer, g_object_unref);
+
+  contiguous_region_data_free (data);
+}
+
+static void
+contiguous_region_data_free (ContiguousRegionData *data)
+{
+  g_object_unref (data->src_buffer);
+  g_free (data->seeds);
+
+  g_slice_free (ContiguousRegionData, data);
+}
+
 static const Babl *
 choose_format (GeglBuffer          *buffer,
                GimpSelectCriterion  select_criterion,
@@ -999,7 +1279,7 @@ find_contiguous_segment (const gfloat        *col,
   return TRUE;
 }
 
-static void
+static gboolean
 find_contiguous_region (GeglBuffer          *src_buffer,
                         GeglBuffer          *mask_buffer,
                         const Babl          *format,
@@ -1012,7 +1292,8 @@ find_contiguous_region (GeglBuffer          *src_buffer,
                         gboolean             diagonal_neighbors,
                         gint                 x,
                         gint                 y,
-                        const gfloat        *col)
+                        const gfloat        *col,
+                        GimpAsync           *async)
 {
   const Babl          *mask_format = babl_format ("Y float");
   GeglSampler         *src_sampler;
@@ -1022,6 +1303,8 @@ find_contiguous_region (GeglBuffer          *src_buffer,
   gint                 new_start, new_end;
   GQueue              *segment_queue;
   gfloat              *row = NULL;
+  gint                 n_segments = 0;
+  gboolean             canceled   = FALSE;
 
   src_extent = gegl_buffer_get_extent (src_buffer);
 
@@ -1040,6 +1323,17 @@ find_contiguous_region (GeglBuffer          *src_buffer,
 
   do
     {
+      if (async && ++n_segments == SEGMENTS_PER_CANCEL_CHECK)
+        {
+          n_segments = 0;
+
+          if (gimp_async_is_canceled (async))
+            {
+              canceled = TRUE;
+              break;
+            }
+        }
+
       pop_segment (segment_queue,
                    &y, &old_y, &start, &end);
 
@@ -1115,6 +1409,8 @@ find_contiguous_region (GeglBuffer          *src_buffer,
 #ifdef FETCH_ROW
   g_free (row);
 #endif
+
+  return ! canceled;
 }
 
 static void
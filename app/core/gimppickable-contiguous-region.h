@@ -27,6 +27,23 @@ GeglBuffer * gimp_pickable_contiguous_region_by_seed                (GimpPickabl
                                                                      gboolean             diagonal_neighbors,
                                                                      gint                 x,
                                                                      gint                 y);
+GeglBuffer * gimp_pickable_contiguous_region_by_seed_at_level       (GimpPickable        *pickable,
+                                                                     gboolean             antialias,
+                                                                     gfloat               threshold,
+                                                                     gboolean             select_transparent,
+                                                                     GimpSelectCriterion  select_criterion,
+                                                                     gboolean             diagonal_neighbors,
+                                                                     gint                 level,
+                                                                     gint                 x,
+                                                                     gint                 y);
+GimpAsync  * gimp_pickable_contiguous_region_by_seeds_async         (GimpPickable        *pickable,
+                                                                     gboolean             antialias,
+                                                                     gfloat               threshold,
+                                                                     gboolean             select_transparent,
+                                                                     GimpSelectCriterion  select_criterion,
+                                                                     gboolean             diagonal_neighbors,
+                                                                     const GimpVector2   *seeds,
+                                                                     gint                 n_seeds);
 
 GeglBuffer * gimp_pickable_contiguous_region_by_color               (GimpPickable        *pickable,
                                                                      gboolean             antialias,
@@ -76,6 +76,9 @@ struct _GimpProjectionPrivate
 
   cairo_region_t            *update_region;
   GeglRectangle              priority_rect;
+  GHashTable                *priority_levels;
+  gint                       priority_level;
+  cairo_region_t            *level_region;
   GimpChunkIterator         *iter;
   guint                      idle_id;
 
@@ -136,13 +139,17 @@ static void        gimp_projection_flush_whenever        (GimpProjection  *proj,
                                                           gboolean         now,
                                                           gboolean         direct);
 static void        gimp_projection_update_priority_rect  (GimpProjection  *proj);
+static void        gimp_projection_update_priority_level (GimpProjection  *proj);
+static void        gimp_projection_requeue_level_region  (GimpProjection  *proj);
 static void        gimp_projection_chunk_render_start    (GimpProjection  *proj);
 static void        gimp_projection_chunk_render_stop     (GimpProjection  *proj,
                                                           gboolean         merge);
 static gboolean    gimp_projection_chunk_render_callback (GimpProjection  *proj);
-static gboolean    gimp_projection_chunk_render_iteration(GimpProjection  *proj);
+static gboolean    gimp_projection_chunk_render_iteration(GimpProjection  *proj,
+                                                          gint             level);
 static void        gimp_projection_paint_area            (GimpProjection  *proj,
                                                           gboolean         now,
+                                                          gint             level,
                                                           gint             x,
                                                           gint             y,
                                                           gint             w,
@@ -209,6 +216,8 @@ static void
 gimp_projection_init (GimpProjection *proj)
 {
   proj->priv = gimp_projection_get_instance_private (proj);
+
+  proj->priv->priority_levels = g_hash_table_new (NULL, NULL);
 }
 
 static void
@@ -233,6 +242,8 @@ gimp_projection_finalize (GObject *object)
 
   gimp_projection_free_buffer (proj);
 
+  g_clear_pointer (&proj->priv->priority_levels, g_hash_table_unref);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -519,6 +530,44 @@ gimp_projection_set_priority_rect (GimpProjection *proj,
   gimp_projection_update_priority_rect (proj);
 }
 
+/*  each view of the projection sets the scale it reads the projection
+ *  at, identified by 'owner'.  the projection renders at the finest
+ *  level any of them needs.
+ */
+void
+gimp_projection_set_priority_scale (GimpProjection *proj,
+                                    gpointer        owner,
+                                    gdouble         scale)
+{
+  gint level = 0;
+
+  g_return_if_fail (GIMP_IS_PROJECTION (proj));
+  g_return_if_fail (owner != NULL);
+
+  /*  pick the mipmap level gegl_buffer_get() reads from at this scale  */
+  while (scale <= 0.5 && level < GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL)
+    {
+      scale *= 2.0;
+      level++;
+    }
+
+  g_hash_table_insert (proj->priv->priority_levels,
+                       owner, GINT_TO_POINTER (level));
+
+  gimp_projection_update_priority_level (proj);
+}
+
+void
+gimp_projection_unset_priority_scale (GimpProjection *proj,
+                                      gpointer        owner)
+{
+  g_return_if_fail (GIMP_IS_PROJECTION (proj));
+  g_return_if_fail (owner != NULL);
+
+  if (g_hash_table_remove (proj->priv->priority_levels, owner))
+    gimp_projection_update_priority_level (proj);
+}
+
 void
 gimp_projection_stop_rendering (GimpProjection *proj)
 {
@@ -551,13 +600,23 @@ gimp_projection_finish_draw (GimpProjection *proj)
 {
   g_return_if_fail (GIMP_IS_PROJECTION (proj));
 
+  /*  finish drawing at full resolution, including the areas so far
+   *  only rendered at a coarser level
+   */
+  if (proj->priv->level_region)
+    {
+      gimp_projection_requeue_level_region (proj);
+
+      gimp_projection_chunk_render_start (proj);
+    }
+
   if (proj->priv->iter)
     {
       gimp_chunk_iterator_set_priority_rect (proj->priv->iter, NULL);
 
       gimp_tile_handler_validate_begin_validate (proj->priv->validate_handler);
 
-      while (gimp_projection_chunk_render_iteration (proj));
+      while (gimp_projection_chunk_render_iteration (proj, 0));
 
       gimp_tile_handler_validate_end_validate (proj->priv->validate_handler);
 
@@ -599,6 +658,7 @@ gimp_projection_free_buffer (GimpProjection  *proj)
   gimp_projection_chunk_render_stop (proj, FALSE);
 
   g_clear_pointer (&proj->priv->update_region, cairo_region_destroy);
+  g_clear_pointer (&proj->priv->level_region,  cairo_region_destroy);
 
   if (proj->priv->buffer)
     {
@@ -669,6 +729,7 @@ gimp_projection_flush_whenever (GimpProjection *proj,
 
               gimp_projection_paint_area (proj,
                                           direct,
+                                          0,
                                           rect.x,
                                           rect.y,
                                           rect.width,
@@ -722,6 +783,66 @@ gimp_projection_update_priority_rect (GimpProjection *proj)
     }
 }
 
+static void
+gimp_projection_update_priority_level (GimpProjection *proj)
+{
+  GHashTableIter iter;
+  gpointer       value;
+  gint           level = -1;
+
+  g_hash_table_iter_init (&iter, proj->priv->priority_levels);
+
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      if (level < 0 || GPOINTER_TO_INT (value) < level)
+        level = GPOINTER_TO_INT (value);
+    }
+
+  /*  without any views, render at full resolution  */
+  if (level < 0)
+    level = 0;
+
+  if (level != proj->priv->priority_level)
+    {
+      gboolean finer = level < proj->priv->priority_level;
+
+      proj->priv->priority_level = level;
+
+      /*  areas so far only rendered at a coarser level need to be
+       *  rendered again at the new one
+       */
+      if (finer && proj->priv->level_region)
+        {
+          gimp_projection_requeue_level_region (proj);
+
+          gimp_projection_flush (proj);
+        }
+    }
+}
+
+static void
+gimp_projection_requeue_level_region (GimpProjection *proj)
+{
+  cairo_region_t *region = proj->priv->level_region;
+
+  proj->priv->level_region = NULL;
+
+  /*  only what is still invalid at level 0 needs rendering  */
+  cairo_region_intersect (region,
+                          proj->priv->validate_handler->dirty_region);
+
+  if (proj->priv->update_region)
+    {
+      cairo_region_union (proj->priv->update_region, region);
+
+      cairo_region_destroy (region);
+    }
+  else
+    {
+      proj->priv->update_region = region;
+    }
+}
+
 static void
 gimp_projection_chunk_render_start (GimpProjection *proj)
 {
@@ -825,7 +946,8 @@ gimp_projection_chunk_render_stop (GimpProjection *proj,
 static gboolean
 gimp_projection_chunk_render_callback (GimpProjection *proj)
 {
-  if (gimp_projection_chunk_render_iteration (proj))
+  if (gimp_projection_chunk_render_iteration (proj,
+                                              proj->priv->priority_level))
     {
       return G_SOURCE_CONTINUE;
     }
@@ -838,7 +960,8 @@ gimp_projection_chunk_render_callback (GimpProjection *proj)
 }
 
 static gboolean
-gimp_projection_chunk_render_iteration (GimpProjection *proj)
+gimp_projection_chunk_render_iteration (GimpProjection *proj,
+                                        gint            level)
 {
   if (gimp_chunk_iterator_next (proj->priv->iter))
     {
@@ -848,7 +971,7 @@ gimp_projection_chunk_render_iteration (GimpProjection *proj)
 
       while (gimp_chunk_iterator_get_rect (proj->priv->iter, &rect))
         {
-          gimp_projection_paint_area (proj, TRUE,
+          gimp_projection_paint_area (proj, TRUE, level,
                                       rect.x, rect.y, rect.width, rect.height);
         }
 
@@ -879,6 +1002,7 @@ gimp_projection_chunk_render_iteration (GimpProjection *proj)
 static void
 gimp_projection_paint_area (GimpProjection *proj,
                             gboolean        now,
+                            gint            level,
                             gint            x,
                             gint            y,
                             gint            w,
@@ -894,7 +1018,31 @@ gimp_projection_paint_area (GimpProjection *proj,
   if (gegl_rectangle_intersect (&rect,
                                 GEGL_RECTANGLE (x, y, w, h), &bounding_box))
     {
-      if (now)
+      if (now && level > 0)
+        {
+          /*  render the area only at the level it is viewed at, and
+           *  remember to render it at full resolution once a finer
+           *  level is asked for
+           */
+          gimp_tile_handler_validate_validate_level (
+            proj->priv->validate_handler,
+            proj->priv->buffer,
+            &rect,
+            level);
+
+          if (proj->priv->level_region)
+            {
+              cairo_region_union_rectangle (
+                proj->priv->level_region,
+                (const cairo_rectangle_int_t *) &rect);
+            }
+          else
+            {
+              proj->priv->level_region = cairo_region_create_rectangle (
+                (const cairo_rectangle_int_t *) &rect);
+            }
+        }
+      else if (now)
         {
           gimp_tile_handler_validate_validate (
             proj->priv->validate_handler,
@@ -1090,6 +1238,14 @@ gimp_projection_projectable_bounds_changed (GimpProjectable *projectable,
         (const cairo_rectangle_int_t *) &bounding_box);
     }
 
+  if (proj->priv->level_region)
+    {
+      cairo_region_translate (proj->priv->level_region, dx, dy);
+      cairo_region_intersect_rectangle (
+        proj->priv->level_region,
+        (const cairo_rectangle_int_t *) &bounding_box);
+    }
+
   int_bounds.x -= x;
   int_bounds.y -= y;
 
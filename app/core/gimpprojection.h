@@ -67,6 +67,14 @@ void             gimp_projection_set_priority_rect (GimpProjection    *proj,
                                                     gint               width,
                                                     gint               height);
 
+void             gimp_projection_set_priority_scale
+                                                   (GimpProjection    *proj,
+                                                    gpointer           owner,
+                                                    gdouble            scale);
+void             gimp_projection_unset_priority_scale
+                                                   (GimpProjection    *proj,
+                                                    gpointer           owner);
+
 void             gimp_projection_stop_rendering    (GimpProjection    *proj);
 
 void             gimp_projection_flush             (GimpProjection    *proj);
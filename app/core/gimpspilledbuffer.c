@@ -0,0 +1,588 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpspilledbuffer.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <cairo.h>
+#include <gio/gio.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "core-types.h"
+
+#include "gegl/gimp-gegl-utils.h"
+
+#include "gimp.h"
+#include "gimp-memsize.h"
+#include "gimp-parallel.h"
+#include "gimpasync.h"
+#include "gimpspilledbuffer.h"
+#include "gimpwaitable.h"
+
+#include "gimp-intl.h"
+
+
+/*  a GimpSpilledBuffer moves the contents of a GeglBuffer into a
+ *  zlib-compressed temporary file, in the background, and reads it
+ *  back on demand.  it is used for keeping old undo steps around
+ *  without holding their pixels in memory.
+ *
+ *  when the buffer only holds valid pixels inside a region, only that
+ *  region is written, and the restored buffer is just as sparse, on
+ *  the same tile grid.
+ */
+
+
+#define STRIPE_HEIGHT     64
+#define COMPRESSION_LEVEL 1
+
+
+typedef struct
+{
+  GeglRectangle  extent;
+  const Babl    *format;
+  gint           shift_x;
+  gint           shift_y;
+  gint           tile_width;
+  gint           tile_height;
+} BufferLayout;
+
+struct _GimpSpilledBuffer
+{
+  GFile                     *file;
+  BufferLayout               layout;
+  cairo_region_t            *region;
+  gint64                     size;
+
+  GeglBuffer                *buffer;        /*  the resident buffer, while
+                                             *  spilling or if spilling
+                                             *  failed
+                                             */
+  GimpAsync                 *spill_async;
+  GimpAsync                 *restore_async;
+
+  gint64                     spilled_size;
+
+  GimpSpilledBufferCallback  callback;
+  gpointer                   user_data;
+};
+
+typedef struct
+{
+  GeglBuffer     *buffer;
+  cairo_region_t *region;
+  GFile          *file;
+} SpillData;
+
+typedef struct
+{
+  GFile          *file;
+  BufferLayout    layout;
+  cairo_region_t *region;
+} RestoreData;
+
+
+/*  local function prototypes  */
+
+static void   gimp_spilled_buffer_spill_func     (GimpAsync         *async,
+                                                  SpillData         *data);
+static void   gimp_spilled_buffer_spill_callback (GimpAsync         *async,
+                                                  GimpSpilledBuffer *spilled);
+static void   gimp_spilled_buffer_restore_func   (GimpAsync         *async,
+                                                  RestoreData       *data);
+
+static cairo_region_t *
+              gimp_spilled_buffer_get_region     (GimpSpilledBuffer *spilled);
+
+static void   spill_data_free                    (SpillData         *data);
+static void   restore_data_free                  (RestoreData       *data);
+
+
+/*  public functions  */
+
+/*  starts writing @buffer to disk in the background.  @region, if not
+ *  NULL, is the part of @buffer that holds valid pixels, and @size the
+ *  memory used by @buffer.  @callback is called once spilling has
+ *  finished, successfully or not, and the spilled buffer's memsize has
+ *  changed.
+ */
+GimpSpilledBuffer *
+gimp_spilled_buffer_new (Gimp                      *gimp,
+                         GeglBuffer                *buffer,
+                         const cairo_region_t      *region,
+                         gint64                     size,
+                         GimpSpilledBufferCallback  callback,
+                         gpointer                   user_data)
+{
+  GimpSpilledBuffer *spilled;
+  SpillData         *data;
+
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), NULL);
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
+
+  spilled = g_slice_new0 (GimpSpilledBuffer);
+
+  spilled->file          = gimp_get_temp_file (gimp, "undo");
+  spilled->layout.extent = *gegl_buffer_get_extent (buffer);
+  spilled->layout.format = gegl_buffer_get_format (buffer);
+  spilled->size          = size;
+  spilled->buffer        = g_object_ref (buffer);
+  spilled->callback      = callback;
+  spilled->user_data     = user_data;
+
+  g_object_get (buffer,
+                "shift-x",     &spilled->layout.shift_x,
+                "shift-y",     &spilled->layout.shift_y,
+                "tile-width",  &spilled->layout.tile_width,
+                "tile-height", &spilled->layout.tile_height,
+                NULL);
+
+  if (region)
+    spilled->region = cairo_region_copy (region);
+
+  data = g_slice_new (SpillData);
+
+  data->buffer = gimp_gegl_buffer_dup (buffer);
+  data->region = gimp_spilled_buffer_get_region (spilled);
+  data->file   = g_object_ref (spilled->file);
+
+  spilled->spill_async = gimp_parallel_run_async_full (
+    +1,
+    (GimpRunAsyncFunc) gimp_spilled_buffer_spill_func,
+    data,
+    (GDestroyNotify) spill_data_free);
+
+  gimp_async_add_callback (
+    spilled->spill_async,
+    (GimpAsyncCallback) gimp_spilled_buffer_spill_callback,
+    spilled);
+
+  return spilled;
+}
+
+void
+gimp_spilled_buffer_free (GimpSpilledBuffer *spilled)
+{
+  g_return_if_fail (spilled != NULL);
+
+  if (spilled->spill_async)
+    {
+      gimp_async_remove_callback (
+        spilled->spill_async,
+        (GimpAsyncCallback) gimp_spilled_buffer_spill_callback,
+        spilled);
+
+      gimp_async_cancel_and_wait (spilled->spill_async);
+      g_clear_object (&spilled->spill_async);
+    }
+
+  if (spilled->restore_async)
+    {
+      gimp_async_cancel_and_wait (spilled->restore_async);
+      g_clear_object (&spilled->restore_async);
+    }
+
+  g_file_delete (spilled->file, NULL, NULL);
+
+  g_object_unref (spilled->file);
+  g_clear_object (&spilled->buffer);
+  g_clear_pointer (&spilled->region, cairo_region_destroy);
+
+  g_slice_free (GimpSpilledBuffer, spilled);
+}
+
+/*  starts reading the spilled data back in the background, so that a
+ *  following gimp_spilled_buffer_restore() doesn't have to wait for it
+ */
+void
+gimp_spilled_buffer_prefetch (GimpSpilledBuffer *spilled)
+{
+  RestoreData *data;
+
+  g_return_if_fail (spilled != NULL);
+
+  if (spilled->buffer || spilled->restore_async)
+    return;
+
+  data = g_slice_new (RestoreData);
+
+  data->file   = g_object_ref (spilled->file);
+  data->layout = spilled->layout;
+  data->region = gimp_spilled_buffer_get_region (spilled);
+
+  spilled->restore_async = gimp_parallel_run_async_full (
+    0,
+    (GimpRunAsyncFunc) gimp_spilled_buffer_restore_func,
+    data,
+    (GDestroyNotify) restore_data_free);
+}
+
+/*  returns a new reference to a buffer holding the original contents,
+ *  or NULL if the spilled data can't be read back.  in that case the
+ *  spilled buffer is left as it is, and restoring can be retried.
+ */
+GeglBuffer *
+gimp_spilled_buffer_restore (GimpSpilledBuffer  *spilled,
+                             GError            **error)
+{
+  g_return_val_if_fail (spilled != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (spilled->spill_async)
+    {
+      /*  we still have the resident buffer, no need to finish spilling  */
+      gimp_async_remove_callback (
+        spilled->spill_async,
+        (GimpAsyncCallback) gimp_spilled_buffer_spill_callback,
+        spilled);
+
+      gimp_async_cancel_and_wait (spilled->spill_async);
+      g_clear_object (&spilled->spill_async);
+    }
+
+  if (spilled->buffer)
+    return g_object_ref (spilled->buffer);
+
+  gimp_spilled_buffer_prefetch (spilled);
+
+  gimp_waitable_wait (GIMP_WAITABLE (spilled->restore_async));
+
+  if (gimp_async_is_finished (spilled->restore_async))
+    return g_object_ref (gimp_async_get_result (spilled->restore_async));
+
+  /*  drop the failed read, so the next attempt starts over  */
+  g_clear_object (&spilled->restore_async);
+
+  g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+               _("Could not read undo data from '%s'"),
+               gimp_file_get_utf8_name (spilled->file));
+
+  return NULL;
+}
+
+/*  returns the amount of memory used by the buffer.  'spilled_size'
+ *  returns the amount of data written to disk, and 'pending_size' the
+ *  amount of memory that will be released once spilling finishes.  a
+ *  buffer still counts as resident while it is being spilled.
+ */
+gint64
+gimp_spilled_buffer_get_memsize (GimpSpilledBuffer *spilled,
+                                 gint64            *spilled_size,
+                                 gint64            *pending_size)
+{
+  gint64 memsize         = 0;
+  gint64 spilled_memsize = 0;
+  gint64 pending_memsize = 0;
+
+  if (spilled)
+    {
+      if (spilled->buffer)
+        {
+          memsize += spilled->size;
+
+          if (spilled->spill_async)
+            pending_memsize = spilled->size;
+        }
+      else
+        {
+          spilled_memsize = spilled->spilled_size;
+        }
+
+      if (spilled->restore_async                         &&
+          gimp_async_is_synced (spilled->restore_async) &&
+          gimp_async_is_finished (spilled->restore_async))
+        {
+          memsize += spilled->size;
+        }
+
+      memsize += sizeof (GimpSpilledBuffer);
+    }
+
+  if (spilled_size)
+    *spilled_size = spilled_memsize;
+
+  if (pending_size)
+    *pending_size = pending_memsize;
+
+  return memsize;
+}
+
+
+/*  private functions  */
+
+static void
+gimp_spilled_buffer_spill_func (GimpAsync *async,
+                                SpillData *data)
+{
+  const Babl            *format  = gegl_buffer_get_format (data->buffer);
+  gint                   bpp     = babl_format_get_bytes_per_pixel (format);
+  gint                   n_rects = cairo_region_num_rectangles (data->region);
+  cairo_rectangle_int_t  extents;
+  GFileOutputStream     *file_output;
+  GOutputStream         *output;
+  GConverter            *compressor;
+  GFileInfo             *info;
+  guchar                *stripe;
+  gboolean               success = TRUE;
+  gint                   i;
+
+  file_output = g_file_replace (data->file, NULL, FALSE,
+                                G_FILE_CREATE_PRIVATE, NULL, NULL);
+
+  if (! file_output)
+    {
+      spill_data_free (data);
+
+      gimp_async_abort (async);
+
+      return;
+    }
+
+  compressor = G_CONVERTER (g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW,
+                                                   COMPRESSION_LEVEL));
+  output     = g_converter_output_stream_new (G_OUTPUT_STREAM (file_output),
+                                              compressor);
+  g_object_unref (compressor);
+  g_object_unref (file_output);
+
+  cairo_region_get_extents (data->region, &extents);
+
+  stripe = g_malloc ((gsize) extents.width * STRIPE_HEIGHT * bpp);
+
+  /*  write the region's rectangles one after the other, in stripes  */
+  for (i = 0; success && i < n_rects; i++)
+    {
+      cairo_rectangle_int_t rect;
+      gint                  y;
+
+      cairo_region_get_rectangle (data->region, i, &rect);
+
+      for (y = 0; success && y < rect.height; y += STRIPE_HEIGHT)
+        {
+          GeglRectangle stripe_rect = { rect.x, rect.y + y,
+                                        rect.width,
+                                        MIN (STRIPE_HEIGHT, rect.height - y) };
+
+          if (gimp_async_is_canceled (async))
+            {
+              success = FALSE;
+              break;
+            }
+
+          gegl_buffer_get (data->buffer, &stripe_rect, 1.0, format, stripe,
+                           GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+          success = g_output_stream_write_all (output, stripe,
+                                               (gsize) stripe_rect.width *
+                                                       stripe_rect.height * bpp,
+                                               NULL, NULL, NULL);
+        }
+    }
+
+  g_free (stripe);
+
+  if (! g_output_stream_close (output, NULL, NULL))
+    success = FALSE;
+
+  g_object_unref (output);
+
+  info = success ? g_file_query_info (data->file,
+                                      G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                                      G_FILE_QUERY_INFO_NONE,
+                                      NULL, NULL) : NULL;
+
+  if (info)
+    {
+      gint64 *size = g_new (gint64, 1);
+
+      *size = g_file_info_get_size (info);
+
+      g_object_unref (info);
+
+      spill_data_free (data);
+
+      gimp_async_finish_full (async, size, g_free);
+    }
+  else
+    {
+      g_file_delete (data->file, NULL, NULL);
+
+      spill_data_free (data);
+
+      gimp_async_abort (async);
+    }
+}
+
+static void
+gimp_spilled_buffer_spill_callback (GimpAsync         *async,
+                                    GimpSpilledBuffer *spilled)
+{
+  if (gimp_async_is_finished (async))
+    {
+      spilled->spilled_size = *(gint64 *) gimp_async_get_result (async);
+
+      /*  the pixels are safe on disk now, let go of them  */
+      g_clear_object (&spilled->buffer);
+    }
+
+  /*  otherwise, keep the buffer resident  */
+
+  g_clear_object (&spilled->spill_async);
+
+  if (spilled->callback)
+    spilled->callback (spilled, spilled->user_data);
+}
+
+static void
+gimp_spilled_buffer_restore_func (GimpAsync   *async,
+                                  RestoreData *data)
+{
+  const Babl            *format  = data->layout.format;
+  gint                   bpp     = babl_format_get_bytes_per_pixel (format);
+  gint                   n_rects = cairo_region_num_rectangles (data->region);
+  cairo_rectangle_int_t  extents;
+  GFileInputStream      *file_input;
+  GInputStream          *input;
+  GConverter            *decompressor;
+  GeglBuffer            *buffer;
+  guchar                *stripe;
+  gboolean               success = TRUE;
+  gint                   i;
+
+  file_input = g_file_read (data->file, NULL, NULL);
+
+  if (! file_input)
+    {
+      restore_data_free (data);
+
+      gimp_async_abort (async);
+
+      return;
+    }
+
+  decompressor = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW));
+  input        = g_converter_input_stream_new (G_INPUT_STREAM (file_input),
+                                               decompressor);
+  g_object_unref (decompressor);
+  g_object_unref (file_input);
+
+  /*  recreate the buffer on the original tile grid, so that a sparse
+   *  buffer only gets the tiles of its region allocated again
+   */
+  buffer = g_object_new (GEGL_TYPE_BUFFER,
+                         "format",      format,
+                         "x",           data->layout.extent.x,
+                         "y",           data->layout.extent.y,
+                         "width",       data->layout.extent.width,
+                         "height",      data->layout.extent.height,
+                         "shift-x",     data->layout.shift_x,
+                         "shift-y",     data->layout.shift_y,
+                         "tile-width",  data->layout.tile_width,
+                         "tile-height", data->layout.tile_height,
+                         NULL);
+
+  cairo_region_get_extents (data->region, &extents);
+
+  stripe = g_malloc ((gsize) extents.width * STRIPE_HEIGHT * bpp);
+
+  for (i = 0; success && i < n_rects; i++)
+    {
+      cairo_rectangle_int_t rect;
+      gint                  y;
+
+      cairo_region_get_rectangle (data->region, i, &rect);
+
+      for (y = 0; success && y < rect.height; y += STRIPE_HEIGHT)
+        {
+          GeglRectangle stripe_rect = { rect.x, rect.y + y,
+                                        rect.width,
+                                        MIN (STRIPE_HEIGHT, rect.height - y) };
+          gsize         size        = (gsize) stripe_rect.width *
+                                              stripe_rect.height * bpp;
+          gsize         bytes_read;
+
+          if (gimp_async_is_canceled (async))
+            {
+              success = FALSE;
+              break;
+            }
+
+          success = g_input_stream_read_all (input, stripe, size, &bytes_read,
+                                             NULL, NULL) &&
+                    bytes_read == size;
+
+          if (success)
+            {
+              gegl_buffer_set (buffer, &stripe_rect, 0, format, stripe,
+                               GEGL_AUTO_ROWSTRIDE);
+            }
+        }
+    }
+
+  g_free (stripe);
+
+  g_input_stream_close (input, NULL, NULL);
+  g_object_unref (input);
+
+  restore_data_free (data);
+
+  if (success)
+    {
+      gimp_async_finish_full (async, buffer, g_object_unref);
+    }
+  else
+    {
+      g_object_unref (buffer);
+
+      gimp_async_abort (async);
+    }
+}
+
+/*  returns a new region of the pixels to write and read, either the
+ *  buffer's region or its whole extent
+ */
+static cairo_region_t *
+gimp_spilled_buffer_get_region (GimpSpilledBuffer *spilled)
+{
+  if (spilled->region)
+    return cairo_region_copy (spilled->region);
+
+  return cairo_region_create_rectangle (
+    (const cairo_rectangle_int_t *) &spilled->layout.extent);
+}
+
+static void
+spill_data_free (SpillData *data)
+{
+  g_object_unref (data->buffer);
+  cairo_region_destroy (data->region);
+  g_object_unref (data->file);
+
+  g_slice_free (SpillData, data);
+}
+
+static void
+restore_data_free (RestoreData *data)
+{
+  g_object_unref (data->file);
+  cairo_region_destroy (data->region);
+
+  g_slice_free (RestoreData, data);
+}
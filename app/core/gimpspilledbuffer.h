@@ -0,0 +1,45 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpspilledbuffer.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_SPILLED_BUFFER_H__
+#define __GIMP_SPILLED_BUFFER_H__
+
+
+typedef void (* GimpSpilledBufferCallback) (GimpSpilledBuffer *spilled,
+                                            gpointer           user_data);
+
+
+GimpSpilledBuffer * gimp_spilled_buffer_new         (Gimp                      *gimp,
+                                                     GeglBuffer                *buffer,
+                                                     const cairo_region_t      *region,
+                                                     gint64                     size,
+                                                     GimpSpilledBufferCallback  callback,
+                                                     gpointer                   user_data);
+void                gimp_spilled_buffer_free        (GimpSpilledBuffer         *spilled);
+
+void                gimp_spilled_buffer_prefetch    (GimpSpilledBuffer         *spilled);
+GeglBuffer        * gimp_spilled_buffer_restore     (GimpSpilledBuffer         *spilled,
+                                                     GError                   **error);
+
+gint64              gimp_spilled_buffer_get_memsize (GimpSpilledBuffer         *spilled,
+                                                     gint64                    *spilled_size,
+                                                     gint64                    *pending_size);
+
+
+#endif  /*  __GIMP_SPILLED_BUFFER_H__  */
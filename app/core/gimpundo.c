@@ -89,6 +89,13 @@ static void          gimp_undo_real_pop            (GimpUndo            *undo,
                                                     GimpUndoAccumulator *accum);
 static void          gimp_undo_real_free           (GimpUndo            *undo,
                                                     GimpUndoMode         undo_mode);
+static gint64        gimp_undo_real_spill          (GimpUndo            *undo);
+static void          gimp_undo_real_prefetch       (GimpUndo            *undo);
+static gboolean      gimp_undo_real_unspill        (GimpUndo            *undo,
+                                                    GError             **error);
+static gint64        gimp_undo_real_get_spilled_size
+                                                   (GimpUndo            *undo,
+                                                    gint64              *pending_size);
 
 static gboolean      gimp_undo_create_preview_idle (gpointer             data);
 static void       gimp_undo_create_preview_private (GimpUndo            *undo,
@@ -142,6 +149,10 @@ gimp_undo_class_init (GimpUndoClass *klass)
 
   klass->pop                        = gimp_undo_real_pop;
   klass->free                       = gimp_undo_real_free;
+  klass->spill                      = gimp_undo_real_spill;
+  klass->prefetch                   = gimp_undo_real_prefetch;
+  klass->unspill                    = gimp_undo_real_unspill;
+  klass->get_spilled_size           = gimp_undo_real_get_spilled_size;
 
   g_object_class_install_property (object_class, PROP_IMAGE,
                                    g_param_spec_object ("image", NULL, NULL,
@@ -345,6 +356,34 @@ gimp_undo_real_free (GimpUndo     *undo,
 {
 }
 
+static gint64
+gimp_undo_real_spill (GimpUndo *undo)
+{
+  return 0;
+}
+
+static void
+gimp_undo_real_prefetch (GimpUndo *undo)
+{
+}
+
+static gboolean
+gimp_undo_real_unspill (GimpUndo  *undo,
+                        GError   **error)
+{
+  return TRUE;
+}
+
+static gint64
+gimp_undo_real_get_spilled_size (GimpUndo *undo,
+                                 gint64   *pending_size)
+{
+  if (pending_size)
+    *pending_size = 0;
+
+  return 0;
+}
+
 void
 gimp_undo_pop (GimpUndo            *undo,
                GimpUndoMode         undo_mode,
@@ -379,6 +418,76 @@ gimp_undo_free (GimpUndo     *undo,
   g_signal_emit (undo, undo_signals[FREE], 0, undo_mode);
 }
 
+/**
+ * gimp_undo_spill:
+ * @undo: a #GimpUndo
+ *
+ * Moves the undo's bulk data out of memory, if it supports that.
+ * The data is brought back transparently when the undo is popped.
+ *
+ * Returns: the number of bytes that will be released.
+ **/
+gint64
+gimp_undo_spill (GimpUndo *undo)
+{
+  g_return_val_if_fail (GIMP_IS_UNDO (undo), 0);
+
+  return GIMP_UNDO_GET_CLASS (undo)->spill (undo);
+}
+
+/**
+ * gimp_undo_prefetch:
+ * @undo: a #GimpUndo
+ *
+ * Starts bringing spilled data back into memory in the background,
+ * because the undo is likely going to be popped soon.
+ **/
+void
+gimp_undo_prefetch (GimpUndo *undo)
+{
+  g_return_if_fail (GIMP_IS_UNDO (undo));
+
+  GIMP_UNDO_GET_CLASS (undo)->prefetch (undo);
+}
+
+/**
+ * gimp_undo_unspill:
+ * @undo:  a #GimpUndo
+ * @error: return location for an error
+ *
+ * Brings spilled data back into memory, so that popping @undo can't
+ * fail.
+ *
+ * Returns: %TRUE if all of @undo's data is in memory.
+ **/
+gboolean
+gimp_undo_unspill (GimpUndo  *undo,
+                   GError   **error)
+{
+  g_return_val_if_fail (GIMP_IS_UNDO (undo), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  return GIMP_UNDO_GET_CLASS (undo)->unspill (undo, error);
+}
+
+/**
+ * gimp_undo_get_spilled_size:
+ * @undo:         a #GimpUndo
+ * @pending_size: return location for the amount of memory that is
+ *                still in use but will be released once spilling
+ *                finishes, or %NULL
+ *
+ * Returns: the size of @undo's data that has been written to disk.
+ **/
+gint64
+gimp_undo_get_spilled_size (GimpUndo *undo,
+                            gint64   *pending_size)
+{
+  g_return_val_if_fail (GIMP_IS_UNDO (undo), 0);
+
+  return GIMP_UNDO_GET_CLASS (undo)->get_spilled_size (undo, pending_size);
+}
+
 typedef struct _GimpUndoIdle GimpUndoIdle;
 
 struct _GimpUndoIdle
@@ -72,28 +72,43 @@ struct _GimpUndoClass
                  GimpUndoAccumulator *accum);
   void (* free) (GimpUndo            *undo,
                  GimpUndoMode         undo_mode);
+
+  /*  virtual functions  */
+  gint64   (* spill)            (GimpUndo            *undo);
+  void     (* prefetch)         (GimpUndo            *undo);
+  gboolean (* unspill)          (GimpUndo            *undo,
+                                 GError             **error);
+  gint64   (* get_spilled_size) (GimpUndo            *undo,
+                                 gint64              *pending_size);
 };
 
 
-GType         gimp_undo_get_type        (void) G_GNUC_CONST;
+GType         gimp_undo_get_type         (void) G_GNUC_CONST;
+
+void          gimp_undo_pop              (GimpUndo            *undo,
+                                          GimpUndoMode         undo_mode,
+                                          GimpUndoAccumulator *accum);
+void          gimp_undo_free             (GimpUndo            *undo,
+                                          GimpUndoMode         undo_mode);
 
-void          gimp_undo_pop             (GimpUndo            *undo,
-                                         GimpUndoMode         undo_mode,
-                                         GimpUndoAccumulator *accum);
-void          gimp_undo_free            (GimpUndo            *undo,
-                                         GimpUndoMode         undo_mode);
+gint64        gimp_undo_spill            (GimpUndo            *undo);
+void          gimp_undo_prefetch         (GimpUndo            *undo);
+gboolean      gimp_undo_unspill          (GimpUndo            *undo,
+                                          GError             **error);
+gint64        gimp_undo_get_spilled_size (GimpUndo            *undo,
+                                          gint64              *pending_size);
 
-void          gimp_undo_create_preview  (GimpUndo            *undo,
-                                         GimpContext         *context,
-                                         gboolean             create_now);
-void          gimp_undo_refresh_preview (GimpUndo            *undo,
-                                         GimpContext         *context);
+void          gimp_undo_create_preview   (GimpUndo            *undo,
+                                          GimpContext         *context,
+                                          gboolean             create_now);
+void          gimp_undo_refresh_preview  (GimpUndo            *undo,
+                                          GimpContext         *context);
 
-const gchar * gimp_undo_type_to_name    (GimpUndoType         type);
+const gchar * gimp_undo_type_to_name     (GimpUndoType         type);
 
-gboolean      gimp_undo_is_weak         (GimpUndo            *undo);
-gint          gimp_undo_get_age         (GimpUndo            *undo);
-void          gimp_undo_reset_age       (GimpUndo            *undo);
+gboolean      gimp_undo_is_weak          (GimpUndo            *undo);
+gint          gimp_undo_get_age          (GimpUndo            *undo);
+void          gimp_undo_reset_age        (GimpUndo            *undo);
 
 
 #endif /* __GIMP_UNDO_H__ */
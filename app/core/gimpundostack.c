@@ -38,6 +38,13 @@ static void    gimp_undo_stack_pop         (GimpUndo            *undo,
                                             GimpUndoAccumulator *accum);
 static void    gimp_undo_stack_free        (GimpUndo            *undo,
                                             GimpUndoMode         undo_mode);
+static gint64  gimp_undo_stack_spill       (GimpUndo            *undo);
+static void    gimp_undo_stack_prefetch    (GimpUndo            *undo);
+static gboolean gimp_undo_stack_unspill    (GimpUndo            *undo,
+                                            GError             **error);
+static gint64  gimp_undo_stack_get_spilled_size
+                                           (GimpUndo            *undo,
+                                            gint64              *pending_size);
 
 
 G_DEFINE_TYPE (GimpUndoStack, gimp_undo_stack, GIMP_TYPE_UNDO)
@@ -58,6 +65,10 @@ gimp_undo_stack_class_init (GimpUndoStackClass *klass)
 
   undo_class->pop                = gimp_undo_stack_pop;
   undo_class->free               = gimp_undo_stack_free;
+  undo_class->spill              = gimp_undo_stack_spill;
+  undo_class->prefetch           = gimp_undo_stack_prefetch;
+  undo_class->unspill            = gimp_undo_stack_unspill;
+  undo_class->get_spilled_size   = gimp_undo_stack_get_spilled_size;
 }
 
 static void
@@ -127,6 +138,80 @@ gimp_undo_stack_free (GimpUndo     *undo,
   gimp_container_clear (stack->undos);
 }
 
+static gint64
+gimp_undo_stack_spill (GimpUndo *undo)
+{
+  GimpUndoStack *stack = GIMP_UNDO_STACK (undo);
+  GList         *list;
+  gint64         size  = 0;
+
+  for (list = GIMP_LIST (stack->undos)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      size += gimp_undo_spill (list->data);
+    }
+
+  return size;
+}
+
+static void
+gimp_undo_stack_prefetch (GimpUndo *undo)
+{
+  GimpUndoStack *stack = GIMP_UNDO_STACK (undo);
+  GList         *list;
+
+  for (list = GIMP_LIST (stack->undos)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      gimp_undo_prefetch (list->data);
+    }
+}
+
+static gboolean
+gimp_undo_stack_unspill (GimpUndo  *undo,
+                         GError   **error)
+{
+  GimpUndoStack *stack = GIMP_UNDO_STACK (undo);
+  GList         *list;
+
+  for (list = GIMP_LIST (stack->undos)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      if (! gimp_undo_unspill (list->data, error))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gint64
+gimp_undo_stack_get_spilled_size (GimpUndo *undo,
+                                  gint64   *pending_size)
+{
+  GimpUndoStack *stack   = GIMP_UNDO_STACK (undo);
+  GList         *list;
+  gint64         size    = 0;
+  gint64         pending = 0;
+
+  for (list = GIMP_LIST (stack->undos)->queue->head;
+       list;
+       list = g_list_next (list))
+    {
+      gint64 child_pending;
+
+      size    += gimp_undo_get_spilled_size (list->data, &child_pending);
+      pending += child_pending;
+    }
+
+  if (pending_size)
+    *pending_size = pending;
+
+  return size;
+}
+
 GimpUndoStack *
 gimp_undo_stack_new (GimpImage *image)
 {
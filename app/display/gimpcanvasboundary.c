@@ -96,6 +96,7 @@ gimp_canvas_boundary_class_init (GimpCanvasBoundaryClass *klass)
 
   item_class->draw           = gimp_canvas_boundary_draw;
   item_class->get_extents    = gimp_canvas_boundary_get_extents;
+  item_class->cache          = TRUE;
 
   g_object_class_install_property (object_class, PROP_SEGS,
                                    gimp_param_spec_array ("segs", NULL, NULL,
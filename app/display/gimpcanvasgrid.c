@@ -96,6 +96,7 @@ gimp_canvas_grid_class_init (GimpCanvasGridClass *klass)
   item_class->draw           = gimp_canvas_grid_draw;
   item_class->get_extents    = gimp_canvas_grid_get_extents;
   item_class->stroke         = gimp_canvas_grid_stroke;
+  item_class->cache          = TRUE;
 
   g_object_class_install_property (object_class, PROP_GRID,
                                    g_param_spec_object ("grid", NULL, NULL,
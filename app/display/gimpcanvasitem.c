@@ -28,6 +28,8 @@
 
 #include "display-types.h"
 
+#include "core/gimpimage.h"
+
 #include "gimpcanvas-style.h"
 #include "gimpcanvasitem.h"
 #include "gimpdisplay.h"
@@ -61,6 +63,19 @@ struct _GimpCanvasItemPrivate
   gint              suspend_filling;
   gint              change_count;
   cairo_region_t   *change_region;
+
+  cairo_surface_t  *cache;
+  gboolean          cache_stable;
+  gint              cache_x;
+  gint              cache_y;
+  gint              cache_offset_x;
+  gint              cache_offset_y;
+  gdouble           cache_scale_x;
+  gdouble           cache_scale_y;
+  gint              cache_disp_width;
+  gint              cache_disp_height;
+  gint              cache_image_width;
+  gint              cache_image_height;
 };
 
 
@@ -91,6 +106,10 @@ static gboolean         gimp_canvas_item_real_hit         (GimpCanvasItem  *item
                                                            gdouble          x,
                                                            gdouble          y);
 
+static gboolean         gimp_canvas_item_draw_cached      (GimpCanvasItem  *item,
+                                                           cairo_t         *cr);
+static void             gimp_canvas_item_invalidate_cache (GimpCanvasItem  *item);
+
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpCanvasItem, gimp_canvas_item, GIMP_TYPE_OBJECT)
 
@@ -116,6 +135,7 @@ gimp_canvas_item_class_init (GimpCanvasItemClass *klass)
   klass->stroke                             = gimp_canvas_item_real_stroke;
   klass->fill                               = gimp_canvas_item_real_fill;
   klass->hit                                = gimp_canvas_item_real_hit;
+  klass->cache                              = FALSE;
 
   item_signals[UPDATE] =
     g_signal_new ("update",
@@ -170,6 +190,8 @@ gimp_canvas_item_init (GimpCanvasItem *item)
   private->suspend_filling  = 0;
   private->change_count     = 1; /* avoid emissions during construction */
   private->change_region    = NULL;
+  private->cache            = NULL;
+  private->cache_stable     = FALSE;
 }
 
 static void
@@ -191,6 +213,8 @@ gimp_canvas_item_dispose (GObject *object)
 
   item->private->change_count++; /* avoid emissions during destruction */
 
+  gimp_canvas_item_invalidate_cache (item);
+
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
@@ -265,6 +289,8 @@ gimp_canvas_item_dispatch_properties_changed (GObject     *object,
                                                               n_pspecs,
                                                               pspecs);
 
+  gimp_canvas_item_invalidate_cache (item);
+
   if (_gimp_canvas_item_needs_update (item))
     {
       cairo_region_t *region = gimp_canvas_item_get_extents (item);
@@ -326,6 +352,142 @@ gimp_canvas_item_real_hit (GimpCanvasItem *item,
   return FALSE;
 }
 
+static gboolean
+gimp_canvas_item_draw_cached (GimpCanvasItem *item,
+                              cairo_t        *cr)
+{
+  GimpCanvasItemPrivate *private = item->private;
+  GimpDisplayShell      *shell   = private->shell;
+  GimpImage             *image   = gimp_display_get_image (shell->display);
+  cairo_matrix_t         matrix;
+  gint                   image_width  = 0;
+  gint                   image_height = 0;
+
+  /*  items inside stroking or filling groups only contribute their path
+   *  to the group, and are not drawn on their own
+   */
+  if (! GIMP_CANVAS_ITEM_GET_CLASS (item)->cache ||
+      private->suspend_stroking                  ||
+      private->suspend_filling)
+    {
+      return FALSE;
+    }
+
+  /*  the cache is composited 1:1, so it can't be used when the canvas is
+   *  drawn rotated
+   */
+  cairo_get_matrix (cr, &matrix);
+
+  if (matrix.xx != 1.0               ||
+      matrix.yx != 0.0               ||
+      matrix.xy != 0.0               ||
+      matrix.yy != 1.0               ||
+      matrix.x0 != floor (matrix.x0) ||
+      matrix.y0 != floor (matrix.y0))
+    {
+      return FALSE;
+    }
+
+  if (image)
+    {
+      image_width  = gimp_image_get_width  (image);
+      image_height = gimp_image_get_height (image);
+    }
+
+  if (private->cache                                    &&
+      (private->cache_offset_x     != shell->offset_x    ||
+       private->cache_offset_y     != shell->offset_y    ||
+       private->cache_scale_x      != shell->scale_x     ||
+       private->cache_scale_y      != shell->scale_y     ||
+       private->cache_disp_width   != shell->disp_width  ||
+       private->cache_disp_height  != shell->disp_height ||
+       private->cache_image_width  != image_width        ||
+       private->cache_image_height != image_height))
+    {
+      gimp_canvas_item_invalidate_cache (item);
+    }
+
+  if (! private->cache)
+    {
+      cairo_region_t        *region;
+      cairo_rectangle_int_t  rect;
+      cairo_t               *cache_cr;
+      gdouble                device_scale_x;
+      gdouble                device_scale_y;
+
+      /*  items that change on every redraw, such as items following the
+       *  pointer, wouldn't gain anything from the cache, so only items
+       *  drawn at least twice without changing are cached
+       */
+      if (! private->cache_stable)
+        {
+          private->cache_stable = TRUE;
+
+          return FALSE;
+        }
+
+      region = gimp_canvas_item_get_extents (item);
+
+      if (! region)
+        return FALSE;
+
+      cairo_region_get_extents (region, &rect);
+      cairo_region_destroy (region);
+
+      if (! gimp_rectangle_intersect (rect.x, rect.y, rect.width, rect.height,
+                                      0, 0,
+                                      shell->disp_width, shell->disp_height,
+                                      &rect.x, &rect.y,
+                                      &rect.width, &rect.height))
+        {
+          return FALSE;
+        }
+
+      cairo_surface_get_device_scale (cairo_get_target (cr),
+                                      &device_scale_x, &device_scale_y);
+
+      private->cache =
+        cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                    ceil (rect.width  * device_scale_x),
+                                    ceil (rect.height * device_scale_y));
+      cairo_surface_set_device_scale (private->cache,
+                                      device_scale_x, device_scale_y);
+
+      private->cache_x            = rect.x;
+      private->cache_y            = rect.y;
+      private->cache_offset_x     = shell->offset_x;
+      private->cache_offset_y     = shell->offset_y;
+      private->cache_scale_x      = shell->scale_x;
+      private->cache_scale_y      = shell->scale_y;
+      private->cache_disp_width   = shell->disp_width;
+      private->cache_disp_height  = shell->disp_height;
+      private->cache_image_width  = image_width;
+      private->cache_image_height = image_height;
+
+      cache_cr = cairo_create (private->cache);
+
+      cairo_translate (cache_cr, -rect.x, -rect.y);
+
+      GIMP_CANVAS_ITEM_GET_CLASS (item)->draw (item, cache_cr);
+
+      cairo_destroy (cache_cr);
+    }
+
+  cairo_set_source_surface (cr, private->cache,
+                            private->cache_x, private->cache_y);
+  cairo_paint (cr);
+
+  return TRUE;
+}
+
+static void
+gimp_canvas_item_invalidate_cache (GimpCanvasItem *item)
+{
+  g_clear_pointer (&item->private->cache, cairo_surface_destroy);
+
+  item->private->cache_stable = FALSE;
+}
+
 
 /*  public functions  */
 
@@ -363,7 +525,10 @@ gimp_canvas_item_draw (GimpCanvasItem *item,
   if (item->private->visible)
     {
       cairo_save (cr);
-      GIMP_CANVAS_ITEM_GET_CLASS (item)->draw (item, cr);
+
+      if (! gimp_canvas_item_draw_cached (item, cr))
+        GIMP_CANVAS_ITEM_GET_CLASS (item)->draw (item, cr);
+
       cairo_restore (cr);
     }
 }
@@ -487,6 +652,8 @@ gimp_canvas_item_end_change (GimpCanvasItem *item)
 
   if (private->change_count == 0)
     {
+      gimp_canvas_item_invalidate_cache (item);
+
       if (g_signal_has_handler_pending (item, item_signals[UPDATE], 0, FALSE))
         {
           cairo_region_t *region = gimp_canvas_item_get_extents (item);
@@ -683,6 +850,8 @@ void
 _gimp_canvas_item_update (GimpCanvasItem *item,
                           cairo_region_t *region)
 {
+  gimp_canvas_item_invalidate_cache (item);
+
   g_signal_emit (item, item_signals[UPDATE], 0,
                  region);
 }
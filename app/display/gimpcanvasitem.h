@@ -64,6 +64,11 @@ struct _GimpCanvasItemClass
   gboolean         (* hit)         (GimpCanvasItem   *item,
                                     gdouble           x,
                                     gdouble           y);
+
+  /*  whether the item is rendered into a retained surface, which is
+   *  only re-rendered when the item or the view change
+   */
+  gboolean         cache;
 };
 
 
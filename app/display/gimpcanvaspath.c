@@ -98,6 +98,7 @@ gimp_canvas_path_class_init (GimpCanvasPathClass *klass)
   item_class->draw           = gimp_canvas_path_draw;
   item_class->get_extents    = gimp_canvas_path_get_extents;
   item_class->stroke         = gimp_canvas_path_stroke;
+  item_class->cache          = TRUE;
 
   g_object_class_install_property (object_class, PROP_PATH,
                                    g_param_spec_boxed ("path", NULL, NULL,
@@ -40,6 +40,7 @@
 #include "core/gimp-transform-utils.h"
 #include "core/gimp-utils.h"
 #include "core/gimpchannel.h"
+#include "core/gimpchunkiterator.h"
 #include "core/gimpimage.h"
 #include "core/gimplayer.h"
 #include "core/gimppickable.h"
@@ -48,6 +49,16 @@
 #include "gimpcanvastransformpreview.h"
 #include "gimpdisplayshell.h"
 
+#include "gimp-priorities.h"
+
+
+/*  the highest level of detail the preview source is reduced to  */
+#define MAX_LOD_LEVEL      4
+
+/*  how long the preview has to stay unchanged before it is rendered
+ *  from the full-resolution source, in milliseconds
+ */
+#define FULL_QUALITY_DELAY 200
 
 enum
 {
@@ -92,7 +103,25 @@ struct _GimpCanvasTransformPreviewPrivate
   GeglRectangle        node_rect;
   gdouble              node_opacity;
   GimpMatrix3          node_matrix;
+  GeglNode            *node_input;
+  GeglNode            *node_transform_input;
   GeglNode            *node_output;
+
+  /*  downsampled source, transformed while the preview changes  */
+  GeglNode            *lod_source_node;
+  GeglBuffer          *lod_buffer;
+  gint                 lod_level;
+
+  /*  full-resolution rendering, performed once the preview settles  */
+  guint                full_idle_id;
+  GimpChunkIterator   *full_iter;
+  cairo_surface_t     *full_surface;
+  GeglRectangle        full_rect;
+  gboolean             full_complete;
+  gint                 full_offset_x;
+  gint                 full_offset_y;
+  gdouble              full_scale_x;
+  gdouble              full_scale_y;
 };
 
 #define GET_PRIVATE(transform_preview) \
@@ -120,7 +149,14 @@ static void             gimp_canvas_transform_preview_layer_changed (GimpLayer
 
 static void             gimp_canvas_transform_preview_set_pickable  (GimpCanvasTransformPreview *transform_preview,
                                                                      GimpPickable               *pickable);
-static void             gimp_canvas_transform_preview_sync_node     (GimpCanvasTransformPreview *transform_preview);
+static void             gimp_canvas_transform_preview_sync_node     (GimpCanvasTransformPreview *transform_preview,
+                                                                     gint                        level);
+
+static gint             gimp_canvas_transform_preview_get_level     (GimpCanvasTransformPreview *transform_preview);
+static void             gimp_canvas_transform_preview_queue_full    (GimpCanvasTransformPreview *transform_preview);
+static void             gimp_canvas_transform_preview_stop_full     (GimpCanvasTransformPreview *transform_preview);
+static gboolean         gimp_canvas_transform_preview_full_timeout  (GimpCanvasTransformPreview *transform_preview);
+static gboolean         gimp_canvas_transform_preview_full_idle     (GimpCanvasTransformPreview *transform_preview);
 
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpCanvasTransformPreview,
@@ -219,7 +255,10 @@ gimp_canvas_transform_preview_dispose (GObject *object)
   GimpCanvasTransformPreview        *transform_preview = GIMP_CANVAS_TRANSFORM_PREVIEW (object);
   GimpCanvasTransformPreviewPrivate *private           = GET_PRIVATE (object);
 
+  gimp_canvas_transform_preview_stop_full (transform_preview);
+
   g_clear_object (&private->node);
+  g_clear_object (&private->lod_buffer);
 
   gimp_canvas_transform_preview_set_pickable (transform_preview, NULL);
 
@@ -235,6 +274,8 @@ gimp_canvas_transform_preview_set_property (GObject      *object,
   GimpCanvasTransformPreview        *transform_preview = GIMP_CANVAS_TRANSFORM_PREVIEW (object);
   GimpCanvasTransformPreviewPrivate *private           = GET_PRIVATE (object);
 
+  gimp_canvas_transform_preview_stop_full (transform_preview);
+
   switch (property_id)
     {
     case PROP_PICKABLE:
@@ -376,6 +417,7 @@ gimp_canvas_transform_preview_draw (GimpCanvasItem *item,
   cairo_surface_t                   *surface;
   guchar                            *surface_data;
   gint                               surface_stride;
+  gint                               level;
 
   if (! gimp_canvas_transform_preview_transform (item, &extents))
     return;
@@ -400,6 +442,30 @@ gimp_canvas_transform_preview_draw (GimpCanvasItem *item,
       return;
     }
 
+  if (private->full_surface                        &&
+      (private->full_offset_x != shell->offset_x ||
+       private->full_offset_y != shell->offset_y ||
+       private->full_scale_x  != shell->scale_x  ||
+       private->full_scale_y  != shell->scale_y))
+    {
+      gimp_canvas_transform_preview_stop_full (transform_preview);
+    }
+
+  if (private->full_complete)
+    {
+      cairo_set_source_surface (cr, private->full_surface,
+                                private->full_rect.x, private->full_rect.y);
+      cairo_rectangle (cr, bounds.x, bounds.y, bounds.width, bounds.height);
+      cairo_fill (cr);
+
+      return;
+    }
+
+  level = gimp_canvas_transform_preview_get_level (transform_preview);
+
+  if (level > 0)
+    gimp_canvas_transform_preview_queue_full (transform_preview);
+
   surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
                                         bounds.width, bounds.height);
 
@@ -408,7 +474,7 @@ gimp_canvas_transform_preview_draw (GimpCanvasItem *item,
   surface_data   = cairo_image_surface_get_data (surface);
   surface_stride = cairo_image_surface_get_stride (surface);
 
-  gimp_canvas_transform_preview_sync_node (transform_preview);
+  gimp_canvas_transform_preview_sync_node (transform_preview, level);
 
   gegl_node_blit (private->node_output, 1.0,
                   GEGL_RECTANGLE (bounds.x + shell->offset_x,
@@ -444,6 +510,8 @@ gimp_canvas_transform_preview_layer_changed (GimpLayer                  *layer,
 {
   GimpCanvasItem *item = GIMP_CANVAS_ITEM (transform_preview);
 
+  gimp_canvas_transform_preview_stop_full (transform_preview);
+
   gimp_canvas_item_begin_change (item);
   gimp_canvas_item_end_change   (item);
 }
@@ -482,7 +550,8 @@ gimp_canvas_transform_preview_set_pickable (GimpCanvasTransformPreview *transfor
 }
 
 static void
-gimp_canvas_transform_preview_sync_node (GimpCanvasTransformPreview *transform_preview)
+gimp_canvas_transform_preview_sync_node (GimpCanvasTransformPreview *transform_preview,
+                                         gint                        level)
 {
   GimpCanvasTransformPreviewPrivate *private    = GET_PRIVATE (transform_preview);
   GimpCanvasItem                    *item       = GIMP_CANVAS_ITEM (transform_preview);
@@ -494,6 +563,8 @@ gimp_canvas_transform_preview_sync_node (GimpCanvasTransformPreview *transform_p
   gdouble                            opacity    = private->opacity;
   gint                               offset_x   = 0;
   gint                               offset_y   = 0;
+  gboolean                           lod_valid  = TRUE;
+  GeglNode                          *input;
   GimpMatrix3                        matrix;
 
   if (! private->node)
@@ -554,6 +625,11 @@ gimp_canvas_transform_preview_sync_node (GimpCanvasTransformPreview *transform_p
                              "sampler",   GIMP_INTERPOLATION_NONE,
                              NULL);
 
+      private->lod_source_node =
+        gegl_node_new_child (private->node,
+                             "operation", "gegl:buffer-source",
+                             NULL);
+
       gegl_node_link_many (private->source_node,
                            private->convert_format_node,
                            private->transform_node,
@@ -567,13 +643,15 @@ gimp_canvas_transform_preview_sync_node (GimpCanvasTransformPreview *transform_p
                            private->mask_crop_node,
                            NULL);
 
-      private->node_pickable   = NULL;
-      private->node_layer_mask = NULL;
-      private->node_mask       = NULL;
-      private->node_rect       = *GEGL_RECTANGLE (0, 0, 0, 0);
-      private->node_opacity    = 1.0;
+      private->node_pickable        = NULL;
+      private->node_layer_mask      = NULL;
+      private->node_mask            = NULL;
+      private->node_rect            = *GEGL_RECTANGLE (0, 0, 0, 0);
+      private->node_opacity         = 1.0;
       gimp_matrix3_identity (&private->node_matrix);
-      private->node_output     = private->transform_node;
+      private->node_input           = private->convert_format_node;
+      private->node_transform_input = private->convert_format_node;
+      private->node_output          = private->transform_node;
     }
 
   if (GIMP_IS_ITEM (pickable))
@@ -610,7 +688,11 @@ gimp_canvas_transform_preview_sync_node (GimpCanvasTransformPreview *transform_p
         }
     }
 
+  /*  the downsampled source is sampled at the matching coordinates of the
+   *  full-resolution source
+   */
   gimp_matrix3_identity (&matrix);
+  gimp_matrix3_scale (&matrix, 1 << level, 1 << level);
   gimp_matrix3_translate (&matrix, offset_x, offset_y);
   gimp_matrix3_mult (&private->transform, &matrix);
   gimp_matrix3_scale (&matrix, shell->scale_x, shell->scale_y);
@@ -619,6 +701,8 @@ gimp_canvas_transform_preview_sync_node (GimpCanvasTransformPreview *transform_p
     {
       GeglBuffer *buffer;
 
+      lod_valid = FALSE;
+
       gimp_pickable_flush (pickable);
 
       buffer = gimp_pickable_get_buffer (pickable);
@@ -667,6 +751,8 @@ gimp_canvas_transform_preview_sync_node (GimpCanvasTransformPreview *transform_p
         {
           private->node_rect = rect;
 
+          lod_valid = FALSE;
+
           gegl_node_set (private->mask_translate_node,
                          "x", (gdouble) -rect.x,
                          "y", (gdouble) -rect.y,
@@ -691,6 +777,8 @@ gimp_canvas_transform_preview_sync_node (GimpCanvasTransformPreview *transform_p
 
   if (opacity != private->node_opacity)
     {
+      lod_valid = FALSE;
+
       gegl_node_set (private->opacity_node,
                      "value", opacity,
                      NULL);
@@ -702,6 +790,8 @@ gimp_canvas_transform_preview_sync_node (GimpCanvasTransformPreview *transform_p
     {
       GeglNode *output = private->source_node;
 
+      lod_valid = FALSE;
+
       if (layer_mask && ! mask)
         {
           gegl_node_link (output, private->layer_mask_opacity_node);
@@ -737,7 +827,8 @@ gimp_canvas_transform_preview_sync_node (GimpCanvasTransformPreview *transform_p
           output = private->cache_node;
         }
 
-      gegl_node_link (output, private->transform_node);
+      private->node_input = output;
+
       output = private->transform_node;
 
       if (layer_mask && mask)
@@ -749,6 +840,66 @@ gimp_canvas_transform_preview_sync_node (GimpCanvasTransformPreview *transform_p
       private->node_output = output;
     }
 
+  if (! lod_valid)
+    g_clear_object (&private->lod_buffer);
+
+  input = private->node_input;
+
+  if (level > 0)
+    {
+      if (private->lod_buffer && private->lod_level != level)
+        g_clear_object (&private->lod_buffer);
+
+      if (! private->lod_buffer)
+        {
+          const Babl    *format;
+          GeglRectangle  bounding_box;
+          GeglRectangle  rect;
+          gint           stride;
+          guchar        *data;
+
+          format = gimp_pickable_get_format_with_alpha (pickable);
+
+          bounding_box = gegl_node_get_bounding_box (private->node_input);
+
+          rect.x      = floor ((gdouble) bounding_box.x / (1 << level));
+          rect.y      = floor ((gdouble) bounding_box.y / (1 << level));
+          rect.width  = ceil  ((gdouble) (bounding_box.x +
+                                          bounding_box.width)  /
+                               (1 << level)) - rect.x;
+          rect.height = ceil  ((gdouble) (bounding_box.y +
+                                          bounding_box.height) /
+                               (1 << level)) - rect.y;
+
+          stride = rect.width * babl_format_get_bytes_per_pixel (format);
+          data   = g_malloc0 ((gsize) stride * rect.height);
+
+          /*  rendering the source at a reduced level reads it from the
+           *  buffers' mipmaps
+           */
+          gegl_node_blit (private->node_input, 1.0 / (1 << level), &rect,
+                          format, data, stride, GEGL_BLIT_DEFAULT);
+
+          private->lod_buffer = gegl_buffer_linear_new_from_data (
+            data, format, &rect, stride,
+            (GDestroyNotify) g_free, data);
+          private->lod_level  = level;
+
+          gegl_node_set (private->lod_source_node,
+                         "buffer", private->lod_buffer,
+                         NULL);
+        }
+
+      input = private->lod_source_node;
+    }
+
+  if (input != private->node_transform_input)
+    {
+      gegl_node_link (input, private->transform_node);
+
+      private->node_transform_input = input;
+    }
+
   if (memcmp (&matrix, &private->node_matrix, sizeof (matrix)))
     {
       private->node_matrix = matrix;
@@ -762,6 +913,160 @@ gimp_canvas_transform_preview_sync_node (GimpCanvasTransformPreview *transform_p
   private->node_opacity    = opacity;
 }
 
+static gint
+gimp_canvas_transform_preview_get_level (GimpCanvasTransformPreview *transform_preview)
+{
+  GimpCanvasItem   *item  = GIMP_CANVAS_ITEM (transform_preview);
+  GimpDisplayShell *shell = gimp_canvas_item_get_shell (item);
+  gdouble           scale = MAX (shell->scale_x, shell->scale_y);
+  gint              level = 0;
+
+  /*  pick the coarsest level whose resolution is still at least that of
+   *  the display
+   */
+  while (scale <= 0.5 && level < MAX_LOD_LEVEL)
+    {
+      scale *= 2.0;
+      level++;
+    }
+
+  return level;
+}
+
+static void
+gimp_canvas_transform_preview_queue_full (GimpCanvasTransformPreview *transform_preview)
+{
+  GimpCanvasTransformPreviewPrivate *private = GET_PRIVATE (transform_preview);
+
+  if (! private->full_idle_id)
+    {
+      private->full_idle_id =
+        g_timeout_add (FULL_QUALITY_DELAY,
+                       (GSourceFunc) gimp_canvas_transform_preview_full_timeout,
+                       transform_preview);
+    }
+}
+
+static void
+gimp_canvas_transform_preview_stop_full (GimpCanvasTransformPreview *transform_preview)
+{
+  GimpCanvasTransformPreviewPrivate *private = GET_PRIVATE (transform_preview);
+
+  if (private->full_idle_id)
+    {
+      g_source_remove (private->full_idle_id);
+
+      private->full_idle_id = 0;
+    }
+
+  if (private->full_iter)
+    {
+      gimp_chunk_iterator_stop (private->full_iter, TRUE);
+
+      private->full_iter = NULL;
+    }
+
+  g_clear_pointer (&private->full_surface, cairo_surface_destroy);
+
+  private->full_complete = FALSE;
+}
+
+static gboolean
+gimp_canvas_transform_preview_full_timeout (GimpCanvasTransformPreview *transform_preview)
+{
+  GimpCanvasTransformPreviewPrivate *private = GET_PRIVATE (transform_preview);
+  GimpCanvasItem                    *item    = GIMP_CANVAS_ITEM (transform_preview);
+  GimpDisplayShell                  *shell   = gimp_canvas_item_get_shell (item);
+  cairo_rectangle_int_t              extents;
+  cairo_region_t                    *region;
+
+  private->full_idle_id = 0;
+
+  if (! gimp_canvas_transform_preview_transform (item, &extents) ||
+      ! gimp_rectangle_intersect (extents.x, extents.y,
+                                  extents.width, extents.height,
+                                  0, 0,
+                                  shell->disp_width, shell->disp_height,
+                                  &private->full_rect.x,
+                                  &private->full_rect.y,
+                                  &private->full_rect.width,
+                                  &private->full_rect.height))
+    {
+      return G_SOURCE_REMOVE;
+    }
+
+  private->full_surface = cairo_image_surface_create (
+    CAIRO_FORMAT_ARGB32,
+    private->full_rect.width, private->full_rect.height);
+
+  private->full_offset_x = shell->offset_x;
+  private->full_offset_y = shell->offset_y;
+  private->full_scale_x  = shell->scale_x;
+  private->full_scale_y  = shell->scale_y;
+
+  region = cairo_region_create_rectangle (
+    (const cairo_rectangle_int_t *) &private->full_rect);
+
+  private->full_iter = gimp_chunk_iterator_new (region);
+
+  private->full_idle_id =
+    g_idle_add_full (GIMP_PRIORITY_DISPLAY_SHELL_RENDER_IDLE,
+                     (GSourceFunc) gimp_canvas_transform_preview_full_idle,
+                     transform_preview, NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+gimp_canvas_transform_preview_full_idle (GimpCanvasTransformPreview *transform_preview)
+{
+  GimpCanvasTransformPreviewPrivate *private = GET_PRIVATE (transform_preview);
+  GimpCanvasItem                    *item    = GIMP_CANVAS_ITEM (transform_preview);
+  GimpDisplayShell                  *shell   = gimp_canvas_item_get_shell (item);
+
+  if (gimp_chunk_iterator_next (private->full_iter))
+    {
+      guchar        *surface_data;
+      gint           surface_stride;
+      GeglRectangle  rect;
+
+      surface_data   = cairo_image_surface_get_data (private->full_surface);
+      surface_stride = cairo_image_surface_get_stride (private->full_surface);
+
+      gimp_canvas_transform_preview_sync_node (transform_preview, 0);
+
+      cairo_surface_flush (private->full_surface);
+
+      while (gimp_chunk_iterator_get_rect (private->full_iter, &rect))
+        {
+          gegl_node_blit (private->node_output, 1.0,
+                          GEGL_RECTANGLE (rect.x + shell->offset_x,
+                                          rect.y + shell->offset_y,
+                                          rect.width,
+                                          rect.height),
+                          babl_format ("cairo-ARGB32"),
+                          surface_data +
+                          (rect.y - private->full_rect.y) * surface_stride +
+                          (rect.x - private->full_rect.x) * 4,
+                          surface_stride,
+                          GEGL_BLIT_CACHE);
+        }
+
+      cairo_surface_mark_dirty (private->full_surface);
+
+      return G_SOURCE_CONTINUE;
+    }
+
+  private->full_iter     = NULL;
+  private->full_idle_id  = 0;
+  private->full_complete = TRUE;
+
+  gimp_canvas_item_begin_change (item);
+  gimp_canvas_item_end_change   (item);
+
+  return G_SOURCE_REMOVE;
+}
+
 
 /* public functions */
 
@@ -46,6 +46,7 @@
 #include "gimpdisplayshell-title.h"
 #include "gimpdisplayshell-transform.h"
 #include "gimpimagewindow.h"
+#include "gimpmotionbuffer.h"
 #include "gimpnavigationeditor.h"
 
 #include "git-version.h"
@@ -267,7 +268,7 @@ gimp_display_shell_canvas_size_allocate (GtkWidget        *widget,
       shell->disp_height != allocation->height)
     {
       g_clear_pointer (&shell->render_cache, cairo_surface_destroy);
-      gimp_display_shell_render_invalidate_full (shell);
+      gimp_display_shell_render_invalidate_view (shell);
 
       shell->disp_width  = allocation->width;
       shell->disp_height = allocation->height;
@@ -299,6 +300,8 @@ gimp_display_shell_canvas_draw (GtkWidget        *widget,
       if (gimp_display_get_image (shell->display))
         {
           gimp_display_shell_canvas_draw_image (shell, cr);
+
+          gimp_motion_buffer_frame_drawn (shell->motion_buffer);
         }
       else
         {
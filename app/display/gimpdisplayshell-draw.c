@@ -146,7 +146,7 @@ gimp_display_shell_draw_image (GimpDisplayShell *shell,
 {
   gdouble chunk_width;
   gdouble chunk_height;
-  gdouble scale = 1.0;
+  gdouble scale;
   gint    n_rows;
   gint    n_cols;
   gint    r, c;
@@ -155,34 +155,9 @@ gimp_display_shell_draw_image (GimpDisplayShell *shell,
   g_return_if_fail (gimp_display_get_image (shell->display));
   g_return_if_fail (cr != NULL);
 
-  /*  display the image in RENDER_BUF_WIDTH x RENDER_BUF_HEIGHT
-   *  maximally-sized image-space chunks.  adjust the screen-space
-   *  chunk size as necessary, to accommodate for the display
-   *  transform and window scale factor.
-   */
-  chunk_width  = shell->render_buf_width;
-  chunk_height = shell->render_buf_height;
-
-  /* multiply the image scale-factor by the window scale-factor, and divide
-   * the cairo scale-factor by the same amount (further down), so that we make
-   * full use of the screen resolution, even on hidpi displays.
-   */
-  scale *= shell->render_scale;
-
-  scale *= MAX (shell->scale_x, shell->scale_y);
-
-  if (scale != shell->scale_x)
-    chunk_width  = (chunk_width  - 1.0) * (shell->scale_x / scale);
-  if (scale != shell->scale_y)
-    chunk_height = (chunk_height - 1.0) * (shell->scale_y / scale);
-
-  if (shell->rotate_untransform)
-    {
-      gdouble a = shell->rotate_angle * G_PI / 180.0;
-
-      chunk_width = chunk_height = (MIN (chunk_width, chunk_height) - 1.0) /
-                                   (fabs (sin (a)) + fabs (cos (a)));
-    }
+  gimp_display_shell_render_get_chunk_size (shell,
+                                            &scale,
+                                            &chunk_width, &chunk_height);
 
   /* divide the painted area to evenly-sized chunks */
   n_rows = ceil (h / floor (chunk_height));
@@ -204,6 +179,14 @@ gimp_display_shell_draw_image (GimpDisplayShell *shell,
           cairo_rectangle (cr, x1, y1, x2 - x1, y2 - y1);
           cairo_clip (cr);
 
+          /* try the tiles cached from earlier renders first */
+          if (! gimp_display_shell_render_is_valid (shell,
+                                                    x1, y1, x2 - x1, y2 - y1))
+            {
+              gimp_display_shell_render_restore_area (shell, cr,
+                                                      x1, y1, x2 - x1, y2 - y1);
+            }
+
           if (! gimp_display_shell_render_is_valid (shell,
                                                     x1, y1, x2 - x1, y2 - y1))
             {
@@ -217,7 +200,8 @@ gimp_display_shell_draw_image (GimpDisplayShell *shell,
             }
 
           /* divide the cairo scale-factor by the window scale-factor, since
-           * the render cache uses device pixels.  see comment further up.
+           * the render cache uses device pixels.  see
+           * gimp_display_shell_render_get_chunk_size().
            */
           cairo_scale (cr,
                        1.0 / shell->render_scale,
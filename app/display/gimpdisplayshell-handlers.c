@@ -41,6 +41,7 @@
 #include "core/gimpimage-sample-points.h"
 #include "core/gimpitem.h"
 #include "core/gimpitemstack.h"
+#include "core/gimpprojection.h"
 #include "core/gimpsamplepoint.h"
 #include "core/gimptreehandler.h"
 
@@ -434,6 +435,9 @@ gimp_display_shell_disconnect (GimpDisplayShell *shell)
 
   user_context = gimp_get_user_context (shell->display->gimp);
 
+  gimp_projection_unset_priority_scale (gimp_image_get_projection (image),
+                                        shell);
+
   gimp_canvas_layer_boundary_set_layers (GIMP_CANVAS_LAYER_BOUNDARY (shell->layer_boundary),
                                          NULL);
 
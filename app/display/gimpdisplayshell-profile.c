@@ -44,13 +44,39 @@
 #include "gimp-intl.h"
 
 
+#define PROFILE_LUT_SIZE                33
+#define PROFILE_LUT_PIXELS_PER_THREAD   (64 * 64)
+
+
+typedef struct
+{
+  const gfloat *lut;
+  const Babl   *fish;
+  const guchar *src;
+  gint          src_stride;
+  guchar       *dest;
+  gint          dest_stride;
+  gint          width;
+} ConvertLutData;
+
+
 /*  local function prototypes  */
 
-static void   gimp_display_shell_profile_free        (GimpDisplayShell *shell);
+static void     gimp_display_shell_profile_free         (GimpDisplayShell     *shell);
+
+static gboolean gimp_display_shell_profile_can_bake_lut (GimpDisplayShell     *shell,
+                                                         const Babl           *src_format);
+static void     gimp_display_shell_profile_bake_lut     (GimpDisplayShell     *shell,
+                                                         const Babl           *src_format,
+                                                         const Babl           *dest_format);
+static void     gimp_display_shell_profile_convert_lut_rows
+                                                        (gsize                 offset,
+                                                         gsize                 size,
+                                                         const ConvertLutData *data);
 
-static void   gimp_display_shell_color_config_notify (GimpColorConfig  *config,
-                                                      const GParamSpec *pspec,
-                                                      GimpDisplayShell *shell);
+static void     gimp_display_shell_color_config_notify  (GimpColorConfig      *config,
+                                                         const GParamSpec     *pspec,
+                                                         GimpDisplayShell     *shell);
 
 
 /*  public functions  */
@@ -156,20 +182,36 @@ gimp_display_shell_profile_update (GimpDisplayShell *shell)
                                      filter_format,
                                      dest_format);
 
+  /*  if the display transform is a pure function of the pixel's
+   *  color, bake it into a lookup table once, instead of running
+   *  lcms over every rendered chunk
+   */
+  if (gimp_display_shell_profile_can_bake_lut (shell, src_format))
+    gimp_display_shell_profile_bake_lut (shell, src_format, dest_format);
+
   if (shell->filter_transform || shell->profile_transform)
     {
-      gint w = shell->render_buf_width;
-      gint h = shell->render_buf_height;
+      const Babl *buffer_format;
+      gint        w = shell->render_buf_width;
+      gint        h = shell->render_buf_height;
+
+      /*  with a baked lut, the projection pixels are fetched in the
+       *  lut's format
+       */
+      if (shell->profile_lut)
+        buffer_format = shell->profile_lut_format;
+      else
+        buffer_format = src_format;
 
       shell->profile_data =
-        gegl_malloc (w * h * babl_format_get_bytes_per_pixel (src_format));
+        gegl_malloc (w * h * babl_format_get_bytes_per_pixel (buffer_format));
 
       shell->profile_stride =
-        w * babl_format_get_bytes_per_pixel (src_format);
+        w * babl_format_get_bytes_per_pixel (buffer_format);
 
       shell->profile_buffer =
         gegl_buffer_linear_new_from_data (shell->profile_data,
-                                          src_format,
+                                          buffer_format,
                                           GEGL_RECTANGLE (0, 0, w, h),
                                           GEGL_AUTO_ROWSTRIDE,
                                           (GDestroyNotify) gegl_free,
@@ -211,6 +253,37 @@ gimp_display_shell_profile_can_convert_to_u8 (GimpDisplayShell *shell)
   return FALSE;
 }
 
+void
+gimp_display_shell_profile_convert_lut (GimpDisplayShell *shell,
+                                        const guchar     *src,
+                                        gint              src_stride,
+                                        guchar           *dest,
+                                        gint              dest_stride,
+                                        gint              width,
+                                        gint              height)
+{
+  ConvertLutData data;
+
+  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
+  g_return_if_fail (shell->profile_lut != NULL);
+  g_return_if_fail (src != NULL);
+  g_return_if_fail (dest != NULL);
+
+  data.lut         = shell->profile_lut;
+  data.fish        = babl_fish (babl_format ("R'G'B'A float"),
+                                babl_format ("cairo-ARGB32"));
+  data.src         = src;
+  data.src_stride  = src_stride;
+  data.dest        = dest;
+  data.dest_stride = dest_stride;
+  data.width       = width;
+
+  gegl_parallel_distribute_range (
+    height, (gdouble) PROFILE_LUT_PIXELS_PER_THREAD / MAX (width, 1),
+    (GeglParallelDistributeRangeFunc) gimp_display_shell_profile_convert_lut_rows,
+    &data);
+}
+
 
 /*  private functions  */
 
@@ -222,6 +295,220 @@ gimp_display_shell_profile_free (GimpDisplayShell *shell)
   g_clear_object (&shell->profile_buffer);
   shell->profile_data   = NULL;
   shell->profile_stride = 0;
+
+  g_clear_pointer (&shell->profile_lut, g_free);
+  shell->profile_lut_format = NULL;
+}
+
+static gboolean
+gimp_display_shell_profile_can_bake_lut (GimpDisplayShell *shell,
+                                         const Babl       *src_format)
+{
+  GimpColorConfig *config = gimp_display_shell_get_color_config (shell);
+
+  if (! shell->profile_transform || gimp_display_shell_has_filter (shell))
+    return FALSE;
+
+  /*  the lut is indexed by RGB, and only covers the [0..1] range  */
+  if (gimp_babl_format_get_base_type (src_format) != GIMP_RGB ||
+      ! gimp_babl_is_bounded (gimp_babl_format_get_precision (src_format)))
+    return FALSE;
+
+  /*  the gamut check marks out-of-gamut pixels with a flat color,
+   *  which doesn't survive interpolation
+   */
+  if (gimp_color_config_get_mode (config) == GIMP_COLOR_MANAGEMENT_SOFTPROOF &&
+      gimp_color_config_get_simulation_gamut_check (config))
+    return FALSE;
+
+  return TRUE;
+}
+
+static void
+gimp_display_shell_profile_bake_lut (GimpDisplayShell *shell,
+                                     const Babl       *src_format,
+                                     const Babl       *dest_format)
+{
+  const Babl *lut_format;
+  const gint  n_samples = PROFILE_LUT_SIZE *
+                          PROFILE_LUT_SIZE *
+                          PROFILE_LUT_SIZE;
+  gfloat     *grid;
+  gpointer    src;
+  gpointer    dest;
+  gfloat     *lut;
+  gint        r, g, b;
+  gint        i;
+
+  /*  sample the grid in the image's own space, using a perceptual
+   *  encoding, so that the samples are spread evenly over what the
+   *  eye can tell apart
+   */
+  lut_format = gimp_babl_format (GIMP_RGB,
+                                 GIMP_PRECISION_FLOAT_NON_LINEAR,
+                                 TRUE,
+                                 babl_format_get_space (src_format));
+
+  grid = g_new (gfloat, 4 * n_samples);
+  src  = g_malloc (n_samples * babl_format_get_bytes_per_pixel (src_format));
+  dest = g_malloc (n_samples * babl_format_get_bytes_per_pixel (dest_format));
+
+  i = 0;
+
+  for (r = 0; r < PROFILE_LUT_SIZE; r++)
+    for (g = 0; g < PROFILE_LUT_SIZE; g++)
+      for (b = 0; b < PROFILE_LUT_SIZE; b++)
+        {
+          grid[i++] = (gfloat) r / (PROFILE_LUT_SIZE - 1);
+          grid[i++] = (gfloat) g / (PROFILE_LUT_SIZE - 1);
+          grid[i++] = (gfloat) b / (PROFILE_LUT_SIZE - 1);
+          grid[i++] = 1.0f;
+        }
+
+  babl_process (babl_fish (lut_format, src_format),
+                grid, src, n_samples);
+
+  gimp_color_transform_process_pixels (shell->profile_transform,
+                                       src_format,  src,
+                                       dest_format, dest,
+                                       n_samples);
+
+  babl_process (babl_fish (dest_format, babl_format ("R'G'B'A float")),
+                dest, grid, n_samples);
+
+  lut = g_new (gfloat, 3 * n_samples);
+
+  for (i = 0; i < n_samples; i++)
+    {
+      lut[3 * i + 0] = grid[4 * i + 0];
+      lut[3 * i + 1] = grid[4 * i + 1];
+      lut[3 * i + 2] = grid[4 * i + 2];
+    }
+
+  g_free (grid);
+  g_free (src);
+  g_free (dest);
+
+  shell->profile_lut        = lut;
+  shell->profile_lut_format = lut_format;
+}
+
+static inline gint
+gimp_display_shell_profile_lut_index (gfloat  value,
+                                      gfloat *frac)
+{
+  gint index;
+
+  /*  also maps NaN to 0  */
+  if (! (value > 0.0f))
+    value = 0.0f;
+  else if (value > 1.0f)
+    value = 1.0f;
+
+  value *= PROFILE_LUT_SIZE - 1;
+  index  = MIN ((gint) value, PROFILE_LUT_SIZE - 2);
+
+  *frac = value - index;
+
+  return index;
+}
+
+static void
+gimp_display_shell_profile_convert_lut_rows (gsize                 offset,
+                                             gsize                 size,
+                                             const ConvertLutData *data)
+{
+  const gint  dr = 3 * PROFILE_LUT_SIZE * PROFILE_LUT_SIZE;
+  const gint  dg = 3 * PROFILE_LUT_SIZE;
+  const gint  db = 3;
+  gfloat     *row;
+  gsize       y;
+
+  row = gegl_scratch_new (gfloat, 4 * data->width);
+
+  for (y = offset; y < offset + size; y++)
+    {
+      const gfloat *src  = (const gfloat *) (data->src +
+                                             y * data->src_stride);
+      gfloat       *dest = row;
+      gint          x;
+
+      for (x = 0; x < data->width; x++)
+        {
+          const gfloat *c000;
+          const gfloat *c1;
+          const gfloat *c2;
+          const gfloat *c111;
+          gfloat        fr, fg, fb;
+          gfloat        f1, f2, f3;
+          gint          c;
+
+          c000 = data->lut +
+                 dr * gimp_display_shell_profile_lut_index (src[0], &fr) +
+                 dg * gimp_display_shell_profile_lut_index (src[1], &fg) +
+                 db * gimp_display_shell_profile_lut_index (src[2], &fb);
+          c111 = c000 + dr + dg + db;
+
+          /*  tetrahedral interpolation: pick the tetrahedron of the
+           *  cell containing the sample, by ordering its fractions
+           */
+          if (fr > fg)
+            {
+              if (fg > fb)
+                {
+                  c1 = c000 + dr;      c2 = c1 + dg;
+                  f1 = fr;             f2 = fg;      f3 = fb;
+                }
+              else if (fr > fb)
+                {
+                  c1 = c000 + dr;      c2 = c1 + db;
+                  f1 = fr;             f2 = fb;      f3 = fg;
+                }
+              else
+                {
+                  c1 = c000 + db;      c2 = c1 + dr;
+                  f1 = fb;             f2 = fr;      f3 = fg;
+                }
+            }
+          else
+            {
+              if (fb > fg)
+                {
+                  c1 = c000 + db;      c2 = c1 + dg;
+                  f1 = fb;             f2 = fg;      f3 = fr;
+                }
+              else if (fb > fr)
+                {
+                  c1 = c000 + dg;      c2 = c1 + db;
+                  f1 = fg;             f2 = fb;      f3 = fr;
+                }
+              else
+                {
+                  c1 = c000 + dg;      c2 = c1 + dr;
+                  f1 = fg;             f2 = fr;      f3 = fb;
+                }
+            }
+
+          for (c = 0; c < 3; c++)
+            {
+              dest[c] = c000[c]                  +
+                        (c1[c]   - c000[c]) * f1 +
+                        (c2[c]   - c1[c])   * f2 +
+                        (c111[c] - c2[c])   * f3;
+            }
+
+          dest[3] = src[3];
+
+          src  += 4;
+          dest += 4;
+        }
+
+      babl_process (data->fish,
+                    row, data->dest + y * data->dest_stride,
+                    data->width);
+    }
+
+  gegl_scratch_free (row);
 }
 
 static void
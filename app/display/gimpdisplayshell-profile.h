@@ -26,5 +26,13 @@ void     gimp_display_shell_profile_update            (GimpDisplayShell *shell);
 
 gboolean gimp_display_shell_profile_can_convert_to_u8 (GimpDisplayShell *shell);
 
+void     gimp_display_shell_profile_convert_lut       (GimpDisplayShell *shell,
+                                                       const guchar     *src,
+                                                       gint              src_stride,
+                                                       guchar           *dest,
+                                                       gint              dest_stride,
+                                                       gint              width,
+                                                       gint              height);
+
 
 #endif /*  __GIMP_DISPLAY_SHELL_PROFILE_H__  */
@@ -28,6 +28,7 @@
 
 #include "config/gimpdisplayconfig.h"
 
+#include "core/gimp-utils.h"
 #include "core/gimpimage.h"
 #include "core/gimppickable.h"
 #include "core/gimpprojectable.h"
@@ -39,10 +40,110 @@
 #include "gimpdisplayshell-profile.h"
 #include "gimpdisplayshell-render.h"
 
+#include "gimp-priorities.h"
+
 
 #define GIMP_DISPLAY_RENDER_ENABLE_SCALING 1
 #define GIMP_DISPLAY_RENDER_MAX_SCALE      4
 
+/*  the render cache keeps screen-space tiles of past renders, keyed by
+ *  the view transform, so that panning and switching between zoom
+ *  levels can reuse them.  tiles are placed in "view space", which is
+ *  screen space without the scroll offset.
+ */
+#define GIMP_DISPLAY_RENDER_TILE_SIZE      256
+#define GIMP_DISPLAY_RENDER_TILES_MIN_SIZE (64 << 20)
+#define GIMP_DISPLAY_RENDER_TILES_MARGIN   1
+
+
+typedef struct
+{
+  gdouble          scale_x;
+  gdouble          scale_y;
+  gdouble          rotate_angle;
+  gboolean         flip_horizontally;
+  gboolean         flip_vertically;
+  gboolean         show_all;
+  gint             render_scale;
+
+  gint             x;         /*  tile column and row, in view space  */
+  gint             y;
+} RenderTileKey;
+
+typedef struct
+{
+  RenderTileKey    key;
+
+  cairo_matrix_t   transform; /*  image space to view space           */
+  cairo_surface_t *surface;
+  cairo_region_t  *valid;     /*  in tile coordinates                 */
+
+  GList            lru_link;
+} RenderTile;
+
+
+static guint        render_tile_key_hash                (const RenderTileKey *key);
+static gboolean     render_tile_key_equal               (const RenderTileKey *key1,
+                                                         const RenderTileKey *key2);
+static void         render_tile_free                    (RenderTile          *tile);
+static void         render_transform_bounds             (const cairo_matrix_t *matrix,
+                                                         gdouble             *x1,
+                                                         gdouble             *y1,
+                                                         gdouble             *x2,
+                                                         gdouble             *y2);
+
+static void         gimp_display_shell_render_get_tile_key
+                                                        (GimpDisplayShell    *shell,
+                                                         gint                 x,
+                                                         gint                 y,
+                                                         RenderTileKey       *key);
+static void         gimp_display_shell_render_get_view_transform
+                                                        (GimpDisplayShell    *shell,
+                                                         cairo_matrix_t      *matrix);
+static void         gimp_display_shell_render_get_tile_range
+                                                        (GimpDisplayShell    *shell,
+                                                         gint                 x,
+                                                         gint                 y,
+                                                         gint                 width,
+                                                         gint                 height,
+                                                         gint                *tx1,
+                                                         gint                *ty1,
+                                                         gint                *tx2,
+                                                         gint                *ty2);
+static RenderTile * gimp_display_shell_render_lookup_tile
+                                                        (GimpDisplayShell    *shell,
+                                                         gint                 tx,
+                                                         gint                 ty,
+                                                         gboolean             create);
+static void         gimp_display_shell_render_store_area
+                                                        (GimpDisplayShell    *shell,
+                                                         gint                 x,
+                                                         gint                 y,
+                                                         gint                 width,
+                                                         gint                 height);
+static void         gimp_display_shell_render_trim_tiles
+                                                        (GimpDisplayShell    *shell);
+static void         gimp_display_shell_render_queue_prerender
+                                                        (GimpDisplayShell    *shell);
+static gboolean     gimp_display_shell_render_prerender_idle
+                                                        (GimpDisplayShell    *shell);
+
+static void         gimp_display_shell_render_ensure_cache
+                                                        (GimpDisplayShell    *shell,
+                                                         cairo_surface_t     *target);
+static void         gimp_display_shell_render_internal  (GimpDisplayShell    *shell,
+                                                         cairo_surface_t     *target,
+                                                         gint                 target_x,
+                                                         gint                 target_y,
+                                                         gint                 tx,
+                                                         gint                 ty,
+                                                         gint                 twidth,
+                                                         gint                 theight,
+                                                         gdouble              scale);
+
+
+/*  public functions  */
+
 
 void
 gimp_display_shell_render_set_scale (GimpDisplayShell *shell,
@@ -68,6 +169,27 @@ gimp_display_shell_render_invalidate_full (GimpDisplayShell *shell)
   g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
 
   g_clear_pointer (&shell->render_cache_valid, cairo_region_destroy);
+
+  if (shell->render_tiles_idle_id)
+    {
+      g_source_remove (shell->render_tiles_idle_id);
+      shell->render_tiles_idle_id = 0;
+    }
+
+  g_queue_init (&shell->render_tiles_lru);
+  g_clear_pointer (&shell->render_tiles, g_hash_table_unref);
+  shell->render_tiles_size = 0;
+}
+
+void
+gimp_display_shell_render_invalidate_view (GimpDisplayShell *shell)
+{
+  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
+
+  /*  only the view transform changed, the cached tiles are still
+   *  valid for their own views
+   */
+  g_clear_pointer (&shell->render_cache_valid, cairo_region_destroy);
 }
 
 void
@@ -90,6 +212,50 @@ gimp_display_shell_render_invalidate_area (GimpDisplayShell *shell,
 
       cairo_region_subtract_rectangle (shell->render_cache_valid, &rect);
     }
+
+  if (shell->render_tiles)
+    {
+      cairo_matrix_t untransform;
+      GList         *list;
+      gdouble        x1, y1, x2, y2;
+
+      /*  map the area back to image space, so that it can be invalidated
+       *  in the tiles of all views
+       */
+      gimp_display_shell_render_get_view_transform (shell, &untransform);
+      cairo_matrix_invert (&untransform);
+
+      x1 = x + shell->offset_x;
+      y1 = y + shell->offset_y;
+      x2 = x1 + width;
+      y2 = y1 + height;
+
+      render_transform_bounds (&untransform, &x1, &y1, &x2, &y2);
+
+      for (list = shell->render_tiles_lru.head; list; list = g_list_next (list))
+        {
+          RenderTile            *tile = list->data;
+          cairo_rectangle_int_t  rect;
+          gdouble                tx1  = x1;
+          gdouble                ty1  = y1;
+          gdouble                tx2  = x2;
+          gdouble                ty2  = y2;
+
+          render_transform_bounds (&tile->transform,
+                                              &tx1, &ty1, &tx2, &ty2);
+
+          /*  leave room for the filter's spill  */
+          rect.x      = floor (tx1) - 2;
+          rect.y      = floor (ty1) - 2;
+          rect.width  = ceil  (tx2) + 2 - rect.x;
+          rect.height = ceil  (ty2) + 2 - rect.y;
+
+          rect.x -= tile->key.x * GIMP_DISPLAY_RENDER_TILE_SIZE;
+          rect.y -= tile->key.y * GIMP_DISPLAY_RENDER_TILE_SIZE;
+
+          cairo_region_subtract_rectangle (tile->valid, &rect);
+        }
+    }
 }
 
 void
@@ -111,6 +277,8 @@ gimp_display_shell_render_validate_area (GimpDisplayShell *shell,
       rect.height = height;
 
       cairo_region_union_rectangle (shell->render_cache_valid, &rect);
+
+      gimp_display_shell_render_store_area (shell, x, y, width, height);
     }
 }
 
@@ -140,6 +308,152 @@ gimp_display_shell_render_is_valid (GimpDisplayShell *shell,
   return FALSE;
 }
 
+void
+gimp_display_shell_render_restore_area (GimpDisplayShell *shell,
+                                        cairo_t          *cr,
+                                        gint              x,
+                                        gint              y,
+                                        gint              width,
+                                        gint              height)
+{
+  cairo_region_t        *region;
+  cairo_rectangle_int_t  rect;
+  cairo_t               *my_cr = NULL;
+  gint                   tx1, ty1, tx2, ty2;
+  gint                   tx, ty;
+
+  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
+  g_return_if_fail (cr != NULL);
+
+  if (! shell->render_tiles)
+    return;
+
+  gimp_display_shell_render_ensure_cache (shell, cairo_get_target (cr));
+
+  rect.x      = x;
+  rect.y      = y;
+  rect.width  = width;
+  rect.height = height;
+
+  region = cairo_region_create_rectangle (&rect);
+  cairo_region_subtract (region, shell->render_cache_valid);
+
+  gimp_display_shell_render_get_tile_range (shell, x, y, width, height,
+                                            &tx1, &ty1, &tx2, &ty2);
+
+  for (ty = ty1; ty < ty2 && ! cairo_region_is_empty (region); ty++)
+    {
+      for (tx = tx1; tx < tx2 && ! cairo_region_is_empty (region); tx++)
+        {
+          RenderTile     *tile;
+          cairo_region_t *tile_region;
+          gint            origin_x;
+          gint            origin_y;
+          gint            n_rects;
+          gint            i;
+
+          tile = gimp_display_shell_render_lookup_tile (shell, tx, ty, FALSE);
+
+          if (! tile)
+            continue;
+
+          /*  the tile's origin, in screen space  */
+          origin_x = tx * GIMP_DISPLAY_RENDER_TILE_SIZE - shell->offset_x;
+          origin_y = ty * GIMP_DISPLAY_RENDER_TILE_SIZE - shell->offset_y;
+
+          tile_region = cairo_region_copy (tile->valid);
+          cairo_region_translate (tile_region, origin_x, origin_y);
+          cairo_region_intersect (tile_region, region);
+
+          n_rects = cairo_region_num_rectangles (tile_region);
+
+          if (n_rects > 0)
+            {
+              if (! my_cr)
+                {
+                  my_cr = cairo_create (shell->render_cache);
+
+                  cairo_set_operator (my_cr, CAIRO_OPERATOR_SOURCE);
+                }
+
+              for (i = 0; i < n_rects; i++)
+                {
+                  cairo_region_get_rectangle (tile_region, i, &rect);
+
+                  cairo_rectangle (my_cr,
+                                   rect.x      * shell->render_scale,
+                                   rect.y      * shell->render_scale,
+                                   rect.width  * shell->render_scale,
+                                   rect.height * shell->render_scale);
+                }
+
+              cairo_save (my_cr);
+              cairo_clip (my_cr);
+
+              cairo_set_source_surface (my_cr, tile->surface,
+                                        origin_x * shell->render_scale,
+                                        origin_y * shell->render_scale);
+              cairo_paint (my_cr);
+
+              cairo_restore (my_cr);
+
+              cairo_region_union (shell->render_cache_valid, tile_region);
+              cairo_region_subtract (region, tile_region);
+            }
+
+          cairo_region_destroy (tile_region);
+        }
+    }
+
+  if (my_cr)
+    cairo_destroy (my_cr);
+
+  cairo_region_destroy (region);
+
+  gimp_display_shell_render_queue_prerender (shell);
+}
+
+void
+gimp_display_shell_render_get_chunk_size (GimpDisplayShell *shell,
+                                          gdouble          *scale,
+                                          gdouble          *chunk_width,
+                                          gdouble          *chunk_height)
+{
+  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
+  g_return_if_fail (scale != NULL);
+  g_return_if_fail (chunk_width != NULL && chunk_height != NULL);
+
+  /*  display the image in RENDER_BUF_WIDTH x RENDER_BUF_HEIGHT
+   *  maximally-sized image-space chunks.  adjust the screen-space
+   *  chunk size as necessary, to accommodate for the display
+   *  transform and window scale factor.
+   */
+  *chunk_width  = shell->render_buf_width;
+  *chunk_height = shell->render_buf_height;
+
+  /* multiply the image scale-factor by the window scale-factor, and divide
+   * the cairo scale-factor by the same amount (when painting the render
+   * cache), so that we make full use of the screen resolution, even on
+   * hidpi displays.
+   */
+  *scale = shell->render_scale;
+
+  *scale *= MAX (shell->scale_x, shell->scale_y);
+
+  if (*scale != shell->scale_x)
+    *chunk_width  = (*chunk_width  - 1.0) * (shell->scale_x / *scale);
+  if (*scale != shell->scale_y)
+    *chunk_height = (*chunk_height - 1.0) * (shell->scale_y / *scale);
+
+  if (shell->rotate_untransform)
+    {
+      gdouble a = shell->rotate_angle * G_PI / 180.0;
+
+      *chunk_width = *chunk_height = (MIN (*chunk_width, *chunk_height) - 1.0) /
+                                     (fabs (sin (a)) + fabs (cos (a)));
+    }
+}
+
 void
 gimp_display_shell_render (GimpDisplayShell *shell,
                            cairo_t          *cr,
@@ -148,6 +462,471 @@ gimp_display_shell_render (GimpDisplayShell *shell,
                            gint              twidth,
                            gint              theight,
                            gdouble           scale)
+{
+  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
+  g_return_if_fail (cr != NULL);
+  g_return_if_fail (scale > 0.0);
+
+  if (! shell->render_surface)
+    {
+      shell->render_surface =
+        cairo_surface_create_similar_image (cairo_get_target (cr),
+                                            CAIRO_FORMAT_ARGB32,
+                                            shell->render_buf_width,
+                                            shell->render_buf_height);
+    }
+
+  gimp_display_shell_render_ensure_cache (shell, cairo_get_target (cr));
+
+  gimp_display_shell_render_internal (shell, shell->render_cache, 0, 0,
+                                      tx, ty, twidth, theight, scale);
+}
+
+
+/*  private functions  */
+
+static guint
+render_tile_key_hash (const RenderTileKey *key)
+{
+  guint hash;
+
+  hash = g_double_hash (&key->scale_x);
+  hash = hash * 31 + g_double_hash (&key->scale_y);
+  hash = hash * 31 + g_double_hash (&key->rotate_angle);
+  hash = hash * 31 + ((key->flip_horizontally << 0) |
+                      (key->flip_vertically   << 1) |
+                      (key->show_all          << 2));
+  hash = hash * 31 + key->render_scale;
+  hash = hash * 31 + key->x;
+  hash = hash * 31 + key->y;
+
+  return hash;
+}
+
+static gboolean
+render_tile_key_equal (const RenderTileKey *key1,
+                       const RenderTileKey *key2)
+{
+  return key1->scale_x           == key2->scale_x           &&
+         key1->scale_y           == key2->scale_y           &&
+         key1->rotate_angle      == key2->rotate_angle      &&
+         key1->flip_horizontally == key2->flip_horizontally &&
+         key1->flip_vertically   == key2->flip_vertically   &&
+         key1->show_all          == key2->show_all          &&
+         key1->render_scale      == key2->render_scale      &&
+         key1->x                 == key2->x                 &&
+         key1->y                 == key2->y;
+}
+
+static void
+render_tile_free (RenderTile *tile)
+{
+  cairo_surface_destroy (tile->surface);
+  cairo_region_destroy (tile->valid);
+
+  g_slice_free (RenderTile, tile);
+}
+
+static void
+render_transform_bounds (const cairo_matrix_t *matrix,
+                         gdouble              *x1,
+                         gdouble              *y1,
+                         gdouble              *x2,
+                         gdouble              *y2)
+{
+  gdouble tx1 = *x1;
+  gdouble ty1 = *y1;
+  gdouble tx2 = *x1;
+  gdouble ty2 = *y2;
+  gdouble tx3 = *x2;
+  gdouble ty3 = *y1;
+  gdouble tx4 = *x2;
+  gdouble ty4 = *y2;
+
+  cairo_matrix_transform_point (matrix, &tx1, &ty1);
+  cairo_matrix_transform_point (matrix, &tx2, &ty2);
+  cairo_matrix_transform_point (matrix, &tx3, &ty3);
+  cairo_matrix_transform_point (matrix, &tx4, &ty4);
+
+  *x1 = MIN4 (tx1, tx2, tx3, tx4);
+  *y1 = MIN4 (ty1, ty2, ty3, ty4);
+  *x2 = MAX4 (tx1, tx2, tx3, tx4);
+  *y2 = MAX4 (ty1, ty2, ty3, ty4);
+}
+
+static void
+gimp_display_shell_render_get_tile_key (GimpDisplayShell *shell,
+                                        gint              x,
+                                        gint              y,
+                                        RenderTileKey    *key)
+{
+  key->scale_x           = shell->scale_x;
+  key->scale_y           = shell->scale_y;
+  key->rotate_angle      = shell->rotate_angle;
+  key->flip_horizontally = shell->flip_horizontally ? TRUE : FALSE;
+  key->flip_vertically   = shell->flip_vertically   ? TRUE : FALSE;
+  key->show_all          = shell->show_all          ? TRUE : FALSE;
+  key->render_scale      = shell->render_scale;
+  key->x                 = x;
+  key->y                 = y;
+}
+
+static void
+gimp_display_shell_render_get_view_transform (GimpDisplayShell *shell,
+                                              cairo_matrix_t   *matrix)
+{
+  cairo_matrix_init_scale (matrix, shell->scale_x, shell->scale_y);
+
+  /*  the rotation is around a point that moves with the scroll offset,
+   *  so take the offset out on both sides
+   */
+  if (shell->rotate_transform)
+    {
+      cairo_matrix_t offset;
+
+      cairo_matrix_init_translate (&offset, -shell->offset_x, -shell->offset_y);
+      cairo_matrix_multiply (matrix, matrix, &offset);
+
+      cairo_matrix_multiply (matrix, matrix, shell->rotate_transform);
+
+      cairo_matrix_init_translate (&offset, shell->offset_x, shell->offset_y);
+      cairo_matrix_multiply (matrix, matrix, &offset);
+    }
+}
+
+static void
+gimp_display_shell_render_get_tile_range (GimpDisplayShell *shell,
+                                          gint              x,
+                                          gint              y,
+                                          gint              width,
+                                          gint              height,
+                                          gint             *tx1,
+                                          gint             *ty1,
+                                          gint             *tx2,
+                                          gint             *ty2)
+{
+  x += shell->offset_x;
+  y += shell->offset_y;
+
+  *tx1 = floor ((gdouble)  x           / GIMP_DISPLAY_RENDER_TILE_SIZE);
+  *ty1 = floor ((gdouble)  y           / GIMP_DISPLAY_RENDER_TILE_SIZE);
+  *tx2 = ceil  ((gdouble) (x + width)  / GIMP_DISPLAY_RENDER_TILE_SIZE);
+  *ty2 = ceil  ((gdouble) (y + height) / GIMP_DISPLAY_RENDER_TILE_SIZE);
+}
+
+static RenderTile *
+gimp_display_shell_render_lookup_tile (GimpDisplayShell *shell,
+                                       gint              tx,
+                                       gint              ty,
+                                       gboolean          create)
+{
+  RenderTileKey  key;
+  RenderTile    *tile = NULL;
+
+  gimp_display_shell_render_get_tile_key (shell, tx, ty, &key);
+
+  if (shell->render_tiles)
+    tile = g_hash_table_lookup (shell->render_tiles, &key);
+
+  if (! tile && create)
+    {
+      gint size = GIMP_DISPLAY_RENDER_TILE_SIZE * shell->render_scale;
+
+      if (! shell->render_tiles)
+        {
+          shell->render_tiles =
+            g_hash_table_new_full ((GHashFunc)      render_tile_key_hash,
+                                   (GEqualFunc)     render_tile_key_equal,
+                                   NULL,
+                                   (GDestroyNotify) render_tile_free);
+        }
+
+      tile = g_slice_new0 (RenderTile);
+
+      tile->key     = key;
+      tile->surface = cairo_surface_create_similar_image (shell->render_cache,
+                                                          CAIRO_FORMAT_ARGB32,
+                                                          size, size);
+      tile->valid   = cairo_region_create ();
+
+      gimp_display_shell_render_get_view_transform (shell, &tile->transform);
+
+      tile->lru_link.data = tile;
+
+      g_hash_table_insert (shell->render_tiles, &tile->key, tile);
+      g_queue_push_head_link (&shell->render_tiles_lru, &tile->lru_link);
+
+      shell->render_tiles_size += (gint64) size * size * 4;
+    }
+  else if (tile)
+    {
+      g_queue_unlink (&shell->render_tiles_lru, &tile->lru_link);
+      g_queue_push_head_link (&shell->render_tiles_lru, &tile->lru_link);
+    }
+
+  return tile;
+}
+
+static void
+gimp_display_shell_render_store_area (GimpDisplayShell *shell,
+                                      gint              x,
+                                      gint              y,
+                                      gint              width,
+                                      gint              height)
+{
+  gint tx1, ty1, tx2, ty2;
+  gint tx, ty;
+
+  gimp_display_shell_render_get_tile_range (shell, x, y, width, height,
+                                            &tx1, &ty1, &tx2, &ty2);
+
+  for (ty = ty1; ty < ty2; ty++)
+    {
+      for (tx = tx1; tx < tx2; tx++)
+        {
+          RenderTile            *tile;
+          cairo_rectangle_int_t  rect;
+          cairo_t               *cr;
+          gint                   origin_x;
+          gint                   origin_y;
+
+          tile = gimp_display_shell_render_lookup_tile (shell, tx, ty, TRUE);
+
+          /*  the tile's origin, in screen space  */
+          origin_x = tx * GIMP_DISPLAY_RENDER_TILE_SIZE - shell->offset_x;
+          origin_y = ty * GIMP_DISPLAY_RENDER_TILE_SIZE - shell->offset_y;
+
+          rect.x      = MAX (x, origin_x);
+          rect.y      = MAX (y, origin_y);
+          rect.width  = MIN (x + width,  origin_x + GIMP_DISPLAY_RENDER_TILE_SIZE) -
+                        rect.x;
+          rect.height = MIN (y + height, origin_y + GIMP_DISPLAY_RENDER_TILE_SIZE) -
+                        rect.y;
+
+          rect.x -= origin_x;
+          rect.y -= origin_y;
+
+          cr = cairo_create (tile->surface);
+
+          cairo_rectangle (cr,
+                           rect.x      * shell->render_scale,
+                           rect.y      * shell->render_scale,
+                           rect.width  * shell->render_scale,
+                           rect.height * shell->render_scale);
+          cairo_clip (cr);
+
+          cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+          cairo_set_source_surface (cr, shell->render_cache,
+                                    -origin_x * shell->render_scale,
+                                    -origin_y * shell->render_scale);
+          cairo_paint (cr);
+
+          cairo_destroy (cr);
+
+          cairo_region_union_rectangle (tile->valid, &rect);
+        }
+    }
+
+  gimp_display_shell_render_trim_tiles (shell);
+
+  gimp_display_shell_render_queue_prerender (shell);
+}
+
+static void
+gimp_display_shell_render_trim_tiles (GimpDisplayShell *shell)
+{
+  gint64 max_size;
+
+  /*  keep at least a few viewports' worth of tiles around  */
+  max_size = (gint64) shell->disp_width  * shell->render_scale *
+                      shell->disp_height * shell->render_scale * 4 * 4;
+  max_size = MAX (max_size, GIMP_DISPLAY_RENDER_TILES_MIN_SIZE);
+
+  while (shell->render_tiles_size > max_size)
+    {
+      GList      *link = g_queue_pop_tail_link (&shell->render_tiles_lru);
+      RenderTile *tile = link->data;
+      gint        size = GIMP_DISPLAY_RENDER_TILE_SIZE * tile->key.render_scale;
+
+      shell->render_tiles_size -= (gint64) size * size * 4;
+
+      g_hash_table_remove (shell->render_tiles, &tile->key);
+    }
+}
+
+static void
+gimp_display_shell_render_queue_prerender (GimpDisplayShell *shell)
+{
+  if (! shell->render_tiles_idle_id)
+    {
+      shell->render_tiles_idle_id =
+        g_idle_add_full (GIMP_PRIORITY_DISPLAY_SHELL_RENDER_IDLE,
+                         (GSourceFunc) gimp_display_shell_render_prerender_idle,
+                         shell, NULL);
+    }
+}
+
+static gboolean
+gimp_display_shell_render_prerender_idle (GimpDisplayShell *shell)
+{
+  GeglRectangle  bounding_box;
+  cairo_matrix_t transform;
+  gdouble        x1, y1, x2, y2;
+  gdouble        scale;
+  gdouble        chunk_width;
+  gdouble        chunk_height;
+  gint           tx1, ty1, tx2, ty2;
+  gint           tx, ty;
+
+  if (! shell->render_cache || ! shell->render_surface ||
+      ! gimp_display_get_image (shell->display)        ||
+      ! shell->show_image)
+    {
+      shell->render_tiles_idle_id = 0;
+
+      return G_SOURCE_REMOVE;
+    }
+
+  /*  the image's bounds, in view space  */
+  bounding_box = gimp_display_shell_get_bounding_box (shell);
+
+  x1 = bounding_box.x;
+  y1 = bounding_box.y;
+  x2 = bounding_box.x + bounding_box.width;
+  y2 = bounding_box.y + bounding_box.height;
+
+  gimp_display_shell_render_get_view_transform (shell, &transform);
+  render_transform_bounds (&transform, &x1, &y1, &x2, &y2);
+
+  /*  the tiles around the viewport, clipped to the image  */
+  gimp_display_shell_render_get_tile_range (shell,
+                                            0, 0,
+                                            shell->disp_width,
+                                            shell->disp_height,
+                                            &tx1, &ty1, &tx2, &ty2);
+
+  tx1 = MAX (tx1 - GIMP_DISPLAY_RENDER_TILES_MARGIN,
+             floor (x1 / GIMP_DISPLAY_RENDER_TILE_SIZE));
+  ty1 = MAX (ty1 - GIMP_DISPLAY_RENDER_TILES_MARGIN,
+             floor (y1 / GIMP_DISPLAY_RENDER_TILE_SIZE));
+  tx2 = MIN (tx2 + GIMP_DISPLAY_RENDER_TILES_MARGIN,
+             ceil (x2 / GIMP_DISPLAY_RENDER_TILE_SIZE));
+  ty2 = MIN (ty2 + GIMP_DISPLAY_RENDER_TILES_MARGIN,
+             ceil (y2 / GIMP_DISPLAY_RENDER_TILE_SIZE));
+
+  gimp_display_shell_render_get_chunk_size (shell,
+                                            &scale,
+                                            &chunk_width, &chunk_height);
+
+  for (ty = ty1; ty < ty2; ty++)
+    {
+      for (tx = tx1; tx < tx2; tx++)
+        {
+          cairo_rectangle_int_t  rect;
+          RenderTile            *tile;
+          gint                   origin_x;
+          gint                   origin_y;
+          gint                   n_rows;
+          gint                   n_cols;
+          gint                   r, c;
+
+          rect.x      = 0;
+          rect.y      = 0;
+          rect.width  = GIMP_DISPLAY_RENDER_TILE_SIZE;
+          rect.height = GIMP_DISPLAY_RENDER_TILE_SIZE;
+
+          tile = gimp_display_shell_render_lookup_tile (shell, tx, ty, FALSE);
+
+          if (tile &&
+              cairo_region_contains_rectangle (tile->valid, &rect) ==
+              CAIRO_REGION_OVERLAP_IN)
+            {
+              continue;
+            }
+
+          tile = gimp_display_shell_render_lookup_tile (shell, tx, ty, TRUE);
+
+          /*  the tile's origin, in screen space  */
+          origin_x = tx * GIMP_DISPLAY_RENDER_TILE_SIZE - shell->offset_x;
+          origin_y = ty * GIMP_DISPLAY_RENDER_TILE_SIZE - shell->offset_y;
+
+          n_rows = ceil (rect.height / floor (chunk_height));
+          n_cols = ceil (rect.width  / floor (chunk_width));
+
+          for (r = 0; r < n_rows; r++)
+            {
+              gint cy1 = (2 *  r      * rect.height + n_rows) / (2 * n_rows);
+              gint cy2 = (2 * (r + 1) * rect.height + n_rows) / (2 * n_rows);
+
+              for (c = 0; c < n_cols; c++)
+                {
+                  cairo_rectangle_int_t chunk;
+
+                  chunk.x      = (2 *  c      * rect.width + n_cols) / (2 * n_cols);
+                  chunk.y      = cy1;
+                  chunk.width  = (2 * (c + 1) * rect.width + n_cols) / (2 * n_cols) -
+                                 chunk.x;
+                  chunk.height = cy2 - cy1;
+
+                  if (cairo_region_contains_rectangle (tile->valid, &chunk) ==
+                      CAIRO_REGION_OVERLAP_IN)
+                    {
+                      continue;
+                    }
+
+                  gimp_display_shell_render_internal (shell, tile->surface,
+                                                      origin_x, origin_y,
+                                                      origin_x + chunk.x,
+                                                      origin_y + chunk.y,
+                                                      chunk.width,
+                                                      chunk.height,
+                                                      scale);
+
+                  cairo_region_union_rectangle (tile->valid, &chunk);
+                }
+            }
+
+          gimp_display_shell_render_trim_tiles (shell);
+
+          /*  one tile per iteration, to keep the UI responsive  */
+          return G_SOURCE_CONTINUE;
+        }
+    }
+
+  shell->render_tiles_idle_id = 0;
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gimp_display_shell_render_ensure_cache (GimpDisplayShell *shell,
+                                        cairo_surface_t  *target)
+{
+  if (! shell->render_cache)
+    {
+      shell->render_cache = cairo_surface_create_similar_image (
+        target,
+        CAIRO_FORMAT_ARGB32,
+        shell->disp_width  * shell->render_scale,
+        shell->disp_height * shell->render_scale);
+    }
+
+  if (! shell->render_cache_valid)
+    {
+      shell->render_cache_valid = cairo_region_create ();
+    }
+}
+
+static void
+gimp_display_shell_render_internal (GimpDisplayShell *shell,
+                                    cairo_surface_t  *target,
+                                    gint              target_x,
+                                    gint              target_y,
+                                    gint              tx,
+                                    gint              ty,
+                                    gint              twidth,
+                                    gint              theight,
+                                    gdouble           scale)
 {
   GimpDisplayConfig *display_config;
   GimpImage         *image;
@@ -168,10 +947,6 @@ gimp_display_shell_render (GimpDisplayShell *shell,
   GeglAbyssPolicy    abyss_policy;
   gint               filter = GEGL_BUFFER_FILTER_AUTO;
 
-  g_return_if_fail (GIMP_IS_DISPLAY_SHELL (shell));
-  g_return_if_fail (cr != NULL);
-  g_return_if_fail (scale > 0.0);
-
   /* map chunk from screen space to scaled image space */
   gimp_display_shell_untransform_bounds_with_scale (shell, scale,
                                                     tx, ty,
@@ -187,8 +962,8 @@ gimp_display_shell_render (GimpDisplayShell *shell,
   g_return_if_fail (width  > 0 && width  <= shell->render_buf_width);
   g_return_if_fail (height > 0 && height <= shell->render_buf_height);
 
-  tx      *= shell->render_scale;
-  ty      *= shell->render_scale;
+  tx      = (tx - target_x) * shell->render_scale;
+  ty      = (ty - target_y) * shell->render_scale;
   twidth  *= shell->render_scale;
   theight *= shell->render_scale;
 
@@ -213,39 +988,17 @@ gimp_display_shell_render (GimpDisplayShell *shell,
   gimp_projectable_begin_render (GIMP_PROJECTABLE (image));
 #endif
 
-  if (! shell->render_surface)
-    {
-      shell->render_surface =
-        cairo_surface_create_similar_image (cairo_get_target (cr),
-                                            CAIRO_FORMAT_ARGB32,
-                                            shell->render_buf_width,
-                                            shell->render_buf_height);
-    }
-
   cairo_surface_flush (shell->render_surface);
 
-  if (! shell->render_cache)
-    {
-      shell->render_cache = cairo_surface_create_similar_image (
-        cairo_get_target (cr),
-        CAIRO_FORMAT_ARGB32,
-        shell->disp_width  * shell->render_scale,
-        shell->disp_height * shell->render_scale);
-    }
+  my_cr = cairo_create (target);
 
-  if (! shell->render_cache_valid)
-    {
-      shell->render_cache_valid = cairo_region_create ();
-    }
-
-  my_cr = cairo_create (shell->render_cache);
-
-  /* clip to chunk bounds, in screen space */
+  /* clip to chunk bounds, in target space */
   cairo_rectangle (my_cr, tx, ty, twidth, theight);
   cairo_clip (my_cr);
 
   /* transform to scaled image space, and apply uneven scaling */
   cairo_scale (my_cr, shell->render_scale, shell->render_scale);
+  cairo_translate (my_cr, -target_x, -target_y);
   if (shell->rotate_transform)
     cairo_transform (my_cr, shell->rotate_transform);
   cairo_translate (my_cr, -shell->offset_x, -shell->offset_y);
@@ -254,8 +1007,34 @@ gimp_display_shell_render (GimpDisplayShell *shell,
   cairo_stride = cairo_image_surface_get_stride (shell->render_surface);
   cairo_data   = cairo_image_surface_get_data (shell->render_surface);
 
-  if (shell->profile_transform ||
-      gimp_display_shell_has_filter (shell))
+  if (shell->profile_lut)
+    {
+      /*  if the profile transform is baked into a lut, load the
+       *  projection pixels in the lut's format, and look them up
+       *  straight into the cairo-ARGB32 buffer
+       */
+#ifndef USE_NODE_BLIT
+      gegl_buffer_get (buffer,
+                       GEGL_RECTANGLE (x, y, width, height), scale,
+                       shell->profile_lut_format,
+                       shell->profile_data, shell->profile_stride,
+                       abyss_policy | filter);
+#else
+      gegl_node_blit (node,
+                      scale, GEGL_RECTANGLE (x, y, width, height),
+                      shell->profile_lut_format,
+                      shell->profile_data, shell->profile_stride,
+                      GEGL_BLIT_CACHE | filter);
+#endif
+
+      gimp_display_shell_profile_convert_lut (shell,
+                                              shell->profile_data,
+                                              shell->profile_stride,
+                                              cairo_data, cairo_stride,
+                                              width, height);
+    }
+  else if (shell->profile_transform ||
+           gimp_display_shell_has_filter (shell))
     {
       gboolean can_convert_to_u8;
 
@@ -23,6 +23,7 @@ void     gimp_display_shell_render_set_scale       (GimpDisplayShell *shell,
                                                     gint              scale);
 
 void     gimp_display_shell_render_invalidate_full (GimpDisplayShell *shell);
+void     gimp_display_shell_render_invalidate_view (GimpDisplayShell *shell);
 void     gimp_display_shell_render_invalidate_area (GimpDisplayShell *shell,
                                                     gint              x,
                                                     gint              y,
@@ -41,6 +42,18 @@ gboolean gimp_display_shell_render_is_valid        (GimpDisplayShell *shell,
                                                     gint              width,
                                                     gint              height);
 
+void     gimp_display_shell_render_restore_area    (GimpDisplayShell *shell,
+                                                    cairo_t          *cr,
+                                                    gint              x,
+                                                    gint              y,
+                                                    gint              width,
+                                                    gint              height);
+
+void     gimp_display_shell_render_get_chunk_size  (GimpDisplayShell *shell,
+                                                    gdouble          *scale,
+                                                    gdouble          *chunk_width,
+                                                    gdouble          *chunk_height);
+
 void     gimp_display_shell_render                 (GimpDisplayShell *shell,
                                                     cairo_t          *cr,
                                                     gint              x,
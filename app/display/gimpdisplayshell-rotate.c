@@ -91,7 +91,7 @@ gimp_display_shell_flip (GimpDisplayShell *shell,
       gimp_display_shell_restore_viewport_center (shell, cx, cy);
 
       gimp_display_shell_expose_full (shell);
-      gimp_display_shell_render_invalidate_full (shell);
+      gimp_display_shell_render_invalidate_view (shell);
 
       /* re-enable the active tool */
       gimp_display_shell_resume (shell);
@@ -135,7 +135,7 @@ gimp_display_shell_rotate_to (GimpDisplayShell *shell,
   gimp_display_shell_restore_viewport_center (shell, cx, cy);
 
   gimp_display_shell_expose_full (shell);
-  gimp_display_shell_render_invalidate_full (shell);
+  gimp_display_shell_render_invalidate_view (shell);
 
   /* re-enable the active tool */
   gimp_display_shell_resume (shell);
@@ -180,7 +180,7 @@ gimp_display_shell_scroll_set_offset (GimpDisplayShell *shell,
   gimp_display_shell_scrolled (shell);
 
   gimp_display_shell_expose_full (shell);
-  gimp_display_shell_render_invalidate_full (shell);
+  gimp_display_shell_render_invalidate_view (shell);
 
   /* re-enable the active tool */
   gimp_display_shell_resume (shell);
@@ -760,8 +760,8 @@ gimp_display_shell_dispose (GObject *object)
 
   g_clear_object (&shell->zoom_gesture);
 
-  g_clear_pointer (&shell->render_cache,       cairo_surface_destroy);
-  g_clear_pointer (&shell->render_cache_valid, cairo_region_destroy);
+  gimp_display_shell_render_invalidate_full (shell);
+  g_clear_pointer (&shell->render_cache, cairo_surface_destroy);
 
   g_clear_pointer (&shell->render_surface, cairo_surface_destroy);
   g_clear_pointer (&shell->mask_surface,   cairo_surface_destroy);
@@ -1900,6 +1900,11 @@ gimp_display_shell_update_priority_rect (GimpDisplayShell *shell)
       gimp_display_shell_untransform_viewport (shell, ! shell->show_all,
                                                &x, &y, &width, &height);
       gimp_projection_set_priority_rect (projection, x, y, width, height);
+
+      /*  the scale gimp_display_shell_render() reads the projection at  */
+      gimp_projection_set_priority_scale (projection, shell,
+                                          shell->render_scale *
+                                          MAX (shell->scale_x, shell->scale_y));
     }
 }
 
@@ -157,6 +157,8 @@ struct _GimpDisplayShell
   GeglBuffer         *profile_buffer;  /*  buffer for profile transform       */
   guchar             *profile_data;    /*  profile_buffer's pixels            */
   gint                profile_stride;  /*  profile_buffer's stride            */
+  gfloat             *profile_lut;     /*  baked profile transform            */
+  const Babl         *profile_lut_format; /*  profile_lut's sample format     */
 
   GimpColorDisplayStack *filter_stack; /*  color display conversion stuff     */
   guint                  filter_idle_id;
@@ -173,6 +175,11 @@ struct _GimpDisplayShell
   cairo_surface_t   *render_cache;
   cairo_region_t    *render_cache_valid;
 
+  GHashTable        *render_tiles;     /*  tiles of earlier renders, per view */
+  GQueue             render_tiles_lru;
+  gint64             render_tiles_size;
+  guint              render_tiles_idle_id;
+
   gint               render_buf_width;
   gint               render_buf_height;
 
@@ -26,6 +26,7 @@
 
 #include "display-types.h"
 
+#include "core/gimp-input-latency.h"
 #include "core/gimpcoords.h"
 #include "core/gimpcoords-interpolate.h"
 #include "core/gimpmarshal.h"
@@ -39,6 +40,15 @@
 #define DIRECTION_RADIUS     (1.0 / MAX (scale_x, scale_y))
 #define SMOOTH_FACTOR        0.3
 
+/* Stroke events are coalesced once handling them takes longer than the
+ * interval they arrive at.  An event is dropped if it deviates less than
+ * COALESCE_TOLERANCE screen pixels (at full load) from the line through
+ * its neighbors, and at most COALESCE_MAX events are dropped in a row.
+ */
+#define COALESCE_TOLERANCE   1.0
+#define COALESCE_PRESSURE    0.02
+#define COALESCE_MAX         8
+
 
 enum
 {
@@ -75,6 +85,22 @@ static void     gimp_motion_buffer_interpolate_stroke  (GimpMotionBuffer *buffer
                                                         GimpCoords       *coords);
 static gboolean gimp_motion_buffer_event_queue_timeout (GimpMotionBuffer *buffer);
 
+static void     gimp_motion_buffer_stroke              (GimpMotionBuffer *buffer,
+                                                        const GimpCoords *coords,
+                                                        guint32           time,
+                                                        GdkModifierType   state);
+static void     gimp_motion_buffer_emit_stroke         (GimpMotionBuffer *buffer,
+                                                        const GimpCoords *coords,
+                                                        guint32           time,
+                                                        GdkModifierType   state);
+static gdouble  gimp_motion_buffer_get_tolerance       (GimpMotionBuffer *buffer,
+                                                        const GimpCoords *coords);
+static gboolean gimp_motion_buffer_can_coalesce        (GimpMotionBuffer *buffer,
+                                                        const GimpCoords *coords,
+                                                        gdouble           tolerance);
+static void     gimp_motion_buffer_flush_held          (GimpMotionBuffer *buffer);
+static gboolean gimp_motion_buffer_held_idle           (GimpMotionBuffer *buffer);
+
 
 G_DEFINE_TYPE (GimpMotionBuffer, gimp_motion_buffer, GIMP_TYPE_OBJECT)
 
@@ -136,6 +162,14 @@ gimp_motion_buffer_dispose (GObject *object)
       buffer->event_delay_timeout = 0;
     }
 
+  if (buffer->held_idle_id)
+    {
+      g_source_remove (buffer->held_idle_id);
+      buffer->held_idle_id = 0;
+    }
+
+  buffer->held = FALSE;
+
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
@@ -207,6 +241,19 @@ gimp_motion_buffer_begin_stroke (GimpMotionBuffer *buffer,
 
   buffer->last_read_motion_time = time;
 
+  /*  a held event can only be left over from an unfinished stroke, it
+   *  must not leak into the new one
+   */
+  if (buffer->held_idle_id)
+    {
+      g_source_remove (buffer->held_idle_id);
+      buffer->held_idle_id = 0;
+    }
+
+  buffer->held              = FALSE;
+  buffer->n_coalesced       = 0;
+  buffer->last_stroke_valid = FALSE;
+
   *last_motion = buffer->last_coords;
 }
 
@@ -222,6 +269,10 @@ gimp_motion_buffer_end_stroke (GimpMotionBuffer *buffer)
     }
 
   gimp_motion_buffer_event_queue_timeout (buffer);
+
+  gimp_motion_buffer_flush_held (buffer);
+
+  buffer->last_stroke_valid = FALSE;
 }
 
 /**
@@ -426,6 +477,9 @@ gimp_motion_buffer_motion_event (GimpMotionBuffer *buffer,
 
   g_array_append_val (buffer->event_queue, *coords);
 
+  if (! buffer->event_arrival_time)
+    buffer->event_arrival_time = g_get_monotonic_time ();
+
   buffer->last_coords            = *coords;
   buffer->last_motion_time       = time;
   buffer->last_motion_delta_time = delta_time;
@@ -481,8 +535,7 @@ gimp_motion_buffer_request_stroke (GimpMotionBuffer *buffer,
 
       gimp_motion_buffer_pop_event_queue (buffer, &buf_coords);
 
-      g_signal_emit (buffer, motion_buffer_signals[STROKE], 0,
-                     &buf_coords, time, event_state);
+      gimp_motion_buffer_stroke (buffer, &buf_coords, time, event_state);
     }
 
   if (buffer->event_delay)
@@ -510,10 +563,37 @@ gimp_motion_buffer_request_hover (GimpMotionBuffer *buffer,
       g_signal_emit (buffer, motion_buffer_signals[HOVER], 0,
                      &buf_coords, state, proximity);
 
+      /*  only stroke events are measured  */
+      buffer->event_arrival_time = 0;
+
       g_array_set_size (buffer->event_queue, 0);
     }
 }
 
+/**
+ * gimp_motion_buffer_frame_drawn:
+ * @buffer:
+ *
+ * Notifies @buffer that a frame of the canvas was drawn.  If stroke
+ * events were handled since the last frame, the time since the arrival
+ * of the oldest of them is recorded as input latency.
+ **/
+void
+gimp_motion_buffer_frame_drawn (GimpMotionBuffer *buffer)
+{
+  g_return_if_fail (GIMP_IS_MOTION_BUFFER (buffer));
+
+  if (buffer->stroke_emitted && buffer->event_arrival_time)
+    {
+      gimp_input_latency_record (g_get_monotonic_time () -
+                                 buffer->event_arrival_time);
+
+      buffer->event_arrival_time = 0;
+    }
+
+  buffer->stroke_emitted = FALSE;
+}
+
 
 /*  private functions  */
 
@@ -592,3 +672,165 @@ gimp_motion_buffer_event_queue_timeout (GimpMotionBuffer *buffer)
 
   return FALSE;
 }
+
+/*  all stroke events go through here.  while handling stroke events is
+ *  slower than they arrive, one event is held back, and dropped if the
+ *  stroke still passes close enough to it without it.
+ */
+static void
+gimp_motion_buffer_stroke (GimpMotionBuffer *buffer,
+                           const GimpCoords *coords,
+                           guint32           time,
+                           GdkModifierType   state)
+{
+  gdouble tolerance = gimp_motion_buffer_get_tolerance (buffer, coords);
+
+  if (buffer->held)
+    {
+      buffer->held = FALSE;
+
+      if (buffer->held_state == state        &&
+          buffer->n_coalesced < COALESCE_MAX &&
+          gimp_motion_buffer_can_coalesce (buffer, coords, tolerance))
+        {
+          buffer->n_coalesced++;
+        }
+      else
+        {
+          gimp_motion_buffer_emit_stroke (buffer,
+                                          &buffer->held_coords,
+                                          buffer->held_time,
+                                          buffer->held_state);
+        }
+    }
+
+  if (tolerance > 0.0 && buffer->last_stroke_valid)
+    {
+      buffer->held        = TRUE;
+      buffer->held_coords = *coords;
+      buffer->held_time   = time;
+      buffer->held_state  = state;
+
+      /*  flush the held event once the pending input is handled, before
+       *  the canvas is redrawn
+       */
+      if (! buffer->held_idle_id)
+        {
+          buffer->held_idle_id =
+            g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                             (GSourceFunc) gimp_motion_buffer_held_idle,
+                             buffer, NULL);
+        }
+    }
+  else
+    {
+      gimp_motion_buffer_emit_stroke (buffer, coords, time, state);
+    }
+}
+
+static void
+gimp_motion_buffer_emit_stroke (GimpMotionBuffer *buffer,
+                                const GimpCoords *coords,
+                                guint32           time,
+                                GdkModifierType   state)
+{
+  GimpCoords stroke_coords = *coords;
+  gint64     start;
+  gdouble    cost;
+
+  start = g_get_monotonic_time ();
+
+  g_signal_emit (buffer, motion_buffer_signals[STROKE], 0,
+                 &stroke_coords, time, state);
+
+  cost = (g_get_monotonic_time () - start) / 1000.0;
+
+  buffer->stroke_cost = (buffer->stroke_cost * (1 - SMOOTH_FACTOR) +
+                         cost                * SMOOTH_FACTOR);
+
+  buffer->last_stroke_coords = *coords;
+  buffer->last_stroke_valid  = TRUE;
+  buffer->n_coalesced        = 0;
+  buffer->stroke_emitted     = TRUE;
+}
+
+/*  returns the distance, in image pixels, by which a stroke event may
+ *  deviate from the stroke and still be dropped, or 0.0 if events are
+ *  handled fast enough not to need coalescing.
+ */
+static gdouble
+gimp_motion_buffer_get_tolerance (GimpMotionBuffer *buffer,
+                                  const GimpCoords *coords)
+{
+  gdouble scale = MAX (coords->xscale, coords->yscale);
+  gdouble load;
+
+  if (buffer->last_motion_delta_time <= 0.0 || scale <= 0.0)
+    return 0.0;
+
+  load = buffer->stroke_cost / buffer->last_motion_delta_time - 1.0;
+
+  return CLAMP (load, 0.0, 1.0) * COALESCE_TOLERANCE / scale;
+}
+
+static gboolean
+gimp_motion_buffer_can_coalesce (GimpMotionBuffer *buffer,
+                                 const GimpCoords *coords,
+                                 gdouble           tolerance)
+{
+  const GimpCoords *prev = &buffer->last_stroke_coords;
+  const GimpCoords *held = &buffer->held_coords;
+  gdouble           dx   = coords->x - prev->x;
+  gdouble           dy   = coords->y - prev->y;
+  gdouble           len  = SQR (dx) + SQR (dy);
+  gdouble           t    = 0.0;
+  gdouble           x;
+  gdouble           y;
+  gdouble           pressure;
+
+  if (tolerance <= 0.0)
+    return FALSE;
+
+  if (len > 0.0)
+    {
+      t = ((held->x - prev->x) * dx + (held->y - prev->y) * dy) / len;
+      t = CLAMP (t, 0.0, 1.0);
+    }
+
+  x        = prev->x        + t * dx;
+  y        = prev->y        + t * dy;
+  pressure = prev->pressure + t * (coords->pressure - prev->pressure);
+
+  return (SQR (held->x - x) + SQR (held->y - y) <= SQR (tolerance) &&
+          fabs (held->pressure - pressure)      <= COALESCE_PRESSURE);
+}
+
+static void
+gimp_motion_buffer_flush_held (GimpMotionBuffer *buffer)
+{
+  if (buffer->held_idle_id)
+    {
+      g_source_remove (buffer->held_idle_id);
+      buffer->held_idle_id = 0;
+    }
+
+  if (buffer->held)
+    {
+      buffer->held = FALSE;
+
+      gimp_motion_buffer_emit_stroke (buffer,
+                                      &buffer->held_coords,
+                                      buffer->held_time,
+                                      buffer->held_state);
+    }
+}
+
+static gboolean
+gimp_motion_buffer_held_idle (GimpMotionBuffer *buffer)
+{
+  buffer->held_idle_id = 0;
+
+  gimp_motion_buffer_flush_held (buffer);
+
+  return G_SOURCE_REMOVE;
+}
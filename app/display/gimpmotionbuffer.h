@@ -56,6 +56,26 @@ struct _GimpMotionBuffer
 
   gint               event_delay_timeout;
   GdkModifierType    last_active_state;
+
+  gdouble            stroke_cost;        /* smoothed cost of a stroke event,
+                                          *  in milliseconds
+                                          */
+  GimpCoords         last_stroke_coords; /* last emitted stroke event    */
+  gboolean           last_stroke_valid;
+
+  gboolean           held;               /* TRUE if a stroke event is held
+                                          *  back for coalescing
+                                          */
+  GimpCoords         held_coords;
+  guint32            held_time;
+  GdkModifierType    held_state;
+  gint               n_coalesced;
+  guint              held_idle_id;
+
+  gint64             event_arrival_time; /* arrival of the oldest event not
+                                          *  yet drawn
+                                          */
+  gboolean           stroke_emitted;
 };
 
 struct _GimpMotionBufferClass
@@ -95,5 +115,7 @@ void       gimp_motion_buffer_request_hover        (GimpMotionBuffer *buffer,
                                                     GdkModifierType   state,
                                                     gboolean          proximity);
 
+void       gimp_motion_buffer_frame_drawn          (GimpMotionBuffer *buffer);
+
 
 #endif /* __GIMP_MOTION_BUFFER_H__ */
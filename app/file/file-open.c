@@ -727,6 +727,9 @@ file_open_sanitize_image (GimpImage *image,
    */
   gimp_image_clean_all (image);
 
+  /*  the image now matches its file  */
+  gimp_image_update_file_mtime (image);
+
   /* Make sure the projection is completely constructed from valid
    * layers, this is needed in case something triggers projection or
    * image preview creation before all layers are loaded, see bug #767663.
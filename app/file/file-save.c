@@ -254,6 +254,7 @@ file_save (Gimp                *gimp,
           gimp_image_set_imported_file (image, NULL);
 
           gimp_image_clean_all (image);
+          gimp_image_update_file_mtime (image);
         }
       else if (export_backward)
         {
@@ -1099,4 +1099,268 @@ gimp_gegl_average_color (GeglBuffer          *buffer,
   babl_process (babl_fish (average_format, format), average.color, color, 1);
 }
 
+
+/*  orthogonal rotation and flipping.  each destination chunk is filled
+ *  from a single linear read of the matching source block, walking the
+ *  block in small squares so that the transposing cases stay within
+ *  the cache.
+ */
+
+#define TRANSPOSE_BLOCK_SIZE 16
+
+/*  the pixel copy is expanded once per pixel size, so that the
+ *  compiler turns the memcpy() into plain moves
+ */
+#define ORTHOGONAL_COPY_FUNC(name, size)                                       \
+static void                                                                    \
+name (const guint8 *src,                                                       \
+      gint          src_step_x,                                                \
+      gint          src_step_y,                                                \
+      guint8       *dest,                                                      \
+      gint          dest_stride,                                               \
+      gint          width,                                                     \
+      gint          height,                                                    \
+      gint          bpp)                                                       \
+{                                                                              \
+  gint x0, y0;                                                                 \
+  gint x, y;                                                                   \
+                                                                               \
+  for (y0 = 0; y0 < height; y0 += TRANSPOSE_BLOCK_SIZE)                        \
+    {                                                                          \
+      gint y1 = MIN (y0 + TRANSPOSE_BLOCK_SIZE, height);                       \
+                                                                               \
+      for (x0 = 0; x0 < width; x0 += TRANSPOSE_BLOCK_SIZE)                     \
+        {                                                                      \
+          gint x1 = MIN (x0 + TRANSPOSE_BLOCK_SIZE, width);                    \
+                                                                               \
+          for (y = y0; y < y1; y++)                                            \
+            {                                                                  \
+              const guint8 *s = src + (gintptr) y  * src_step_y +              \
+                                      (gintptr) x0 * src_step_x;               \
+              guint8       *d = dest + (gintptr) y  * dest_stride +            \
+                                       (gintptr) x0 * bpp;                     \
+                                                                               \
+              for (x = x0; x < x1; x++)                                        \
+                {                                                              \
+                  memcpy (d, s, size);                                         \
+                                                                               \
+                  s += src_step_x;                                             \
+                  d += bpp;                                                    \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+}
+
+ORTHOGONAL_COPY_FUNC (gimp_gegl_orthogonal_copy_2,  2)
+ORTHOGONAL_COPY_FUNC (gimp_gegl_orthogonal_copy_3,  3)
+ORTHOGONAL_COPY_FUNC (gimp_gegl_orthogonal_copy_4,  4)
+ORTHOGONAL_COPY_FUNC (gimp_gegl_orthogonal_copy_6,  6)
+ORTHOGONAL_COPY_FUNC (gimp_gegl_orthogonal_copy_8,  8)
+ORTHOGONAL_COPY_FUNC (gimp_gegl_orthogonal_copy_12, 12)
+ORTHOGONAL_COPY_FUNC (gimp_gegl_orthogonal_copy_16, 16)
+ORTHOGONAL_COPY_FUNC (gimp_gegl_orthogonal_copy_n,  bpp)
+
+#undef ORTHOGONAL_COPY_FUNC
+
+static void
+gimp_gegl_orthogonal_transform (GeglBuffer          *src_buffer,
+                                const GeglRectangle *src_rect,
+                                GeglBuffer          *dest_buffer,
+                                const GeglRectangle *dest_rect,
+                                gboolean             transpose,
+                                gboolean             reverse_x,
+                                gboolean             reverse_y)
+{
+  const Babl *format = gegl_buffer_get_format (dest_buffer);
+  gint        bpp    = babl_format_get_bytes_per_pixel (format);
+
+  if (gegl_rectangle_is_empty (dest_rect))
+    return;
+
+  gegl_parallel_distribute_area (
+    dest_rect, PIXELS_PER_THREAD,
+    [=] (const GeglRectangle *dest_area)
+    {
+      GeglBufferIterator *iter;
+
+      iter = gegl_buffer_iterator_new (dest_buffer, dest_area, 0, format,
+                                       GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE,
+                                       1);
+
+      while (gegl_buffer_iterator_next (iter))
+        {
+          const GeglRectangle *roi = &iter->items[0].roi;
+          GeglRectangle        block;
+          guint8              *data;
+          gint                 u, v;
+          gint                 stride;
+          gint                 step_x;
+          gint                 step_y;
+          const guint8        *src;
+
+          /*  the chunk's position relative to dest_rect  */
+          u = roi->x - dest_rect->x;
+          v = roi->y - dest_rect->y;
+
+          /*  the source block that maps onto the chunk.  when
+           *  transposing, the chunk's columns are the block's rows.
+           */
+          if (! transpose)
+            {
+              block.width  = roi->width;
+              block.height = roi->height;
+              block.x      = reverse_x ? src_rect->width  - u - roi->width  : u;
+              block.y      = reverse_y ? src_rect->height - v - roi->height : v;
+            }
+          else
+            {
+              block.width  = roi->height;
+              block.height = roi->width;
+              block.x      = reverse_x ? src_rect->width  - v - roi->height : v;
+              block.y      = reverse_y ? src_rect->height - u - roi->width  : u;
+            }
+
+          block.x += src_rect->x;
+          block.y += src_rect->y;
+
+          stride = block.width * bpp;
+
+          data = gegl_scratch_new (guint8, (gsize) stride * block.height);
+
+          gegl_buffer_get (src_buffer, &block, 1.0, format, data,
+                           stride, GEGL_ABYSS_NONE);
+
+          /*  the source step per destination pixel, along x and y  */
+          if (! transpose)
+            {
+              step_x = reverse_x ? -bpp    : bpp;
+              step_y = reverse_y ? -stride : stride;
+            }
+          else
+            {
+              step_x = reverse_y ? -stride : stride;
+              step_y = reverse_x ? -bpp    : bpp;
+            }
+
+          src = data;
+
+          if (step_x < 0)
+            src -= (gintptr) step_x * (roi->width - 1);
+          if (step_y < 0)
+            src -= (gintptr) step_y * (roi->height - 1);
+
+          switch (bpp)
+            {
+#define ORTHOGONAL_COPY(size)                                                  \
+            case size:                                                         \
+              gimp_gegl_orthogonal_copy_##size (                               \
+                src, step_x, step_y,                                           \
+                (guint8 *) iter->items[0].data, roi->width * bpp,              \
+                roi->width, roi->height, bpp);                                 \
+              break;
+
+            ORTHOGONAL_COPY (2)
+            ORTHOGONAL_COPY (3)
+            ORTHOGONAL_COPY (4)
+            ORTHOGONAL_COPY (6)
+            ORTHOGONAL_COPY (8)
+            ORTHOGONAL_COPY (12)
+            ORTHOGONAL_COPY (16)
+
+#undef ORTHOGONAL_COPY
+
+            default:
+              gimp_gegl_orthogonal_copy_n (
+                src, step_x, step_y,
+                (guint8 *) iter->items[0].data, roi->width * bpp,
+                roi->width, roi->height, bpp);
+              break;
+            }
+
+          gegl_scratch_free (data);
+        }
+    });
+}
+
+void
+gimp_gegl_buffer_rotate (GeglBuffer          *src_buffer,
+                         const GeglRectangle *src_rect,
+                         GeglBuffer          *dest_buffer,
+                         const GeglRectangle *dest_rect,
+                         GimpRotationType     rotate_type)
+{
+  g_return_if_fail (GEGL_IS_BUFFER (src_buffer));
+  g_return_if_fail (src_rect != NULL);
+  g_return_if_fail (GEGL_IS_BUFFER (dest_buffer));
+  g_return_if_fail (dest_rect != NULL);
+  g_return_if_fail (gegl_buffer_get_format (src_buffer) ==
+                    gegl_buffer_get_format (dest_buffer));
+
+  switch (rotate_type)
+    {
+    case GIMP_ROTATE_90:
+      g_return_if_fail (dest_rect->width  == src_rect->height &&
+                        dest_rect->height == src_rect->width);
+
+      gimp_gegl_orthogonal_transform (src_buffer, src_rect,
+                                      dest_buffer, dest_rect,
+                                      TRUE, FALSE, TRUE);
+      break;
+
+    case GIMP_ROTATE_180:
+      g_return_if_fail (dest_rect->width  == src_rect->width &&
+                        dest_rect->height == src_rect->height);
+
+      gimp_gegl_orthogonal_transform (src_buffer, src_rect,
+                                      dest_buffer, dest_rect,
+                                      FALSE, TRUE, TRUE);
+      break;
+
+    case GIMP_ROTATE_270:
+      g_return_if_fail (dest_rect->width  == src_rect->height &&
+                        dest_rect->height == src_rect->width);
+
+      gimp_gegl_orthogonal_transform (src_buffer, src_rect,
+                                      dest_buffer, dest_rect,
+                                      TRUE, TRUE, FALSE);
+      break;
+    }
+}
+
+void
+gimp_gegl_buffer_flip (GeglBuffer          *src_buffer,
+                       const GeglRectangle *src_rect,
+                       GeglBuffer          *dest_buffer,
+                       const GeglRectangle *dest_rect,
+                       GimpOrientationType  flip_type)
+{
+  g_return_if_fail (GEGL_IS_BUFFER (src_buffer));
+  g_return_if_fail (src_rect != NULL);
+  g_return_if_fail (GEGL_IS_BUFFER (dest_buffer));
+  g_return_if_fail (dest_rect != NULL);
+  g_return_if_fail (dest_rect->width  == src_rect->width &&
+                    dest_rect->height == src_rect->height);
+  g_return_if_fail (gegl_buffer_get_format (src_buffer) ==
+                    gegl_buffer_get_format (dest_buffer));
+
+  switch (flip_type)
+    {
+    case GIMP_ORIENTATION_HORIZONTAL:
+      gimp_gegl_orthogonal_transform (src_buffer, src_rect,
+                                      dest_buffer, dest_rect,
+                                      FALSE, TRUE, FALSE);
+      break;
+
+    case GIMP_ORIENTATION_VERTICAL:
+      gimp_gegl_orthogonal_transform (src_buffer, src_rect,
+                                      dest_buffer, dest_rect,
+                                      FALSE, FALSE, TRUE);
+      break;
+
+    case GIMP_ORIENTATION_UNKNOWN:
+      break;
+    }
+}
+
 } /* extern "C" */
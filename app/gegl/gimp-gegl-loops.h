@@ -31,6 +31,17 @@ void   gimp_gegl_buffer_copy           (GeglBuffer               *src_buffer,
 void   gimp_gegl_clear                 (GeglBuffer               *buffer,
                                         const GeglRectangle      *rect);
 
+void   gimp_gegl_buffer_rotate         (GeglBuffer               *src_buffer,
+                                        const GeglRectangle      *src_rect,
+                                        GeglBuffer               *dest_buffer,
+                                        const GeglRectangle      *dest_rect,
+                                        GimpRotationType          rotate_type);
+void   gimp_gegl_buffer_flip           (GeglBuffer               *src_buffer,
+                                        const GeglRectangle      *src_rect,
+                                        GeglBuffer               *dest_buffer,
+                                        const GeglRectangle      *dest_rect,
+                                        GimpOrientationType       flip_type);
+
 /*  this is a pretty stupid port of concolve_region() that only works
  *  on a linear source buffer
  */
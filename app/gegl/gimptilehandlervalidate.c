@@ -22,6 +22,7 @@
 #include <gegl.h>
 
 #include "libgimpbase/gimpbase.h"
+#include "libgimpmath/gimpmath.h"
 
 #include "gimp-gegl-types.h"
 
@@ -69,6 +70,10 @@ static void     gimp_tile_handler_validate_real_validate_buffer (GimpTileHandler
                                                                  const GeglRectangle     *rect,
                                                                  GeglBuffer              *buffer);
 
+static void     gimp_tile_handler_validate_levels_subtract      (GimpTileHandlerValidate *validate,
+                                                                 const GeglRectangle     *rect);
+static gboolean gimp_tile_handler_validate_can_render_levels    (GimpTileHandlerValidate *validate);
+
 static gpointer gimp_tile_handler_validate_command              (GeglTileSource  *source,
                                                                  GeglTileCommand  command,
                                                                  gint             x,
@@ -84,6 +89,9 @@ G_DEFINE_TYPE (GimpTileHandlerValidate, gimp_tile_handler_validate,
 
 static guint gimp_tile_handler_validate_signals[LAST_SIGNAL];
 
+static guintptr gimp_tile_handler_validate_level_total = 0;
+static guintptr gimp_tile_handler_validate_level_time  = 0;
+
 
 static void
 gimp_tile_handler_validate_class_init (GimpTileHandlerValidateClass *klass)
@@ -137,19 +145,28 @@ gimp_tile_handler_validate_init (GimpTileHandlerValidate *validate)
 {
   GeglTileSource *source = GEGL_TILE_SOURCE (validate);
 
+  gint            i;
+
   source->command = gimp_tile_handler_validate_command;
 
   validate->dirty_region = cairo_region_create ();
+
+  for (i = 0; i < GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL; i++)
+    validate->level_dirty_regions[i] = cairo_region_create ();
 }
 
 static void
 gimp_tile_handler_validate_finalize (GObject *object)
 {
   GimpTileHandlerValidate *validate = GIMP_TILE_HANDLER_VALIDATE (object);
+  gint                     i;
 
   g_clear_object (&validate->graph);
   g_clear_pointer (&validate->dirty_region, cairo_region_destroy);
 
+  for (i = 0; i < GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL; i++)
+    g_clear_pointer (&validate->level_dirty_regions[i], cairo_region_destroy);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -302,6 +319,9 @@ gimp_tile_handler_validate_validate_tile (GeglTileSource *source,
                                                GEGL_TILE_GET, x, y, 0, NULL);
     }
 
+  gimp_tile_handler_validate_levels_subtract (
+    validate, (const GeglRectangle *) &tile_rect);
+
   if (overlap == CAIRO_REGION_OVERLAP_IN || validate->whole_tile)
     {
       gint tile_bpp;
@@ -408,6 +428,131 @@ gimp_tile_handler_validate_validate_tile (GeglTileSource *source,
   return tile;
 }
 
+static void
+gimp_tile_handler_validate_get_level_tile_rect (GimpTileHandlerValidate *validate,
+                                                gint                     x,
+                                                gint                     y,
+                                                gint                     z,
+                                                cairo_rectangle_int_t   *rect)
+{
+  /*  the tile's footprint at level 0  */
+  rect->x      = (x * validate->tile_width)  << z;
+  rect->y      = (y * validate->tile_height) << z;
+  rect->width  = validate->tile_width        << z;
+  rect->height = validate->tile_height       << z;
+}
+
+static GeglTile *
+gimp_tile_handler_validate_render_level_tile (GimpTileHandlerValidate *validate,
+                                              gint                     x,
+                                              gint                     y,
+                                              gint                     z)
+{
+  GeglTile              *tile;
+  cairo_rectangle_int_t  tile_rect;
+  gint                   tile_bpp;
+  gint                   tile_stride;
+  gint64                 start_time;
+
+  gimp_tile_handler_validate_get_level_tile_rect (validate, x, y, z,
+                                                  &tile_rect);
+
+  cairo_region_subtract_rectangle (validate->level_dirty_regions[z - 1],
+                                   &tile_rect);
+
+  tile_bpp    = babl_format_get_bytes_per_pixel (validate->format);
+  tile_stride = tile_bpp * validate->tile_width;
+
+  tile = gegl_tile_handler_get_source_tile (GEGL_TILE_HANDLER (validate),
+                                            x, y, z, FALSE);
+
+  start_time = g_get_monotonic_time ();
+
+  gimp_tile_handler_validate_begin_validate (validate);
+
+  gegl_tile_lock (tile);
+
+  /*  render the tile directly at its level, so that the graph reads
+   *  its inputs from their own mipmaps at the same level, instead of
+   *  rendering the full-resolution pixels only to throw most of them
+   *  away
+   */
+  gegl_node_blit (validate->graph, 1.0 / (1 << z),
+                  GEGL_RECTANGLE (x * validate->tile_width,
+                                  y * validate->tile_height,
+                                  validate->tile_width,
+                                  validate->tile_height),
+                  validate->format,
+                  gegl_tile_get_data (tile), tile_stride,
+                  GEGL_BLIT_DEFAULT);
+
+  gegl_tile_unlock (tile);
+
+  gimp_tile_handler_validate_end_validate (validate);
+
+  g_atomic_pointer_add (&gimp_tile_handler_validate_level_total,
+                        tile_stride * validate->tile_height);
+  g_atomic_pointer_add (&gimp_tile_handler_validate_level_time,
+                        g_get_monotonic_time () - start_time);
+
+  return tile;
+}
+
+static GeglTile *
+gimp_tile_handler_validate_validate_level_tile (GeglTileSource *source,
+                                                gint            x,
+                                                gint            y,
+                                                gint            z)
+{
+  GimpTileHandlerValidate *validate = GIMP_TILE_HANDLER_VALIDATE (source);
+  cairo_rectangle_int_t    tile_rect;
+
+  gimp_tile_handler_validate_get_level_tile_rect (validate, x, y, z,
+                                                  &tile_rect);
+
+  if (validate->suspend_validate ||
+      cairo_region_contains_rectangle (validate->level_dirty_regions[z - 1],
+                                       &tile_rect) == CAIRO_REGION_OVERLAP_OUT)
+    {
+      /*  either the tile is still valid, or the level below it is,
+       *  and it can be downsampled from it as usual
+       */
+      return gegl_tile_handler_source_command (source,
+                                               GEGL_TILE_GET, x, y, z, NULL);
+    }
+
+  return gimp_tile_handler_validate_render_level_tile (validate, x, y, z);
+}
+
+static void
+gimp_tile_handler_validate_levels_subtract (GimpTileHandlerValidate *validate,
+                                            const GeglRectangle     *rect)
+{
+  gint i;
+
+  /*  once an area is valid at level 0, the levels above it can be
+   *  downsampled from it
+   */
+  for (i = 0; i < GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL; i++)
+    {
+      cairo_region_subtract_rectangle (validate->level_dirty_regions[i],
+                                       (const cairo_rectangle_int_t *) rect);
+    }
+}
+
+static gboolean
+gimp_tile_handler_validate_can_render_levels (GimpTileHandlerValidate *validate)
+{
+  GimpTileHandlerValidateClass *klass;
+
+  klass = GIMP_TILE_HANDLER_VALIDATE_GET_CLASS (validate);
+
+  /*  subclasses overriding validate() only know how to render at
+   *  level 0
+   */
+  return klass->validate == gimp_tile_handler_validate_real_validate;
+}
+
 static gpointer
 gimp_tile_handler_validate_command (GeglTileSource  *source,
                                     GeglTileCommand  command,
@@ -419,6 +564,14 @@ gimp_tile_handler_validate_command (GeglTileSource  *source,
   if (command == GEGL_TILE_GET && z == 0)
     return gimp_tile_handler_validate_validate_tile (source, x, y);
 
+  if (command == GEGL_TILE_GET                      &&
+      z > 0 && z <= GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL &&
+      gimp_tile_handler_validate_can_render_levels (
+        GIMP_TILE_HANDLER_VALIDATE (source)))
+    {
+      return gimp_tile_handler_validate_validate_level_tile (source, x, y, z);
+    }
+
   return gegl_tile_handler_source_command (source, command, x, y, z, data);
 }
 
@@ -486,12 +639,20 @@ void
 gimp_tile_handler_validate_invalidate (GimpTileHandlerValidate *validate,
                                        const GeglRectangle     *rect)
 {
+  gint i;
+
   g_return_if_fail (GIMP_IS_TILE_HANDLER_VALIDATE (validate));
   g_return_if_fail (rect != NULL);
 
   cairo_region_union_rectangle (validate->dirty_region,
                                 (cairo_rectangle_int_t *) rect);
 
+  for (i = 0; i < GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL; i++)
+    {
+      cairo_region_union_rectangle (validate->level_dirty_regions[i],
+                                    (cairo_rectangle_int_t *) rect);
+    }
+
   gegl_tile_handler_damage_rect (GEGL_TILE_HANDLER (validate), rect);
 
   g_signal_emit (validate, gimp_tile_handler_validate_signals[INVALIDATED],
@@ -507,6 +668,8 @@ gimp_tile_handler_validate_undo_invalidate (GimpTileHandlerValidate *validate,
 
   cairo_region_subtract_rectangle (validate->dirty_region,
                                    (cairo_rectangle_int_t *) rect);
+
+  gimp_tile_handler_validate_levels_subtract (validate, rect);
 }
 
 void
@@ -605,6 +768,8 @@ gimp_tile_handler_validate_validate (GimpTileHandlerValidate *validate,
           cairo_region_subtract_rectangle (
             validate->dirty_region,
             (const cairo_rectangle_int_t *) rect);
+
+          gimp_tile_handler_validate_levels_subtract (validate, rect);
         }
 
       g_clear_pointer (&region, cairo_region_destroy);
@@ -620,6 +785,75 @@ gimp_tile_handler_validate_validate (GimpTileHandlerValidate *validate,
       cairo_region_subtract_rectangle (
             validate->dirty_region,
             (const cairo_rectangle_int_t *) rect);
+
+      gimp_tile_handler_validate_levels_subtract (validate, rect);
+    }
+}
+
+void
+gimp_tile_handler_validate_validate_level (GimpTileHandlerValidate *validate,
+                                           GeglBuffer              *buffer,
+                                           const GeglRectangle     *rect,
+                                           gint                     level)
+{
+  gint level_tile_width;
+  gint level_tile_height;
+  gint x1, y1;
+  gint x2, y2;
+  gint x, y;
+
+  g_return_if_fail (GIMP_IS_TILE_HANDLER_VALIDATE (validate));
+  g_return_if_fail (gimp_tile_handler_validate_get_assigned (buffer) ==
+                    validate);
+  g_return_if_fail (level >= 0 &&
+                    level <= GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL);
+
+  if (! rect)
+    rect = gegl_buffer_get_extent (buffer);
+
+  if (level == 0 || ! gimp_tile_handler_validate_can_render_levels (validate))
+    {
+      gimp_tile_handler_validate_validate (validate, buffer, rect,
+                                           FALSE, FALSE);
+
+      return;
+    }
+
+  level_tile_width  = validate->tile_width  << level;
+  level_tile_height = validate->tile_height << level;
+
+  x1 = floor ((gdouble) rect->x / level_tile_width);
+  y1 = floor ((gdouble) rect->y / level_tile_height);
+  x2 = ceil  ((gdouble) (rect->x + rect->width)  / level_tile_width);
+  y2 = ceil  ((gdouble) (rect->y + rect->height) / level_tile_height);
+
+  for (y = y1; y < y2; y++)
+    {
+      for (x = x1; x < x2; x++)
+        {
+          cairo_rectangle_int_t tile_rect;
+          GeglTile             *tile;
+
+          gimp_tile_handler_validate_get_level_tile_rect (validate,
+                                                          x, y, level,
+                                                          &tile_rect);
+
+          if (cairo_region_contains_rectangle (
+                validate->level_dirty_regions[level - 1], &tile_rect) ==
+              CAIRO_REGION_OVERLAP_OUT)
+            {
+              continue;
+            }
+
+          /*  the rendered tile stays in the buffer's cache, as part
+           *  of its mipmap pyramid
+           */
+          tile = gimp_tile_handler_validate_render_level_tile (validate,
+                                                               x, y, level);
+
+          if (tile)
+            gegl_tile_unref (tile);
+        }
     }
 }
 
@@ -628,6 +862,7 @@ gimp_tile_handler_validate_buffer_set_extent (GeglBuffer          *buffer,
                                               const GeglRectangle *extent)
 {
   GimpTileHandlerValidate *validate;
+  gint                     i;
 
   g_return_val_if_fail (GEGL_IS_BUFFER (buffer), FALSE);
   g_return_val_if_fail (extent != NULL, FALSE);
@@ -645,6 +880,13 @@ gimp_tile_handler_validate_buffer_set_extent (GeglBuffer          *buffer,
       cairo_region_intersect_rectangle (validate->dirty_region,
                                         (const cairo_rectangle_int_t *) extent);
 
+      for (i = 0; i < GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL; i++)
+        {
+          cairo_region_intersect_rectangle (
+            validate->level_dirty_regions[i],
+            (const cairo_rectangle_int_t *) extent);
+        }
+
       return TRUE;
     }
 
@@ -663,6 +905,8 @@ gimp_tile_handler_validate_buffer_copy (GeglBuffer          *src_buffer,
   GimpTileHandlerValidate *dst_validate;
   GeglRectangle            real_src_rect;
   GeglRectangle            real_dst_rect;
+  cairo_region_t          *level_region;
+  gint                     i;
 
   g_return_if_fail (GEGL_IS_BUFFER (src_buffer));
   g_return_if_fail (GEGL_IS_BUFFER (dst_buffer));
@@ -765,4 +1009,33 @@ gimp_tile_handler_validate_buffer_copy (GeglBuffer          *src_buffer,
             }
         }
     }
+
+  /*  only level 0 is copied, the copied area's levels are dirty where
+   *  level 0 is
+   */
+  level_region = cairo_region_copy (dst_validate->dirty_region);
+
+  cairo_region_intersect_rectangle (level_region,
+                                    (cairo_rectangle_int_t *) &real_dst_rect);
+
+  for (i = 0; i < GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL; i++)
+    {
+      cairo_region_subtract_rectangle (dst_validate->level_dirty_regions[i],
+                                       (cairo_rectangle_int_t *) &real_dst_rect);
+      cairo_region_union (dst_validate->level_dirty_regions[i], level_region);
+    }
+
+  cairo_region_destroy (level_region);
+}
+
+guint64
+gimp_tile_handler_validate_get_level_total (void)
+{
+  return gimp_tile_handler_validate_level_total;
+}
+
+gdouble
+gimp_tile_handler_validate_get_level_time (void)
+{
+  return gimp_tile_handler_validate_level_time / (gdouble) G_USEC_PER_SEC;
 }
@@ -27,6 +27,11 @@
 
 G_BEGIN_DECLS
 
+/*  the highest mipmap level rendered directly from the graph, above
+ *  it, levels are downsampled from the level below
+ */
+#define GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL 8
+
 #define GIMP_TYPE_TILE_HANDLER_VALIDATE            (gimp_tile_handler_validate_get_type ())
 #define GIMP_TILE_HANDLER_VALIDATE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_TILE_HANDLER_VALIDATE, GimpTileHandlerValidate))
 #define GIMP_TILE_HANDLER_VALIDATE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GIMP_TYPE_TILE_HANDLER_VALIDATE, GimpTileHandlerValidateClass))
@@ -44,6 +49,7 @@ struct _GimpTileHandlerValidate
 
   GeglNode        *graph;
   cairo_region_t  *dirty_region;
+  cairo_region_t  *level_dirty_regions[GIMP_TILE_HANDLER_VALIDATE_MAX_LEVEL];
   const Babl      *format;
   gint             tile_width;
   gint             tile_height;
@@ -97,6 +103,10 @@ void                      gimp_tile_handler_validate_validate          (GimpTile
                                                                         const GeglRectangle     *rect,
                                                                         gboolean                 intersect,
                                                                         gboolean                 chunked);
+void                      gimp_tile_handler_validate_validate_level    (GimpTileHandlerValidate *validate,
+                                                                        GeglBuffer              *buffer,
+                                                                        const GeglRectangle     *rect,
+                                                                        gint                     level);
 
 gboolean                  gimp_tile_handler_validate_buffer_set_extent (GeglBuffer              *buffer,
                                                                         const GeglRectangle     *extent);
@@ -106,6 +116,9 @@ void                      gimp_tile_handler_validate_buffer_copy       (GeglBuff
                                                                         GeglBuffer              *dst_buffer,
                                                                         const GeglRectangle     *dst_rect);
 
+guint64                   gimp_tile_handler_validate_get_level_total   (void);
+gdouble                   gimp_tile_handler_validate_get_level_time    (void);
+
 
 G_END_DECLS
 
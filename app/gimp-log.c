@@ -17,12 +17,51 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "glib-object.h"
 
+#ifdef G_OS_WIN32
+#include <windows.h>
+#else
+#ifdef HAVE_SYS_TIMES_H
+#include <sys/times.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#endif
+
 #include "gimp-debug.h"
 #include "gimp-log.h"
 
 
+typedef struct
+{
+  gint64 wall;    /* microseconds since the trace started */
+  gint64 cpu;     /* process CPU time, in microseconds    */
+  gint64 read;    /* bytes read by the process            */
+  gint64 written; /* bytes written by the process         */
+  gint64 rss;     /* resident set size, in bytes          */
+} GimpLogSample;
+
+typedef struct
+{
+  gchar         *name;
+  gint           level; /* 0 for explicit phases, 1 and 2 for status texts */
+  GimpLogSample  start;
+} GimpLogPhase;
+
+
+static void   gimp_log_trace_sample      (GimpLogSample *sample);
+static gint   gimp_log_trace_get_tid     (void);
+static void   gimp_log_trace_append_name (GString       *str,
+                                          const gchar   *name);
+static void   gimp_log_trace_push        (const gchar   *name,
+                                          gint           level);
+static void   gimp_log_trace_pop         (void);
+
+
 static const GDebugKey log_keys[] =
 {
   { "tool-events",        GIMP_LOG_TOOL_EVENTS        },
@@ -45,7 +84,8 @@ static const GDebugKey log_keys[] =
   { "rectangle-tool",     GIMP_LOG_RECTANGLE_TOOL     },
   { "brush-cache",        GIMP_LOG_BRUSH_CACHE        },
   { "projection",         GIMP_LOG_PROJECTION         },
-  { "xcf",                GIMP_LOG_XCF                }
+  { "xcf",                GIMP_LOG_XCF                },
+  { "startup",            GIMP_LOG_STARTUP            }
 };
 
 static const gchar * const log_domains[] =
@@ -86,6 +126,15 @@ static const gchar * const log_domains[] =
 
 GimpLogFlags gimp_log_flags = 0;
 
+static gboolean  trace_active     = FALSE;
+static gchar    *trace_filename   = NULL;
+static gint64    trace_start_time = 0;
+static GString  *trace_events     = NULL;
+static GSList   *trace_phases     = NULL;
+static GMutex    trace_mutex;
+static GPrivate  trace_tid;
+static gint      trace_n_threads  = 0;
+
 
 void
 gimp_log_init (void)
@@ -130,6 +179,13 @@ gimp_log_init (void)
                                                  G_N_ELEMENTS (log_keys));
         }
     }
+
+  env_log_val = g_getenv ("GIMP_STARTUP_TRACE");
+
+  if (env_log_val && *env_log_val)
+    gimp_log_trace_init (env_log_val);
+  else if (gimp_log_flags & GIMP_LOG_STARTUP)
+    gimp_log_trace_init (NULL);
 }
 
 void
@@ -172,6 +228,27 @@ gimp_logv (GimpLogFlags  flags,
   g_log (domain, G_LOG_LEVEL_DEBUG,
          "%s(%d): %s", function, line, message);
 
+  /*  log messages show up as instant events in the trace  */
+  if (trace_active && flags != GIMP_LOG_STARTUP)
+    {
+      gint64 now = g_get_monotonic_time () - trace_start_time;
+
+      g_mutex_lock (&trace_mutex);
+
+      if (trace_events)
+        {
+          g_string_append (trace_events, ",\n{\"name\":");
+          gimp_log_trace_append_name (trace_events, message);
+          g_string_append_printf (trace_events,
+                                  ",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\","
+                                  "\"ts\":%" G_GINT64_FORMAT ","
+                                  "\"pid\":1,\"tid\":%d}",
+                                  domain, now, gimp_log_trace_get_tid ());
+        }
+
+      g_mutex_unlock (&trace_mutex);
+    }
+
   g_free (message);
 }
 
@@ -217,3 +294,419 @@ gimp_log_remove_handler (GimpLogHandler handler)
 
   g_free (handler);
 }
+
+/**
+ * gimp_log_trace_init:
+ * @filename: (nullable): the file to write the trace to
+ *
+ * Starts recording startup phases, as delimited by
+ * gimp_log_trace_begin(), gimp_log_trace_end() and
+ * gimp_log_trace_status().  The phases, together with all messages
+ * of enabled log domains, are written to @filename in the Chrome
+ * trace event format by gimp_log_trace_finish().  If @filename is
+ * %NULL, phases are only reported through the "startup" log domain.
+ *
+ * Called from gimp_log_init() if $GIMP_STARTUP_TRACE is set, and
+ * for the --startup-trace command line option.
+ **/
+void
+gimp_log_trace_init (const gchar *filename)
+{
+  if (! trace_active)
+    {
+      trace_active     = TRUE;
+      trace_start_time = g_get_monotonic_time ();
+
+      /*  make the calling thread, i.e. the main thread, thread 1  */
+      gimp_log_trace_get_tid ();
+    }
+
+  if (filename)
+    {
+      g_free (trace_filename);
+      trace_filename = g_strdup (filename);
+
+      if (! trace_events)
+        trace_events = g_string_new (NULL);
+    }
+}
+
+/**
+ * gimp_log_trace_begin:
+ * @name: the name of the phase
+ *
+ * Begins a startup phase, nested in the currently running one.  May
+ * only be called from the main thread.
+ **/
+void
+gimp_log_trace_begin (const gchar *name)
+{
+  g_return_if_fail (name != NULL);
+
+  if (! trace_active)
+    return;
+
+  gimp_log_trace_push (name, 0);
+}
+
+/**
+ * gimp_log_trace_end:
+ * @name: the name of the phase, as passed to gimp_log_trace_begin()
+ *
+ * Ends the phase @name, along with all phases still running inside
+ * of it.
+ **/
+void
+gimp_log_trace_end (const gchar *name)
+{
+  g_return_if_fail (name != NULL);
+
+  if (! trace_active)
+    return;
+
+  while (trace_phases)
+    {
+      GimpLogPhase *phase = trace_phases->data;
+      gboolean      found;
+
+      found = (phase->level == 0 && ! strcmp (phase->name, name));
+
+      gimp_log_trace_pop ();
+
+      if (found)
+        break;
+    }
+}
+
+/**
+ * gimp_log_trace_status:
+ * @text1: (nullable): the main status text
+ * @text2: (nullable): the secondary status text
+ *
+ * Turns the startup status messages, as shown on the splash, into
+ * phases: @text1 starts a new phase, replacing the one started by the
+ * previous @text1, and @text2 starts a phase nested in it.  Passing
+ * %NULL keeps the respective phase running, while an empty string
+ * ends it.
+ **/
+void
+gimp_log_trace_status (const gchar *text1,
+                       const gchar *text2)
+{
+  if (! trace_active)
+    return;
+
+  if (text1)
+    {
+      while (trace_phases &&
+             ((GimpLogPhase *) trace_phases->data)->level >= 1)
+        gimp_log_trace_pop ();
+
+      if (*text1)
+        gimp_log_trace_push (text1, 1);
+    }
+
+  if (text2)
+    {
+      while (trace_phases &&
+             ((GimpLogPhase *) trace_phases->data)->level == 2)
+        gimp_log_trace_pop ();
+
+      if (*text2)
+        gimp_log_trace_push (text2, 2);
+    }
+}
+
+/**
+ * gimp_log_trace_mark:
+ * @name: the name of the event
+ *
+ * Records a single point in time, such as the end of an operation
+ * which finishes asynchronously.
+ **/
+void
+gimp_log_trace_mark (const gchar *name)
+{
+  g_return_if_fail (name != NULL);
+
+  if (! trace_active)
+    return;
+
+  GIMP_LOG (STARTUP, "%s", name);
+
+  if (trace_events)
+    {
+      gint64 now = g_get_monotonic_time () - trace_start_time;
+
+      g_mutex_lock (&trace_mutex);
+
+      g_string_append (trace_events, ",\n{\"name\":");
+      gimp_log_trace_append_name (trace_events, name);
+      g_string_append_printf (trace_events,
+                              ",\"cat\":\"startup\",\"ph\":\"i\",\"s\":\"p\","
+                              "\"ts\":%" G_GINT64_FORMAT ","
+                              "\"pid\":1,\"tid\":%d}",
+                              now, gimp_log_trace_get_tid ());
+
+      g_mutex_unlock (&trace_mutex);
+    }
+}
+
+/**
+ * gimp_log_trace_finish:
+ *
+ * Ends all running phases, writes the trace file if one was
+ * requested, and stops recording.
+ **/
+void
+gimp_log_trace_finish (void)
+{
+  GString *events;
+
+  if (! trace_active)
+    return;
+
+  while (trace_phases)
+    gimp_log_trace_pop ();
+
+  g_mutex_lock (&trace_mutex);
+
+  events       = trace_events;
+  trace_events = NULL;
+  trace_active = FALSE;
+
+  g_mutex_unlock (&trace_mutex);
+
+  if (events && trace_filename)
+    {
+      GError *error = NULL;
+
+      /*  skip the separator in front of the first event  */
+      if (events->len > 0)
+        g_string_erase (events, 0, 2);
+
+      g_string_prepend (events, "{\"traceEvents\":[\n");
+      g_string_append (events, "\n],\n\"displayTimeUnit\":\"ms\"}\n");
+
+      if (! g_file_set_contents (trace_filename,
+                                 events->str, events->len, &error))
+        {
+          g_printerr ("Could not write startup trace: %s\n",
+                      error->message);
+          g_clear_error (&error);
+        }
+    }
+
+  if (events)
+    g_string_free (events, TRUE);
+
+  g_clear_pointer (&trace_filename, g_free);
+}
+
+
+/*  private functions  */
+
+static void
+gimp_log_trace_sample (GimpLogSample *sample)
+{
+  memset (sample, 0, sizeof (GimpLogSample));
+
+  sample->wall = g_get_monotonic_time () - trace_start_time;
+
+#ifdef G_OS_WIN32
+  {
+    FILETIME    creation_time;
+    FILETIME    exit_time;
+    FILETIME    kernel_time;
+    FILETIME    user_time;
+    IO_COUNTERS io_counters;
+
+    if (GetProcessTimes (GetCurrentProcess (),
+                         &creation_time, &exit_time,
+                         &kernel_time, &user_time))
+      {
+        guint64 usage;
+
+        usage  = ((guint64) kernel_time.dwHighDateTime << 32) |
+                  (guint64) kernel_time.dwLowDateTime;
+        usage += ((guint64) user_time.dwHighDateTime << 32) |
+                  (guint64) user_time.dwLowDateTime;
+
+        /*  FILETIME is in units of 100 nanoseconds  */
+        sample->cpu = usage / 10;
+      }
+
+    if (GetProcessIoCounters (GetCurrentProcess (), &io_counters))
+      {
+        sample->read    = io_counters.ReadTransferCount;
+        sample->written = io_counters.WriteTransferCount;
+      }
+  }
+#else
+#ifdef HAVE_SYS_TIMES_H
+  {
+    struct tms tms;
+    glong      ticks = sysconf (_SC_CLK_TCK);
+
+    if (times (&tms) != (clock_t) -1 && ticks > 0)
+      {
+        sample->cpu = (gint64) (tms.tms_utime + tms.tms_stime) *
+                      G_USEC_PER_SEC / ticks;
+      }
+  }
+#endif
+
+#ifdef __linux__
+  {
+    gchar *contents;
+
+    if (g_file_get_contents ("/proc/self/io", &contents, NULL, NULL))
+      {
+        gchar *str;
+
+        /*  "rchar" and "wchar" count all bytes passed to read() and
+         *  write(), including what was served from the page cache
+         */
+        if ((str = strstr (contents, "rchar:")))
+          sample->read = g_ascii_strtoll (str + strlen ("rchar:"), NULL, 10);
+
+        if ((str = strstr (contents, "wchar:")))
+          sample->written = g_ascii_strtoll (str + strlen ("wchar:"), NULL, 10);
+
+        g_free (contents);
+      }
+
+    if (g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL))
+      {
+        gchar  *str;
+        gint64  pages;
+
+        /*  the second field is the number of resident pages  */
+        g_ascii_strtoll (contents, &str, 10);
+        pages = g_ascii_strtoll (str, NULL, 10);
+
+        sample->rss = pages * sysconf (_SC_PAGESIZE);
+
+        g_free (contents);
+      }
+  }
+#endif
+#endif
+}
+
+static gint
+gimp_log_trace_get_tid (void)
+{
+  gint tid = GPOINTER_TO_INT (g_private_get (&trace_tid));
+
+  if (! tid)
+    {
+      tid = g_atomic_int_add (&trace_n_threads, 1) + 1;
+
+      g_private_set (&trace_tid, GINT_TO_POINTER (tid));
+    }
+
+  return tid;
+}
+
+static void
+gimp_log_trace_append_name (GString     *str,
+                            const gchar *name)
+{
+  const gchar *p;
+
+  g_string_append_c (str, '"');
+
+  for (p = name; *p; p++)
+    {
+      switch (*p)
+        {
+        case '"':
+          g_string_append (str, "\\\"");
+          break;
+
+        case '\\':
+          g_string_append (str, "\\\\");
+          break;
+
+        default:
+          if ((guchar) *p < 0x20)
+            g_string_append_printf (str, "\\u%04x", (guchar) *p);
+          else
+            g_string_append_c (str, *p);
+          break;
+        }
+    }
+
+  g_string_append_c (str, '"');
+}
+
+static void
+gimp_log_trace_push (const gchar *name,
+                     gint         level)
+{
+  GimpLogPhase *phase = g_slice_new (GimpLogPhase);
+
+  phase->name  = g_strdup (name);
+  phase->level = level;
+
+  gimp_log_trace_sample (&phase->start);
+
+  trace_phases = g_slist_prepend (trace_phases, phase);
+}
+
+static void
+gimp_log_trace_pop (void)
+{
+  GimpLogPhase  *phase = trace_phases->data;
+  GimpLogSample  end;
+  gint64         wall;
+  gint64         cpu;
+  gint64         read;
+  gint64         written;
+  gint64         rss;
+
+  trace_phases = g_slist_delete_link (trace_phases, trace_phases);
+
+  gimp_log_trace_sample (&end);
+
+  wall    = end.wall    - phase->start.wall;
+  cpu     = end.cpu     - phase->start.cpu;
+  read    = end.read    - phase->start.read;
+  written = end.written - phase->start.written;
+  rss     = end.rss     - phase->start.rss;
+
+  GIMP_LOG (STARTUP,
+            "%s: %.3f ms wall, %.3f ms cpu, "
+            "%" G_GINT64_FORMAT " bytes read, "
+            "%" G_GINT64_FORMAT " bytes written, "
+            "%+" G_GINT64_FORMAT " bytes resident",
+            phase->name,
+            wall / 1000.0, cpu / 1000.0,
+            read, written, rss);
+
+  if (trace_events)
+    {
+      g_mutex_lock (&trace_mutex);
+
+      g_string_append (trace_events, ",\n{\"name\":");
+      gimp_log_trace_append_name (trace_events, phase->name);
+      g_string_append_printf (trace_events,
+                              ",\"cat\":\"startup\",\"ph\":\"X\","
+                              "\"ts\":%" G_GINT64_FORMAT ","
+                              "\"dur\":%" G_GINT64_FORMAT ","
+                              "\"pid\":1,\"tid\":%d,"
+                              "\"args\":{\"cpu-us\":%" G_GINT64_FORMAT ","
+                              "\"read-bytes\":%" G_GINT64_FORMAT ","
+                              "\"written-bytes\":%" G_GINT64_FORMAT ","
+                              "\"resident-bytes\":%" G_GINT64_FORMAT "}}",
+                              phase->start.wall, wall,
+                              gimp_log_trace_get_tid (),
+                              cpu, read, written, rss);
+
+      g_mutex_unlock (&trace_mutex);
+    }
+
+  g_free (phase->name);
+  g_slice_free (GimpLogPhase, phase);
+}
@@ -45,7 +45,8 @@ typedef enum
   GIMP_LOG_BRUSH_CACHE        = 1 << 18,
   GIMP_LOG_PROJECTION         = 1 << 19,
   GIMP_LOG_XCF                = 1 << 20,
-  GIMP_LOG_MAGIC_MATCH        = 1 << 21
+  GIMP_LOG_MAGIC_MATCH        = 1 << 21,
+  GIMP_LOG_STARTUP            = 1 << 22
 } GimpLogFlags;
 
 
@@ -70,6 +71,14 @@ GimpLogHandler   gimp_log_set_handler    (gboolean        global,
                                           gpointer        user_data);
 void             gimp_log_remove_handler (GimpLogHandler  handler);
 
+void             gimp_log_trace_init     (const gchar    *filename);
+void             gimp_log_trace_begin    (const gchar    *name);
+void             gimp_log_trace_end      (const gchar    *name);
+void             gimp_log_trace_status   (const gchar    *text1,
+                                          const gchar    *text2);
+void             gimp_log_trace_mark     (const gchar    *name);
+void             gimp_log_trace_finish   (void);
+
 
 #ifdef G_HAVE_ISO_VARARGS
 
@@ -113,6 +122,7 @@ void             gimp_log_remove_handler (GimpLogHandler  handler);
 #define BRUSH_CACHE        GIMP_LOG_BRUSH_CACHE
 #define PROJECTION         GIMP_LOG_PROJECTION
 #define XCF                GIMP_LOG_XCF
+#define STARTUP            GIMP_LOG_STARTUP
 
 #if 0 /* last resort */
 #  define GIMP_LOG /* nothing => no varargs, no log */
@@ -36,6 +36,9 @@
 
 /* #define G_PRIORITY_DEFAULT_IDLE 200 */
 
+/*  pre-rendering around the viewport, only after the projection is done  */
+#define GIMP_PRIORITY_DISPLAY_SHELL_RENDER_IDLE (G_PRIORITY_DEFAULT_IDLE)
+
 #define GIMP_PRIORITY_VIEWABLE_IDLE (G_PRIORITY_LOW)
 
 /* #define G_PRIORITY_LOW 300 */
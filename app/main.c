@@ -105,6 +105,10 @@ static gboolean  gimp_option_dump_gimprc      (const gchar  *option_name,
                                                const gchar  *value,
                                                gpointer      data,
                                                GError      **error);
+static gboolean  gimp_option_startup_trace    (const gchar  *option_name,
+                                               const gchar  *value,
+                                               gpointer      data,
+                                               GError      **error);
 static gboolean  gimp_option_dump_pdb_procedures_deprecated
                                               (const gchar  *option_name,
                                                const gchar  *value,
@@ -261,6 +265,11 @@ static const GOptionEntry main_entries[] =
     G_OPTION_ARG_NONE, &use_debug_handler,
     N_("Enable non-fatal debugging signal handlers"), NULL
   },
+  {
+    "startup-trace", 0, 0,
+    G_OPTION_ARG_CALLBACK, gimp_option_startup_trace,
+    N_("Write a timeline of the startup phases to <file>"), "<file>"
+  },
   {
     "g-fatal-warnings", 0, G_OPTION_FLAG_NO_ARG,
     G_OPTION_ARG_CALLBACK, gimp_option_fatal_warnings,
@@ -891,6 +900,17 @@ gimp_option_fatal_warnings (const gchar  *option_name,
   return TRUE;
 }
 
+static gboolean
+gimp_option_startup_trace (const gchar  *option_name,
+                           const gchar  *value,
+                           gpointer      data,
+                           GError      **error)
+{
+  gimp_log_trace_init (value);
+
+  return TRUE;
+}
+
 static gboolean
 gimp_option_stack_trace_mode (const gchar  *option_name,
                               const gchar  *value,
@@ -38,6 +38,7 @@
 #include "gimpoperationequalize.h"
 #include "gimpoperationfillsource.h"
 #include "gimpoperationflood.h"
+#include "gimpoperationfusedpointfilter.h"
 #include "gimpoperationgradient.h"
 #include "gimpoperationgrow.h"
 #include "gimpoperationhistogramsink.h"
@@ -133,6 +134,7 @@ gimp_operations_init (Gimp *gimp)
   g_type_class_ref (GIMP_TYPE_OPERATION_EQUALIZE);
   g_type_class_ref (GIMP_TYPE_OPERATION_FILL_SOURCE);
   g_type_class_ref (GIMP_TYPE_OPERATION_FLOOD);
+  g_type_class_ref (GIMP_TYPE_OPERATION_FUSED_POINT_FILTER);
   g_type_class_ref (GIMP_TYPE_OPERATION_GRADIENT);
   g_type_class_ref (GIMP_TYPE_OPERATION_GROW);
   g_type_class_ref (GIMP_TYPE_OPERATION_HISTOGRAM_SINK);
@@ -24,10 +24,13 @@
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gegl.h>
 
+#include "libgimpbase/gimpbase.h"
 #include "libgimpmath/gimpmath.h"
 
 #include "operations-types.h"
 
+#include "gegl/gimp-babl.h"
+
 #include "core/gimpcurve.h"
 #include "core/gimpcurve-map.h"
 
@@ -37,12 +40,27 @@
 #include "gimp-intl.h"
 
 
-static gboolean gimp_operation_curves_process (GeglOperation       *operation,
-                                               void                *in_buf,
-                                               void                *out_buf,
-                                               glong                samples,
-                                               const GeglRectangle *roi,
-                                               gint                 level);
+static void     gimp_operation_curves_finalize      (GObject             *object);
+static void     gimp_operation_curves_set_property  (GObject             *object,
+                                                     guint                property_id,
+                                                     const GValue        *value,
+                                                     GParamSpec          *pspec);
+
+static void     gimp_operation_curves_prepare       (GeglOperation       *operation);
+static gboolean gimp_operation_curves_process       (GeglOperation       *operation,
+                                                     void                *in_buf,
+                                                     void                *out_buf,
+                                                     glong                samples,
+                                                     const GeglRectangle *roi,
+                                                     gint                 level);
+
+static void     gimp_operation_curves_config_notify (GObject             *config,
+                                                     GParamSpec          *pspec,
+                                                     GimpOperationCurves *curves);
+
+static gpointer gimp_operation_curves_get_lut       (GimpOperationCurves *curves,
+                                                     GimpCurvesConfig    *config);
+static void     gimp_operation_curves_clear_lut     (GimpOperationCurves *curves);
 
 
 G_DEFINE_TYPE (GimpOperationCurves, gimp_operation_curves,
@@ -58,7 +76,8 @@ gimp_operation_curves_class_init (GimpOperationCurvesClass *klass)
   GeglOperationClass            *operation_class = GEGL_OPERATION_CLASS (klass);
   GeglOperationPointFilterClass *point_class     = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
 
-  object_class->set_property   = gimp_operation_point_filter_set_property;
+  object_class->finalize       = gimp_operation_curves_finalize;
+  object_class->set_property   = gimp_operation_curves_set_property;
   object_class->get_property   = gimp_operation_point_filter_get_property;
 
   gegl_operation_class_set_keys (operation_class,
@@ -67,7 +86,11 @@ gimp_operation_curves_class_init (GimpOperationCurvesClass *klass)
                                  "description", _("Adjust color curves"),
                                  NULL);
 
-  point_class->process = gimp_operation_curves_process;
+  operation_class->prepare = gimp_operation_curves_prepare;
+
+  point_class->process     = gimp_operation_curves_process;
+
+  GIMP_OPERATION_POINT_FILTER_CLASS (klass)->per_channel = TRUE;
 
   g_object_class_install_property (object_class,
                                    GIMP_OPERATION_POINT_FILTER_PROP_TRC,
@@ -93,6 +116,106 @@ gimp_operation_curves_init (GimpOperationCurves *self)
 {
 }
 
+static void
+gimp_operation_curves_finalize (GObject *object)
+{
+  GimpOperationCurves *self = GIMP_OPERATION_CURVES (object);
+
+  gimp_operation_curves_clear_lut (self);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gimp_operation_curves_set_property (GObject      *object,
+                                    guint         property_id,
+                                    const GValue *value,
+                                    GParamSpec   *pspec)
+{
+  GimpOperationCurves      *self  = GIMP_OPERATION_CURVES (object);
+  GimpOperationPointFilter *point = GIMP_OPERATION_POINT_FILTER (object);
+
+  if (property_id == GIMP_OPERATION_POINT_FILTER_PROP_CONFIG &&
+      point->config)
+    {
+      g_signal_handlers_disconnect_by_func (point->config,
+                                            gimp_operation_curves_config_notify,
+                                            self);
+    }
+
+  gimp_operation_point_filter_set_property (object, property_id,
+                                            value, pspec);
+
+  if (property_id == GIMP_OPERATION_POINT_FILTER_PROP_CONFIG &&
+      point->config)
+    {
+      /*  the config is modified in place while the tool is active,
+       *  so we have to watch it to know when to rebake the table
+       */
+      g_signal_connect_object (point->config, "notify",
+                               G_CALLBACK (gimp_operation_curves_config_notify),
+                               self, 0);
+    }
+
+  gimp_operation_curves_clear_lut (self);
+}
+
+static void
+gimp_operation_curves_prepare (GeglOperation *operation)
+{
+  GimpOperationCurves      *self      = GIMP_OPERATION_CURVES (operation);
+  GimpOperationPointFilter *point     = GIMP_OPERATION_POINT_FILTER (operation);
+  const Babl               *input     = gegl_operation_get_source_format (operation,
+                                                                          "input");
+  gint                      n_entries = 0;
+
+  GEGL_OPERATION_CLASS (parent_class)->prepare (operation);
+
+  /*  integer input which is already in the TRC we operate on can be
+   *  mapped through a lookup table, without going through float
+   */
+  if (input && gimp_babl_format_get_trc (input) == point->trc)
+    {
+      switch (gimp_babl_format_get_component_type (input))
+        {
+        case GIMP_COMPONENT_TYPE_U8:
+          n_entries = 256;
+          break;
+
+        case GIMP_COMPONENT_TYPE_U16:
+          n_entries = 65536;
+          break;
+
+        default:
+          break;
+        }
+    }
+
+  if (n_entries != self->lut_n_entries)
+    {
+      gimp_operation_curves_clear_lut (self);
+
+      self->lut_n_entries = n_entries;
+    }
+
+  self->lut_format = NULL;
+
+  if (n_entries)
+    {
+      const Babl *space = gegl_operation_get_source_space (operation,
+                                                           "input");
+
+      self->lut_format =
+        gimp_babl_format (GIMP_RGB,
+                          gimp_babl_precision (gimp_babl_format_get_component_type (input),
+                                               point->trc),
+                          TRUE, space);
+
+      gegl_operation_set_format (operation, "input",  self->lut_format);
+      gegl_operation_set_format (operation, "output", self->lut_format);
+    }
+}
+
 static gboolean
 gimp_operation_curves_process (GeglOperation       *operation,
                                void                *in_buf,
@@ -101,19 +224,89 @@ gimp_operation_curves_process (GeglOperation       *operation,
                                const GeglRectangle *roi,
                                gint                 level)
 {
+  GimpOperationCurves      *self   = GIMP_OPERATION_CURVES (operation);
   GimpOperationPointFilter *point  = GIMP_OPERATION_POINT_FILTER (operation);
   GimpCurvesConfig         *config = GIMP_CURVES_CONFIG (point->config);
-  gfloat                   *src    = in_buf;
-  gfloat                   *dest   = out_buf;
 
   if (! config)
     return FALSE;
 
-  gimp_curve_map_pixels (config->curve[0],
-                         config->curve[1],
-                         config->curve[2],
-                         config->curve[3],
-                         config->curve[4], src, dest, samples);
+  /*  a user of the operation, like gimp:fused-point-filter, may have
+   *  overridden the integer format chosen in prepare()
+   */
+  if (self->lut_format &&
+      gegl_operation_get_format (operation, "input") == self->lut_format)
+    {
+      gimp_curve_map_pixels_lut (gimp_operation_curves_get_lut (self, config),
+                                 self->lut_n_entries,
+                                 in_buf, out_buf, samples);
+    }
+  else
+    {
+      gimp_curve_map_pixels (config->curve[0],
+                             config->curve[1],
+                             config->curve[2],
+                             config->curve[3],
+                             config->curve[4], in_buf, out_buf, samples);
+    }
 
   return TRUE;
 }
+
+static void
+gimp_operation_curves_config_notify (GObject             *config,
+                                     GParamSpec          *pspec,
+                                     GimpOperationCurves *curves)
+{
+  gimp_operation_curves_clear_lut (curves);
+}
+
+/*  the table is baked by the first thread that needs it, into a new
+ *  allocation, and only published once it's complete, so process()
+ *  never sees a table that is being written
+ */
+static gpointer
+gimp_operation_curves_get_lut (GimpOperationCurves *curves,
+                               GimpCurvesConfig    *config)
+{
+  gpointer lut = g_atomic_pointer_get (&curves->lut);
+
+  if (! lut)
+    {
+      lut = g_malloc (4 * curves->lut_n_entries *
+                      (curves->lut_n_entries == 256 ? sizeof (guint8) :
+                                                      sizeof (guint16)));
+
+      gimp_curve_map_fill_lut (config->curve[0],
+                               config->curve[1],
+                               config->curve[2],
+                               config->curve[3],
+                               config->curve[4],
+                               curves->lut_n_entries, lut);
+
+      if (! g_atomic_pointer_compare_and_exchange (&curves->lut, NULL, lut))
+        {
+          /*  another thread was faster  */
+          g_free (lut);
+
+          lut = g_atomic_pointer_get (&curves->lut);
+        }
+    }
+
+  return lut;
+}
+
+/*  the config is only changed from the main thread, between renders,
+ *  so no thread is still reading the table being dropped
+ */
+static void
+gimp_operation_curves_clear_lut (GimpOperationCurves *curves)
+{
+  gpointer lut;
+
+  do
+    lut = g_atomic_pointer_get (&curves->lut);
+  while (! g_atomic_pointer_compare_and_exchange (&curves->lut, lut, NULL));
+
+  g_free (lut);
+}
@@ -39,6 +39,11 @@ typedef struct _GimpOperationCurvesClass GimpOperationCurvesClass;
 struct _GimpOperationCurves
 {
   GimpOperationPointFilter  parent_instance;
+
+  /*  the curves baked into a lookup table, for u8 and u16 input  */
+  const Babl               *lut_format;
+  gint                      lut_n_entries;
+  gpointer                  lut;
 };
 
 struct _GimpOperationCurvesClass
@@ -0,0 +1,615 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpoperationfusedpointfilter.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* gimp:fused-point-filter applies a chain of point filters (curves,
+ * levels, hue-saturation, ...) in a single pass.  The chain is given
+ * as an array of configured GIMP point-filter nodes, which are cloned
+ * into a private graph, only used to let each operation choose its
+ * formats.
+ *
+ * Each chunk is processed in blocks small enough to stay in the cache,
+ * running all the filters on a block before moving on to the next one,
+ * instead of letting every filter do its own pass over the whole
+ * buffer.  All the steps work on four-component float formats, even
+ * where an operation would pick an integer format on its own.  When
+ * all the filters are per-channel, and the input is 8- or 16-bit, the
+ * whole chain is baked into a lookup table instead.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "operations-types.h"
+
+#include "gegl/gimp-babl.h"
+
+#include "gimpoperationfusedpointfilter.h"
+#include "gimpoperationpointfilter.h"
+
+#include "gimp-intl.h"
+
+
+#define BLOCK_SIZE 256 /* pixels */
+
+
+enum
+{
+  PROP_0,
+  PROP_FILTERS
+};
+
+
+struct _GimpFusedPointFilterStep
+{
+  GeglNode      *node;
+  GeglOperation *operation;
+  const Babl    *input_format;
+  const Babl    *output_format;
+  const Babl    *fish;
+};
+
+
+static void       gimp_operation_fused_point_filter_finalize     (GObject             *object);
+static void       gimp_operation_fused_point_filter_get_property (GObject             *object,
+                                                                  guint                property_id,
+                                                                  GValue              *value,
+                                                                  GParamSpec          *pspec);
+static void       gimp_operation_fused_point_filter_set_property (GObject             *object,
+                                                                  guint                property_id,
+                                                                  const GValue        *value,
+                                                                  GParamSpec          *pspec);
+
+static void       gimp_operation_fused_point_filter_prepare      (GeglOperation       *operation);
+static gboolean   gimp_operation_fused_point_filter_process      (GeglOperation       *operation,
+                                                                  void                *in_buf,
+                                                                  void                *out_buf,
+                                                                  glong                samples,
+                                                                  const GeglRectangle *roi,
+                                                                  gint                 level);
+
+static void       gimp_operation_fused_point_filter_clear        (GimpOperationFusedPointFilter *self);
+static void       gimp_operation_fused_point_filter_build        (GimpOperationFusedPointFilter *self);
+static gboolean   gimp_operation_fused_point_filter_is_float     (const Babl          *format);
+static gboolean   gimp_operation_fused_point_filter_is_per_channel
+                                                                 (GimpOperationFusedPointFilter *self);
+static void       gimp_operation_fused_point_filter_bake_lut     (GimpOperationFusedPointFilter *self,
+                                                                  const GeglRectangle *roi,
+                                                                  gint                 level);
+static void       gimp_operation_fused_point_filter_run_block    (GimpOperationFusedPointFilter *self,
+                                                                  const gfloat        *src,
+                                                                  gfloat              *dest,
+                                                                  gint                 samples,
+                                                                  gfloat              *temp,
+                                                                  const GeglRectangle *roi,
+                                                                  gint                 level);
+
+
+G_DEFINE_TYPE (GimpOperationFusedPointFilter, gimp_operation_fused_point_filter,
+               GEGL_TYPE_OPERATION_POINT_FILTER)
+
+#define parent_class gimp_operation_fused_point_filter_parent_class
+
+
+static void
+gimp_operation_fused_point_filter_class_init (GimpOperationFusedPointFilterClass *klass)
+{
+  GObjectClass                  *object_class    = G_OBJECT_CLASS (klass);
+  GeglOperationClass            *operation_class = GEGL_OPERATION_CLASS (klass);
+  GeglOperationPointFilterClass *point_class     = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+
+  object_class->finalize     = gimp_operation_fused_point_filter_finalize;
+  object_class->set_property = gimp_operation_fused_point_filter_set_property;
+  object_class->get_property = gimp_operation_fused_point_filter_get_property;
+
+  operation_class->prepare   = gimp_operation_fused_point_filter_prepare;
+
+  point_class->process       = gimp_operation_fused_point_filter_process;
+
+  gegl_operation_class_set_keys (operation_class,
+                                 "name",        "gimp:fused-point-filter",
+                                 "categories",  "color",
+                                 "description", _("Apply a chain of point filters in a single pass"),
+                                 NULL);
+
+  g_object_class_install_property (object_class, PROP_FILTERS,
+                                   g_param_spec_boxed ("filters",
+                                                       "Filters",
+                                                       "Array of point-filter nodes",
+                                                       G_TYPE_PTR_ARRAY,
+                                                       G_PARAM_READWRITE |
+                                                       G_PARAM_CONSTRUCT));
+}
+
+static void
+gimp_operation_fused_point_filter_init (GimpOperationFusedPointFilter *self)
+{
+}
+
+static void
+gimp_operation_fused_point_filter_finalize (GObject *object)
+{
+  GimpOperationFusedPointFilter *self = GIMP_OPERATION_FUSED_POINT_FILTER (object);
+
+  gimp_operation_fused_point_filter_clear (self);
+
+  g_clear_pointer (&self->filters, g_ptr_array_unref);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gimp_operation_fused_point_filter_get_property (GObject    *object,
+                                                guint       property_id,
+                                                GValue     *value,
+                                                GParamSpec *pspec)
+{
+  GimpOperationFusedPointFilter *self = GIMP_OPERATION_FUSED_POINT_FILTER (object);
+
+  switch (property_id)
+    {
+    case PROP_FILTERS:
+      g_value_set_boxed (value, self->filters);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+    }
+}
+
+static void
+gimp_operation_fused_point_filter_set_property (GObject      *object,
+                                                guint         property_id,
+                                                const GValue *value,
+                                                GParamSpec   *pspec)
+{
+  GimpOperationFusedPointFilter *self = GIMP_OPERATION_FUSED_POINT_FILTER (object);
+
+  switch (property_id)
+    {
+    case PROP_FILTERS:
+      g_clear_pointer (&self->filters, g_ptr_array_unref);
+      self->filters = g_value_dup_boxed (value);
+
+      gimp_operation_fused_point_filter_build (self);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+    }
+}
+
+static void
+gimp_operation_fused_point_filter_prepare (GeglOperation *operation)
+{
+  GimpOperationFusedPointFilter *self   = GIMP_OPERATION_FUSED_POINT_FILTER (operation);
+  const Babl                    *format = gegl_operation_get_source_format (operation,
+                                                                           "input");
+  const Babl                    *space  = gegl_operation_get_source_space (operation,
+                                                                          "input");
+  const Babl                    *float_format;
+  GeglBuffer                    *buffer;
+  const Babl                    *prev_format;
+  gint                           i;
+
+  g_clear_pointer (&self->lut, g_free);
+  self->lut_format = NULL;
+
+  if (! format)
+    format = babl_format_with_space ("RGBA float", space);
+
+  float_format =
+    gimp_babl_format (GIMP_RGB,
+                      gimp_babl_precision (GIMP_COMPONENT_TYPE_FLOAT,
+                                           gimp_babl_format_get_trc (format)),
+                      TRUE, space);
+
+  if (self->n_steps == 0)
+    {
+      gegl_operation_set_format (operation, "input",  float_format);
+      gegl_operation_set_format (operation, "output", float_format);
+
+      return;
+    }
+
+  /*  let the operations choose their formats, based on a float version
+   *  of our input, so they don't pick their integer paths
+   */
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, 1, 1), float_format);
+  gegl_node_set (self->source,
+                 "buffer", buffer,
+                 NULL);
+  g_object_unref (buffer);
+
+  gegl_node_get_bounding_box (self->steps[self->n_steps - 1].node);
+
+  prev_format = NULL;
+
+  for (i = 0; i < self->n_steps; i++)
+    {
+      GimpFusedPointFilterStep *step = &self->steps[i];
+
+      step->input_format  = gegl_operation_get_format (step->operation,
+                                                       "input");
+      step->output_format = gegl_operation_get_format (step->operation,
+                                                       "output");
+
+      /*  run_block() and bake_lut() rely on float formats  */
+      if (! gimp_operation_fused_point_filter_is_float (step->input_format))
+        {
+          step->input_format = float_format;
+
+          gegl_operation_set_format (step->operation, "input",
+                                     step->input_format);
+        }
+
+      if (! gimp_operation_fused_point_filter_is_float (step->output_format))
+        {
+          step->output_format = float_format;
+
+          gegl_operation_set_format (step->operation, "output",
+                                     step->output_format);
+        }
+
+      if (prev_format && prev_format != step->input_format)
+        step->fish = babl_fish (prev_format, step->input_format);
+      else
+        step->fish = NULL;
+
+      prev_format = step->output_format;
+    }
+
+  if (gimp_operation_fused_point_filter_is_per_channel (self))
+    {
+      GimpComponentType component;
+
+      component = gimp_babl_format_get_component_type (format);
+
+      if (component == GIMP_COMPONENT_TYPE_U8 ||
+          component == GIMP_COMPONENT_TYPE_U16)
+        {
+          GimpTRCType trc = gimp_babl_format_get_trc (format);
+
+          self->lut_format =
+            gimp_babl_format (GIMP_RGB,
+                              gimp_babl_precision (component, trc),
+                              TRUE, space);
+
+          gimp_operation_fused_point_filter_bake_lut (self, NULL, 0);
+        }
+    }
+
+  if (self->lut)
+    {
+      gegl_operation_set_format (operation, "input",  self->lut_format);
+      gegl_operation_set_format (operation, "output", self->lut_format);
+    }
+  else
+    {
+      gegl_operation_set_format (operation, "input",
+                                 self->steps[0].input_format);
+      gegl_operation_set_format (operation, "output",
+                                 self->steps[self->n_steps - 1].output_format);
+    }
+}
+
+static gboolean
+gimp_operation_fused_point_filter_process (GeglOperation       *operation,
+                                           void                *in_buf,
+                                           void                *out_buf,
+                                           glong                samples,
+                                           const GeglRectangle *roi,
+                                           gint                 level)
+{
+  GimpOperationFusedPointFilter *self = GIMP_OPERATION_FUSED_POINT_FILTER (operation);
+
+  if (self->n_steps == 0)
+    {
+      if (in_buf != out_buf)
+        memcpy (out_buf, in_buf, samples * 4 * sizeof (gfloat));
+
+      return TRUE;
+    }
+
+  if (self->lut)
+    {
+      if (babl_format_get_bytes_per_pixel (self->lut_format) == 4)
+        {
+          const guint8 *lut  = self->lut;
+          const guint8 *src  = in_buf;
+          guint8       *dest = out_buf;
+
+          while (samples--)
+            {
+              dest[0] = lut[0 * 256 + src[0]];
+              dest[1] = lut[1 * 256 + src[1]];
+              dest[2] = lut[2 * 256 + src[2]];
+              dest[3] = lut[3 * 256 + src[3]];
+
+              src  += 4;
+              dest += 4;
+            }
+        }
+      else
+        {
+          const guint16 *lut  = self->lut;
+          const guint16 *src  = in_buf;
+          guint16       *dest = out_buf;
+
+          while (samples--)
+            {
+              dest[0] = lut[0 * 65536 + src[0]];
+              dest[1] = lut[1 * 65536 + src[1]];
+              dest[2] = lut[2 * 65536 + src[2]];
+              dest[3] = lut[3 * 65536 + src[3]];
+
+              src  += 4;
+              dest += 4;
+            }
+        }
+    }
+  else
+    {
+      const gfloat *src  = in_buf;
+      gfloat       *dest = out_buf;
+      gfloat       *temp;
+
+      temp = gegl_scratch_new (gfloat, 4 * BLOCK_SIZE);
+
+      while (samples > 0)
+        {
+          gint n = MIN (samples, BLOCK_SIZE);
+
+          gimp_operation_fused_point_filter_run_block (self, src, dest, n,
+                                                       temp, roi, level);
+
+          src     += 4 * n;
+          dest    += 4 * n;
+          samples -= n;
+        }
+
+      gegl_scratch_free (temp);
+    }
+
+  return TRUE;
+}
+
+static void
+gimp_operation_fused_point_filter_clear (GimpOperationFusedPointFilter *self)
+{
+  g_clear_object (&self->graph);
+  self->source = NULL;
+
+  g_clear_pointer (&self->steps, g_free);
+  self->n_steps = 0;
+
+  g_clear_pointer (&self->lut, g_free);
+  self->lut_format = NULL;
+}
+
+static void
+gimp_operation_fused_point_filter_build (GimpOperationFusedPointFilter *self)
+{
+  GeglNode *prev;
+  guint     i;
+
+  gimp_operation_fused_point_filter_clear (self);
+
+  if (! self->filters || self->filters->len == 0)
+    return;
+
+  self->graph  = gegl_node_new ();
+  self->source = gegl_node_new_child (self->graph,
+                                      "operation", "gegl:buffer-source",
+                                      NULL);
+
+  self->steps = g_new0 (GimpFusedPointFilterStep, self->filters->len);
+
+  prev = self->source;
+
+  for (i = 0; i < self->filters->len; i++)
+    {
+      GeglNode      *filter = g_ptr_array_index (self->filters, i);
+      const gchar   *name   = gegl_node_get_operation (filter);
+      GeglOperation *operation;
+      GeglNode      *node;
+      GParamSpec   **pspecs;
+      guint          n_pspecs;
+      guint          j;
+
+      operation = gegl_node_get_gegl_operation (filter);
+
+      /*  GIMP point filters process in place, and accept the float
+       *  formats prepare() forces on them
+       */
+      if (! GIMP_IS_OPERATION_POINT_FILTER (operation))
+        {
+          g_warning ("%s: '%s' is not a GIMP point filter, skipping",
+                     G_STRFUNC, name);
+          continue;
+        }
+
+      node = gegl_node_new_child (self->graph,
+                                  "operation", name,
+                                  NULL);
+
+      pspecs = gegl_operation_list_properties (name, &n_pspecs);
+
+      for (j = 0; j < n_pspecs; j++)
+        {
+          GValue value = G_VALUE_INIT;
+
+          g_value_init (&value, pspecs[j]->value_type);
+
+          gegl_node_get_property (filter, pspecs[j]->name, &value);
+          gegl_node_set_property (node,   pspecs[j]->name, &value);
+
+          g_value_unset (&value);
+        }
+
+      g_free (pspecs);
+
+      gegl_node_link (prev, node);
+      prev = node;
+
+      self->steps[self->n_steps].node      = node;
+      self->steps[self->n_steps].operation = gegl_node_get_gegl_operation (node);
+      self->n_steps++;
+    }
+}
+
+static gboolean
+gimp_operation_fused_point_filter_is_float (const Babl *format)
+{
+  return format                                   &&
+         babl_format_get_n_components (format) == 4 &&
+         babl_format_get_type (format, 0) == babl_type ("float");
+}
+
+static gboolean
+gimp_operation_fused_point_filter_is_per_channel (GimpOperationFusedPointFilter *self)
+{
+  gint i;
+
+  for (i = 0; i < self->n_steps; i++)
+    {
+      GeglOperation *operation = self->steps[i].operation;
+
+      if (! GIMP_OPERATION_POINT_FILTER_GET_CLASS (operation)->per_channel)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+gimp_operation_fused_point_filter_bake_lut (GimpOperationFusedPointFilter *self,
+                                            const GeglRectangle           *roi,
+                                            gint                           level)
+{
+  const Babl *float_format = self->steps[0].input_format;
+  const Babl *last_format  = self->steps[self->n_steps - 1].output_format;
+  gint        bpc;
+  gint        n_entries;
+  gpointer    ramp;
+  gfloat     *input;
+  gfloat     *output;
+  gfloat     *temp;
+  gint        i;
+  gint        c;
+
+  bpc       = babl_format_get_bytes_per_pixel (self->lut_format) / 4;
+  n_entries = (bpc == 1) ? 256 : 65536;
+
+  /*  a ramp through all the values of the table's component type,
+   *  on all four components
+   */
+  ramp = g_malloc (n_entries * 4 * bpc);
+
+  for (i = 0; i < n_entries; i++)
+    {
+      for (c = 0; c < 4; c++)
+        {
+          if (bpc == 1)
+            ((guint8 *) ramp)[4 * i + c] = i;
+          else
+            ((guint16 *) ramp)[4 * i + c] = i;
+        }
+    }
+
+  input  = g_new (gfloat, 4 * n_entries);
+  output = g_new (gfloat, 4 * n_entries);
+  temp   = g_new (gfloat, 4 * BLOCK_SIZE);
+
+  babl_process (babl_fish (self->lut_format, float_format),
+                ramp, input, n_entries);
+
+  for (i = 0; i < n_entries; i += BLOCK_SIZE)
+    {
+      gimp_operation_fused_point_filter_run_block (self,
+                                                   input  + 4 * i,
+                                                   output + 4 * i,
+                                                   MIN (BLOCK_SIZE,
+                                                        n_entries - i),
+                                                   temp, roi, level);
+    }
+
+  babl_process (babl_fish (last_format, self->lut_format),
+                output, ramp, n_entries);
+
+  /*  transpose the converted ramp into one table per component  */
+  self->lut = g_malloc (n_entries * 4 * bpc);
+
+  for (i = 0; i < n_entries; i++)
+    {
+      for (c = 0; c < 4; c++)
+        {
+          if (bpc == 1)
+            ((guint8 *) self->lut)[c * n_entries + i] =
+              ((guint8 *) ramp)[4 * i + c];
+          else
+            ((guint16 *) self->lut)[c * n_entries + i] =
+              ((guint16 *) ramp)[4 * i + c];
+        }
+    }
+
+  g_free (temp);
+  g_free (output);
+  g_free (input);
+  g_free (ramp);
+}
+
+static void
+gimp_operation_fused_point_filter_run_block (GimpOperationFusedPointFilter *self,
+                                             const gfloat                  *src,
+                                             gfloat                        *dest,
+                                             gint                           samples,
+                                             gfloat                        *temp,
+                                             const GeglRectangle           *roi,
+                                             gint                           level)
+{
+  gint i;
+
+  if (src != dest)
+    memcpy (dest, src, samples * 4 * sizeof (gfloat));
+
+  for (i = 0; i < self->n_steps; i++)
+    {
+      GimpFusedPointFilterStep      *step  = &self->steps[i];
+      GeglOperationPointFilterClass *klass;
+
+      if (step->fish)
+        {
+          babl_process (step->fish, dest, temp, samples);
+          memcpy (dest, temp, samples * 4 * sizeof (gfloat));
+        }
+
+      klass = GEGL_OPERATION_POINT_FILTER_GET_CLASS (step->operation);
+
+      /*  point filters can process in place  */
+      klass->process (step->operation, dest, dest, samples, roi, level);
+    }
+}
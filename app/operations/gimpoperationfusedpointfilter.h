@@ -0,0 +1,67 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimpoperationfusedpointfilter.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_OPERATION_FUSED_POINT_FILTER_H__
+#define __GIMP_OPERATION_FUSED_POINT_FILTER_H__
+
+
+#include <gegl-plugin.h>
+#include <operation/gegl-operation-point-filter.h>
+
+
+#define GIMP_TYPE_OPERATION_FUSED_POINT_FILTER            (gimp_operation_fused_point_filter_get_type ())
+#define GIMP_OPERATION_FUSED_POINT_FILTER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GIMP_TYPE_OPERATION_FUSED_POINT_FILTER, GimpOperationFusedPointFilter))
+#define GIMP_OPERATION_FUSED_POINT_FILTER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GIMP_TYPE_OPERATION_FUSED_POINT_FILTER, GimpOperationFusedPointFilterClass))
+#define GIMP_IS_OPERATION_FUSED_POINT_FILTER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GIMP_TYPE_OPERATION_FUSED_POINT_FILTER))
+#define GIMP_IS_OPERATION_FUSED_POINT_FILTER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GIMP_TYPE_OPERATION_FUSED_POINT_FILTER))
+#define GIMP_OPERATION_FUSED_POINT_FILTER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GIMP_TYPE_OPERATION_FUSED_POINT_FILTER, GimpOperationFusedPointFilterClass))
+
+
+typedef struct _GimpOperationFusedPointFilter      GimpOperationFusedPointFilter;
+typedef struct _GimpOperationFusedPointFilterClass GimpOperationFusedPointFilterClass;
+
+typedef struct _GimpFusedPointFilterStep           GimpFusedPointFilterStep;
+
+struct _GimpOperationFusedPointFilter
+{
+  GeglOperationPointFilter  parent_instance;
+
+  GPtrArray                *filters;
+
+  /*  private graph, used to prepare the fused operations  */
+  GeglNode                 *graph;
+  GeglNode                 *source;
+  GimpFusedPointFilterStep *steps;
+  gint                      n_steps;
+
+  /*  baked lookup table, for chains of per-channel filters  */
+  const Babl               *lut_format;
+  gpointer                  lut;
+};
+
+struct _GimpOperationFusedPointFilterClass
+{
+  GeglOperationPointFilterClass  parent_class;
+};
+
+
+GType   gimp_operation_fused_point_filter_get_type (void) G_GNUC_CONST;
+
+
+#endif /* __GIMP_OPERATION_FUSED_POINT_FILTER_H__ */
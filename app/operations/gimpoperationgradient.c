@@ -138,23 +138,34 @@ static gdouble         gradient_calc_spiral_factor               (gdouble
                                                                   gdouble                y,
                                                                   gboolean               clockwise);
 
-static gdouble         gradient_calc_shapeburst_angular_factor   (GeglSampler           *dist_sampler,
-                                                                  gdouble                offset,
-                                                                  gdouble                x,
-                                                                  gdouble                y);
-static gdouble         gradient_calc_shapeburst_spherical_factor (GeglSampler           *dist_sampler,
-                                                                  gdouble                offset,
-                                                                  gdouble                x,
-                                                                  gdouble                y);
-static gdouble         gradient_calc_shapeburst_dimpled_factor   (GeglSampler           *dist_sampler,
-                                                                  gdouble                offset,
-                                                                  gdouble                x,
-                                                                  gdouble                y);
+static gdouble         gradient_calc_shapeburst_angular_factor   (gfloat                 value,
+                                                                  gdouble                offset);
+static gdouble         gradient_calc_shapeburst_spherical_factor (gfloat                 value,
+                                                                  gdouble                offset);
+static gdouble         gradient_calc_shapeburst_dimpled_factor   (gfloat                 value,
+                                                                  gdouble                offset);
+
+static inline gboolean gradient_repeat_factor                    (RenderBlendData       *rbd,
+                                                                  gdouble               *factor);
+static inline void     gradient_factor_color                     (RenderBlendData       *rbd,
+                                                                  gdouble                factor,
+                                                                  GimpRGB               *color);
 
 static void            gradient_render_pixel                     (gdouble                x,
                                                                   gdouble                y,
                                                                   GimpRGB               *color,
                                                                   gpointer               render_data);
+static void            gradient_render_row_factors               (RenderBlendData       *rbd,
+                                                                  gint                   x,
+                                                                  gint                   y,
+                                                                  gint                   width,
+                                                                  const gfloat          *dist,
+                                                                  gfloat                *factors);
+static void            gradient_render_row                       (RenderBlendData       *rbd,
+                                                                  const gfloat          *factors,
+                                                                  gint                   width,
+                                                                  GRand                 *dither_rand,
+                                                                  gfloat                *dest);
 
 static void            gradient_put_pixel                        (gint                   x,
                                                                   gint                   y,
@@ -801,17 +812,11 @@ gradient_calc_spiral_factor (gdouble   dist,
 }
 
 static gdouble
-gradient_calc_shapeburst_angular_factor (GeglSampler *dist_sampler,
-                                         gdouble      offset,
-                                         gdouble      x,
-                                         gdouble      y)
+gradient_calc_shapeburst_angular_factor (gfloat  value,
+                                         gdouble offset)
 {
-  gfloat value;
-
   offset = offset / 100.0;
 
-  gegl_sampler_get (dist_sampler, x, y, NULL, &value, GEGL_ABYSS_NONE);
-
   value = 1.0 - value;
 
   if (value < offset)
@@ -826,17 +831,11 @@ gradient_calc_shapeburst_angular_factor (GeglSampler *dist_sampler,
 
 
 static gdouble
-gradient_calc_shapeburst_spherical_factor (GeglSampler *dist_sampler,
-                                           gdouble      offset,
-                                           gdouble      x,
-                                           gdouble      y)
+gradient_calc_shapeburst_spherical_factor (gfloat  value,
+                                           gdouble offset)
 {
-  gfloat value;
-
   offset = 1.0 - offset / 100.0;
 
-  gegl_sampler_get (dist_sampler, x, y, NULL, &value, GEGL_ABYSS_NONE);
-
   if (value > offset)
     value = 1.0;
   else if (offset == 0.0)
@@ -851,17 +850,11 @@ gradient_calc_shapeburst_spherical_factor (GeglSampler *dist_sampler,
 
 
 static gdouble
-gradient_calc_shapeburst_dimpled_factor (GeglSampler *dist_sampler,
-                                         gdouble      offset,
-                                         gdouble      x,
-                                         gdouble      y)
+gradient_calc_shapeburst_dimpled_factor (gfloat  value,
+                                         gdouble offset)
 {
-  gfloat value;
-
   offset = 1.0 - offset / 100.0;
 
-  gegl_sampler_get (dist_sampler, x, y, NULL, &value, GEGL_ABYSS_NONE);
-
   if (value > offset)
     value = 1.0;
   else if (offset == 0.0)
@@ -874,6 +867,65 @@ gradient_calc_shapeburst_dimpled_factor (GeglSampler *dist_sampler,
   return value;
 }
 
+static inline gboolean
+gradient_repeat_factor (RenderBlendData *rbd,
+                        gdouble         *factor)
+{
+  switch (rbd->repeat)
+    {
+    case GIMP_REPEAT_NONE:
+      break;
+
+    case GIMP_REPEAT_SAWTOOTH:
+      *factor = *factor - floor (*factor);
+      break;
+
+    case GIMP_REPEAT_TRIANGULAR:
+      {
+        guint ifactor;
+
+        if (*factor < 0.0)
+          *factor = -*factor;
+
+        ifactor = (guint) *factor;
+        *factor = *factor - floor (*factor);
+
+        if (ifactor & 1)
+          *factor = 1.0 - *factor;
+      }
+      break;
+
+    case GIMP_REPEAT_TRUNCATE:
+      if (*factor < 0.0 || *factor > 1.0)
+        return FALSE;
+      break;
+    }
+
+  return TRUE;
+}
+
+static inline void
+gradient_factor_color (RenderBlendData *rbd,
+                       gdouble          factor,
+                       GimpRGB         *color)
+{
+  if (rbd->gradient_cache)
+    {
+      factor = CLAMP (factor, 0.0, 1.0);
+
+      *color =
+        rbd->gradient_cache[ROUND (factor * (rbd->gradient_cache_size - 1))];
+    }
+  else
+    {
+      rbd->last_seg = gimp_gradient_get_color_at (rbd->gradient, NULL,
+                                                  rbd->last_seg, factor,
+                                                  rbd->reverse,
+                                                  rbd->blend_color_space,
+                                                  color);
+    }
+}
+
 static void
 gradient_render_pixel (gdouble   x,
                        gdouble   y,
@@ -882,6 +934,7 @@ gradient_render_pixel (gdouble   x,
 {
   RenderBlendData *rbd = render_data;
   gdouble          factor;
+  gfloat           value;
 
   /*  we want to calculate the color at the pixel's center  */
   x += 0.5;
@@ -927,21 +980,21 @@ gradient_render_pixel (gdouble   x,
       break;
 
     case GIMP_GRADIENT_SHAPEBURST_ANGULAR:
-      factor = gradient_calc_shapeburst_angular_factor (rbd->dist_sampler,
-                                                        rbd->offset,
-                                                        x, y);
+      gegl_sampler_get (rbd->dist_sampler, x, y, NULL, &value,
+                        GEGL_ABYSS_NONE);
+      factor = gradient_calc_shapeburst_angular_factor (value, rbd->offset);
       break;
 
     case GIMP_GRADIENT_SHAPEBURST_SPHERICAL:
-      factor = gradient_calc_shapeburst_spherical_factor (rbd->dist_sampler,
-                                                          rbd->offset,
-                                                          x, y);
+      gegl_sampler_get (rbd->dist_sampler, x, y, NULL, &value,
+                        GEGL_ABYSS_NONE);
+      factor = gradient_calc_shapeburst_spherical_factor (value, rbd->offset);
       break;
 
     case GIMP_GRADIENT_SHAPEBURST_DIMPLED:
-      factor = gradient_calc_shapeburst_dimpled_factor (rbd->dist_sampler,
-                                                        rbd->offset,
-                                                        x, y);
+      gegl_sampler_get (rbd->dist_sampler, x, y, NULL, &value,
+                        GEGL_ABYSS_NONE);
+      factor = gradient_calc_shapeburst_dimpled_factor (value, rbd->offset);
       break;
 
     case GIMP_GRADIENT_SPIRAL_CLOCKWISE:
@@ -963,55 +1016,241 @@ gradient_render_pixel (gdouble   x,
 
   /* Adjust for repeat */
 
-  switch (rbd->repeat)
+  if (! gradient_repeat_factor (rbd, &factor))
     {
-    case GIMP_REPEAT_NONE:
-      break;
+      gimp_rgba_set (color, 0.0, 0.0, 0.0, 0.0);
+      return;
+    }
 
-    case GIMP_REPEAT_SAWTOOTH:
-      factor = factor - floor (factor);
-      break;
+  /* Blend the colors */
 
-    case GIMP_REPEAT_TRIANGULAR:
-      {
-        guint ifactor;
+  gradient_factor_color (rbd, factor, color);
+}
 
-        if (factor < 0.0)
-          factor = -factor;
+/*  calculates the blending factors of a row of pixel centers.  the
+ *  common shapes have simple float loops, which the compiler can
+ *  vectorize; the rest go through the per-pixel functions.
+ */
+static void
+gradient_render_row_factors (RenderBlendData *rbd,
+                             gint             x,
+                             gint             y,
+                             gint             width,
+                             const gfloat    *dist,
+                             gfloat          *factors)
+{
+  const gdouble dx     = x + 0.5 - rbd->sx;
+  const gdouble dy     = y + 0.5 - rbd->sy;
+  const gfloat  offset = rbd->offset / 100.0;
+  gint          i;
 
-        ifactor = (guint) factor;
-        factor = factor - floor (factor);
+  if (rbd->dist == 0.0)
+    {
+      switch (rbd->gradient_type)
+        {
+        case GIMP_GRADIENT_LINEAR:
+        case GIMP_GRADIENT_BILINEAR:
+        case GIMP_GRADIENT_RADIAL:
+        case GIMP_GRADIENT_SQUARE:
+        case GIMP_GRADIENT_CONICAL_SYMMETRIC:
+        case GIMP_GRADIENT_CONICAL_ASYMMETRIC:
+        case GIMP_GRADIENT_SPIRAL_CLOCKWISE:
+        case GIMP_GRADIENT_SPIRAL_ANTICLOCKWISE:
+          for (i = 0; i < width; i++)
+            factors[i] = 0.0f;
+          return;
 
-        if (ifactor & 1)
-          factor = 1.0 - factor;
-      }
-      break;
+        default:
+          break;
+        }
+    }
 
-    case GIMP_REPEAT_TRUNCATE:
-      if (factor < 0.0 || factor > 1.0)
+  if (offset < 1.0f)
+    {
+      const gfloat inv_dist   = 1.0 / rbd->dist;
+      const gfloat inv_offset = 1.0f / (1.0f - offset);
+
+      switch (rbd->gradient_type)
         {
-          gimp_rgba_set (color, 0.0, 0.0, 0.0, 0.0);
+        case GIMP_GRADIENT_LINEAR:
+          {
+            const gfloat v0 = rbd->vec[0] / rbd->dist;
+            const gfloat r0 = (rbd->vec[0] * dx + rbd->vec[1] * dy) / rbd->dist;
+
+            for (i = 0; i < width; i++)
+              {
+                gfloat rat = r0 + v0 * i;
+
+                factors[i] = rat < 0.0f ? rat * inv_offset :
+                                          MAX (rat - offset, 0.0f) * inv_offset;
+              }
+          }
+          return;
+
+        case GIMP_GRADIENT_BILINEAR:
+          {
+            const gfloat v0 = rbd->vec[0] / rbd->dist;
+            const gfloat r0 = (rbd->vec[0] * dx + rbd->vec[1] * dy) / rbd->dist;
+
+            for (i = 0; i < width; i++)
+              {
+                gfloat rat = fabsf (r0 + v0 * i);
+
+                factors[i] = MAX (rat - offset, 0.0f) * inv_offset;
+              }
+          }
+          return;
+
+        case GIMP_GRADIENT_RADIAL:
+          {
+            const gfloat x0  = dx;
+            const gfloat dy2 = dy * dy;
+
+            for (i = 0; i < width; i++)
+              {
+                gfloat xx  = x0 + i;
+                gfloat rat = sqrtf (xx * xx + dy2) * inv_dist;
+
+                factors[i] = MAX (rat - offset, 0.0f) * inv_offset;
+              }
+          }
+          return;
+
+        case GIMP_GRADIENT_SQUARE:
+          {
+            const gfloat x0  = dx;
+            const gfloat ady = fabs (dy);
+
+            for (i = 0; i < width; i++)
+              {
+                gfloat rat = MAX (fabsf (x0 + i), ady) * inv_dist;
+
+                factors[i] = MAX (rat - offset, 0.0f) * inv_offset;
+              }
+          }
           return;
+
+        default:
+          break;
         }
-      break;
     }
 
-  /* Blend the colors */
-
-  if (rbd->gradient_cache)
+  switch (rbd->gradient_type)
     {
-      factor = CLAMP (factor, 0.0, 1.0);
+    case GIMP_GRADIENT_SHAPEBURST_ANGULAR:
+      for (i = 0; i < width; i++)
+        factors[i] = gradient_calc_shapeburst_angular_factor (dist[i],
+                                                              rbd->offset);
+      break;
 
-      *color =
-        rbd->gradient_cache[ROUND (factor * (rbd->gradient_cache_size - 1))];
+    case GIMP_GRADIENT_SHAPEBURST_SPHERICAL:
+      for (i = 0; i < width; i++)
+        factors[i] = gradient_calc_shapeburst_spherical_factor (dist[i],
+                                                                rbd->offset);
+      break;
+
+    case GIMP_GRADIENT_SHAPEBURST_DIMPLED:
+      for (i = 0; i < width; i++)
+        factors[i] = gradient_calc_shapeburst_dimpled_factor (dist[i],
+                                                              rbd->offset);
+      break;
+
+    default:
+      for (i = 0; i < width; i++)
+        {
+          gdouble factor;
+
+          switch (rbd->gradient_type)
+            {
+            case GIMP_GRADIENT_LINEAR:
+              factor = gradient_calc_linear_factor (rbd->dist,
+                                                    rbd->vec, rbd->offset,
+                                                    dx + i, dy);
+              break;
+
+            case GIMP_GRADIENT_BILINEAR:
+              factor = gradient_calc_bilinear_factor (rbd->dist,
+                                                      rbd->vec, rbd->offset,
+                                                      dx + i, dy);
+              break;
+
+            case GIMP_GRADIENT_RADIAL:
+              factor = gradient_calc_radial_factor (rbd->dist, rbd->offset,
+                                                    dx + i, dy);
+              break;
+
+            case GIMP_GRADIENT_SQUARE:
+              factor = gradient_calc_square_factor (rbd->dist, rbd->offset,
+                                                    dx + i, dy);
+              break;
+
+            case GIMP_GRADIENT_CONICAL_SYMMETRIC:
+              factor = gradient_calc_conical_sym_factor (rbd->dist,
+                                                         rbd->vec, rbd->offset,
+                                                         dx + i, dy);
+              break;
+
+            case GIMP_GRADIENT_CONICAL_ASYMMETRIC:
+              factor = gradient_calc_conical_asym_factor (rbd->dist,
+                                                          rbd->vec, rbd->offset,
+                                                          dx + i, dy);
+              break;
+
+            case GIMP_GRADIENT_SPIRAL_CLOCKWISE:
+              factor = gradient_calc_spiral_factor (rbd->dist,
+                                                    rbd->vec, rbd->offset,
+                                                    dx + i, dy, TRUE);
+              break;
+
+            case GIMP_GRADIENT_SPIRAL_ANTICLOCKWISE:
+              factor = gradient_calc_spiral_factor (rbd->dist,
+                                                    rbd->vec, rbd->offset,
+                                                    dx + i, dy, FALSE);
+              break;
+
+            default:
+              g_return_if_reached ();
+            }
+
+          factors[i] = factor;
+        }
+      break;
     }
-  else
+}
+
+/*  converts a row of blending factors to colors  */
+static void
+gradient_render_row (RenderBlendData *rbd,
+                     const gfloat    *factors,
+                     gint             width,
+                     GRand           *dither_rand,
+                     gfloat          *dest)
+{
+  gint i;
+
+  for (i = 0; i < width; i++)
     {
-      rbd->last_seg = gimp_gradient_get_color_at (rbd->gradient, NULL,
-                                                  rbd->last_seg, factor,
-                                                  rbd->reverse,
-                                                  rbd->blend_color_space,
-                                                  color);
+      GimpRGB color  = { 0.0, 0.0, 0.0, 1.0 };
+      gdouble factor = factors[i];
+
+      if (gradient_repeat_factor (rbd, &factor))
+        gradient_factor_color (rbd, factor, &color);
+      else
+        gimp_rgba_set (&color, 0.0, 0.0, 0.0, 0.0);
+
+      if (dither_rand)
+        {
+          gradient_dither_pixel (&color, dither_rand, dest);
+        }
+      else
+        {
+          dest[0] = color.r;
+          dest[1] = color.g;
+          dest[2] = color.b;
+          dest[3] = color.a;
+        }
+
+      dest += 4;
     }
 }
 
@@ -1128,8 +1367,18 @@ gimp_operation_gradient_process (GeglOperation       *operation,
     case GIMP_GRADIENT_SHAPEBURST_SPHERICAL:
     case GIMP_GRADIENT_SHAPEBURST_DIMPLED:
       rbd.dist = sqrt (SQR (ex - sx) + SQR (ey - sy));
-      rbd.dist_sampler = gegl_buffer_sampler_new_at_level (
-        input, babl_format ("Y float"), GEGL_SAMPLER_NEAREST, level);
+
+      if (! input)
+        return TRUE;
+
+      /*  the supersampling code samples the distance map at arbitrary
+       *  positions, otherwise we read it along with the output below
+       */
+      if (self->supersample)
+        {
+          rbd.dist_sampler = gegl_buffer_sampler_new_at_level (
+            input, babl_format ("Y float"), GEGL_SAMPLER_NEAREST, level);
+        }
       break;
 
     default:
@@ -1149,7 +1398,7 @@ gimp_operation_gradient_process (GeglOperation       *operation,
 
   iter = gegl_buffer_iterator_new (output, result, 0,
                                    babl_format ("R'G'B'A float"),
-                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 2);
   roi = &iter->items[0].roi;
 
   if (self->dither)
@@ -1179,41 +1428,38 @@ gimp_operation_gradient_process (GeglOperation       *operation,
     }
   else
     {
+      gboolean shapeburst = self->gradient_type >= GIMP_GRADIENT_SHAPEBURST_ANGULAR &&
+                            self->gradient_type <= GIMP_GRADIENT_SHAPEBURST_DIMPLED;
+
+      if (shapeburst)
+        {
+          gegl_buffer_iterator_add (iter, input, result, level,
+                                    babl_format ("Y float"),
+                                    GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
+        }
+
       while (gegl_buffer_iterator_next (iter))
         {
-          gfloat *dest = iter->items[0].data;
-          gint    endx = roi->x + roi->width;
-          gint    endy = roi->y + roi->height;
-          gint    x, y;
+          gfloat       *dest    = iter->items[0].data;
+          const gfloat *dist    = shapeburst ? iter->items[1].data : NULL;
+          gfloat       *factors = gegl_scratch_new (gfloat, roi->width);
+          gint          endy    = roi->y + roi->height;
+          gint          y;
 
-          if (dither_rand)
+          for (y = roi->y; y < endy; y++)
             {
-              for (y = roi->y; y < endy; y++)
-                for (x = roi->x; x < endx; x++)
-                  {
-                    GimpRGB  color = { 0.0, 0.0, 0.0, 1.0 };
+              gradient_render_row_factors (&rbd, roi->x, y, roi->width,
+                                           dist, factors);
+              gradient_render_row (&rbd, factors, roi->width,
+                                   dither_rand, dest);
 
-                    gradient_render_pixel (x, y, &color, &rbd);
-                    gradient_dither_pixel (&color, dither_rand, dest);
+              dest += 4 * roi->width;
 
-                    dest += 4;
-                  }
-            }
-          else
-            {
-              for (y = roi->y; y < endy; y++)
-                for (x = roi->x; x < endx; x++)
-                  {
-                    GimpRGB  color = { 0.0, 0.0, 0.0, 1.0 };
-
-                    gradient_render_pixel (x, y, &color, &rbd);
-
-                    *dest++ = color.r;
-                    *dest++ = color.g;
-                    *dest++ = color.b;
-                    *dest++ = color.a;
-                  }
+              if (dist)
+                dist += roi->width;
             }
+
+          gegl_scratch_free (factors);
         }
     }
 
@@ -66,6 +66,8 @@ gimp_operation_levels_class_init (GimpOperationLevelsClass *klass)
 
   point_class->process = gimp_operation_levels_process;
 
+  GIMP_OPERATION_POINT_FILTER_CLASS (klass)->per_channel = TRUE;
+
   g_object_class_install_property (object_class,
                                    GIMP_OPERATION_POINT_FILTER_PROP_TRC,
                                    g_param_spec_enum ("trc",
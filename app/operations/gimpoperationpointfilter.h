@@ -55,6 +55,11 @@ struct _GimpOperationPointFilter
 struct _GimpOperationPointFilterClass
 {
   GeglOperationPointFilterClass  parent_class;
+
+  /*  whether each output component depends only on the same input
+   *  component, which allows baking the filter into a 1D lookup table
+   */
+  gboolean                       per_channel;
 };
 
 
@@ -77,6 +77,8 @@ gimp_operation_posterize_class_init (GimpOperationPosterizeClass *klass)
 
   point_class->process       = gimp_operation_posterize_process;
 
+  GIMP_OPERATION_POINT_FILTER_CLASS (klass)->per_channel = TRUE;
+
   gegl_operation_class_set_keys (operation_class,
                                  "name",        "gimp:posterize",
                                  "categories",  "color",
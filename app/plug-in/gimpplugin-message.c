@@ -661,7 +661,9 @@ gimp_plug_in_handle_proc_return (GimpPlugIn   *plug_in,
                                                    proc_frame->return_vals);
     }
 
-  gimp_plug_in_close (plug_in, FALSE);
+  /*  a worker is handed back to the worker pool by its caller  */
+  if (! plug_in->worker)
+    gimp_plug_in_close (plug_in, FALSE);
 }
 
 static void
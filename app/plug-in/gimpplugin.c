@@ -97,6 +97,7 @@
 
 static void       gimp_plug_in_finalize      (GObject      *object);
 
+static void       gimp_plug_in_add_watch     (GimpPlugIn   *plug_in);
 static gboolean   gimp_plug_in_recv_message  (GIOChannel   *channel,
                                               GIOCondition  cond,
                                               gpointer      data);
@@ -178,6 +179,24 @@ gimp_plug_in_finalize (GObject *object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gimp_plug_in_add_watch (GimpPlugIn *plug_in)
+{
+  GSource *source;
+
+  source = g_io_create_watch (plug_in->my_read,
+                              G_IO_IN  | G_IO_PRI | G_IO_ERR | G_IO_HUP);
+
+  g_source_set_callback (source,
+                         (GSourceFunc) gimp_plug_in_recv_message, plug_in,
+                         NULL);
+
+  g_source_set_can_recurse (source, TRUE);
+
+  plug_in->input_id = g_source_attach (source, NULL);
+  g_source_unref (source);
+}
+
 static gboolean
 gimp_plug_in_recv_message (GIOChannel   *channel,
                            GIOCondition  cond,
@@ -530,7 +549,7 @@ gimp_plug_in_open (GimpPlugIn         *plug_in,
       break;
 
     case GIMP_PLUG_IN_CALL_RUN:
-      mode = "-run";
+      mode = plug_in->worker ? "-worker" : "-run";
       debug_flag = GIMP_DEBUG_WRAP_RUN;
       break;
 
@@ -608,21 +627,7 @@ gimp_plug_in_open (GimpPlugIn         *plug_in,
   g_clear_pointer (&plug_in->his_write, g_io_channel_unref);
 
   if (! synchronous)
-    {
-      GSource *source;
-
-      source = g_io_create_watch (plug_in->my_read,
-                                  G_IO_IN  | G_IO_PRI | G_IO_ERR | G_IO_HUP);
-
-      g_source_set_callback (source,
-                             (GSourceFunc) gimp_plug_in_recv_message, plug_in,
-                             NULL);
-
-      g_source_set_can_recurse (source, TRUE);
-
-      plug_in->input_id = g_source_attach (source, NULL);
-      g_source_unref (source);
-    }
+    gimp_plug_in_add_watch (plug_in);
 
   plug_in->open      = TRUE;
   plug_in->call_mode = call_mode;
@@ -822,6 +827,28 @@ gimp_plug_in_close (GimpPlugIn *plug_in,
   gimp_plug_in_manager_remove_open_plug_in (plug_in->manager, plug_in);
 }
 
+/*  Stop listening to a worker while it is parked in the worker pool,
+ *  its pipe is checked when it is taken out again.
+ */
+void
+gimp_plug_in_set_idle (GimpPlugIn *plug_in,
+                       gboolean    idle)
+{
+  g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
+  g_return_if_fail (plug_in->open);
+  g_return_if_fail (plug_in->worker);
+
+  if (idle && plug_in->input_id)
+    {
+      g_source_remove (plug_in->input_id);
+      plug_in->input_id = 0;
+    }
+  else if (! idle && ! plug_in->input_id)
+    {
+      gimp_plug_in_add_watch (plug_in);
+    }
+}
+
 GimpPlugInProcFrame *
 gimp_plug_in_get_proc_frame (GimpPlugIn *plug_in)
 {
@@ -47,6 +47,7 @@ struct _GimpPlugIn
   GimpPlugInCallMode   call_mode;       /*  QUERY, INIT or RUN                */
   guint                open : 1;        /*  Is the plug-in open?              */
   guint                hup : 1;         /*  Did we receive a G_IO_HUP         */
+  guint                worker : 1;      /*  Is this a persistent worker?      */
   GPid                 pid;             /*  Plug-in's process id              */
 
   GIOChannel          *my_read;         /*  App's read and write channels     */
@@ -68,6 +69,9 @@ struct _GimpPlugIn
   GList               *temp_proc_frames;
 
   GimpPlugInDef       *plug_in_def;     /*  Valid during query() and init()   */
+
+  gint                 n_runs;          /*  Procedures run by this worker     */
+  gint64               idle_since;      /*  When this worker was released     */
 };
 
 struct _GimpPlugInClass
@@ -89,6 +93,8 @@ gboolean      gimp_plug_in_open              (GimpPlugIn             *plug_in,
                                               gboolean                synchronous);
 void          gimp_plug_in_close             (GimpPlugIn             *plug_in,
                                               gboolean                kill_it);
+void          gimp_plug_in_set_idle          (GimpPlugIn             *plug_in,
+                                              gboolean                idle);
 
 GimpPlugInProcFrame *
               gimp_plug_in_get_proc_frame    (GimpPlugIn             *plug_in);
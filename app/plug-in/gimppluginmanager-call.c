@@ -49,12 +49,21 @@
 #include "gimppluginmanager.h"
 #define __YES_I_NEED_GIMP_PLUG_IN_MANAGER_CALL__
 #include "gimppluginmanager-call.h"
+#include "gimppluginmanager-workers.h"
 #include "gimppluginshm.h"
 #include "gimptemporaryprocedure.h"
 
 #include "gimp-intl.h"
 
 
+typedef struct
+{
+  GimpPlugIn    *plug_in;
+  GimpPlugInDef *plug_in_def;
+  gint64         start_time;
+} GimpPlugInCall;
+
+
 static void
 gimp_allow_set_foreground_window (GimpPlugIn *plug_in)
 {
@@ -63,6 +72,21 @@ gimp_allow_set_foreground_window (GimpPlugIn *plug_in)
 #endif
 }
 
+static void
+gimp_plug_in_manager_call_finish (GimpPlugInCall         *call,
+                                  GimpPlugInCallDoneFunc  done_func,
+                                  gpointer                user_data)
+{
+  g_clear_object (&call->plug_in);
+
+  if (done_func)
+    {
+      done_func (call->plug_in_def,
+                 g_get_monotonic_time () - call->start_time,
+                 user_data);
+    }
+}
+
 
 /*  public functions  */
 
@@ -71,79 +95,162 @@ gimp_plug_in_manager_call_query (GimpPlugInManager *manager,
                                  GimpContext       *context,
                                  GimpPlugInDef     *plug_in_def)
 {
-  GimpPlugIn *plug_in;
+  GSList list = { plug_in_def, NULL };
 
   g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
   g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
   g_return_if_fail (GIMP_IS_PLUG_IN_DEF (plug_in_def));
 
-  plug_in = gimp_plug_in_new (manager, context, NULL,
-                              NULL, plug_in_def->file);
+  gimp_plug_in_manager_call_many (manager, context, GIMP_PLUG_IN_CALL_QUERY,
+                                  &list, 1, NULL, NULL);
+}
 
-  if (plug_in)
+void
+gimp_plug_in_manager_call_init (GimpPlugInManager *manager,
+                                GimpContext       *context,
+                                GimpPlugInDef     *plug_in_def)
+{
+  GSList list = { plug_in_def, NULL };
+
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+  g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
+  g_return_if_fail (GIMP_IS_PLUG_IN_DEF (plug_in_def));
+
+  gimp_plug_in_manager_call_many (manager, context, GIMP_PLUG_IN_CALL_INIT,
+                                  &list, 1, NULL, NULL);
+}
+
+/*  Each plug-in's messages are handled in the order it sent them, and
+ *  everything a plug-in registers in query() and init() is kept in its
+ *  GimpPlugInDef, so the result doesn't depend on how the running
+ *  plug-ins interleave.  done_func is called in the order the plug-ins
+ *  finish.
+ */
+void
+gimp_plug_in_manager_call_many (GimpPlugInManager      *manager,
+                                GimpContext            *context,
+                                GimpPlugInCallMode      call_mode,
+                                GSList                 *plug_in_defs,
+                                gint                    max_running,
+                                GimpPlugInCallDoneFunc  done_func,
+                                gpointer                user_data)
+{
+  GArray *running;
+  GArray *poll_fds;
+  GSList *list;
+
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+  g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
+  g_return_if_fail (call_mode == GIMP_PLUG_IN_CALL_QUERY ||
+                    call_mode == GIMP_PLUG_IN_CALL_INIT);
+
+  /*  don't confuse the debugger with several plug-ins at once  */
+  if (manager->debug)
+    max_running = 1;
+
+  max_running = MAX (max_running, 1);
+
+  running  = g_array_new (FALSE, FALSE, sizeof (GimpPlugInCall));
+  poll_fds = g_array_new (FALSE, FALSE, sizeof (GPollFD));
+
+  list = plug_in_defs;
+
+  while (list || running->len > 0)
     {
-      plug_in->plug_in_def = plug_in_def;
+      gint i;
 
-      if (gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_QUERY, TRUE))
+      while (list && running->len < max_running)
         {
-          while (plug_in->open)
+          GimpPlugInDef  *plug_in_def = list->data;
+          GimpPlugInCall  call;
+
+          list = list->next;
+
+          call.plug_in_def = plug_in_def;
+          call.start_time  = g_get_monotonic_time ();
+          call.plug_in     = gimp_plug_in_new (manager, context, NULL,
+                                               NULL, plug_in_def->file);
+
+          if (call.plug_in)
             {
-              GimpWireMessage msg;
+              call.plug_in->plug_in_def = plug_in_def;
 
-              if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
-                {
-                  gimp_plug_in_close (plug_in, TRUE);
-                }
-              else
+              if (gimp_plug_in_open (call.plug_in, call_mode, TRUE))
                 {
-                  gimp_plug_in_handle_message (plug_in, &msg);
-                  gimp_wire_destroy (&msg);
+                  g_array_append_val (running, call);
+
+                  continue;
                 }
             }
+
+          gimp_plug_in_manager_call_finish (&call, done_func, user_data);
         }
 
-      g_object_unref (plug_in);
-    }
-}
+      if (running->len == 0)
+        continue;
 
-void
-gimp_plug_in_manager_call_init (GimpPlugInManager *manager,
-                                GimpContext       *context,
-                                GimpPlugInDef     *plug_in_def)
-{
-  GimpPlugIn *plug_in;
+      g_array_set_size (poll_fds, running->len);
 
-  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
-  g_return_if_fail (GIMP_IS_PDB_CONTEXT (context));
-  g_return_if_fail (GIMP_IS_PLUG_IN_DEF (plug_in_def));
+      for (i = 0; i < running->len; i++)
+        {
+          GimpPlugInCall *call = &g_array_index (running, GimpPlugInCall, i);
+          GPollFD        *fd   = &g_array_index (poll_fds, GPollFD, i);
 
-  plug_in = gimp_plug_in_new (manager, context, NULL,
-                              NULL, plug_in_def->file);
+#ifdef G_OS_WIN32
+          g_io_channel_win32_make_pollfd (call->plug_in->my_read,
+                                          G_IO_IN | G_IO_ERR | G_IO_HUP,
+                                          fd);
+#else
+          fd->fd     = g_io_channel_unix_get_fd (call->plug_in->my_read);
+          fd->events = G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP;
+#endif
+          fd->revents = 0;
+        }
 
-  if (plug_in)
-    {
-      plug_in->plug_in_def = plug_in_def;
+      if (g_poll ((GPollFD *) poll_fds->data, poll_fds->len, -1) < 0)
+        continue;
 
-      if (gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_INIT, TRUE))
+      for (i = 0; i < running->len; i++)
         {
-          while (plug_in->open)
+          GimpPlugInCall *call = &g_array_index (running, GimpPlugInCall, i);
+          GPollFD        *fd   = &g_array_index (poll_fds, GPollFD, i);
+
+          if (fd->revents)
             {
               GimpWireMessage msg;
 
-              if (! gimp_wire_read_msg (plug_in->my_read, &msg, plug_in))
+              if (! gimp_wire_read_msg (call->plug_in->my_read, &msg,
+                                        call->plug_in))
                 {
-                  gimp_plug_in_close (plug_in, TRUE);
+                  gimp_plug_in_close (call->plug_in, TRUE);
                 }
               else
                 {
-                  gimp_plug_in_handle_message (plug_in, &msg);
+                  gimp_plug_in_handle_message (call->plug_in, &msg);
                   gimp_wire_destroy (&msg);
                 }
             }
         }
 
-      g_object_unref (plug_in);
+      for (i = 0; i < running->len; )
+        {
+          GimpPlugInCall *call = &g_array_index (running, GimpPlugInCall, i);
+
+          if (! call->plug_in->open)
+            {
+              gimp_plug_in_manager_call_finish (call, done_func, user_data);
+
+              g_array_remove_index (running, i);
+            }
+          else
+            {
+              i++;
+            }
+        }
     }
+
+  g_array_free (poll_fds, TRUE);
+  g_array_free (running,  TRUE);
 }
 
 GimpValueArray *
@@ -156,7 +263,8 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
                                GimpDisplay         *display)
 {
   GimpValueArray *return_vals = NULL;
-  GimpPlugIn     *plug_in;
+  GimpPlugIn     *plug_in     = NULL;
+  gboolean        worker;
 
   g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), NULL);
   g_return_val_if_fail (GIMP_IS_PDB_CONTEXT (context), NULL);
@@ -165,7 +273,20 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
   g_return_val_if_fail (args != NULL, NULL);
   g_return_val_if_fail (display == NULL || GIMP_IS_DISPLAY (display), NULL);
 
-  plug_in = gimp_plug_in_new (manager, context, progress, procedure, NULL);
+  worker = gimp_plug_in_manager_workers_use (manager, procedure, args,
+                                             synchronous);
+
+  if (worker)
+    plug_in = gimp_plug_in_manager_workers_take (manager, context, progress,
+                                                 procedure);
+
+  if (! plug_in)
+    {
+      plug_in = gimp_plug_in_new (manager, context, progress, procedure, NULL);
+
+      if (plug_in)
+        plug_in->worker = worker;
+    }
 
   if (plug_in)
     {
@@ -179,7 +300,9 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
       GObject           *monitor;
       GFile             *icon_theme_dir;
 
-      if (! gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_RUN, FALSE))
+      /*  a warm worker taken from the pool is already running  */
+      if (! plug_in->open &&
+          ! gimp_plug_in_open (plug_in, GIMP_PLUG_IN_CALL_RUN, FALSE))
         {
           const gchar *name  = gimp_object_get_name (plug_in);
           GError      *error = g_error_new (GIMP_PLUG_IN_ERROR,
@@ -239,6 +362,9 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
       proc_run.n_params = gimp_value_array_length (args);
       proc_run.params   = _gimp_value_array_to_gp_params (args, FALSE);
 
+      /*  send GP_CONFIG before every run, also to a warm worker, so that
+       *  it always gets the current display, timestamp and settings
+       */
       if (! gp_config_write (plug_in->my_write, &config, plug_in)     ||
           ! gp_proc_run_write (plug_in->my_write, &proc_run, plug_in) ||
           ! gimp_wire_flush (plug_in->my_write, plug_in))
@@ -254,6 +380,12 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
 
           _gimp_gp_params_free (proc_run.params, proc_run.n_params, FALSE);
 
+          /*  don't leave a broken plug-in, possibly a worker that died
+           *  while it was idle, running and registered as open
+           */
+          if (plug_in->open)
+            gimp_plug_in_close (plug_in, TRUE);
+
           g_object_unref (plug_in);
 
           return_vals = gimp_procedure_get_return_values (GIMP_PROCEDURE (procedure),
@@ -298,6 +430,9 @@ gimp_plug_in_manager_call_run (GimpPlugInManager   *manager,
           g_clear_pointer (&proc_frame->main_loop, g_main_loop_unref);
 
           return_vals = gimp_plug_in_proc_frame_get_return_values (proc_frame);
+
+          if (plug_in->worker)
+            gimp_plug_in_manager_workers_release (manager, plug_in);
         }
 
       g_object_unref (plug_in);
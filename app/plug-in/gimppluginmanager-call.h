@@ -25,6 +25,11 @@
 #endif
 
 
+typedef void (* GimpPlugInCallDoneFunc) (GimpPlugInDef *plug_in_def,
+                                         gint64         duration,
+                                         gpointer       user_data);
+
+
 /*  Call the plug-in's query() function
  */
 void             gimp_plug_in_manager_call_query    (GimpPlugInManager      *manager,
@@ -37,6 +42,17 @@ void             gimp_plug_in_manager_call_init     (GimpPlugInManager      *man
                                                      GimpContext            *context,
                                                      GimpPlugInDef          *plug_in_def);
 
+/*  Call the query() or init() function of each plug-in in a list,
+ *  running up to max_running plug-ins at once
+ */
+void             gimp_plug_in_manager_call_many     (GimpPlugInManager      *manager,
+                                                     GimpContext            *context,
+                                                     GimpPlugInCallMode      call_mode,
+                                                     GSList                 *plug_in_defs,
+                                                     gint                    max_running,
+                                                     GimpPlugInCallDoneFunc  done_func,
+                                                     gpointer                user_data);
+
 /*  Run a plug-in as if it were a procedure database procedure
  */
 GimpValueArray * gimp_plug_in_manager_call_run      (GimpPlugInManager      *manager,
@@ -45,13 +45,25 @@
 #include "gimppluginmanager-file.h"
 #include "gimppluginmanager-help-domain.h"
 #include "gimppluginmanager-locale-domain.h"
+#include "gimppluginmanager-menu-branch.h"
 #include "gimppluginmanager-restore.h"
 #include "gimppluginprocedure.h"
 #include "plug-in-rc.h"
+#include "plug-in-rc-cache.h"
 
 #include "gimp-intl.h"
 
 
+typedef struct
+{
+  GimpPlugInManager  *manager;
+  GimpPlugInCallMode  call_mode;
+  GimpInitStatusFunc  status_callback;
+  gint                nth;
+  gint                n_plugins;
+} CallStatus;
+
+
 static void    gimp_plug_in_manager_search            (GimpPlugInManager    *manager,
                                                        GimpInitStatusFunc    status_callback);
 static void    gimp_plug_in_manager_search_directory  (GimpPlugInManager    *manager,
@@ -66,6 +78,20 @@ static void    gimp_plug_in_manager_query_new         (GimpPlugInManager    *man
 static void    gimp_plug_in_manager_init_plug_ins     (GimpPlugInManager    *manager,
                                                        GimpContext          *context,
                                                        GimpInitStatusFunc    status_callback);
+static void    gimp_plug_in_manager_call_plug_ins     (GimpPlugInManager    *manager,
+                                                       GimpContext          *context,
+                                                       GimpPlugInCallMode    call_mode,
+                                                       GSList               *plug_in_defs,
+                                                       GimpInitStatusFunc    status_callback);
+static void    gimp_plug_in_manager_call_done         (GimpPlugInDef        *plug_in_def,
+                                                       gint64                duration,
+                                                       CallStatus           *status);
+static void    gimp_plug_in_manager_sort_branches     (GimpPlugInManager    *manager,
+                                                       GSList               *plug_in_defs,
+                                                       guint                 n_branches);
+static gint    gimp_plug_in_manager_branch_compare    (gconstpointer         a,
+                                                       gconstpointer         b,
+                                                       gpointer              data);
 static void    gimp_plug_in_manager_run_extensions    (GimpPlugInManager    *manager,
                                                        GimpContext          *context,
                                                        GimpInitStatusFunc    status_callback);
@@ -142,6 +168,15 @@ gimp_plug_in_manager_restore (GimpPlugInManager  *manager,
                                 NULL, GIMP_MESSAGE_ERROR, error->message);
           g_clear_error (&error);
         }
+      else if (! plug_in_rc_cache_write (manager->plug_in_defs, pluginrc,
+                                         &error))
+        {
+          /* the cache is optional, pluginrc will be parsed instead */
+          if (gimp->be_verbose)
+            g_print ("Failed to write pluginrc cache: %s\n", error->message);
+
+          g_clear_error (&error);
+        }
 
       manager->write_pluginrc = FALSE;
     }
@@ -425,15 +460,42 @@ gimp_plug_in_manager_read_pluginrc (GimpPlugInManager  *manager,
                                     GimpInitStatusFunc  status_callback)
 {
   GSList *rc_defs;
+  gint64  start_time;
   GError *error = NULL;
 
   status_callback (_("Resource configuration"),
                    gimp_file_get_utf8_name (pluginrc), 0.0);
 
-  if (manager->gimp->be_verbose)
-    g_print ("Parsing '%s'\n", gimp_file_get_utf8_name (pluginrc));
+  start_time = g_get_monotonic_time ();
+
+  /* prefer the binary copy of pluginrc, if it's up to date */
+  rc_defs = plug_in_rc_cache_parse (manager->gimp, pluginrc, &error);
+
+  if (! rc_defs)
+    {
+      /* a missing pluginrc is handled below */
+      if (error && ! g_error_matches (error,
+                                      GIMP_CONFIG_ERROR,
+                                      GIMP_CONFIG_ERROR_OPEN_ENOENT))
+        {
+          if (manager->gimp->be_verbose)
+            g_print ("Not using pluginrc cache: %s\n", error->message);
 
-  rc_defs = plug_in_rc_parse (manager->gimp, pluginrc, &error);
+          /* regenerate the cache */
+          manager->write_pluginrc = TRUE;
+        }
+
+      g_clear_error (&error);
+
+      if (manager->gimp->be_verbose)
+        g_print ("Parsing '%s'\n", gimp_file_get_utf8_name (pluginrc));
+
+      rc_defs = plug_in_rc_parse (manager->gimp, pluginrc, &error);
+    }
+
+  if (manager->gimp->be_verbose)
+    g_print ("Reading pluginrc took %.3f s\n",
+             (g_get_monotonic_time () - start_time) / 1000000.0);
 
   if (rc_defs)
     {
@@ -460,46 +522,30 @@ gimp_plug_in_manager_query_new (GimpPlugInManager  *manager,
                                 GimpContext        *context,
                                 GimpInitStatusFunc  status_callback)
 {
+  GSList *plug_in_defs = NULL;
   GSList *list;
-  gint    n_plugins;
 
   status_callback (_("Querying new Plug-ins"), "", 0.0);
 
-  for (list = manager->plug_in_defs, n_plugins = 0; list; list = list->next)
+  for (list = manager->plug_in_defs; list; list = list->next)
     {
       GimpPlugInDef *plug_in_def = list->data;
 
       if (plug_in_def->needs_query)
-        n_plugins++;
+        plug_in_defs = g_slist_prepend (plug_in_defs, plug_in_def);
     }
 
-  if (n_plugins)
+  if (plug_in_defs)
     {
-      gint nth;
-
       manager->write_pluginrc = TRUE;
 
-      for (list = manager->plug_in_defs, nth = 0; list; list = list->next)
-        {
-          GimpPlugInDef *plug_in_def = list->data;
-
-          if (plug_in_def->needs_query)
-            {
-              gchar *basename;
+      plug_in_defs = g_slist_reverse (plug_in_defs);
 
-              basename =
-                g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
-              status_callback (NULL, basename,
-                               (gdouble) nth++ / (gdouble) n_plugins);
-              g_free (basename);
+      gimp_plug_in_manager_call_plug_ins (manager, context,
+                                          GIMP_PLUG_IN_CALL_QUERY,
+                                          plug_in_defs, status_callback);
 
-              if (manager->gimp->be_verbose)
-                g_print ("Querying plug-in: '%s'\n",
-                         gimp_file_get_utf8_name (plug_in_def->file));
-
-              gimp_plug_in_manager_call_query (manager, context, plug_in_def);
-            }
-        }
+      g_slist_free (plug_in_defs);
     }
 
   status_callback (NULL, "", 1.0);
@@ -511,47 +557,148 @@ gimp_plug_in_manager_init_plug_ins (GimpPlugInManager  *manager,
                                     GimpContext        *context,
                                     GimpInitStatusFunc  status_callback)
 {
+  GSList *plug_in_defs = NULL;
   GSList *list;
-  gint    n_plugins;
 
   status_callback (_("Initializing Plug-ins"), "", 0.0);
 
-  for (list = manager->plug_in_defs, n_plugins = 0; list; list = list->next)
+  for (list = manager->plug_in_defs; list; list = list->next)
     {
       GimpPlugInDef *plug_in_def = list->data;
 
       if (plug_in_def->has_init)
-        n_plugins++;
+        plug_in_defs = g_slist_prepend (plug_in_defs, plug_in_def);
     }
 
-  if (n_plugins)
+  if (plug_in_defs)
     {
-      gint nth;
+      plug_in_defs = g_slist_reverse (plug_in_defs);
 
-      for (list = manager->plug_in_defs, nth = 0; list; list = list->next)
-        {
-          GimpPlugInDef *plug_in_def = list->data;
+      gimp_plug_in_manager_call_plug_ins (manager, context,
+                                          GIMP_PLUG_IN_CALL_INIT,
+                                          plug_in_defs, status_callback);
 
-          if (plug_in_def->has_init)
-            {
-              gchar *basename;
+      g_slist_free (plug_in_defs);
+    }
+
+  status_callback (NULL, "", 1.0);
+}
 
-              basename =
-                g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
-              status_callback (NULL, basename,
-                               (gdouble) nth++ / (gdouble) n_plugins);
-              g_free (basename);
+/* call the query() or init() functions of the plug-ins, running as many
+ * of them at once as we use threads
+ */
+static void
+gimp_plug_in_manager_call_plug_ins (GimpPlugInManager  *manager,
+                                    GimpContext        *context,
+                                    GimpPlugInCallMode  call_mode,
+                                    GSList             *plug_in_defs,
+                                    GimpInitStatusFunc  status_callback)
+{
+  GimpGeglConfig *config = GIMP_GEGL_CONFIG (manager->gimp->config);
+  CallStatus      status;
+  guint           n_branches;
+  gint64          start_time;
+
+  status.manager         = manager;
+  status.call_mode       = call_mode;
+  status.status_callback = status_callback;
+  status.nth             = 0;
+  status.n_plugins       = g_slist_length (plug_in_defs);
+
+  n_branches = g_slist_length (manager->menu_branches);
+  start_time = g_get_monotonic_time ();
+
+  gimp_plug_in_manager_call_many (manager, context, call_mode, plug_in_defs,
+                                  config->num_processors,
+                                  (GimpPlugInCallDoneFunc)
+                                  gimp_plug_in_manager_call_done,
+                                  &status);
+
+  /* the plug-ins' menu branches were added in the order the plug-ins
+   * happened to send them, restore the order of the plug-ins
+   */
+  gimp_plug_in_manager_sort_branches (manager, plug_in_defs, n_branches);
 
-              if (manager->gimp->be_verbose)
-                g_print ("Initializing plug-in: '%s'\n",
-                         gimp_file_get_utf8_name (plug_in_def->file));
+  if (manager->gimp->be_verbose)
+    g_print ("%s %d plug-ins took %.3f s\n",
+             call_mode == GIMP_PLUG_IN_CALL_QUERY ? "Querying" : "Initializing",
+             status.n_plugins,
+             (g_get_monotonic_time () - start_time) / 1000000.0);
+}
 
-              gimp_plug_in_manager_call_init (manager, context, plug_in_def);
-            }
-        }
+static void
+gimp_plug_in_manager_call_done (GimpPlugInDef *plug_in_def,
+                                gint64         duration,
+                                CallStatus    *status)
+{
+  gchar *basename;
+
+  basename = g_path_get_basename (gimp_file_get_utf8_name (plug_in_def->file));
+  status->status_callback (NULL, basename,
+                           (gdouble) ++status->nth /
+                           (gdouble) status->n_plugins);
+  g_free (basename);
+
+  if (status->manager->gimp->be_verbose)
+    g_print ("%s plug-in: '%s' (%.3f s)\n",
+             status->call_mode == GIMP_PLUG_IN_CALL_QUERY ?
+             "Queried" : "Initialized",
+             gimp_file_get_utf8_name (plug_in_def->file),
+             duration / 1000000.0);
+}
+
+static void
+gimp_plug_in_manager_sort_branches (GimpPlugInManager *manager,
+                                    GSList            *plug_in_defs,
+                                    guint              n_branches)
+{
+  GHashTable *order;
+  GSList     *list;
+  gint        i;
+
+  if (g_slist_length (manager->menu_branches) < n_branches + 2)
+    return;
+
+  order = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+
+  for (list = plug_in_defs, i = 0; list; list = list->next, i++)
+    {
+      GimpPlugInDef *plug_in_def = list->data;
+
+      g_hash_table_insert (order, plug_in_def->file, GINT_TO_POINTER (i));
     }
 
-  status_callback (NULL, "", 1.0);
+  /*  g_slist_sort() is stable, so each plug-in's branches keep their order  */
+  if (n_branches == 0)
+    {
+      manager->menu_branches =
+        g_slist_sort_with_data (manager->menu_branches,
+                                gimp_plug_in_manager_branch_compare,
+                                order);
+    }
+  else
+    {
+      list = g_slist_nth (manager->menu_branches, n_branches - 1);
+
+      list->next = g_slist_sort_with_data (list->next,
+                                           gimp_plug_in_manager_branch_compare,
+                                           order);
+    }
+
+  g_hash_table_unref (order);
+}
+
+static gint
+gimp_plug_in_manager_branch_compare (gconstpointer a,
+                                     gconstpointer b,
+                                     gpointer      data)
+{
+  const GimpPlugInMenuBranch *branch_a = a;
+  const GimpPlugInMenuBranch *branch_b = b;
+  GHashTable                 *order    = data;
+
+  return (GPOINTER_TO_INT (g_hash_table_lookup (order, branch_a->file)) -
+          GPOINTER_TO_INT (g_hash_table_lookup (order, branch_b->file)));
 }
 
 /* run automatically started extensions */
@@ -0,0 +1,284 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimppluginmanager-workers.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpbase/gimpprotocol.h"
+
+#include "plug-in-types.h"
+
+#include "config/gimpcoreconfig.h"
+
+#include "core/gimp.h"
+
+#include "gimpplugin.h"
+#include "gimppluginmanager.h"
+#include "gimppluginmanager-workers.h"
+#include "gimppluginprocedure.h"
+
+
+/*  a worker is retired after this many calls, to bound whatever
+ *  memory or state a plug-in leaks from one call to the next
+ */
+#define GIMP_PLUG_IN_WORKER_MAX_RUNS      256
+
+/*  idle workers are closed after this many seconds  */
+#define GIMP_PLUG_IN_WORKER_IDLE_TIMEOUT  60
+
+
+static gboolean   gimp_plug_in_manager_workers_timeout (GimpPlugInManager *manager);
+
+static gboolean   gimp_plug_in_worker_is_alive         (GimpPlugIn        *plug_in);
+static void       gimp_plug_in_worker_retire           (GimpPlugIn        *plug_in);
+
+
+/*  public functions  */
+
+void
+gimp_plug_in_manager_workers_exit (GimpPlugInManager *manager)
+{
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+
+  if (manager->workers_timeout_id)
+    {
+      g_source_remove (manager->workers_timeout_id);
+      manager->workers_timeout_id = 0;
+    }
+
+  g_list_free_full (manager->workers,
+                    (GDestroyNotify) gimp_plug_in_worker_retire);
+  manager->workers = NULL;
+}
+
+gboolean
+gimp_plug_in_manager_workers_use (GimpPlugInManager   *manager,
+                                  GimpPlugInProcedure *procedure,
+                                  GimpValueArray      *args,
+                                  gboolean             synchronous)
+{
+  GValue *run_mode;
+
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), FALSE);
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_PROCEDURE (procedure), FALSE);
+  g_return_val_if_fail (args != NULL, FALSE);
+
+  if (manager->gimp->config->plug_in_workers < 1 || ! synchronous)
+    return FALSE;
+
+  /*  a debugger wrapped around the plug-in expects it to exit  */
+  if (manager->debug)
+    return FALSE;
+
+  if (GIMP_PROCEDURE (procedure)->proc_type != GIMP_PDB_PROC_TYPE_PLUGIN)
+    return FALSE;
+
+  /*  an interactive call may leave dialogs or other user visible
+   *  state behind in the plug-in, only reuse non-interactive ones
+   */
+  if (gimp_value_array_length (args) < 1)
+    return FALSE;
+
+  run_mode = gimp_value_array_index (args, 0);
+
+  return (G_VALUE_HOLDS (run_mode, GIMP_TYPE_RUN_MODE) &&
+          g_value_get_enum (run_mode) == GIMP_RUN_NONINTERACTIVE);
+}
+
+GimpPlugIn *
+gimp_plug_in_manager_workers_take (GimpPlugInManager   *manager,
+                                   GimpContext         *context,
+                                   GimpProgress        *progress,
+                                   GimpPlugInProcedure *procedure)
+{
+  GFile *file;
+  GList *list;
+
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager), NULL);
+  g_return_val_if_fail (GIMP_IS_PLUG_IN_PROCEDURE (procedure), NULL);
+
+  file = gimp_plug_in_procedure_get_file (procedure);
+
+  list = manager->workers;
+
+  while (list)
+    {
+      GimpPlugIn *plug_in = list->data;
+      GList      *next    = g_list_next (list);
+
+      if (g_file_equal (plug_in->file, file))
+        {
+          manager->workers = g_list_delete_link (manager->workers, list);
+
+          if (gimp_plug_in_worker_is_alive (plug_in))
+            {
+              gimp_plug_in_proc_frame_init (&plug_in->main_proc_frame,
+                                            context, progress, procedure);
+
+              gimp_plug_in_set_idle (plug_in, FALSE);
+
+              return plug_in;
+            }
+
+          gimp_plug_in_worker_retire (plug_in);
+        }
+
+      list = next;
+    }
+
+  return NULL;
+}
+
+void
+gimp_plug_in_manager_workers_release (GimpPlugInManager *manager,
+                                      GimpPlugIn        *plug_in)
+{
+  gint max_workers;
+
+  g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
+  g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
+  g_return_if_fail (plug_in->worker);
+
+  /*  the worker crashed or quit on its own  */
+  if (! plug_in->open)
+    return;
+
+  plug_in->n_runs++;
+
+  /*  clean up after the call, the next one initializes the frame again  */
+  gimp_plug_in_proc_frame_dispose (&plug_in->main_proc_frame, plug_in);
+
+  max_workers = manager->gimp->config->plug_in_workers;
+
+  if (max_workers < 1                                  ||
+      plug_in->n_runs >= GIMP_PLUG_IN_WORKER_MAX_RUNS  ||
+      plug_in->temp_procedures                         ||
+      plug_in->temp_proc_frames)
+    {
+      gp_quit_write (plug_in->my_write, plug_in);
+      gimp_plug_in_close (plug_in, FALSE);
+
+      return;
+    }
+
+  gimp_plug_in_set_idle (plug_in, TRUE);
+
+  plug_in->idle_since = g_get_monotonic_time ();
+
+  manager->workers = g_list_prepend (manager->workers,
+                                     g_object_ref (plug_in));
+
+  /*  keep the most recently used workers  */
+  while (g_list_length (manager->workers) > max_workers)
+    {
+      GList *last = g_list_last (manager->workers);
+
+      gimp_plug_in_worker_retire (last->data);
+
+      manager->workers = g_list_delete_link (manager->workers, last);
+    }
+
+  if (! manager->workers_timeout_id)
+    manager->workers_timeout_id =
+      g_timeout_add_seconds (GIMP_PLUG_IN_WORKER_IDLE_TIMEOUT / 4,
+                             (GSourceFunc) gimp_plug_in_manager_workers_timeout,
+                             manager);
+}
+
+
+/*  private functions  */
+
+static gboolean
+gimp_plug_in_manager_workers_timeout (GimpPlugInManager *manager)
+{
+  gint64  now  = g_get_monotonic_time ();
+  GList  *list = manager->workers;
+
+  while (list)
+    {
+      GimpPlugIn *plug_in = list->data;
+      GList      *next    = g_list_next (list);
+
+      if (now - plug_in->idle_since >=
+          GIMP_PLUG_IN_WORKER_IDLE_TIMEOUT * G_TIME_SPAN_SECOND)
+        {
+          manager->workers = g_list_delete_link (manager->workers, list);
+
+          gimp_plug_in_worker_retire (plug_in);
+        }
+
+      list = next;
+    }
+
+  if (manager->workers)
+    return G_SOURCE_CONTINUE;
+
+  manager->workers_timeout_id = 0;
+
+  return G_SOURCE_REMOVE;
+}
+
+/*  an idle worker must be silent, if its pipe is readable it either
+ *  exited or wrote something out of turn, and can't be trusted
+ */
+static gboolean
+gimp_plug_in_worker_is_alive (GimpPlugIn *plug_in)
+{
+  GPollFD fd;
+
+  if (! plug_in->open)
+    return FALSE;
+
+#ifdef G_OS_WIN32
+  g_io_channel_win32_make_pollfd (plug_in->my_read,
+                                  G_IO_IN | G_IO_ERR | G_IO_HUP,
+                                  &fd);
+#else
+  fd.fd     = g_io_channel_unix_get_fd (plug_in->my_read);
+  fd.events = G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP;
+#endif
+  fd.revents = 0;
+
+  return g_poll (&fd, 1, 0) == 0;
+}
+
+static void
+gimp_plug_in_worker_retire (GimpPlugIn *plug_in)
+{
+  if (plug_in->open)
+    {
+      if (gimp_plug_in_worker_is_alive (plug_in))
+        {
+          /*  let it exit on its own, it's idle and not holding any
+           *  state, so there is no need to block on killing it
+           */
+          gp_quit_write (plug_in->my_write, plug_in);
+          gimp_plug_in_close (plug_in, FALSE);
+        }
+      else
+        {
+          gimp_plug_in_close (plug_in, TRUE);
+        }
+    }
+
+  g_object_unref (plug_in);
+}
@@ -0,0 +1,43 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * gimppluginmanager-workers.h
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GIMP_PLUG_IN_MANAGER_WORKERS_H__
+#define __GIMP_PLUG_IN_MANAGER_WORKERS_H__
+
+
+void         gimp_plug_in_manager_workers_exit    (GimpPlugInManager   *manager);
+
+/* Whether a call may be run by a worker */
+gboolean     gimp_plug_in_manager_workers_use     (GimpPlugInManager   *manager,
+                                                   GimpPlugInProcedure *procedure,
+                                                   GimpValueArray      *args,
+                                                   gboolean             synchronous);
+
+/* Take an idle worker for @procedure out of the pool, or NULL */
+GimpPlugIn * gimp_plug_in_manager_workers_take    (GimpPlugInManager   *manager,
+                                                   GimpContext         *context,
+                                                   GimpProgress        *progress,
+                                                   GimpPlugInProcedure *procedure);
+
+/* Give a worker back to the pool after its call returned */
+void         gimp_plug_in_manager_workers_release (GimpPlugInManager   *manager,
+                                                   GimpPlugIn          *plug_in);
+
+
+#endif /* __GIMP_PLUG_IN_MANAGER_WORKERS_H__ */
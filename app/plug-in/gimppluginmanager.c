@@ -48,6 +48,7 @@
 #include "gimppluginmanager-help-domain.h"
 #include "gimppluginmanager-locale-domain.h"
 #include "gimppluginmanager-menu-branch.h"
+#include "gimppluginmanager-workers.h"
 #include "gimppluginshm.h"
 #include "gimptemporaryprocedure.h"
 
@@ -262,6 +263,8 @@ gimp_plug_in_manager_exit (GimpPlugInManager *manager)
 {
   g_return_if_fail (GIMP_IS_PLUG_IN_MANAGER (manager));
 
+  gimp_plug_in_manager_workers_exit (manager);
+
   while (manager->open_plug_ins)
     gimp_plug_in_close (manager->open_plug_ins->data, TRUE);
 
@@ -62,6 +62,9 @@ struct _GimpPlugInManager
   GSList            *open_plug_ins;
   GSList            *plug_in_stack;
 
+  GList             *workers;
+  guint              workers_timeout_id;
+
   GimpPlugInShm     *shm;
   GimpInterpreterDB *interpreter_db;
   GimpEnvironTable  *environ_table;
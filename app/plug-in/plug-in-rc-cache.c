@@ -0,0 +1,1133 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * plug-in-rc-cache.c
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*  A binary copy of pluginrc, which is written next to it, and read
+ *  instead of it as long as pluginrc itself is unchanged.
+ *
+ *  The file is a header, followed by a stream of records, followed by
+ *  a string table.  All numbers are little-endian; strings are stored
+ *  once in the string table, NUL-terminated, and referenced by their
+ *  offset.  The file is mapped, and strings are copied straight out of
+ *  the mapping, so reading it doesn't involve any tokenizing.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gegl.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpbase/gimpprotocol.h"
+#include "libgimpconfig/gimpconfig.h"
+
+#include "libgimp/gimpgpparams.h"
+
+#include "plug-in-types.h"
+
+#include "core/gimp.h"
+
+#include "gimpplugindef.h"
+#include "gimppluginprocedure.h"
+#include "plug-in-rc.h"
+#include "plug-in-rc-cache.h"
+
+#include "gimp-intl.h"
+
+
+#define PLUG_IN_RC_CACHE_MAGIC   "GIMPPRC\n"
+#define PLUG_IN_RC_CACHE_VERSION 2
+#define PLUG_IN_RC_CACHE_SUFFIX  ".cache"
+
+#define NO_STRING                G_MAXUINT32
+
+#define FLAG_HAS_INIT            (1 << 0)
+
+#define FLAG_FILE_PROC           (1 << 0)
+#define FLAG_HANDLES_REMOTE      (1 << 1)
+#define FLAG_HANDLES_RAW         (1 << 2)
+
+
+typedef struct
+{
+  GByteArray *records;
+  GByteArray *strings;
+  GHashTable *string_offsets;
+} CacheWriter;
+
+typedef struct
+{
+  const guint8 *data;
+  const guint8 *end;
+  const gchar  *strings;
+  gsize         strings_size;
+  gboolean      error;
+} CacheReader;
+
+
+static GFile               * plug_in_rc_cache_get_file  (GFile               *pluginrc);
+static gboolean              plug_in_rc_cache_get_stamp (GFile               *pluginrc,
+                                                         guint64             *mtime,
+                                                         guint32             *mtime_usec,
+                                                         guint64             *size,
+                                                         GError             **error);
+
+static GimpPlugInDef       * plug_in_def_read           (CacheReader         *reader,
+                                                         Gimp                *gimp);
+static GimpPlugInProcedure * plug_in_procedure_read     (CacheReader         *reader,
+                                                         GFile               *file);
+static void                  plug_in_proc_arg_read      (CacheReader         *reader,
+                                                         GimpProcedure       *procedure,
+                                                         gboolean             return_value);
+
+static void                  plug_in_def_write          (CacheWriter         *writer,
+                                                         GimpPlugInDef       *plug_in_def,
+                                                         const gchar         *path);
+static void                  plug_in_procedure_write    (CacheWriter         *writer,
+                                                         GimpPlugInProcedure *proc);
+static void                  plug_in_proc_arg_write     (CacheWriter         *writer,
+                                                         GParamSpec          *pspec);
+
+static guint32               cache_read_uint32          (CacheReader         *reader);
+static gint32                cache_read_int32           (CacheReader         *reader);
+static guint64               cache_read_uint64          (CacheReader         *reader);
+static gint64                cache_read_int64           (CacheReader         *reader);
+static gdouble               cache_read_double          (CacheReader         *reader);
+static const gchar         * cache_read_string          (CacheReader         *reader);
+static const guint8        * cache_read_data            (CacheReader         *reader,
+                                                         gsize               *length);
+
+static void                  cache_write_uint32         (GByteArray          *array,
+                                                         guint32              value);
+static void                  cache_write_uint64         (GByteArray          *array,
+                                                         guint64              value);
+static void                  cache_write_double         (GByteArray          *array,
+                                                         gdouble              value);
+static void                  cache_write_string         (CacheWriter         *writer,
+                                                         const gchar         *string);
+static void                  cache_write_data           (CacheWriter         *writer,
+                                                         const guint8        *data,
+                                                         gsize                length);
+
+
+/*  public functions  */
+
+GSList *
+plug_in_rc_cache_parse (Gimp    *gimp,
+                        GFile   *pluginrc,
+                        GError **error)
+{
+  GFile       *file;
+  gchar       *path;
+  GMappedFile *mapped;
+  CacheReader  reader;
+  GSList      *plug_in_defs = NULL;
+  guint64      mtime;
+  guint32      mtime_usec;
+  guint64      size;
+  guint32      n_plug_in_defs;
+  guint32      records_size;
+  guint32      strings_size;
+  gsize        header_size;
+  gsize        length;
+  guint32      i;
+
+  g_return_val_if_fail (GIMP_IS_GIMP (gimp), NULL);
+  g_return_val_if_fail (G_IS_FILE (pluginrc), NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (! plug_in_rc_cache_get_stamp (pluginrc, &mtime, &mtime_usec, &size,
+                                    error))
+    return NULL;
+
+  file = plug_in_rc_cache_get_file (pluginrc);
+  path = g_file_get_path (file);
+
+  if (! path)
+    {
+      g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_OPEN,
+                   _("'%s' is not a local file."),
+                   gimp_file_get_utf8_name (file));
+      g_object_unref (file);
+
+      return NULL;
+    }
+
+  mapped = g_mapped_file_new (path, FALSE, error);
+
+  g_free (path);
+
+  if (! mapped)
+    {
+      g_object_unref (file);
+
+      return NULL;
+    }
+
+  length = g_mapped_file_get_length (mapped);
+
+  reader.data         = (const guint8 *) g_mapped_file_get_contents (mapped);
+  reader.end          = reader.data + length;
+  reader.strings      = NULL;
+  reader.strings_size = 0;
+  reader.error        = FALSE;
+
+  if (length < strlen (PLUG_IN_RC_CACHE_MAGIC) ||
+      memcmp (reader.data, PLUG_IN_RC_CACHE_MAGIC,
+              strlen (PLUG_IN_RC_CACHE_MAGIC)))
+    {
+      goto corrupt;
+    }
+
+  reader.data += strlen (PLUG_IN_RC_CACHE_MAGIC);
+
+  if (cache_read_uint32 (&reader) != PLUG_IN_RC_CACHE_VERSION ||
+      cache_read_uint32 (&reader) != PLUG_IN_RC_FILE_VERSION  ||
+      cache_read_uint32 (&reader) != GIMP_PROTOCOL_VERSION)
+    {
+      if (! reader.error)
+        {
+          g_set_error (error,
+                       GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_VERSION,
+                       _("Skipping '%s': wrong version."),
+                       gimp_file_get_utf8_name (file));
+          goto error;
+        }
+
+      goto corrupt;
+    }
+
+  if (cache_read_uint64 (&reader) != mtime      ||
+      cache_read_uint32 (&reader) != mtime_usec ||
+      cache_read_uint64 (&reader) != size)
+    {
+      if (! reader.error)
+        {
+          g_set_error (error,
+                       GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_VERSION,
+                       _("Skipping '%s': out of date."),
+                       gimp_file_get_utf8_name (file));
+          goto error;
+        }
+
+      goto corrupt;
+    }
+
+  n_plug_in_defs = cache_read_uint32 (&reader);
+  records_size   = cache_read_uint32 (&reader);
+  strings_size   = cache_read_uint32 (&reader);
+
+  header_size = reader.data - (const guint8 *) g_mapped_file_get_contents (mapped);
+
+  if (reader.error                                                 ||
+      (guint64) header_size + records_size + strings_size != length ||
+      strings_size == 0                                            ||
+      reader.data[records_size + strings_size - 1] != '\0')
+    {
+      goto corrupt;
+    }
+
+  reader.end          = reader.data + records_size;
+  reader.strings      = (const gchar *) reader.end;
+  reader.strings_size = strings_size;
+
+  for (i = 0; i < n_plug_in_defs && ! reader.error; i++)
+    {
+      GimpPlugInDef *plug_in_def = plug_in_def_read (&reader, gimp);
+
+      if (plug_in_def)
+        plug_in_defs = g_slist_prepend (plug_in_defs, plug_in_def);
+    }
+
+  if (reader.error || reader.data != reader.end)
+    goto corrupt;
+
+  g_mapped_file_unref (mapped);
+  g_object_unref (file);
+
+  return g_slist_reverse (plug_in_defs);
+
+ corrupt:
+  g_set_error (error, GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_PARSE,
+               _("Skipping '%s': file is corrupt."),
+               gimp_file_get_utf8_name (file));
+
+ error:
+  g_slist_free_full (plug_in_defs, (GDestroyNotify) g_object_unref);
+
+  g_mapped_file_unref (mapped);
+  g_object_unref (file);
+
+  return NULL;
+}
+
+gboolean
+plug_in_rc_cache_write (GSList  *plug_in_defs,
+                        GFile   *pluginrc,
+                        GError **error)
+{
+  CacheWriter  writer;
+  GByteArray  *header;
+  GFile       *file;
+  GSList      *list;
+  guint64      mtime;
+  guint32      mtime_usec;
+  guint64      size;
+  guint32      n_plug_in_defs = 0;
+  gboolean     success;
+
+  g_return_val_if_fail (G_IS_FILE (pluginrc), FALSE);
+  g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  /*  the cache is only valid for the pluginrc written right before  */
+  if (! plug_in_rc_cache_get_stamp (pluginrc, &mtime, &mtime_usec, &size,
+                                    error))
+    return FALSE;
+
+  writer.records        = g_byte_array_new ();
+  writer.strings        = g_byte_array_new ();
+  writer.string_offsets = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                 g_free, NULL);
+
+  for (list = plug_in_defs; list; list = list->next)
+    {
+      GimpPlugInDef *plug_in_def = list->data;
+
+      if (plug_in_def->procedures)
+        {
+          gchar *path = gimp_file_get_config_path (plug_in_def->file, NULL);
+
+          if (! path)
+            continue;
+
+          plug_in_def_write (&writer, plug_in_def, path);
+          n_plug_in_defs++;
+
+          g_free (path);
+        }
+    }
+
+  /*  terminate the string table, see cache_read_string()  */
+  g_byte_array_append (writer.strings, (const guint8 *) "", 1);
+
+  header = g_byte_array_new ();
+
+  g_byte_array_append (header,
+                       (const guint8 *) PLUG_IN_RC_CACHE_MAGIC,
+                       strlen (PLUG_IN_RC_CACHE_MAGIC));
+  cache_write_uint32 (header, PLUG_IN_RC_CACHE_VERSION);
+  cache_write_uint32 (header, PLUG_IN_RC_FILE_VERSION);
+  cache_write_uint32 (header, GIMP_PROTOCOL_VERSION);
+  cache_write_uint64 (header, mtime);
+  cache_write_uint32 (header, mtime_usec);
+  cache_write_uint64 (header, size);
+  cache_write_uint32 (header, n_plug_in_defs);
+  cache_write_uint32 (header, writer.records->len);
+  cache_write_uint32 (header, writer.strings->len);
+
+  g_byte_array_append (header, writer.records->data, writer.records->len);
+  g_byte_array_append (header, writer.strings->data, writer.strings->len);
+
+  file = plug_in_rc_cache_get_file (pluginrc);
+
+  success = g_file_replace_contents (file,
+                                     (const gchar *) header->data, header->len,
+                                     NULL, FALSE, G_FILE_CREATE_NONE,
+                                     NULL, NULL, error);
+
+  g_object_unref (file);
+
+  g_byte_array_free (header, TRUE);
+  g_byte_array_free (writer.records, TRUE);
+  g_byte_array_free (writer.strings, TRUE);
+  g_hash_table_unref (writer.string_offsets);
+
+  return success;
+}
+
+
+/*  private functions  */
+
+static GFile *
+plug_in_rc_cache_get_file (GFile *pluginrc)
+{
+  GFile *parent   = g_file_get_parent (pluginrc);
+  gchar *basename = g_file_get_basename (pluginrc);
+  gchar *name     = g_strconcat (basename, PLUG_IN_RC_CACHE_SUFFIX, NULL);
+  GFile *file     = g_file_get_child (parent, name);
+
+  g_free (name);
+  g_free (basename);
+  g_object_unref (parent);
+
+  return file;
+}
+
+static gboolean
+plug_in_rc_cache_get_stamp (GFile    *pluginrc,
+                            guint64  *mtime,
+                            guint32  *mtime_usec,
+                            guint64  *size,
+                            GError  **error)
+{
+  GFileInfo *info;
+  GError    *my_error = NULL;
+
+  info = g_file_query_info (pluginrc,
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                            G_FILE_QUERY_INFO_NONE,
+                            NULL, &my_error);
+
+  if (! info)
+    {
+      if (my_error->code == G_IO_ERROR_NOT_FOUND)
+        {
+          g_set_error (error,
+                       GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_OPEN_ENOENT,
+                       "%s", my_error->message);
+        }
+      else
+        {
+          g_set_error (error,
+                       GIMP_CONFIG_ERROR, GIMP_CONFIG_ERROR_OPEN,
+                       "%s", my_error->message);
+        }
+
+      g_clear_error (&my_error);
+
+      return FALSE;
+    }
+
+  *mtime      = g_file_info_get_attribute_uint64 (info,
+                                                  G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  *mtime_usec = g_file_info_get_attribute_uint32 (info,
+                                                  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+  *size       = g_file_info_get_size (info);
+
+  g_object_unref (info);
+
+  return TRUE;
+}
+
+static GimpPlugInDef *
+plug_in_def_read (CacheReader *reader,
+                  Gimp        *gimp)
+{
+  GimpPlugInDef *plug_in_def = NULL;
+  const gchar   *path;
+  GFile         *file        = NULL;
+  gint64         mtime;
+  guint32        flags;
+  const gchar   *locale_domain_name;
+  const gchar   *locale_domain_path;
+  const gchar   *help_domain_name;
+  const gchar   *help_domain_uri;
+  guint32        n_procedures;
+  guint32        i;
+
+  path               = cache_read_string (reader);
+  mtime              = cache_read_int64  (reader);
+  flags              = cache_read_uint32 (reader);
+  locale_domain_name = cache_read_string (reader);
+  locale_domain_path = cache_read_string (reader);
+  help_domain_name   = cache_read_string (reader);
+  help_domain_uri    = cache_read_string (reader);
+  n_procedures       = cache_read_uint32 (reader);
+
+  if (reader->error || ! (path && *path))
+    {
+      reader->error = TRUE;
+
+      return NULL;
+    }
+
+  file = gimp_file_new_for_config_path (path, NULL);
+
+  if (file)
+    {
+      plug_in_def = gimp_plug_in_def_new (file);
+      g_object_unref (file);
+
+      plug_in_def->mtime = mtime;
+    }
+
+  /*  the procedures must be read in any case, to skip them  */
+  for (i = 0; i < n_procedures && ! reader->error; i++)
+    {
+      GimpPlugInProcedure *proc;
+
+      proc = plug_in_procedure_read (reader,
+                                     plug_in_def ? plug_in_def->file : NULL);
+
+      if (proc)
+        {
+          if (plug_in_def)
+            gimp_plug_in_def_add_procedure (plug_in_def, proc);
+
+          g_object_unref (proc);
+        }
+    }
+
+  if (! plug_in_def)
+    return NULL;
+
+  if (reader->error)
+    {
+      g_object_unref (plug_in_def);
+
+      return NULL;
+    }
+
+  if (locale_domain_name)
+    {
+      gchar *expanded_path = NULL;
+
+      if (locale_domain_path)
+        expanded_path = gimp_config_path_expand (locale_domain_path,
+                                                 TRUE, NULL);
+
+      gimp_plug_in_def_set_locale_domain (plug_in_def,
+                                          locale_domain_name, expanded_path);
+
+      g_free (expanded_path);
+    }
+
+  if (help_domain_name)
+    gimp_plug_in_def_set_help_domain (plug_in_def,
+                                      help_domain_name, help_domain_uri);
+
+  if (flags & FLAG_HAS_INIT)
+    gimp_plug_in_def_set_has_init (plug_in_def, TRUE);
+
+  return plug_in_def;
+}
+
+/*  if file is NULL, the procedure is only skipped  */
+static GimpPlugInProcedure *
+plug_in_procedure_read (CacheReader *reader,
+                        GFile       *file)
+{
+  GimpProcedure       *procedure = NULL;
+  GimpPlugInProcedure *proc      = NULL;
+  const gchar         *name;
+  guint32              proc_type;
+  guint32              n_menu_paths;
+  guint32              icon_type;
+  const guint8        *icon_data;
+  gsize                icon_data_length;
+  guint32              flags;
+  guint32              n_args;
+  guint32              n_return_vals;
+  guint32              i;
+
+  name      = cache_read_string (reader);
+  proc_type = cache_read_uint32 (reader);
+
+  if (reader->error || ! (name && *name) ||
+      (proc_type != GIMP_PDB_PROC_TYPE_PLUGIN &&
+       proc_type != GIMP_PDB_PROC_TYPE_EXTENSION))
+    {
+      reader->error = TRUE;
+
+      return NULL;
+    }
+
+  if (file)
+    {
+      procedure = gimp_plug_in_procedure_new (proc_type, file);
+      proc      = GIMP_PLUG_IN_PROCEDURE (procedure);
+
+      gimp_object_set_name (GIMP_OBJECT (procedure), name);
+
+      procedure->blurb     = g_strdup (cache_read_string (reader));
+      procedure->help      = g_strdup (cache_read_string (reader));
+      procedure->authors   = g_strdup (cache_read_string (reader));
+      procedure->copyright = g_strdup (cache_read_string (reader));
+      procedure->date      = g_strdup (cache_read_string (reader));
+      proc->menu_label     = g_strdup (cache_read_string (reader));
+    }
+  else
+    {
+      for (i = 0; i < 6; i++)
+        cache_read_string (reader);
+    }
+
+  n_menu_paths = cache_read_uint32 (reader);
+
+  for (i = 0; i < n_menu_paths && ! reader->error; i++)
+    {
+      const gchar *menu_path = cache_read_string (reader);
+
+      if (proc && menu_path)
+        proc->menu_paths = g_list_append (proc->menu_paths,
+                                          g_strdup (menu_path));
+    }
+
+  icon_type = cache_read_uint32 (reader);
+  icon_data = cache_read_data (reader, &icon_data_length);
+
+  if (proc && icon_data && ! reader->error)
+    {
+      switch (icon_type)
+        {
+        case GIMP_ICON_TYPE_ICON_NAME:
+        case GIMP_ICON_TYPE_IMAGE_FILE:
+          gimp_plug_in_procedure_take_icon (proc, icon_type,
+                                            (guint8 *) g_strndup ((const gchar *) icon_data,
+                                                                  icon_data_length),
+                                            -1, NULL);
+          break;
+
+        case GIMP_ICON_TYPE_PIXBUF:
+          gimp_plug_in_procedure_set_icon (proc, icon_type,
+                                           icon_data, icon_data_length,
+                                           NULL);
+          break;
+
+        default:
+          reader->error = TRUE;
+          break;
+        }
+    }
+
+  flags = cache_read_uint32 (reader);
+
+  if (flags & FLAG_FILE_PROC)
+    {
+      const gchar *extensions   = cache_read_string (reader);
+      const gchar *prefixes     = cache_read_string (reader);
+      const gchar *magics       = cache_read_string (reader);
+      const gchar *mime_types   = cache_read_string (reader);
+      const gchar *thumb_loader = cache_read_string (reader);
+      gint32       priority     = cache_read_int32  (reader);
+
+      if (proc && ! reader->error)
+        {
+          proc->file_proc  = TRUE;
+          proc->extensions = g_strdup (extensions);
+          proc->prefixes   = g_strdup (prefixes);
+          proc->magics     = g_strdup (magics);
+
+          if (priority)
+            gimp_plug_in_procedure_set_priority (proc, priority);
+
+          if (mime_types)
+            gimp_plug_in_procedure_set_mime_types (proc, mime_types);
+
+          if (flags & FLAG_HANDLES_REMOTE)
+            gimp_plug_in_procedure_set_handles_remote (proc);
+
+          if (flags & FLAG_HANDLES_RAW)
+            gimp_plug_in_procedure_set_handles_raw (proc);
+
+          if (thumb_loader)
+            gimp_plug_in_procedure_set_thumb_loader (proc, thumb_loader);
+        }
+    }
+
+  if (proc)
+    {
+      gimp_plug_in_procedure_set_image_types (proc,
+                                              cache_read_string (reader));
+      gimp_plug_in_procedure_set_sensitivity_mask (proc,
+                                                   cache_read_int32 (reader));
+    }
+  else
+    {
+      cache_read_string (reader);
+      cache_read_int32 (reader);
+    }
+
+  n_args        = cache_read_uint32 (reader);
+  n_return_vals = cache_read_uint32 (reader);
+
+  for (i = 0; i < n_args && ! reader->error; i++)
+    plug_in_proc_arg_read (reader, procedure, FALSE);
+
+  for (i = 0; i < n_return_vals && ! reader->error; i++)
+    plug_in_proc_arg_read (reader, procedure, TRUE);
+
+  return proc;
+}
+
+static void
+plug_in_proc_arg_read (CacheReader   *reader,
+                       GimpProcedure *procedure,
+                       gboolean       return_value)
+{
+  GPParamDef  param_def = { 0, };
+  GParamSpec *pspec;
+
+  param_def.param_def_type  = cache_read_uint32 (reader);
+  param_def.type_name       = (gchar *) cache_read_string (reader);
+  param_def.value_type_name = (gchar *) cache_read_string (reader);
+  param_def.name            = (gchar *) cache_read_string (reader);
+  param_def.nick            = (gchar *) cache_read_string (reader);
+  param_def.blurb           = (gchar *) cache_read_string (reader);
+  param_def.flags           = cache_read_uint32 (reader);
+
+  switch (param_def.param_def_type)
+    {
+    case GP_PARAM_DEF_TYPE_DEFAULT:
+      break;
+
+    case GP_PARAM_DEF_TYPE_INT:
+      param_def.meta.m_int.min_val     = cache_read_int64 (reader);
+      param_def.meta.m_int.max_val     = cache_read_int64 (reader);
+      param_def.meta.m_int.default_val = cache_read_int64 (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_UNIT:
+      param_def.meta.m_unit.allow_pixels  = cache_read_int32 (reader);
+      param_def.meta.m_unit.allow_percent = cache_read_int32 (reader);
+      param_def.meta.m_unit.default_val   = cache_read_int32 (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ENUM:
+      param_def.meta.m_enum.default_val = cache_read_int32 (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_BOOLEAN:
+      param_def.meta.m_boolean.default_val = cache_read_int32 (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_FLOAT:
+      param_def.meta.m_float.min_val     = cache_read_double (reader);
+      param_def.meta.m_float.max_val     = cache_read_double (reader);
+      param_def.meta.m_float.default_val = cache_read_double (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_STRING:
+      param_def.meta.m_string.default_val =
+        (gchar *) cache_read_string (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_COLOR:
+      param_def.meta.m_color.has_alpha     = cache_read_int32  (reader);
+      param_def.meta.m_color.default_val.r = cache_read_double (reader);
+      param_def.meta.m_color.default_val.g = cache_read_double (reader);
+      param_def.meta.m_color.default_val.b = cache_read_double (reader);
+      param_def.meta.m_color.default_val.a = cache_read_double (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ID:
+      param_def.meta.m_id.none_ok = cache_read_int32 (reader);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ID_ARRAY:
+      param_def.meta.m_id_array.type_name =
+        (gchar *) cache_read_string (reader);
+      break;
+
+    default:
+      reader->error = TRUE;
+      break;
+    }
+
+  if (reader->error               ||
+      ! procedure                 ||
+      ! param_def.type_name       ||
+      ! param_def.value_type_name ||
+      ! param_def.name)
+    {
+      return;
+    }
+
+  pspec = _gimp_gp_param_def_to_param_spec (&param_def);
+
+  if (return_value)
+    gimp_procedure_add_return_value (procedure, pspec);
+  else
+    gimp_procedure_add_argument (procedure, pspec);
+}
+
+static void
+plug_in_def_write (CacheWriter   *writer,
+                   GimpPlugInDef *plug_in_def,
+                   const gchar   *path)
+{
+  gchar   *locale_domain_path = NULL;
+  GSList  *list;
+  guint32  flags              = 0;
+  guint32  n_procedures       = 0;
+
+  if (plug_in_def->has_init)
+    flags |= FLAG_HAS_INIT;
+
+  if (plug_in_def->locale_domain_name && plug_in_def->locale_domain_path)
+    locale_domain_path = gimp_config_path_unexpand (plug_in_def->locale_domain_path,
+                                                    TRUE, NULL);
+
+  for (list = plug_in_def->procedures; list; list = list->next)
+    {
+      GimpPlugInProcedure *proc = list->data;
+
+      if (! proc->installed_during_init)
+        n_procedures++;
+    }
+
+  cache_write_string (writer, path);
+  cache_write_uint64 (writer->records, plug_in_def->mtime);
+  cache_write_uint32 (writer->records, flags);
+  cache_write_string (writer, plug_in_def->locale_domain_name);
+  cache_write_string (writer, locale_domain_path);
+  cache_write_string (writer, plug_in_def->help_domain_name);
+  cache_write_string (writer, plug_in_def->help_domain_name ?
+                              plug_in_def->help_domain_uri : NULL);
+  cache_write_uint32 (writer->records, n_procedures);
+
+  g_free (locale_domain_path);
+
+  for (list = plug_in_def->procedures; list; list = list->next)
+    {
+      GimpPlugInProcedure *proc = list->data;
+
+      if (! proc->installed_during_init)
+        plug_in_procedure_write (writer, proc);
+    }
+}
+
+static void
+plug_in_procedure_write (CacheWriter         *writer,
+                         GimpPlugInProcedure *proc)
+{
+  GimpProcedure *procedure = GIMP_PROCEDURE (proc);
+  GList         *list;
+  guint32        flags     = 0;
+  gint           i;
+
+  cache_write_string (writer, gimp_object_get_name (procedure));
+  cache_write_uint32 (writer->records, procedure->proc_type);
+  cache_write_string (writer, procedure->blurb);
+  cache_write_string (writer, procedure->help);
+  cache_write_string (writer, procedure->authors);
+  cache_write_string (writer, procedure->copyright);
+  cache_write_string (writer, procedure->date);
+  cache_write_string (writer, proc->menu_label);
+
+  cache_write_uint32 (writer->records, g_list_length (proc->menu_paths));
+
+  for (list = proc->menu_paths; list; list = list->next)
+    cache_write_string (writer, list->data);
+
+  cache_write_uint32 (writer->records, proc->icon_type);
+
+  switch (proc->icon_type)
+    {
+    case GIMP_ICON_TYPE_ICON_NAME:
+    case GIMP_ICON_TYPE_IMAGE_FILE:
+      cache_write_data (writer, proc->icon_data,
+                        proc->icon_data ?
+                        strlen ((const gchar *) proc->icon_data) : 0);
+      break;
+
+    case GIMP_ICON_TYPE_PIXBUF:
+      cache_write_data (writer, proc->icon_data,
+                        MAX (proc->icon_data_length, 0));
+      break;
+    }
+
+  if (proc->file_proc)
+    {
+      flags |= FLAG_FILE_PROC;
+
+      if (proc->handles_remote)
+        flags |= FLAG_HANDLES_REMOTE;
+
+      if (proc->handles_raw && ! proc->image_types)
+        flags |= FLAG_HANDLES_RAW;
+    }
+
+  cache_write_uint32 (writer->records, flags);
+
+  if (proc->file_proc)
+    {
+      cache_write_string (writer, proc->extensions);
+      cache_write_string (writer, proc->prefixes);
+      cache_write_string (writer, proc->magics);
+      cache_write_string (writer, proc->mime_types);
+      cache_write_string (writer, proc->thumb_loader);
+      cache_write_uint32 (writer->records, proc->priority);
+    }
+
+  cache_write_string (writer, proc->image_types);
+  cache_write_uint32 (writer->records, proc->sensitivity_mask);
+
+  cache_write_uint32 (writer->records, procedure->num_args);
+  cache_write_uint32 (writer->records, procedure->num_values);
+
+  for (i = 0; i < procedure->num_args; i++)
+    plug_in_proc_arg_write (writer, procedure->args[i]);
+
+  for (i = 0; i < procedure->num_values; i++)
+    plug_in_proc_arg_write (writer, procedure->values[i]);
+}
+
+static void
+plug_in_proc_arg_write (CacheWriter *writer,
+                        GParamSpec  *pspec)
+{
+  GPParamDef  param_def = { 0, };
+  GByteArray *records   = writer->records;
+
+  _gimp_param_spec_to_gp_param_def (pspec, &param_def);
+
+  cache_write_uint32 (records, param_def.param_def_type);
+  cache_write_string (writer, param_def.type_name);
+  cache_write_string (writer, param_def.value_type_name);
+  cache_write_string (writer, g_param_spec_get_name (pspec));
+  cache_write_string (writer, g_param_spec_get_nick (pspec));
+  cache_write_string (writer, g_param_spec_get_blurb (pspec));
+  cache_write_uint32 (records, pspec->flags);
+
+  switch (param_def.param_def_type)
+    {
+    case GP_PARAM_DEF_TYPE_DEFAULT:
+      break;
+
+    case GP_PARAM_DEF_TYPE_INT:
+      cache_write_uint64 (records, param_def.meta.m_int.min_val);
+      cache_write_uint64 (records, param_def.meta.m_int.max_val);
+      cache_write_uint64 (records, param_def.meta.m_int.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_UNIT:
+      cache_write_uint32 (records, param_def.meta.m_unit.allow_pixels);
+      cache_write_uint32 (records, param_def.meta.m_unit.allow_percent);
+      cache_write_uint32 (records, param_def.meta.m_unit.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ENUM:
+      cache_write_uint32 (records, param_def.meta.m_enum.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_BOOLEAN:
+      cache_write_uint32 (records, param_def.meta.m_boolean.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_FLOAT:
+      cache_write_double (records, param_def.meta.m_float.min_val);
+      cache_write_double (records, param_def.meta.m_float.max_val);
+      cache_write_double (records, param_def.meta.m_float.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_STRING:
+      cache_write_string (writer, param_def.meta.m_string.default_val);
+      break;
+
+    case GP_PARAM_DEF_TYPE_COLOR:
+      cache_write_uint32 (records, param_def.meta.m_color.has_alpha);
+      cache_write_double (records, param_def.meta.m_color.default_val.r);
+      cache_write_double (records, param_def.meta.m_color.default_val.g);
+      cache_write_double (records, param_def.meta.m_color.default_val.b);
+      cache_write_double (records, param_def.meta.m_color.default_val.a);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ID:
+      cache_write_uint32 (records, param_def.meta.m_id.none_ok);
+      break;
+
+    case GP_PARAM_DEF_TYPE_ID_ARRAY:
+      cache_write_string (writer, param_def.meta.m_id_array.type_name);
+      break;
+    }
+}
+
+static guint32
+cache_read_uint32 (CacheReader *reader)
+{
+  guint32 value;
+
+  if (reader->error || (gsize) (reader->end - reader->data) < sizeof (value))
+    {
+      reader->error = TRUE;
+
+      return 0;
+    }
+
+  memcpy (&value, reader->data, sizeof (value));
+  reader->data += sizeof (value);
+
+  return GUINT32_FROM_LE (value);
+}
+
+static gint32
+cache_read_int32 (CacheReader *reader)
+{
+  return (gint32) cache_read_uint32 (reader);
+}
+
+static guint64
+cache_read_uint64 (CacheReader *reader)
+{
+  guint64 value;
+
+  if (reader->error || (gsize) (reader->end - reader->data) < sizeof (value))
+    {
+      reader->error = TRUE;
+
+      return 0;
+    }
+
+  memcpy (&value, reader->data, sizeof (value));
+  reader->data += sizeof (value);
+
+  return GUINT64_FROM_LE (value);
+}
+
+static gint64
+cache_read_int64 (CacheReader *reader)
+{
+  return (gint64) cache_read_uint64 (reader);
+}
+
+static gdouble
+cache_read_double (CacheReader *reader)
+{
+  guint64 bits = cache_read_uint64 (reader);
+  gdouble value;
+
+  memcpy (&value, &bits, sizeof (value));
+
+  return value;
+}
+
+/*  the string table ends with a NUL, so any offset into it is the
+ *  start of a terminated string
+ */
+static const gchar *
+cache_read_string (CacheReader *reader)
+{
+  guint32 offset = cache_read_uint32 (reader);
+
+  if (reader->error || offset == NO_STRING)
+    return NULL;
+
+  if (offset >= reader->strings_size)
+    {
+      reader->error = TRUE;
+
+      return NULL;
+    }
+
+  return reader->strings + offset;
+}
+
+static const guint8 *
+cache_read_data (CacheReader *reader,
+                 gsize       *length)
+{
+  guint32 offset = cache_read_uint32 (reader);
+  guint32 size   = cache_read_uint32 (reader);
+
+  *length = 0;
+
+  if (reader->error || offset == NO_STRING)
+    return NULL;
+
+  if (offset > reader->strings_size ||
+      size   > reader->strings_size - offset)
+    {
+      reader->error = TRUE;
+
+      return NULL;
+    }
+
+  *length = size;
+
+  return (const guint8 *) reader->strings + offset;
+}
+
+static void
+cache_write_uint32 (GByteArray *array,
+                    guint32     value)
+{
+  value = GUINT32_TO_LE (value);
+
+  g_byte_array_append (array, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+cache_write_uint64 (GByteArray *array,
+                    guint64     value)
+{
+  value = GUINT64_TO_LE (value);
+
+  g_byte_array_append (array, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+cache_write_double (GByteArray *array,
+                    gdouble     value)
+{
+  guint64 bits;
+
+  memcpy (&bits, &value, sizeof (bits));
+
+  cache_write_uint64 (array, bits);
+}
+
+static void
+cache_write_string (CacheWriter *writer,
+                    const gchar *string)
+{
+  gpointer offset;
+
+  if (! string)
+    {
+      cache_write_uint32 (writer->records, NO_STRING);
+
+      return;
+    }
+
+  if (! g_hash_table_lookup_extended (writer->string_offsets, string,
+                                      NULL, &offset))
+    {
+      offset = GUINT_TO_POINTER (writer->strings->len);
+
+      g_byte_array_append (writer->strings,
+                           (const guint8 *) string, strlen (string) + 1);
+
+      g_hash_table_insert (writer->string_offsets, g_strdup (string), offset);
+    }
+
+  cache_write_uint32 (writer->records, GPOINTER_TO_UINT (offset));
+}
+
+static void
+cache_write_data (CacheWriter  *writer,
+                  const guint8 *data,
+                  gsize         length)
+{
+  if (! data)
+    {
+      cache_write_uint32 (writer->records, NO_STRING);
+      cache_write_uint32 (writer->records, 0);
+
+      return;
+    }
+
+  cache_write_uint32 (writer->records, writer->strings->len);
+  cache_write_uint32 (writer->records, length);
+
+  g_byte_array_append (writer->strings, data, length);
+}
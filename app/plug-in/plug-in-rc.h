@@ -22,6 +22,10 @@
 #define __PLUG_IN_RC_H__
 
 
+/*  bump this to make a new GIMP query all plug-ins again  */
+#define PLUG_IN_RC_FILE_VERSION 13
+
+
 GSList   * plug_in_rc_parse (Gimp    *gimp,
                              GFile   *file,
                              GError **error);
@@ -0,0 +1,276 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpbase/gimpbase.h"
+#include "libgimpconfig/gimpconfig.h"
+
+#include "widgets/widgets-types.h"
+
+#include "widgets/gimpsessioninfo.h"
+
+#include "core/gimp.h"
+#include "core/gimplist.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+/*  the number of passes over the files when running with -m perf  */
+#define GIMP_TEST_N_PERF_PASSES 500
+
+#define ADD_TEST(function) \
+  g_test_add_data_func ("/gimp-config-parse/" #function, gimp, function);
+
+
+static const gchar *sessionrc_files[] =
+{
+  "sessionrc",
+  "sessionrc-2-8-multi-window",
+  "sessionrc-2-8-single-window",
+  "sessionrc-expected",
+  "sessionrc-expected-multi-window",
+  "sessionrc-expected-single-window"
+};
+
+static const gchar *dockrc_files[] =
+{
+  "dockrc",
+  "dockrc-2-8",
+  "dockrc-expected"
+};
+
+
+/**
+ * parse_sessionrc:
+ * @file:
+ *
+ * Parses the session infos in @file the way session_init() does, but
+ * without adding them to the dialog factory.
+ *
+ * Returns: The number of session infos parsed.
+ **/
+static gint
+parse_sessionrc (GFile *file)
+{
+  GimpScanner *scanner;
+  GError      *error   = NULL;
+  gint         n_infos = 0;
+
+  scanner = gimp_scanner_new_file (file, &error);
+  g_assert_no_error (error);
+
+  g_scanner_scope_add_symbol (scanner, 0, "session-info",
+                              GINT_TO_POINTER (1));
+
+  while (g_scanner_peek_next_token (scanner) == G_TOKEN_LEFT_PAREN)
+    {
+      g_scanner_get_next_token (scanner);
+
+      if (g_scanner_get_next_token (scanner) == G_TOKEN_SYMBOL)
+        {
+          GimpSessionInfo *info;
+          gchar           *factory_name = NULL;
+          gchar           *entry_name   = NULL;
+
+          g_assert (gimp_scanner_parse_string (scanner, &factory_name));
+
+          /*  GIMP 2.6 has the entry name as part of the header  */
+          gimp_scanner_parse_string (scanner, &entry_name);
+
+          info = gimp_session_info_new ();
+
+          g_assert (gimp_config_deserialize (GIMP_CONFIG (info),
+                                             scanner, 1, NULL));
+          g_assert (gimp_scanner_parse_token (scanner, G_TOKEN_RIGHT_PAREN));
+
+          g_object_unref (info);
+          g_free (factory_name);
+          g_free (entry_name);
+
+          n_infos++;
+        }
+      else
+        {
+          gint depth = 1;
+
+          /*  skip the simple toplevel settings like (hide-docks no)  */
+          while (depth > 0)
+            {
+              switch (g_scanner_get_next_token (scanner))
+                {
+                case G_TOKEN_LEFT_PAREN:
+                  depth++;
+                  break;
+
+                case G_TOKEN_RIGHT_PAREN:
+                  depth--;
+                  break;
+
+                case G_TOKEN_EOF:
+                case G_TOKEN_ERROR:
+                  g_assert_not_reached ();
+                  break;
+
+                default:
+                  break;
+                }
+            }
+        }
+    }
+
+  g_assert_cmpint (g_scanner_peek_next_token (scanner), ==, G_TOKEN_EOF);
+
+  gimp_scanner_unref (scanner);
+
+  return n_infos;
+}
+
+/**
+ * parse_dockrc:
+ * @file:
+ *
+ * Parses @file into a container like dialogs_load_recent_docks().
+ *
+ * Returns: The number of docks parsed.
+ **/
+static gint
+parse_dockrc (GFile *file)
+{
+  GimpContainer *docks;
+  GError        *error = NULL;
+  gint           n_docks;
+
+  docks = gimp_list_new (GIMP_TYPE_SESSION_INFO, FALSE);
+
+  gimp_config_deserialize_file (GIMP_CONFIG (docks), file, NULL, &error);
+  g_assert_no_error (error);
+
+  n_docks = gimp_container_get_n_children (docks);
+
+  g_object_unref (docks);
+
+  return n_docks;
+}
+
+static void
+parse_files (const gchar  **basenames,
+             gint           n_basenames,
+             gint         (*parse_func) (GFile *file),
+             const gchar   *what)
+{
+  GFile   **files;
+  GTimer   *timer;
+  gint      n_passes;
+  gint      pass;
+  gint      i;
+
+  files = g_new (GFile *, n_basenames);
+
+  for (i = 0; i < n_basenames; i++)
+    {
+      files[i] = gimp_directory_file (basenames[i], NULL);
+
+      /*  make sure the files are actually understood  */
+      g_assert_cmpint (parse_func (files[i]), >, 0);
+    }
+
+  n_passes = g_test_perf () ? GIMP_TEST_N_PERF_PASSES : 1;
+
+  timer = g_timer_new ();
+
+  for (pass = 0; pass < n_passes; pass++)
+    for (i = 0; i < n_basenames; i++)
+      parse_func (files[i]);
+
+  g_timer_stop (timer);
+
+  g_test_minimized_result (g_timer_elapsed (timer, NULL) / n_passes,
+                           "parsing all %s files: %.3f ms per pass",
+                           what,
+                           g_timer_elapsed (timer, NULL) * 1000.0 / n_passes);
+
+  g_timer_destroy (timer);
+
+  for (i = 0; i < n_basenames; i++)
+    g_object_unref (files[i]);
+
+  g_free (files);
+}
+
+/**
+ * parse_sessionrc_files:
+ * @data:
+ *
+ * Parse the sessionrc files in app/tests/gimpdir. Run with "-m perf"
+ * to use this as a benchmark of the config deserializer.
+ **/
+static void
+parse_sessionrc_files (gconstpointer data)
+{
+  parse_files (sessionrc_files, G_N_ELEMENTS (sessionrc_files),
+               parse_sessionrc, "sessionrc");
+}
+
+/**
+ * parse_dockrc_files:
+ * @data:
+ *
+ * Parse the dockrc files in app/tests/gimpdir. Run with "-m perf" to
+ * use this as a benchmark of the config deserializer.
+ **/
+static void
+parse_dockrc_files (gconstpointer data)
+{
+  parse_files (dockrc_files, G_N_ELEMENTS (dockrc_files),
+               parse_dockrc, "dockrc");
+}
+
+int main(int argc, char **argv)
+{
+  Gimp *gimp   = NULL;
+  gint  result = -1;
+
+  gimp_test_bail_if_no_display ();
+  gtk_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+  gimp_test_utils_setup_menus_path ();
+
+  /* The session infos need the dialog factory */
+  gimp = gimp_init_for_gui_testing (FALSE /*show_gui*/);
+  gimp_test_run_mainloop_until_idle ();
+
+  ADD_TEST (parse_sessionrc_files);
+  ADD_TEST (parse_dockrc_files);
+
+  /* Run the tests and return status */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit properly so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
@@ -0,0 +1,705 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 2009 Martin Nordholts
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "widgets/widgets-types.h"
+
+#include "widgets/gimpuimanager.h"
+
+#include "core/gimp.h"
+#include "core/gimpcontext.h"
+#include "core/gimpdrawable-filters.h"
+#include "core/gimpdrawablefilter.h"
+#include "core/gimpfilterstack.h"
+#include "core/gimpimage.h"
+#include "core/gimplayer.h"
+#include "core/gimplayer-new.h"
+
+#include "operations/gimpcurvesconfig.h"
+#include "operations/gimphuesaturationconfig.h"
+#include "operations/gimplevelsconfig.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+#define GIMP_TEST_IMAGE_SIZE 100
+
+/*  the number of filters in the benchmarked chain, the layer size and
+ *  the number of passes over it when running with -m perf
+ */
+#define GIMP_TEST_N_CHAINED_FILTERS  8
+#define GIMP_TEST_PERF_LAYER_SIZE    4096
+#define GIMP_TEST_N_PERF_PASSES      10
+
+#define ADD_IMAGE_TEST(function) \
+  g_test_add ("/gimp-core/" #function, \
+              GimpTestFixture, \
+              gimp, \
+              gimp_test_image_setup, \
+              function, \
+              gimp_test_image_teardown);
+
+#define ADD_TEST(function) \
+  g_test_add ("/gimp-core/" #function, \
+              GimpTestFixture, \
+              gimp, \
+              NULL, \
+              function, \
+              NULL);
+
+
+typedef struct
+{
+  GimpImage *image;
+} GimpTestFixture;
+
+
+static void gimp_test_image_setup    (GimpTestFixture *fixture,
+                                      gconstpointer    data);
+static void gimp_test_image_teardown (GimpTestFixture *fixture,
+                                      gconstpointer    data);
+
+
+/**
+ * gimp_test_image_setup:
+ * @fixture:
+ * @data:
+ *
+ * Test fixture setup for a single image.
+ **/
+static void
+gimp_test_image_setup (GimpTestFixture *fixture,
+                       gconstpointer    data)
+{
+  Gimp *gimp = GIMP (data);
+
+  fixture->image = gimp_image_new (gimp,
+                                   GIMP_TEST_IMAGE_SIZE,
+                                   GIMP_TEST_IMAGE_SIZE,
+                                   GIMP_RGB,
+                                   GIMP_PRECISION_FLOAT_LINEAR);
+}
+
+/**
+ * gimp_test_image_teardown:
+ * @fixture:
+ * @data:
+ *
+ * Test fixture teardown for a single image.
+ **/
+static void
+gimp_test_image_teardown (GimpTestFixture *fixture,
+                          gconstpointer    data)
+{
+  g_object_unref (fixture->image);
+}
+
+/**
+ * rotate_non_overlapping:
+ * @fixture:
+ * @data:
+ *
+ * Super basic test that makes sure we can add a layer
+ * and call gimp_item_rotate with center at (0, -10)
+ * without triggering a failed assertion .
+ **/
+static void
+rotate_non_overlapping (GimpTestFixture *fixture,
+                        gconstpointer    data)
+{
+  Gimp        *gimp    = GIMP (data);
+  GimpImage   *image   = fixture->image;
+  GimpLayer   *layer;
+  GimpContext *context = gimp_context_new (gimp, "Test", NULL /*template*/);
+  gboolean     result;
+
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 0);
+
+  layer = gimp_layer_new (image,
+                          GIMP_TEST_IMAGE_SIZE,
+                          GIMP_TEST_IMAGE_SIZE,
+                          babl_format ("R'G'B'A u8"),
+                          "Test Layer",
+                          GIMP_OPACITY_OPAQUE,
+                          GIMP_LAYER_MODE_NORMAL);
+
+  g_assert_cmpint (GIMP_IS_LAYER (layer), ==, TRUE);
+
+  result = gimp_image_add_layer (image,
+                                 layer,
+                                 GIMP_IMAGE_ACTIVE_PARENT,
+                                 0,
+                                 FALSE);
+
+  gimp_item_rotate (GIMP_ITEM (layer), context, GIMP_ROTATE_90, 0., -10., TRUE);
+
+  g_assert_cmpint (result, ==, TRUE);
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 1);
+  g_object_unref (context);
+}
+
+/**
+ * add_layer:
+ * @fixture:
+ * @data:
+ *
+ * Super basic test that makes sure we can add a layer.
+ **/
+static void
+add_layer (GimpTestFixture *fixture,
+           gconstpointer    data)
+{
+  GimpImage *image = fixture->image;
+  GimpLayer *layer;
+  gboolean   result;
+
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 0);
+
+  layer = gimp_layer_new (image,
+                          GIMP_TEST_IMAGE_SIZE,
+                          GIMP_TEST_IMAGE_SIZE,
+                          babl_format ("R'G'B'A u8"),
+                          "Test Layer",
+                          GIMP_OPACITY_OPAQUE,
+                          GIMP_LAYER_MODE_NORMAL);
+
+  g_assert_cmpint (GIMP_IS_LAYER (layer), ==, TRUE);
+
+  result = gimp_image_add_layer (image,
+                                 layer,
+                                 GIMP_IMAGE_ACTIVE_PARENT,
+                                 0,
+                                 FALSE);
+
+  g_assert_cmpint (result, ==, TRUE);
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 1);
+}
+
+/**
+ * remove_layer:
+ * @fixture:
+ * @data:
+ *
+ * Super basic test that makes sure we can remove a layer.
+ **/
+static void
+remove_layer (GimpTestFixture *fixture,
+              gconstpointer    data)
+{
+  GimpImage *image = fixture->image;
+  GimpLayer *layer;
+  gboolean   result;
+
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 0);
+
+  layer = gimp_layer_new (image,
+                          GIMP_TEST_IMAGE_SIZE,
+                          GIMP_TEST_IMAGE_SIZE,
+                          babl_format ("R'G'B'A u8"),
+                          "Test Layer",
+                          GIMP_OPACITY_OPAQUE,
+                          GIMP_LAYER_MODE_NORMAL);
+
+  g_assert_cmpint (GIMP_IS_LAYER (layer), ==, TRUE);
+
+  result = gimp_image_add_layer (image,
+                                 layer,
+                                 GIMP_IMAGE_ACTIVE_PARENT,
+                                 0,
+                                 FALSE);
+
+  g_assert_cmpint (result, ==, TRUE);
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 1);
+
+  gimp_image_remove_layer (image,
+                           layer,
+                           FALSE,
+                           NULL);
+
+  g_assert_cmpint (gimp_image_get_n_layers (image), ==, 0);
+}
+
+/**
+ * fuse_point_filters:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure consecutive point filters on a drawable are applied by a
+ * single fused node, that the result matches applying them one by
+ * one, and that a filter which stops being a plain point filter
+ * breaks up the run.
+ **/
+static void
+fuse_point_filters (GimpTestFixture *fixture,
+                    gconstpointer    data)
+{
+  GimpImage          *image = fixture->image;
+  GimpLayer          *layer;
+  GimpFilterStack    *stack;
+  GimpDrawableFilter *posterize;
+  GimpDrawableFilter *threshold;
+  GeglNode           *operation;
+  GeglColor          *color;
+  gfloat              fused[4];
+  gfloat              unfused[4];
+  gint                i;
+
+  layer = gimp_layer_new (image,
+                          GIMP_TEST_IMAGE_SIZE,
+                          GIMP_TEST_IMAGE_SIZE,
+                          gimp_image_get_layer_format (image, TRUE),
+                          "Test Layer",
+                          GIMP_OPACITY_OPAQUE,
+                          GIMP_LAYER_MODE_NORMAL);
+
+  gimp_image_add_layer (image,
+                        layer,
+                        GIMP_IMAGE_ACTIVE_PARENT,
+                        0,
+                        FALSE);
+
+  color = gegl_color_new (NULL);
+  gegl_color_set_rgba (color, 0.2, 0.45, 0.7, 1.0);
+  gegl_buffer_set_color (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
+                         NULL, color);
+  g_object_unref (color);
+
+  /*  build the filter stack's graph  */
+  gimp_drawable_get_source_node (GIMP_DRAWABLE (layer));
+
+  stack = GIMP_FILTER_STACK (gimp_drawable_get_filters (GIMP_DRAWABLE (layer)));
+
+  operation = gegl_node_new_child (NULL,
+                                   "operation", "gimp:posterize",
+                                   "levels",    3,
+                                   NULL);
+  posterize = gimp_drawable_filter_new (GIMP_DRAWABLE (layer),
+                                        "Posterize", operation, NULL);
+  g_object_unref (operation);
+
+  gimp_drawable_filter_apply (posterize, NULL);
+
+  g_assert_cmpint (g_list_length (stack->fused_nodes), ==, 0);
+
+  operation = gegl_node_new_child (NULL,
+                                   "operation", "gimp:threshold",
+                                   "low",       0.4,
+                                   NULL);
+  threshold = gimp_drawable_filter_new (GIMP_DRAWABLE (layer),
+                                        "Threshold", operation, NULL);
+  g_object_unref (operation);
+
+  gimp_drawable_filter_apply (threshold, NULL);
+
+  g_assert_cmpint (g_list_length (stack->fused_nodes), ==, 1);
+
+  /*  the filters stay linked to each other, so the top one's node
+   *  gives the result of applying them one by one
+   */
+  gegl_node_blit (gimp_drawable_get_source_node (GIMP_DRAWABLE (layer)),
+                  1.0, GEGL_RECTANGLE (0, 0, 1, 1),
+                  babl_format ("RGBA float"), fused,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+  gegl_node_blit (gimp_filter_get_node (GIMP_FILTER (threshold)),
+                  1.0, GEGL_RECTANGLE (0, 0, 1, 1),
+                  babl_format ("RGBA float"), unfused,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  for (i = 0; i < 4; i++)
+    g_assert_cmpfloat (ABS (fused[i] - unfused[i]), <, 1e-4);
+
+  /*  a filter that is blended with its input can't be fused  */
+  gimp_drawable_filter_set_opacity (threshold, 0.5);
+
+  g_assert_cmpint (g_list_length (stack->fused_nodes), ==, 0);
+
+  gimp_drawable_filter_set_opacity (threshold, GIMP_OPACITY_OPAQUE);
+
+  g_assert_cmpint (g_list_length (stack->fused_nodes), ==, 1);
+
+  gimp_drawable_filter_abort (threshold);
+  gimp_drawable_filter_abort (posterize);
+
+  g_assert_cmpint (g_list_length (stack->fused_nodes), ==, 0);
+
+  g_object_unref (threshold);
+  g_object_unref (posterize);
+}
+
+/**
+ * fuse_point_filters_u8:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure a fused chain works on float data even when one of its
+ * filters has an integer path, like curves on an 8-bit layer, and is
+ * followed by a filter which is not per-channel.
+ **/
+static void
+fuse_point_filters_u8 (GimpTestFixture *fixture,
+                       gconstpointer    data)
+{
+  static const gdouble  points[] = { 0.0, 0.1, 0.5, 0.7, 1.0, 0.9 };
+  GimpImage            *image    = fixture->image;
+  GimpLayer            *layer;
+  GimpFilterStack      *stack;
+  GimpDrawableFilter   *curves;
+  GimpDrawableFilter   *hue_saturation;
+  GeglNode             *operation;
+  GObject              *config;
+  GeglColor            *color;
+  gfloat                fused[4 * 16];
+  gfloat                unfused[4 * 16];
+  gint                  i;
+
+  layer = gimp_layer_new (image,
+                          GIMP_TEST_IMAGE_SIZE,
+                          GIMP_TEST_IMAGE_SIZE,
+                          gimp_image_get_format (image, GIMP_RGB,
+                                                 GIMP_PRECISION_U8_NON_LINEAR,
+                                                 TRUE, NULL),
+                          "Test Layer",
+                          GIMP_OPACITY_OPAQUE,
+                          GIMP_LAYER_MODE_NORMAL);
+
+  gimp_image_add_layer (image,
+                        layer,
+                        GIMP_IMAGE_ACTIVE_PARENT,
+                        0,
+                        FALSE);
+
+  color = gegl_color_new (NULL);
+  gegl_color_set_rgba (color, 0.2, 0.45, 0.7, 1.0);
+  gegl_buffer_set_color (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
+                         NULL, color);
+  g_object_unref (color);
+
+  /*  build the filter stack's graph  */
+  gimp_drawable_get_source_node (GIMP_DRAWABLE (layer));
+
+  stack = GIMP_FILTER_STACK (gimp_drawable_get_filters (GIMP_DRAWABLE (layer)));
+
+  config = gimp_curves_config_new_spline (GIMP_HISTOGRAM_VALUE,
+                                          points, G_N_ELEMENTS (points) / 2);
+  operation = gegl_node_new_child (NULL,
+                                   "operation", "gimp:curves",
+                                   "config",    config,
+                                   NULL);
+  curves = gimp_drawable_filter_new (GIMP_DRAWABLE (layer),
+                                     "Curves", operation, NULL);
+  g_object_unref (operation);
+  g_object_unref (config);
+
+  gimp_drawable_filter_apply (curves, NULL);
+
+  config = g_object_new (GIMP_TYPE_HUE_SATURATION_CONFIG,
+                         "hue",        0.25,
+                         "saturation", 0.5,
+                         NULL);
+  operation = gegl_node_new_child (NULL,
+                                   "operation", "gimp:hue-saturation",
+                                   "config",    config,
+                                   NULL);
+  hue_saturation = gimp_drawable_filter_new (GIMP_DRAWABLE (layer),
+                                             "Hue-Saturation", operation,
+                                             NULL);
+  g_object_unref (operation);
+  g_object_unref (config);
+
+  gimp_drawable_filter_apply (hue_saturation, NULL);
+
+  g_assert_cmpint (g_list_length (stack->fused_nodes), ==, 1);
+
+  gegl_node_blit (gimp_drawable_get_source_node (GIMP_DRAWABLE (layer)),
+                  1.0, GEGL_RECTANGLE (0, 0, 16, 1),
+                  babl_format ("R'G'B'A float"), fused,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+  gegl_node_blit (gimp_filter_get_node (GIMP_FILTER (hue_saturation)),
+                  1.0, GEGL_RECTANGLE (0, 0, 16, 1),
+                  babl_format ("R'G'B'A float"), unfused,
+                  GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  /*  the unfused chain rounds to 8 bits between the filters  */
+  for (i = 0; i < 4 * 16; i++)
+    g_assert_cmpfloat (ABS (fused[i] - unfused[i]), <, 2.0 / 255.0);
+
+  gimp_drawable_filter_abort (hue_saturation);
+  gimp_drawable_filter_abort (curves);
+
+  g_object_unref (hue_saturation);
+  g_object_unref (curves);
+}
+
+/**
+ * blit_node:
+ * @node:
+ * @size:
+ * @n_passes:
+ * @data:
+ *
+ * Renders the @size x @size area of @node into @data @n_passes times.
+ *
+ * Returns: The number of seconds it took per pass.
+ **/
+static gdouble
+blit_node (GeglNode *node,
+           gint      size,
+           gint      n_passes,
+           gfloat   *data)
+{
+  GTimer  *timer;
+  gdouble  elapsed;
+  gint     pass;
+
+  timer = g_timer_new ();
+
+  for (pass = 0; pass < n_passes; pass++)
+    gegl_node_blit (node,
+                    1.0, GEGL_RECTANGLE (0, 0, size, size),
+                    babl_format ("RGBA float"), data,
+                    GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  g_timer_stop (timer);
+
+  elapsed = g_timer_elapsed (timer, NULL) / n_passes;
+
+  g_timer_destroy (timer);
+
+  return elapsed;
+}
+
+/**
+ * fuse_point_filters_chain:
+ * @fixture:
+ * @data:
+ *
+ * Applies a chain of GIMP_TEST_N_CHAINED_FILTERS point filters and
+ * compares rendering it through the fused node with rendering the
+ * filters one by one. Run with "-m perf" to use this as a benchmark
+ * of the fused node against the chain on a larger layer.
+ **/
+static void
+fuse_point_filters_chain (GimpTestFixture *fixture,
+                          gconstpointer    data)
+{
+  GimpImage           *image   = fixture->image;
+  GimpLayer           *layer;
+  GimpFilterStack     *stack;
+  GimpDrawableFilter  *filters[GIMP_TEST_N_CHAINED_FILTERS];
+  GimpFilter          *top;
+  GeglColor           *color;
+  gfloat              *fused;
+  gfloat              *unfused;
+  gdouble              fused_time;
+  gdouble              unfused_time;
+  gint                 size;
+  gint                 n_passes;
+  gint                 i;
+
+  if (g_test_perf ())
+    {
+      size     = GIMP_TEST_PERF_LAYER_SIZE;
+      n_passes = GIMP_TEST_N_PERF_PASSES;
+    }
+  else
+    {
+      size     = GIMP_TEST_IMAGE_SIZE;
+      n_passes = 1;
+    }
+
+  layer = gimp_layer_new (image,
+                          size,
+                          size,
+                          gimp_image_get_layer_format (image, TRUE),
+                          "Test Layer",
+                          GIMP_OPACITY_OPAQUE,
+                          GIMP_LAYER_MODE_NORMAL);
+
+  gimp_image_add_layer (image,
+                        layer,
+                        GIMP_IMAGE_ACTIVE_PARENT,
+                        0,
+                        FALSE);
+
+  color = gegl_color_new (NULL);
+  gegl_color_set_rgba (color, 0.2, 0.45, 0.7, 1.0);
+  gegl_buffer_set_color (gimp_drawable_get_buffer (GIMP_DRAWABLE (layer)),
+                         NULL, color);
+  g_object_unref (color);
+
+  /*  build the filter stack's graph  */
+  gimp_drawable_get_source_node (GIMP_DRAWABLE (layer));
+
+  stack = GIMP_FILTER_STACK (gimp_drawable_get_filters (GIMP_DRAWABLE (layer)));
+
+  /*  alternate between two kinds of filters, so that both the
+   *  per-channel and the other steps are exercised
+   */
+  for (i = 0; i < GIMP_TEST_N_CHAINED_FILTERS; i++)
+    {
+      GeglNode *operation;
+      GObject  *config;
+
+      if (i % 2 == 0)
+        {
+          config = g_object_new (GIMP_TYPE_LEVELS_CONFIG, NULL);
+
+          g_object_set (config,
+                        "gamma", 0.8 + 0.05 * i,
+                        NULL);
+
+          operation = gegl_node_new_child (NULL,
+                                           "operation", "gimp:levels",
+                                           "config",    config,
+                                           NULL);
+        }
+      else
+        {
+          config = g_object_new (GIMP_TYPE_HUE_SATURATION_CONFIG,
+                                 "hue",        0.05 * i,
+                                 "saturation", 0.1,
+                                 NULL);
+
+          operation = gegl_node_new_child (NULL,
+                                           "operation", "gimp:hue-saturation",
+                                           "config",    config,
+                                           NULL);
+        }
+
+      filters[i] = gimp_drawable_filter_new (GIMP_DRAWABLE (layer),
+                                             "Chained Filter", operation,
+                                             NULL);
+      g_object_unref (operation);
+      g_object_unref (config);
+
+      gimp_drawable_filter_apply (filters[i], NULL);
+    }
+
+  g_assert_cmpint (g_list_length (stack->fused_nodes), ==, 1);
+
+  fused   = g_new (gfloat, (gsize) size * size * 4);
+  unfused = g_new (gfloat, (gsize) size * size * 4);
+
+  /*  the filters stay linked to each other, so the top one's node
+   *  gives the result of applying them one by one
+   */
+  top = GIMP_FILTER (filters[GIMP_TEST_N_CHAINED_FILTERS - 1]);
+
+  fused_time   = blit_node (gimp_drawable_get_source_node (GIMP_DRAWABLE (layer)),
+                            size, n_passes, fused);
+  unfused_time = blit_node (gimp_filter_get_node (top),
+                            size, n_passes, unfused);
+
+  for (i = 0; i < size * size * 4; i++)
+    g_assert_cmpfloat (ABS (fused[i] - unfused[i]), <, 1e-4);
+
+  g_test_minimized_result (fused_time,
+                           "%d fused point filters on a %dx%d layer: "
+                           "%.3f ms per pass",
+                           GIMP_TEST_N_CHAINED_FILTERS, size, size,
+                           fused_time * 1000.0);
+  g_test_minimized_result (unfused_time,
+                           "%d chained point filters on a %dx%d layer: "
+                           "%.3f ms per pass",
+                           GIMP_TEST_N_CHAINED_FILTERS, size, size,
+                           unfused_time * 1000.0);
+
+  g_free (fused);
+  g_free (unfused);
+
+  for (i = GIMP_TEST_N_CHAINED_FILTERS - 1; i >= 0; i--)
+    {
+      gimp_drawable_filter_abort (filters[i]);
+      g_object_unref (filters[i]);
+    }
+
+  g_assert_cmpint (g_list_length (stack->fused_nodes), ==, 0);
+}
+
+/**
+ * white_graypoint_in_red_levels:
+ * @fixture:
+ * @data:
+ *
+ * Makes sure the levels algorithm can handle when the graypoint is
+ * white. It's easy to get a divide by zero problem when trying to
+ * calculate what gamma will give a white graypoint.
+ **/
+static void
+white_graypoint_in_red_levels (GimpTestFixture *fixture,
+                               gconstpointer    data)
+{
+  GimpRGB              black   = { 0, 0, 0, 0 };
+  GimpRGB              gray    = { 1, 1, 1, 1 };
+  GimpRGB              white   = { 1, 1, 1, 1 };
+  GimpHistogramChannel channel = GIMP_HISTOGRAM_RED;
+  GimpLevelsConfig    *config;
+
+  config = g_object_new (GIMP_TYPE_LEVELS_CONFIG, NULL);
+
+  gimp_levels_config_adjust_by_colors (config,
+                                       channel,
+                                       &black,
+                                       &gray,
+                                       &white);
+
+  /* Make sure we didn't end up with an invalid gamma value */
+  g_object_set (config,
+                "gamma", config->gamma[channel],
+                NULL);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* We share the same application instance across all tests */
+  gimp = gimp_init_for_testing ();
+
+  /* Add tests */
+  ADD_IMAGE_TEST (add_layer);
+  ADD_IMAGE_TEST (remove_layer);
+  ADD_IMAGE_TEST (rotate_non_overlapping);
+  ADD_IMAGE_TEST (fuse_point_filters);
+  ADD_IMAGE_TEST (fuse_point_filters_u8);
+  ADD_IMAGE_TEST (fuse_point_filters_chain);
+  ADD_TEST (white_graypoint_in_red_levels);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
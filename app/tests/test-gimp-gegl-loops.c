@@ -0,0 +1,369 @@
+/* GIMP - The GNU Image Manipulation Program
+ * Copyright (C) 1995 Spencer Kimball and Peter Mattis
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <gegl.h>
+#include <gtk/gtk.h>
+
+#include "libgimpbase/gimpbase.h"
+
+#include "core/core-types.h"
+
+#include "gegl/gimp-gegl-loops.h"
+
+#include "core/gimp.h"
+
+#include "tests.h"
+
+#include "gimp-app-test-utils.h"
+
+
+/*  the size of the buffer checked pixel by pixel.  odd sizes make
+ *  sure that the partial tiles and blocks at the edges are covered.
+ */
+#define GIMP_TEST_WIDTH  301
+#define GIMP_TEST_HEIGHT 173
+
+/*  the size of the buffer transformed when running with -m perf  */
+#define GIMP_TEST_PERF_WIDTH  30000
+#define GIMP_TEST_PERF_HEIGHT 20000
+
+#define ADD_TEST(function) \
+  g_test_add_data_func ("/gimp-gegl-loops/" #function, gimp, function);
+
+
+typedef enum
+{
+  TEST_ROTATE_90,
+  TEST_ROTATE_180,
+  TEST_ROTATE_270,
+  TEST_FLIP_HORIZONTAL,
+  TEST_FLIP_VERTICAL
+} TestTransform;
+
+
+static void
+transform_buffer (GeglBuffer          *src_buffer,
+                  const GeglRectangle *src_rect,
+                  GeglBuffer          *dest_buffer,
+                  const GeglRectangle *dest_rect,
+                  TestTransform        transform)
+{
+  switch (transform)
+    {
+    case TEST_ROTATE_90:
+      gimp_gegl_buffer_rotate (src_buffer, src_rect, dest_buffer, dest_rect,
+                               GIMP_ROTATE_90);
+      break;
+
+    case TEST_ROTATE_180:
+      gimp_gegl_buffer_rotate (src_buffer, src_rect, dest_buffer, dest_rect,
+                               GIMP_ROTATE_180);
+      break;
+
+    case TEST_ROTATE_270:
+      gimp_gegl_buffer_rotate (src_buffer, src_rect, dest_buffer, dest_rect,
+                               GIMP_ROTATE_270);
+      break;
+
+    case TEST_FLIP_HORIZONTAL:
+      gimp_gegl_buffer_flip (src_buffer, src_rect, dest_buffer, dest_rect,
+                             GIMP_ORIENTATION_HORIZONTAL);
+      break;
+
+    case TEST_FLIP_VERTICAL:
+      gimp_gegl_buffer_flip (src_buffer, src_rect, dest_buffer, dest_rect,
+                             GIMP_ORIENTATION_VERTICAL);
+      break;
+    }
+}
+
+static gboolean
+transform_is_transposing (TestTransform transform)
+{
+  return transform == TEST_ROTATE_90 || transform == TEST_ROTATE_270;
+}
+
+/*  maps the destination pixel (@u, @v) back to the source pixel it
+ *  must have been copied from
+ */
+static void
+transform_get_source (TestTransform  transform,
+                      gint           u,
+                      gint           v,
+                      gint          *x,
+                      gint          *y)
+{
+  switch (transform)
+    {
+    case TEST_ROTATE_90:
+      *x = v;
+      *y = GIMP_TEST_HEIGHT - 1 - u;
+      break;
+
+    case TEST_ROTATE_180:
+      *x = GIMP_TEST_WIDTH  - 1 - u;
+      *y = GIMP_TEST_HEIGHT - 1 - v;
+      break;
+
+    case TEST_ROTATE_270:
+      *x = GIMP_TEST_WIDTH - 1 - v;
+      *y = u;
+      break;
+
+    case TEST_FLIP_HORIZONTAL:
+      *x = GIMP_TEST_WIDTH - 1 - u;
+      *y = v;
+      break;
+
+    case TEST_FLIP_VERTICAL:
+      *x = u;
+      *y = GIMP_TEST_HEIGHT - 1 - v;
+      break;
+    }
+}
+
+/**
+ * check_transform:
+ * @transform:
+ *
+ * Transform a buffer whose pixels hold their own coordinates, into a
+ * destination rectangle that is offset from the origin, and make sure
+ * that every pixel ends up in the right place.
+ **/
+static void
+check_transform (TestTransform transform)
+{
+  const Babl    *format = babl_format ("RGBA float");
+  GeglRectangle  src_rect;
+  GeglRectangle  dest_rect;
+  GeglBuffer    *src_buffer;
+  GeglBuffer    *dest_buffer;
+  gfloat        *data;
+  gint           u, v;
+
+  src_rect = *GEGL_RECTANGLE (0, 0, GIMP_TEST_WIDTH, GIMP_TEST_HEIGHT);
+
+  if (transform_is_transposing (transform))
+    dest_rect = *GEGL_RECTANGLE (17, 5, GIMP_TEST_HEIGHT, GIMP_TEST_WIDTH);
+  else
+    dest_rect = *GEGL_RECTANGLE (17, 5, GIMP_TEST_WIDTH, GIMP_TEST_HEIGHT);
+
+  data = g_new (gfloat, GIMP_TEST_WIDTH * GIMP_TEST_HEIGHT * 4);
+
+  for (v = 0; v < GIMP_TEST_HEIGHT; v++)
+    for (u = 0; u < GIMP_TEST_WIDTH; u++)
+      {
+        gfloat *pixel = data + (v * GIMP_TEST_WIDTH + u) * 4;
+
+        pixel[0] = u;
+        pixel[1] = v;
+        pixel[2] = 0.0f;
+        pixel[3] = 1.0f;
+      }
+
+  src_buffer  = gegl_buffer_new (&src_rect,  format);
+  dest_buffer = gegl_buffer_new (&dest_rect, format);
+
+  gegl_buffer_set (src_buffer, &src_rect, 0, format, data,
+                   GEGL_AUTO_ROWSTRIDE);
+
+  transform_buffer (src_buffer, &src_rect, dest_buffer, &dest_rect,
+                    transform);
+
+  gegl_buffer_get (dest_buffer, &dest_rect, 1.0, format, data,
+                   GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (v = 0; v < dest_rect.height; v++)
+    for (u = 0; u < dest_rect.width; u++)
+      {
+        const gfloat *pixel = data + (v * dest_rect.width + u) * 4;
+        gint          x, y;
+
+        transform_get_source (transform, u, v, &x, &y);
+
+        g_assert_cmpint ((gint) pixel[0], ==, x);
+        g_assert_cmpint ((gint) pixel[1], ==, y);
+        g_assert_cmpfloat (pixel[3], ==, 1.0f);
+      }
+
+  g_object_unref (src_buffer);
+  g_object_unref (dest_buffer);
+
+  g_free (data);
+}
+
+/**
+ * benchmark_transform:
+ * @transform:
+ * @what:
+ *
+ * Time a single transform of a GIMP_TEST_PERF_WIDTH x
+ * GIMP_TEST_PERF_HEIGHT "RGBA float" buffer. Only done when running
+ * with "-m perf", since the buffers need several gigabytes of tile
+ * storage.
+ **/
+static void
+benchmark_transform (TestTransform  transform,
+                     const gchar   *what)
+{
+  const Babl    *format  = babl_format ("RGBA float");
+  const gfloat   color[] = { 0.25f, 0.5f, 0.75f, 1.0f };
+  GeglRectangle  src_rect;
+  GeglRectangle  dest_rect;
+  GeglBuffer    *src_buffer;
+  GeglBuffer    *dest_buffer;
+  GTimer        *timer;
+
+  if (! g_test_perf ())
+    return;
+
+  src_rect = *GEGL_RECTANGLE (0, 0,
+                              GIMP_TEST_PERF_WIDTH, GIMP_TEST_PERF_HEIGHT);
+
+  if (transform_is_transposing (transform))
+    dest_rect = *GEGL_RECTANGLE (0, 0,
+                                 GIMP_TEST_PERF_HEIGHT, GIMP_TEST_PERF_WIDTH);
+  else
+    dest_rect = src_rect;
+
+  src_buffer  = gegl_buffer_new (&src_rect,  format);
+  dest_buffer = gegl_buffer_new (&dest_rect, format);
+
+  gegl_buffer_set_color_from_pixel (src_buffer, &src_rect, color, format);
+
+  timer = g_timer_new ();
+
+  transform_buffer (src_buffer, &src_rect, dest_buffer, &dest_rect,
+                    transform);
+
+  g_timer_stop (timer);
+
+  g_test_minimized_result (g_timer_elapsed (timer, NULL),
+                           "%s of a %dx%d RGBA float buffer: %.3f ms",
+                           what,
+                           GIMP_TEST_PERF_WIDTH, GIMP_TEST_PERF_HEIGHT,
+                           g_timer_elapsed (timer, NULL) * 1000.0);
+
+  g_timer_destroy (timer);
+
+  g_object_unref (src_buffer);
+  g_object_unref (dest_buffer);
+}
+
+/**
+ * rotate_90:
+ * @data:
+ *
+ * Check gimp_gegl_buffer_rotate() with GIMP_ROTATE_90. Run with
+ * "-m perf" to also use this as a benchmark.
+ **/
+static void
+rotate_90 (gconstpointer data)
+{
+  check_transform (TEST_ROTATE_90);
+  benchmark_transform (TEST_ROTATE_90, "rotating by 90 degrees");
+}
+
+/**
+ * rotate_180:
+ * @data:
+ *
+ * Check gimp_gegl_buffer_rotate() with GIMP_ROTATE_180. Run with
+ * "-m perf" to also use this as a benchmark.
+ **/
+static void
+rotate_180 (gconstpointer data)
+{
+  check_transform (TEST_ROTATE_180);
+  benchmark_transform (TEST_ROTATE_180, "rotating by 180 degrees");
+}
+
+/**
+ * rotate_270:
+ * @data:
+ *
+ * Check gimp_gegl_buffer_rotate() with GIMP_ROTATE_270. Run with
+ * "-m perf" to also use this as a benchmark.
+ **/
+static void
+rotate_270 (gconstpointer data)
+{
+  check_transform (TEST_ROTATE_270);
+  benchmark_transform (TEST_ROTATE_270, "rotating by 270 degrees");
+}
+
+/**
+ * flip_horizontal:
+ * @data:
+ *
+ * Check gimp_gegl_buffer_flip() with GIMP_ORIENTATION_HORIZONTAL.
+ * Run with "-m perf" to also use this as a benchmark.
+ **/
+static void
+flip_horizontal (gconstpointer data)
+{
+  check_transform (TEST_FLIP_HORIZONTAL);
+  benchmark_transform (TEST_FLIP_HORIZONTAL, "flipping horizontally");
+}
+
+/**
+ * flip_vertical:
+ * @data:
+ *
+ * Check gimp_gegl_buffer_flip() with GIMP_ORIENTATION_VERTICAL. Run
+ * with "-m perf" to also use this as a benchmark.
+ **/
+static void
+flip_vertical (gconstpointer data)
+{
+  check_transform (TEST_FLIP_VERTICAL);
+  benchmark_transform (TEST_FLIP_VERTICAL, "flipping vertically");
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  Gimp *gimp;
+  int   result;
+
+  g_test_init (&argc, &argv, NULL);
+
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_SRCDIR",
+                                       "app/tests/gimpdir");
+
+  /* The GEGL configuration, like the number of threads, comes from Gimp */
+  gimp = gimp_init_for_testing ();
+
+  ADD_TEST (rotate_90);
+  ADD_TEST (rotate_180);
+  ADD_TEST (rotate_270);
+  ADD_TEST (flip_horizontal);
+  ADD_TEST (flip_vertical);
+
+  /* Run the tests */
+  result = g_test_run ();
+
+  /* Don't write files to the source dir */
+  gimp_test_utils_set_gimp3_directory ("GIMP_TESTING_ABS_TOP_BUILDDIR",
+                                       "app/tests/gimpdir-output");
+
+  /* Exit so we don't break script-fu plug-in wire */
+  gimp_exit (gimp, TRUE);
+
+  return result;
+}
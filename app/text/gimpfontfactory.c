@@ -23,7 +23,10 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib/gstdio.h>
 #include <pango/pangocairo.h>
 #include <pango/pangofc-fontmap.h>
 #include <gegl.h>
@@ -43,6 +46,8 @@
 #include "gimpfont.h"
 #include "gimpfontfactory.h"
 
+#include "gimp-log.h"
+
 #include "gimp-intl.h"
 
 
@@ -55,7 +60,52 @@
 #include <fontconfig/fontconfig.h>
 #endif
 
-#define CONF_FNAME "fonts.conf"
+#define CONF_FNAME  "fonts.conf"
+#define INDEX_FNAME "fontindex"
+
+
+enum
+{
+  CONFIG_HASH = 1,
+  DIRECTORY
+};
+
+
+typedef struct _GimpFontDir      GimpFontDir;
+typedef struct _GimpFontDirEntry GimpFontDirEntry;
+typedef struct _GimpFontLoad     GimpFontLoad;
+
+/* a directory of the font path, as found on disk */
+struct _GimpFontDir
+{
+  GFile    *file;
+  gchar    *path;
+  gint64    mtime;
+  gboolean  enumerated;
+  GList    *fonts;     /* font files in this directory     */
+  GList    *children;  /* a GimpFontDir per subdirectory   */
+  gboolean  unchanged; /* whole subtree is as in the index */
+  gint      n_failed;  /* font files which failed to load  */
+};
+
+/* a directory as recorded in the font index */
+struct _GimpFontDirEntry
+{
+  gint64 mtime;
+  gint   n_failed;
+};
+
+struct _GimpFontLoad
+{
+  FcConfig  *config;
+  GList     *path;
+  GFile     *index_file;
+  gchar     *config_hash;
+  gboolean   be_verbose;
+
+  GPtrArray *names;
+  GError    *error;
+};
 
 
 struct _GimpFontFactoryPrivate
@@ -79,20 +129,39 @@ static gboolean   gimp_font_factory_data_delete     (GimpDataFactory *factory,
                                                      gboolean         delete_from_disk,
                                                      GError         **error);
 
-static void       gimp_font_factory_load            (GimpFontFactory *factory,
-                                                     GError         **error);
+static void       gimp_font_factory_load            (GimpFontFactory *factory);
 static gboolean   gimp_font_factory_load_fonts_conf (FcConfig        *config,
                                                      GFile           *fonts_conf);
+static gchar    * gimp_font_factory_get_config_hash (FcConfig        *config);
+
+static GHashTable *
+                  gimp_font_factory_index_read      (GFile           *file,
+                                                     const gchar     *config_hash);
+static void       gimp_font_factory_index_write     (GFile           *file,
+                                                     const gchar     *config_hash,
+                                                     GList           *dirs);
+
+static GimpFontDir *
+                  gimp_font_factory_scan_fontdir    (GFile           *file,
+                                                     gint64           mtime,
+                                                     GHashTable      *index,
+                                                     gint            *n_dirs);
+static void       gimp_font_factory_free_fontdir    (GimpFontDir     *dir);
 static void       gimp_font_factory_add_directories (FcConfig        *config,
-                                                     GList           *path,
+                                                     GList           *dirs,
+                                                     gint            *n_scanned,
                                                      GError         **error);
-static void       gimp_font_factory_recursive_add_fontdir
-                                                    (FcConfig        *config,
-                                                     GFile           *file,
+static void       gimp_font_factory_add_fontdir     (FcConfig        *config,
+                                                     GimpFontDir     *dir,
+                                                     gint            *n_scanned,
                                                      GError         **error);
+
+static GPtrArray *
+                  gimp_font_factory_list_names      (FcConfig        *config);
 static void       gimp_font_factory_load_names      (GimpContainer   *container,
                                                      PangoFontMap    *fontmap,
-                                                     PangoContext    *context);
+                                                     PangoContext    *context,
+                                                     GPtrArray       *names);
 
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpFontFactory, gimp_font_factory,
@@ -124,34 +193,14 @@ static void
 gimp_font_factory_data_init (GimpDataFactory *factory,
                              GimpContext     *context)
 {
-  GError *error = NULL;
-
-  gimp_font_factory_load (GIMP_FONT_FACTORY (factory), &error);
-
-  if (error)
-    {
-      gimp_message_literal (gimp_data_factory_get_gimp (factory), NULL,
-                            GIMP_MESSAGE_INFO,
-                            error->message);
-      g_error_free (error);
-    }
+  gimp_font_factory_load (GIMP_FONT_FACTORY (factory));
 }
 
 static void
 gimp_font_factory_data_refresh (GimpDataFactory *factory,
                                 GimpContext     *context)
 {
-  GError *error = NULL;
-
-  gimp_font_factory_load (GIMP_FONT_FACTORY (factory), &error);
-
-  if (error)
-    {
-      gimp_message_literal (gimp_data_factory_get_gimp (factory), NULL,
-                            GIMP_MESSAGE_INFO,
-                            error->message);
-      g_error_free (error);
-    }
+  gimp_font_factory_load (GIMP_FONT_FACTORY (factory));
 }
 
 static void
@@ -224,16 +273,100 @@ gimp_font_factory_new (Gimp        *gimp,
 /*  private functions  */
 
 static void
-gimp_font_factory_load_async (GimpAsync *async,
-                              FcConfig  *config)
+gimp_font_factory_load_free (GimpFontLoad *load)
+{
+  if (load->config)
+    FcConfigDestroy (load->config);
+
+  g_list_free_full (load->path, (GDestroyNotify) g_object_unref);
+  g_object_unref (load->index_file);
+  g_free (load->config_hash);
+
+  if (load->names)
+    g_ptr_array_unref (load->names);
+
+  g_clear_error (&load->error);
+
+  g_slice_free (GimpFontLoad, load);
+}
+
+static gint64
+gimp_font_factory_get_mtime (GFileInfo *info)
+{
+  guint64 mtime;
+  guint32 usec;
+
+  mtime = g_file_info_get_attribute_uint64 (info,
+                                            G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  usec  = g_file_info_get_attribute_uint32 (info,
+                                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+
+  return (gint64) mtime * G_USEC_PER_SEC + usec;
+}
+
+static void
+gimp_font_factory_load_async (GimpAsync    *async,
+                              GimpFontLoad *load)
 {
-  if (FcConfigBuildFonts (config))
+  GHashTable *index;
+  GList      *dirs      = NULL;
+  GList      *list;
+  gint        n_dirs    = 0;
+  gint        n_scanned = 0;
+
+  index = gimp_font_factory_index_read (load->index_file, load->config_hash);
+
+  for (list = load->path; list; list = g_list_next (list))
     {
-      gimp_async_finish (async, config);
+      GFileInfo *info;
+      gint64     mtime = 0;
+
+      /* The configured directories must exist or be created. */
+      g_file_make_directory_with_parents (list->data, NULL, NULL);
+
+      info = g_file_query_info (list->data,
+                                G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                                G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                                G_FILE_QUERY_INFO_NONE,
+                                NULL, NULL);
+
+      if (info)
+        {
+          mtime = gimp_font_factory_get_mtime (info);
+
+          g_object_unref (info);
+        }
+
+      dirs = g_list_prepend (dirs,
+                             gimp_font_factory_scan_fontdir (list->data, mtime,
+                                                             index, &n_dirs));
+    }
+
+  dirs = g_list_reverse (dirs);
+
+  gimp_font_factory_add_directories (load->config, dirs, &n_scanned,
+                                     &load->error);
+
+  if (load->be_verbose)
+    g_print ("Font directories: %d rescanned, %d from cache\n",
+             n_scanned, n_dirs - n_scanned);
+
+  if (n_scanned > 0 || g_hash_table_size (index) != n_dirs)
+    gimp_font_factory_index_write (load->index_file, load->config_hash, dirs);
+
+  g_list_free_full (dirs, (GDestroyNotify) gimp_font_factory_free_fontdir);
+  g_hash_table_unref (index);
+
+  if (FcConfigBuildFonts (load->config))
+    {
+      load->names = gimp_font_factory_list_names (load->config);
+
+      gimp_async_finish_full (async, load,
+                              (GDestroyNotify) gimp_font_factory_load_free);
     }
   else
     {
-      FcConfigDestroy (config);
+      gimp_font_factory_load_free (load);
 
       gimp_async_abort (async);
     }
@@ -255,11 +388,11 @@ gimp_font_factory_load_async_callback (GimpAsync       *async,
 
   if (gimp_async_is_finished (async))
     {
-      FcConfig     *config = gimp_async_get_result (async);
+      GimpFontLoad *load = gimp_async_get_result (async);
       PangoFontMap *fontmap;
       PangoContext *context;
 
-      FcConfigSetCurrent (config);
+      FcConfigSetCurrent (load->config);
 
       fontmap = pango_cairo_font_map_new_for_font_type (CAIRO_FONT_TYPE_FT);
       if (! fontmap)
@@ -271,17 +404,28 @@ gimp_font_factory_load_async_callback (GimpAsync       *async,
       context = pango_font_map_create_context (fontmap);
       g_object_unref (fontmap);
 
-      gimp_font_factory_load_names (container, PANGO_FONT_MAP (fontmap), context);
+      gimp_font_factory_load_names (container, PANGO_FONT_MAP (fontmap), context,
+                                    load->names);
       g_object_unref (context);
-      FcConfigDestroy (config);
+
+      g_clear_pointer (&load->config, FcConfigDestroy);
+
+      if (load->error)
+        {
+          Gimp *gimp = gimp_data_factory_get_gimp (GIMP_DATA_FACTORY (factory));
+
+          gimp_message_literal (gimp, NULL, GIMP_MESSAGE_INFO,
+                                load->error->message);
+        }
     }
 
   gimp_container_thaw (container);
+
+  gimp_log_trace_mark ("Fonts loaded");
 }
 
 static void
-gimp_font_factory_load (GimpFontFactory  *factory,
-                        GError          **error)
+gimp_font_factory_load (GimpFontFactory *factory)
 {
   GimpContainer *container;
   Gimp          *gimp;
@@ -289,6 +433,7 @@ gimp_font_factory_load (GimpFontFactory  *factory,
   FcConfig      *config;
   GFile         *fonts_conf;
   GList         *path;
+  GimpFontLoad  *load;
   GimpAsync     *async;
 
   async_set = gimp_data_factory_get_async_set (GIMP_DATA_FACTORY (factory));
@@ -330,17 +475,22 @@ gimp_font_factory_load (GimpFontFactory  *factory,
   gimp_container_freeze (container);
   gimp_container_clear (container);
 
-  gimp_font_factory_add_directories (config, path, error);
-  g_list_free_full (path, (GDestroyNotify) g_object_unref);
+  load = g_slice_new0 (GimpFontLoad);
 
-  /* We perform font cache initialization in a separate thread, so
-   * in the case a cache rebuild is to be done it will not block
-   * the UI.
+  load->config      = config;
+  load->path        = path;
+  load->index_file  = gimp_directory_file (INDEX_FNAME, NULL);
+  load->config_hash = gimp_font_factory_get_config_hash (config);
+  load->be_verbose  = gimp->be_verbose;
+
+  /* We scan our font directories and perform font cache
+   * initialization in a separate thread, so in the case a cache
+   * rebuild is to be done it will not block the UI.
    */
   async = gimp_parallel_run_async_independent_full (
     +10,
     (GimpRunAsyncFunc) gimp_font_factory_load_async,
-    config);
+    load);
 
   gimp_async_add_callback_for_object (
     async,
@@ -368,59 +518,226 @@ gimp_font_factory_load_fonts_conf (FcConfig *config,
   return ret;
 }
 
-static void
-gimp_font_factory_add_directories (FcConfig  *config,
-                                   GList     *path,
-                                   GError   **error)
+/* Identifies the fontconfig version and configuration the font index
+ * was built with.  Whether a font file can be loaded depends on both,
+ * so the whole index is invalid when this changes.
+ */
+static gchar *
+gimp_font_factory_get_config_hash (FcConfig *config)
 {
-  GList *list;
+  GChecksum *checksum = g_checksum_new (G_CHECKSUM_MD5);
+  FcStrList *files;
+  FcChar8   *file;
+  gint       version  = FcGetVersion ();
+  gchar     *hash;
+
+  g_checksum_update (checksum, (const guchar *) &version, sizeof (version));
 
-  for (list = path; list; list = list->next)
+  files = FcConfigGetConfigFiles (config);
+
+  while ((file = FcStrListNext (files)))
     {
-      /* The configured directories must exist or be created. */
-      g_file_make_directory_with_parents (list->data, NULL, NULL);
+      GStatBuf st;
+
+      g_checksum_update (checksum, file, strlen ((const gchar *) file) + 1);
 
-      /* Do not use FcConfigAppFontAddDir(). Instead use
-       * FcConfigAppFontAddFile() with our own recursive loop.
-       * Otherwise, when some fonts fail to load (e.g. permission
-       * issues), we end up in weird situations where the fonts are in
-       * the list, but are unusable and output many errors.
-       * See bug 748553.
-       */
-      gimp_font_factory_recursive_add_fontdir (config, list->data, error);
+      if (! g_stat ((const gchar *) file, &st))
+        {
+          gint64 mtime = st.st_mtime;
+
+          g_checksum_update (checksum,
+                             (const guchar *) &mtime, sizeof (mtime));
+        }
     }
 
-  if (error && *error)
+  FcStrListDone (files);
+
+  hash = g_strdup (g_checksum_get_string (checksum));
+
+  g_checksum_free (checksum);
+
+  return hash;
+}
+
+/* Reads the font index, which maps every directory of the font path
+ * to its mtime and the number of font files in it which failed to
+ * load.  Returns an empty table if there is no index, or if it was
+ * written for a different configuration.
+ */
+static GHashTable *
+gimp_font_factory_index_read (GFile       *file,
+                              const gchar *config_hash)
+{
+  GHashTable *index;
+  GScanner   *scanner;
+  GTokenType  token;
+  gboolean    valid = FALSE;
+
+  index = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                 (GDestroyNotify) g_free,
+                                 (GDestroyNotify) g_free);
+
+  scanner = gimp_scanner_new_file (file, NULL);
+  if (! scanner)
+    return index;
+
+  g_scanner_scope_add_symbol (scanner, 0, "config-hash",
+                              GINT_TO_POINTER (CONFIG_HASH));
+  g_scanner_scope_add_symbol (scanner, 0, "directory",
+                              GINT_TO_POINTER (DIRECTORY));
+
+  token = G_TOKEN_LEFT_PAREN;
+
+  while (g_scanner_peek_next_token (scanner) == token)
     {
-      gchar *font_list = g_strdup ((*error)->message);
+      token = g_scanner_get_next_token (scanner);
 
-      g_clear_error (error);
-      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
-                   _("Some fonts failed to load:\n%s"), font_list);
-      g_free (font_list);
+      switch (token)
+        {
+        case G_TOKEN_LEFT_PAREN:
+          token = G_TOKEN_SYMBOL;
+          break;
+
+        case G_TOKEN_SYMBOL:
+          if (scanner->value.v_symbol == GINT_TO_POINTER (CONFIG_HASH))
+            {
+              gchar *hash = NULL;
+
+              if (! gimp_scanner_parse_string (scanner, &hash))
+                goto error;
+
+              valid = ! g_strcmp0 (hash, config_hash);
+
+              g_free (hash);
+
+              if (! valid)
+                goto error;
+            }
+          else if (scanner->value.v_symbol == GINT_TO_POINTER (DIRECTORY))
+            {
+              GimpFontDirEntry *entry;
+              gchar            *path = NULL;
+
+              if (! valid)
+                goto error;
+
+              entry = g_new0 (GimpFontDirEntry, 1);
+
+              if (! gimp_scanner_parse_string_no_validate (scanner, &path) ||
+                  ! gimp_scanner_parse_int64 (scanner, &entry->mtime)      ||
+                  ! gimp_scanner_parse_int (scanner, &entry->n_failed))
+                {
+                  g_free (path);
+                  g_free (entry);
+
+                  goto error;
+                }
+
+              g_hash_table_insert (index, path, entry);
+            }
+          token = G_TOKEN_RIGHT_PAREN;
+          break;
+
+        case G_TOKEN_RIGHT_PAREN:
+          token = G_TOKEN_LEFT_PAREN;
+          break;
+
+        default: /* do nothing */
+          break;
+        }
     }
+
+  gimp_scanner_unref (scanner);
+
+  return index;
+
+ error:
+  g_hash_table_remove_all (index);
+
+  gimp_scanner_unref (scanner);
+
+  return index;
 }
 
 static void
-gimp_font_factory_recursive_add_fontdir (FcConfig  *config,
-                                         GFile     *file,
-                                         GError   **error)
+gimp_font_factory_index_write_fontdir (GimpConfigWriter *writer,
+                                       GimpFontDir      *dir)
 {
-  GFileEnumerator *enumerator;
+  GList *list;
 
-  g_return_if_fail (config != NULL);
+  if (dir->path)
+    {
+      gimp_config_writer_open (writer, "directory");
+      gimp_config_writer_string (writer, dir->path);
+      gimp_config_writer_printf (writer, "%" G_GINT64_FORMAT " %d",
+                                 dir->mtime, dir->n_failed);
+      gimp_config_writer_close (writer);
+    }
+
+  for (list = dir->children; list; list = g_list_next (list))
+    gimp_font_factory_index_write_fontdir (writer, list->data);
+}
+
+static void
+gimp_font_factory_index_write (GFile       *file,
+                               const gchar *config_hash,
+                               GList       *dirs)
+{
+  GimpConfigWriter *writer;
+  GList            *list;
+
+  writer = gimp_config_writer_new_from_file (file,
+                                             TRUE,
+                                             "GIMP fontindex\n\n"
+                                             "This file records which font "
+                                             "directories loaded without "
+                                             "errors.  It will be recreated "
+                                             "when needed.",
+                                             NULL);
+  if (! writer)
+    return;
+
+  gimp_config_writer_open (writer, "config-hash");
+  gimp_config_writer_string (writer, config_hash);
+  gimp_config_writer_close (writer);
+
+  for (list = dirs; list; list = g_list_next (list))
+    gimp_font_factory_index_write_fontdir (writer, list->data);
+
+  gimp_config_writer_finish (writer, "end of fontindex", NULL);
+}
+
+static GimpFontDir *
+gimp_font_factory_scan_fontdir (GFile      *file,
+                                gint64      mtime,
+                                GHashTable *index,
+                                gint       *n_dirs)
+{
+  GimpFontDir      *dir = g_slice_new0 (GimpFontDir);
+  GimpFontDirEntry *entry;
+  GFileEnumerator  *enumerator;
+  GList            *list;
+
+  dir->file  = g_object_ref (file);
+  dir->path  = g_file_get_path (file);
+  dir->mtime = mtime;
+
+  (*n_dirs)++;
 
   enumerator = g_file_enumerate_children (file,
                                           G_FILE_ATTRIBUTE_STANDARD_NAME ","
                                           G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN ","
                                           G_FILE_ATTRIBUTE_STANDARD_TYPE ","
-                                          G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                          G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                                          G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
                                           G_FILE_QUERY_INFO_NONE,
                                           NULL, NULL);
   if (enumerator)
     {
       GFileInfo *info;
 
+      dir->enumerated = TRUE;
+
       while ((info = g_file_enumerator_next_file (enumerator, NULL, NULL)))
         {
           GFileType  file_type;
@@ -437,47 +754,17 @@ gimp_font_factory_recursive_add_fontdir (FcConfig  *config,
 
           if (file_type == G_FILE_TYPE_DIRECTORY)
             {
-              gimp_font_factory_recursive_add_fontdir (config, child, error);
+              GimpFontDir *subdir;
+
+              subdir = gimp_font_factory_scan_fontdir (child,
+                                                       gimp_font_factory_get_mtime (info),
+                                                       index, n_dirs);
+
+              dir->children = g_list_prepend (dir->children, subdir);
             }
           else if (file_type == G_FILE_TYPE_REGULAR)
             {
-              gchar *path = g_file_get_path (child);
-#ifdef G_OS_WIN32
-              gchar *tmp = g_win32_locale_filename_from_utf8 (path);
-
-              g_free (path);
-              /* XXX: g_win32_locale_filename_from_utf8() may return
-               * NULL. So we need to check that path is not NULL before
-               * trying to load with fontconfig.
-               */
-              path = tmp;
-#endif
-
-              if (! path ||
-                  FcFalse == FcConfigAppFontAddFile (config, (const FcChar8 *) path))
-                {
-                  g_printerr ("%s: adding font file '%s' failed.\n",
-                              G_STRFUNC, path);
-                  if (error)
-                    {
-                      if (*error)
-                        {
-                          gchar *current_message = g_strdup ((*error)->message);
-
-                          g_clear_error (error);
-                          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
-                                       "%s\n- %s", current_message, path);
-                          g_free (current_message);
-                        }
-                      else
-                        {
-                          g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
-                                       "- %s", path);
-                        }
-                    }
-                }
-
-              g_free (path);
+              dir->fonts = g_list_prepend (dir->fonts, g_object_ref (child));
             }
 
           g_object_unref (child);
@@ -485,43 +772,178 @@ gimp_font_factory_recursive_add_fontdir (FcConfig  *config,
         }
 
       g_object_unref (enumerator);
+
+      dir->fonts    = g_list_reverse (dir->fonts);
+      dir->children = g_list_reverse (dir->children);
+    }
+
+  entry = dir->path ? g_hash_table_lookup (index, dir->path) : NULL;
+
+  dir->unchanged = (dir->enumerated         &&
+                    entry                   &&
+                    entry->mtime    == mtime &&
+                    entry->n_failed == 0);
+
+  for (list = dir->children; list; list = g_list_next (list))
+    {
+      GimpFontDir *subdir = list->data;
+
+      if (! subdir->unchanged)
+        dir->unchanged = FALSE;
+    }
+
+  return dir;
+}
+
+static void
+gimp_font_factory_free_fontdir (GimpFontDir *dir)
+{
+  g_list_free_full (dir->children,
+                    (GDestroyNotify) gimp_font_factory_free_fontdir);
+  g_list_free_full (dir->fonts, (GDestroyNotify) g_object_unref);
+  g_object_unref (dir->file);
+  g_free (dir->path);
+
+  g_slice_free (GimpFontDir, dir);
+}
+
+static void
+gimp_font_factory_add_directories (FcConfig  *config,
+                                   GList     *dirs,
+                                   gint      *n_scanned,
+                                   GError   **error)
+{
+  GList *list;
+
+  for (list = dirs; list; list = g_list_next (list))
+    gimp_font_factory_add_fontdir (config, list->data, n_scanned, error);
+
+  if (error && *error)
+    {
+      gchar *font_list = g_strdup ((*error)->message);
+
+      g_clear_error (error);
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                   _("Some fonts failed to load:\n%s"), font_list);
+      g_free (font_list);
+    }
+}
+
+static gchar *
+gimp_font_factory_get_fc_path (GFile *file)
+{
+  gchar *path = g_file_get_path (file);
+
+#ifdef G_OS_WIN32
+  gchar *tmp = g_win32_locale_filename_from_utf8 (path);
+
+  g_free (path);
+  /* XXX: g_win32_locale_filename_from_utf8() may return
+   * NULL. So we need to check that path is not NULL before
+   * trying to load with fontconfig.
+   */
+  path = tmp;
+#endif
+
+  return path;
+}
+
+static void
+gimp_font_factory_append_error (GError      **error,
+                                const gchar  *path,
+                                const gchar  *suffix)
+{
+  if (! error)
+    return;
+
+  if (*error)
+    {
+      gchar *current_message = g_strdup ((*error)->message);
+
+      g_clear_error (error);
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                   "%s\n- %s%s", current_message, path, suffix);
+      g_free (current_message);
     }
   else
     {
-      if (error)
-        {
-          gchar *path = g_file_get_path (file);
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                   "- %s%s", path, suffix);
+    }
+}
 
-          if (*error)
-            {
-              gchar *current_message = g_strdup ((*error)->message);
+static void
+gimp_font_factory_add_fontdir (FcConfig     *config,
+                               GimpFontDir  *dir,
+                               gint         *n_scanned,
+                               GError      **error)
+{
+  GList *list;
 
-              g_clear_error (error);
-              g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
-                           "%s\n- %s%s", current_message, path,
-                           G_DIR_SEPARATOR_S);
-              g_free (current_message);
-            }
-          else
-            {
-              g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
-                           "- %s%s", path, G_DIR_SEPARATOR_S);
-            }
+  g_return_if_fail (config != NULL);
+
+  /* Directories in which all fonts loaded fine last time, and which
+   * didn't change since, can be added as a whole, which lets
+   * fontconfig use its own per-directory cache instead of querying
+   * every single font file.
+   */
+  if (dir->unchanged)
+    {
+      gchar    *path  = gimp_font_factory_get_fc_path (dir->file);
+      gboolean  added = FALSE;
+
+      if (path)
+        added = FcConfigAppFontAddDir (config, (const FcChar8 *) path);
+
+      g_free (path);
+
+      if (added)
+        return;
+    }
+
+  if (! dir->enumerated)
+    {
+      gimp_font_factory_append_error (error, dir->path, G_DIR_SEPARATOR_S);
+      dir->n_failed++;
+
+      return;
+    }
 
-          g_free (path);
+  (*n_scanned)++;
+
+  /* Do not use FcConfigAppFontAddDir() on directories we don't know
+   * to be fine. Instead use FcConfigAppFontAddFile() on each file.
+   * Otherwise, when some fonts fail to load (e.g. permission issues),
+   * we end up in weird situations where the fonts are in the list,
+   * but are unusable and output many errors.  See bug 748553.
+   */
+  for (list = dir->fonts; list; list = g_list_next (list))
+    {
+      gchar *path = gimp_font_factory_get_fc_path (list->data);
+
+      if (! path ||
+          FcFalse == FcConfigAppFontAddFile (config, (const FcChar8 *) path))
+        {
+          g_printerr ("%s: adding font file '%s' failed.\n",
+                      G_STRFUNC, path);
+          gimp_font_factory_append_error (error, path, "");
+          dir->n_failed++;
         }
+
+      g_free (path);
     }
+
+  for (list = dir->children; list; list = g_list_next (list))
+    gimp_font_factory_add_fontdir (config, list->data, n_scanned, error);
 }
 
-static void
-gimp_font_factory_add_font (GimpContainer        *container,
-                            PangoContext         *context,
-                            PangoFontDescription *desc)
+static gchar *
+gimp_font_factory_get_font_name (PangoFontDescription *desc)
 {
   gchar *name;
 
   if (! desc)
-    return;
+    return NULL;
 
   name = pango_font_description_to_string (desc);
 
@@ -531,19 +953,27 @@ gimp_font_factory_add_font (GimpContainer        *container,
    */
   if (name && strlen (name) > 0 &&
       g_utf8_validate (name, -1, NULL))
-    {
-      GimpFont *font;
+    return name;
 
-      font = g_object_new (GIMP_TYPE_FONT,
-                           "name",          name,
-                           "pango-context", context,
-                           NULL);
+  g_free (name);
 
-      gimp_container_add (container, GIMP_OBJECT (font));
-      g_object_unref (font);
-    }
+  return NULL;
+}
 
-  g_free (name);
+static void
+gimp_font_factory_add_font (GimpContainer *container,
+                            PangoContext  *context,
+                            const gchar   *name)
+{
+  GimpFont *font;
+
+  font = g_object_new (GIMP_TYPE_FONT,
+                       "name",          name,
+                       "pango-context", context,
+                       NULL);
+
+  gimp_container_add (container, GIMP_OBJECT (font));
+  g_object_unref (font);
 }
 
 #ifdef USE_FONTCONFIG_DIRECTLY
@@ -560,6 +990,7 @@ gimp_font_factory_make_alias (GimpContainer *container,
                               gboolean       italic)
 {
   PangoFontDescription *desc = pango_font_description_new ();
+  gchar                *name;
 
   pango_font_description_set_family (desc, family);
   pango_font_description_set_style (desc,
@@ -571,8 +1002,12 @@ gimp_font_factory_make_alias (GimpContainer *container,
                                      PANGO_WEIGHT_BOLD : PANGO_WEIGHT_NORMAL);
   pango_font_description_set_stretch (desc, PANGO_STRETCH_NORMAL);
 
-  gimp_font_factory_add_font (container, context, desc);
+  name = gimp_font_factory_get_font_name (desc);
 
+  if (name)
+    gimp_font_factory_add_font (container, context, name);
+
+  g_free (name);
   pango_font_description_free (desc);
 }
 
@@ -596,58 +1031,90 @@ gimp_font_factory_load_aliases (GimpContainer *container,
     }
 }
 
-static void
-gimp_font_factory_load_names (GimpContainer *container,
-                              PangoFontMap  *fontmap,
-                              PangoContext  *context)
+/* Builds the font names while still in the loading thread, so only
+ * creating the GimpFont objects is left for the main thread.
+ */
+static GPtrArray *
+gimp_font_factory_list_names (FcConfig *config)
 {
   FcObjectSet *os;
   FcPattern   *pat;
   FcFontSet   *fontset;
+  GPtrArray   *names;
   gint         i;
 
   os = FcObjectSetBuild (FC_FAMILY, FC_STYLE,
                          FC_SLANT, FC_WEIGHT, FC_WIDTH,
                          NULL);
-  g_return_if_fail (os);
+  g_return_val_if_fail (os, NULL);
 
   pat = FcPatternCreate ();
   if (! pat)
     {
       FcObjectSetDestroy (os);
       g_critical ("%s: FcPatternCreate() returned NULL.", G_STRFUNC);
-      return;
+      return NULL;
     }
 
-  fontset = FcFontList (NULL, pat, os);
+  fontset = FcFontList (config, pat, os);
 
   FcPatternDestroy (pat);
   FcObjectSetDestroy (os);
 
-  g_return_if_fail (fontset);
+  g_return_val_if_fail (fontset, NULL);
+
+  names = g_ptr_array_new_full (fontset->nfont, (GDestroyNotify) g_free);
 
   for (i = 0; i < fontset->nfont; i++)
     {
       PangoFontDescription *desc;
+      gchar                *name;
 
       desc = pango_fc_font_description_from_pattern (fontset->fonts[i], FALSE);
-      gimp_font_factory_add_font (container, context, desc);
+      name = gimp_font_factory_get_font_name (desc);
       pango_font_description_free (desc);
+
+      if (name)
+        g_ptr_array_add (names, name);
     }
 
+  FcFontSetDestroy (fontset);
+
+  return names;
+}
+
+static void
+gimp_font_factory_load_names (GimpContainer *container,
+                              PangoFontMap  *fontmap,
+                              PangoContext  *context,
+                              GPtrArray     *names)
+{
+  gint i;
+
+  if (! names)
+    return;
+
+  for (i = 0; i < names->len; i++)
+    gimp_font_factory_add_font (container, context, names->pdata[i]);
+
   /*  only create aliases if there is at least one font available  */
-  if (fontset->nfont > 0)
+  if (names->len > 0)
     gimp_font_factory_load_aliases (container, context);
-
-  FcFontSetDestroy (fontset);
 }
 
 #else  /* ! USE_FONTCONFIG_DIRECTLY */
 
+static GPtrArray *
+gimp_font_factory_list_names (FcConfig *config)
+{
+  return NULL;
+}
+
 static void
 gimp_font_factory_load_names (GimpContainer *container,
                               PangoFontMap  *fontmap,
-                              PangoContext  *context)
+                              PangoContext  *context,
+                              GPtrArray     *names)
 {
   PangoFontFamily **families;
   PangoFontFace   **faces;
@@ -664,10 +1131,16 @@ gimp_font_factory_load_names (GimpContainer *container,
       for (j = 0; j < n_faces; j++)
         {
           PangoFontDescription *desc;
+          gchar                *name;
 
           desc = pango_font_face_describe (faces[j]);
-          gimp_font_factory_add_font (container, context, desc);
+          name = gimp_font_factory_get_font_name (desc);
           pango_font_description_free (desc);
+
+          if (name)
+            gimp_font_factory_add_font (container, context, name);
+
+          g_free (name);
         }
     }
 
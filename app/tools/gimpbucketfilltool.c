@@ -65,6 +65,9 @@
 #include "gimp-intl.h"
 
 
+#define MAX_PREVIEW_LEVEL 8
+
+
 struct _GimpBucketFillToolPrivate
 {
   GimpLineArt        *line_art;
@@ -74,10 +77,18 @@ struct _GimpBucketFillToolPrivate
   /* For preview */
   GeglNode           *graph;
   GeglNode           *fill_node;
+  GeglNode           *scale_node;
   GeglNode           *offset_node;
 
   GeglBuffer         *fill_mask;
 
+  /* For downscaled previews */
+  gint                preview_level;
+  GeglBuffer         *preview_mask;
+  GimpFillOptions    *fill_options;
+  GArray             *seeds;
+  GimpAsync          *fill_async;
+
   GimpDrawableFilter *filter;
 
   /* Temp property save */
@@ -141,6 +152,22 @@ static void     gimp_bucket_fill_tool_halt             (GimpBucketFillTool    *t
 static void     gimp_bucket_fill_tool_filter_flush     (GimpDrawableFilter    *filter,
                                                         GimpTool              *tool);
 static void     gimp_bucket_fill_tool_create_graph     (GimpBucketFillTool    *tool);
+static void     gimp_bucket_fill_tool_set_fill         (GimpBucketFillTool    *tool,
+                                                        GeglBuffer            *fill,
+                                                        gint                   level,
+                                                        gdouble                x,
+                                                        gdouble                y);
+
+static gint     gimp_bucket_fill_tool_get_preview_level
+                                                       (GimpDisplayShell      *shell);
+static void     gimp_bucket_fill_tool_queue_fill       (GimpBucketFillTool    *tool,
+                                                        GimpDrawable          *drawable,
+                                                        GimpFillOptions       *fill_options,
+                                                        gdouble                x,
+                                                        gdouble                y);
+static void     gimp_bucket_fill_tool_fill_mask_cb     (GimpAsync             *async,
+                                                        GimpBucketFillTool    *tool);
+static void     gimp_bucket_fill_tool_cancel_fill      (GimpBucketFillTool    *tool);
 
 static void     gimp_bucket_fill_tool_reset_line_art   (GimpBucketFillTool    *tool);
 
@@ -337,6 +364,19 @@ gimp_bucket_fill_tool_start (GimpBucketFillTool *tool,
 
   gimp_line_art_freeze (tool->priv->line_art);
 
+  /* the preview level stays fixed during the fill, so that the
+   * downscaled fill masks of all seeds can be combined
+   */
+  if (options->fill_area == GIMP_BUCKET_FILL_SIMILAR_COLORS)
+    {
+      tool->priv->preview_level =
+        gimp_bucket_fill_tool_get_preview_level (gimp_display_get_shell (display));
+    }
+  else
+    {
+      tool->priv->preview_level = 0;
+    }
+
   GIMP_TOOL (tool)->display  = display;
   g_list_free (GIMP_TOOL (tool)->drawables);
   GIMP_TOOL (tool)->drawables = drawables;
@@ -400,6 +440,44 @@ gimp_bucket_fill_tool_preview (GimpBucketFillTool *tool,
               x -= (gdouble) off_x;
               y -= (gdouble) off_y;
             }
+
+          if (tool->priv->preview_level > 0)
+            {
+              gdouble seed_x = x;
+              gdouble seed_y = y;
+
+              /* show a fill computed at the display's mipmap level right
+               * away, and compute the full-resolution fill in the
+               * background.
+               */
+              fill = gimp_drawable_get_bucket_fill_preview (drawable,
+                                                            fill_options,
+                                                            options->fill_transparent,
+                                                            options->fill_criterion,
+                                                            options->threshold / 255.0,
+                                                            shell->show_all,
+                                                            options->sample_merged,
+                                                            options->diagonal_neighbors,
+                                                            tool->priv->preview_level,
+                                                            seed_x, seed_y,
+                                                            &tool->priv->preview_mask,
+                                                            &x, &y, NULL, NULL);
+
+              if (fill)
+                {
+                  gimp_bucket_fill_tool_set_fill (tool, fill,
+                                                  tool->priv->preview_level,
+                                                  x, y);
+                  g_object_unref (fill);
+
+                  gimp_bucket_fill_tool_queue_fill (tool, drawable,
+                                                    fill_options,
+                                                    seed_x, seed_y);
+                }
+
+              return;
+            }
+
           fill = gimp_drawable_get_bucket_fill_buffer (drawable,
                                                        fill_options,
                                                        options->fill_transparent,
@@ -449,14 +527,7 @@ gimp_bucket_fill_tool_preview (GimpBucketFillTool *tool,
         }
       if (fill)
         {
-          gegl_node_set (tool->priv->fill_node,
-                         "buffer", fill,
-                         NULL);
-          gegl_node_set (tool->priv->offset_node,
-                         "x", x,
-                         "y", y,
-                         NULL);
-          gimp_drawable_filter_apply (tool->priv->filter, NULL);
+          gimp_bucket_fill_tool_set_fill (tool, fill, 0, x, y);
           g_object_unref (fill);
         }
     }
@@ -465,6 +536,18 @@ gimp_bucket_fill_tool_preview (GimpBucketFillTool *tool,
 static void
 gimp_bucket_fill_tool_commit (GimpBucketFillTool *tool)
 {
+  if (tool->priv->fill_async)
+    {
+      GimpAsync *async = g_object_ref (tool->priv->fill_async);
+
+      /* runs gimp_bucket_fill_tool_fill_mask_cb(), which replaces the
+       * downscaled preview with the full-resolution fill
+       */
+      gimp_waitable_wait (GIMP_WAITABLE (async));
+
+      g_object_unref (async);
+    }
+
   if (tool->priv->filter)
     {
       gimp_drawable_filter_commit (tool->priv->filter,
@@ -476,10 +559,18 @@ gimp_bucket_fill_tool_commit (GimpBucketFillTool *tool)
 static void
 gimp_bucket_fill_tool_halt (GimpBucketFillTool *tool)
 {
+  gimp_bucket_fill_tool_cancel_fill (tool);
+
+  g_clear_object (&tool->priv->preview_mask);
+  g_clear_object (&tool->priv->fill_options);
+  g_clear_pointer (&tool->priv->seeds, g_array_unref);
+  tool->priv->preview_level = 0;
+
   if (tool->priv->graph)
     {
       g_clear_object (&tool->priv->graph);
       tool->priv->fill_node   = NULL;
+      tool->priv->scale_node  = NULL;
       tool->priv->offset_node = NULL;
     }
 
@@ -514,10 +605,12 @@ gimp_bucket_fill_tool_create_graph (GimpBucketFillTool *tool)
   GeglNode *graph;
   GeglNode *output;
   GeglNode *fill_node;
+  GeglNode *scale_node;
   GeglNode *offset_node;
 
-  g_return_if_fail (! tool->priv->graph     &&
-                    ! tool->priv->fill_node &&
+  g_return_if_fail (! tool->priv->graph      &&
+                    ! tool->priv->fill_node  &&
+                    ! tool->priv->scale_node &&
                     ! tool->priv->offset_node);
 
   graph = gegl_node_new ();
@@ -525,17 +618,161 @@ gimp_bucket_fill_tool_create_graph (GimpBucketFillTool *tool)
   fill_node = gegl_node_new_child (graph,
                                    "operation", "gegl:buffer-source",
                                    NULL);
+  scale_node = gegl_node_new_child (graph,
+                                    "operation", "gegl:scale-ratio",
+                                    "sampler",   GEGL_SAMPLER_NEAREST,
+                                    "x",         1.0,
+                                    "y",         1.0,
+                                    NULL);
   offset_node = gegl_node_new_child (graph,
                                      "operation", "gegl:translate",
                                      NULL);
   output = gegl_node_get_output_proxy (graph, "output");
-  gegl_node_link_many (fill_node, offset_node, output, NULL);
+  gegl_node_link_many (fill_node, scale_node, offset_node, output, NULL);
 
   tool->priv->graph       = graph;
   tool->priv->fill_node   = fill_node;
+  tool->priv->scale_node  = scale_node;
   tool->priv->offset_node = offset_node;
 }
 
+static void
+gimp_bucket_fill_tool_set_fill (GimpBucketFillTool *tool,
+                                GeglBuffer         *fill,
+                                gint                level,
+                                gdouble             x,
+                                gdouble             y)
+{
+  gegl_node_set (tool->priv->fill_node,
+                 "buffer", fill,
+                 NULL);
+  gegl_node_set (tool->priv->scale_node,
+                 "x", (gdouble) (1 << level),
+                 "y", (gdouble) (1 << level),
+                 NULL);
+  gegl_node_set (tool->priv->offset_node,
+                 "x", x,
+                 "y", y,
+                 NULL);
+  gimp_drawable_filter_apply (tool->priv->filter, NULL);
+}
+
+static gint
+gimp_bucket_fill_tool_get_preview_level (GimpDisplayShell *shell)
+{
+  gdouble scale = MAX (shell->scale_x, shell->scale_y);
+  gint    level = 0;
+
+  while (scale <= 0.5 && level < MAX_PREVIEW_LEVEL)
+    {
+      scale *= 2.0;
+      level++;
+    }
+
+  return level;
+}
+
+static void
+gimp_bucket_fill_tool_queue_fill (GimpBucketFillTool *tool,
+                                  GimpDrawable       *drawable,
+                                  GimpFillOptions    *fill_options,
+                                  gdouble             x,
+                                  gdouble             y)
+{
+  GimpBucketFillOptions *options = GIMP_BUCKET_FILL_TOOL_GET_OPTIONS (tool);
+  GimpDisplayShell      *shell;
+  GimpVector2            seed    = { x, y };
+
+  shell = gimp_display_get_shell (GIMP_TOOL (tool)->display);
+
+  if (! tool->priv->seeds)
+    tool->priv->seeds = g_array_new (FALSE, FALSE, sizeof (GimpVector2));
+
+  g_array_append_val (tool->priv->seeds, seed);
+
+  g_set_object (&tool->priv->fill_options, fill_options);
+
+  /* the pending full-resolution fill is superseded by a fill of all
+   * seeds not merged into the fill mask yet, so that we don't keep
+   * the thread pool busy with stale fills while the pointer moves.
+   */
+  gimp_bucket_fill_tool_cancel_fill (tool);
+
+  tool->priv->fill_async =
+    gimp_drawable_get_bucket_fill_mask_async (drawable,
+                                              options->antialias,
+                                              options->fill_transparent,
+                                              options->fill_criterion,
+                                              options->threshold / 255.0,
+                                              shell->show_all,
+                                              options->sample_merged,
+                                              options->diagonal_neighbors,
+                                              (const GimpVector2 *)
+                                              tool->priv->seeds->data,
+                                              tool->priv->seeds->len);
+
+  gimp_async_add_callback_for_object (
+    tool->priv->fill_async,
+    (GimpAsyncCallback) gimp_bucket_fill_tool_fill_mask_cb,
+    tool, tool);
+}
+
+static void
+gimp_bucket_fill_tool_fill_mask_cb (GimpAsync          *async,
+                                    GimpBucketFillTool *tool)
+{
+  GimpBucketFillOptions *options = GIMP_BUCKET_FILL_TOOL_GET_OPTIONS (tool);
+
+  if (gimp_async_is_canceled (async))
+    return;
+
+  if (gimp_async_is_finished (async) && tool->priv->filter)
+    {
+      GimpDrawable *drawable = GIMP_TOOL (tool)->drawables->data;
+      GeglBuffer   *fill;
+      gdouble       x;
+      gdouble       y;
+
+      fill = gimp_drawable_get_bucket_fill_buffer_from_mask (
+        drawable,
+        tool->priv->fill_options,
+        options->sample_merged,
+        gimp_async_get_result (async),
+        &tool->priv->fill_mask,
+        &x, &y, NULL, NULL);
+
+      g_array_set_size (tool->priv->seeds, 0);
+
+      if (fill)
+        {
+          gimp_bucket_fill_tool_set_fill (tool, fill, 0, x, y);
+          g_object_unref (fill);
+        }
+      else
+        {
+          /* the full-resolution fill is entirely masked out, drop the
+           * approximate preview
+           */
+          gimp_bucket_fill_tool_set_fill (tool, NULL, 0, 0.0, 0.0);
+        }
+    }
+
+  g_clear_object (&tool->priv->fill_async);
+}
+
+static void
+gimp_bucket_fill_tool_cancel_fill (GimpBucketFillTool *tool)
+{
+  if (tool->priv->fill_async)
+    {
+      /* we don't wait for the async to finish, and
+       * gimp_bucket_fill_tool_fill_mask_cb() bails if it's canceled.
+       */
+      gimp_cancelable_cancel (GIMP_CANCELABLE (tool->priv->fill_async));
+      g_clear_object (&tool->priv->fill_async);
+    }
+}
+
 static void
 gimp_bucket_fill_tool_button_press (GimpTool            *tool,
                                     const GimpCoords    *coords,
@@ -37,6 +37,7 @@
 #include "operations/layer-modes/gimp-layer-modes.h"
 
 #include "core/gimp.h"
+#include "core/gimpchannel.h"
 #include "core/gimpdrawable.h"
 #include "core/gimpdrawable-gradient.h"
 #include "core/gimpdrawablefilter.h"
@@ -125,6 +126,7 @@ static void   gimp_gradient_tool_line_response       (GimpToolWidget        *wid
                                                       GimpGradientTool         *gradient_tool);
 
 static void   gimp_gradient_tool_precalc_shapeburst  (GimpGradientTool         *gradient_tool);
+static void   gimp_gradient_tool_clear_shapeburst    (GimpGradientTool         *gradient_tool);
 
 static void   gimp_gradient_tool_create_graph        (GimpGradientTool         *gradient_tool);
 static void   gimp_gradient_tool_update_graph        (GimpGradientTool         *gradient_tool);
@@ -230,6 +232,8 @@ gimp_gradient_tool_dispose (GObject *object)
 
   gimp_gradient_tool_set_gradient (gradient_tool, NULL);
 
+  gimp_gradient_tool_clear_shapeburst (gradient_tool);
+
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
@@ -595,7 +599,7 @@ gimp_gradient_tool_options_notify (GimpTool         *tool,
            gimp_gradient_tool_is_shapeburst (gradient_tool) &&
            g_strcmp0 (pspec->name, "distance-metric") == 0)
     {
-      g_clear_object (&gradient_tool->dist_buffer);
+      gimp_gradient_tool_clear_shapeburst (gradient_tool);
       gimp_gradient_tool_precalc_shapeburst (gradient_tool);
       gimp_gradient_tool_update_graph (gradient_tool);
       gimp_drawable_filter_apply (gradient_tool->filter, NULL);
@@ -715,7 +719,12 @@ gimp_gradient_tool_halt (GimpGradientTool *gradient_tool)
       gradient_tool->dist_node      = NULL;
     }
 
-  g_clear_object (&gradient_tool->dist_buffer);
+  /*  a distance map of the selection stays valid until the selection
+   *  changes, so keep it around for the next gradient.  one made from
+   *  the drawable's alpha is likely invalidated by this very gradient.
+   */
+  if (gradient_tool->dist_alpha)
+    gimp_gradient_tool_clear_shapeburst (gradient_tool);
 
   if (gradient_tool->filter)
     {
@@ -842,23 +851,55 @@ gimp_gradient_tool_precalc_shapeburst (GimpGradientTool *gradient_tool)
 {
   GimpGradientOptions *options = GIMP_GRADIENT_TOOL_GET_OPTIONS (gradient_tool);
   GimpTool            *tool    = GIMP_TOOL (gradient_tool);
+  GimpDrawable        *drawable;
+  GimpImage           *image;
   gint                 x, y, width, height;
 
-  if (gradient_tool->dist_buffer || ! tool->drawables)
+  if (! tool->drawables)
     return;
 
   g_return_if_fail (g_list_length (tool->drawables) == 1);
 
-  if (! gimp_item_mask_intersect (GIMP_ITEM (tool->drawables->data),
+  drawable = tool->drawables->data;
+  image    = gimp_item_get_image (GIMP_ITEM (drawable));
+
+  if (! gimp_item_mask_intersect (GIMP_ITEM (drawable),
                                   &x, &y, &width, &height))
     return;
 
+  if (gradient_tool->dist_buffer)
+    {
+      if (gradient_tool->dist_drawable == drawable                  &&
+          gradient_tool->dist_metric   == options->distance_metric &&
+          gegl_rectangle_equal (&gradient_tool->dist_region,
+                                GEGL_RECTANGLE (x, y, width, height)))
+        {
+          return;
+        }
+
+      gimp_gradient_tool_clear_shapeburst (gradient_tool);
+    }
+
   gradient_tool->dist_buffer =
-    gimp_drawable_gradient_shapeburst_distmap (tool->drawables->data,
+    gimp_drawable_gradient_shapeburst_distmap (drawable,
                                                options->distance_metric,
                                                GEGL_RECTANGLE (x, y, width, height),
                                                GIMP_PROGRESS (gradient_tool));
 
+  gradient_tool->dist_region = *GEGL_RECTANGLE (x, y, width, height);
+  gradient_tool->dist_metric = options->distance_metric;
+  gradient_tool->dist_alpha  =
+    gimp_channel_is_empty (gimp_image_get_mask (image)) &&
+    gimp_drawable_has_alpha (drawable);
+
+  g_set_weak_pointer (&gradient_tool->dist_image,    image);
+  g_set_weak_pointer (&gradient_tool->dist_drawable, drawable);
+
+  g_signal_connect_object (image, "mask-changed",
+                           G_CALLBACK (gimp_gradient_tool_clear_shapeburst),
+                           gradient_tool,
+                           G_CONNECT_SWAPPED);
+
   if (gradient_tool->dist_node)
     gegl_node_set (gradient_tool->dist_node,
                    "buffer", gradient_tool->dist_buffer,
@@ -867,6 +908,24 @@ gimp_gradient_tool_precalc_shapeburst (GimpGradientTool *gradient_tool)
   gimp_progress_end (GIMP_PROGRESS (gradient_tool));
 }
 
+static void
+gimp_gradient_tool_clear_shapeburst (GimpGradientTool *gradient_tool)
+{
+  if (gradient_tool->dist_image)
+    {
+      g_signal_handlers_disconnect_by_func (gradient_tool->dist_image,
+                                            gimp_gradient_tool_clear_shapeburst,
+                                            gradient_tool);
+    }
+
+  g_clear_weak_pointer (&gradient_tool->dist_image);
+  g_clear_weak_pointer (&gradient_tool->dist_drawable);
+
+  g_clear_object (&gradient_tool->dist_buffer);
+
+  gradient_tool->dist_alpha = FALSE;
+}
+
 
 /* gegl graph stuff */
 
@@ -58,6 +58,11 @@ struct _GimpGradientTool
 #endif
   GeglNode           *dist_node;
   GeglBuffer         *dist_buffer;
+  GimpImage          *dist_image;     /*  what dist_buffer was     */
+  GimpDrawable       *dist_drawable;  /*  calculated for, so it    */
+  GeglRectangle       dist_region;    /*  can be reused by later   */
+  GeglDistanceMetric  dist_metric;    /*  gradients                */
+  gboolean            dist_alpha;
   GimpDrawableFilter *filter;
 
   /*  editor  */
@@ -58,8 +58,11 @@
 
 #include "widgets-types.h"
 
+#include "gegl/gimptilehandlervalidate.h"
+
 #include "core/gimp.h"
 #include "core/gimp-gui.h"
+#include "core/gimp-input-latency.h"
 #include "core/gimp-utils.h"
 #include "core/gimp-parallel.h"
 #include "core/gimpasync.h"
@@ -149,6 +152,10 @@ typedef enum
 
   /* misc */
   VARIABLE_MIPMAPED,
+  VARIABLE_LEVEL_TOTAL,
+  VARIABLE_LEVEL_TIME,
+  VARIABLE_INPUT_LATENCY,
+  VARIABLE_INPUT_LATENCY_95,
   VARIABLE_ASSIGNED_THREADS,
   VARIABLE_ACTIVE_THREADS,
   VARIABLE_ASYNC_RUNNING,
@@ -708,6 +715,49 @@ static const VariableInfo variables[] =
     .data             = "zoom-total"
   },
 
+  [VARIABLE_LEVEL_TOTAL] =
+  { .name             = "level-total",
+    /* Translators:  "LOD" stands for "level of detail".  */
+    .title            = NC_("dashboard-variable", "LOD"),
+    .description      = N_("Total size of projection data rendered at a "
+                           "reduced level of detail"),
+    .type             = VARIABLE_TYPE_SIZE,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_tile_handler_validate_get_level_total
+  },
+
+  [VARIABLE_LEVEL_TIME] =
+  { .name             = "level-time",
+    .title            = NC_("dashboard-variable", "LOD time"),
+    .description      = N_("Total amount of time spent rendering the "
+                           "projection at a reduced level of detail"),
+    .type             = VARIABLE_TYPE_DURATION,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_tile_handler_validate_get_level_time
+  },
+
+  [VARIABLE_INPUT_LATENCY] =
+  { .name             = "input-latency",
+    .title            = NC_("dashboard-variable", "Input latency"),
+    .description      = N_("Recent time between the arrival of a stroke "
+                           "event and the next canvas frame"),
+    .type             = VARIABLE_TYPE_DURATION,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_input_latency_get_average
+  },
+
+  [VARIABLE_INPUT_LATENCY_95] =
+  { .name             = "input-latency-95",
+    /* Translators:  "95%" stands for "95th percentile".  */
+    .title            = NC_("dashboard-variable", "Input latency (95%)"),
+    .description      = N_("Time between the arrival of a stroke event and "
+                           "the next canvas frame, not exceeded by 95% of "
+                           "recent events"),
+    .type             = VARIABLE_TYPE_DURATION,
+    .sample_func      = gimp_dashboard_sample_function,
+    .data             = gimp_input_latency_get_95th_percentile
+  },
+
   [VARIABLE_ASSIGNED_THREADS] =
   { .name             = "assigned-threads",
     .title            = NC_("dashboard-variable", "Assigned"),
@@ -963,6 +1013,18 @@ static const GroupInfo groups[] =
                           { .variable       = VARIABLE_MIPMAPED,
                             .default_active = TRUE
                           },
+                          { .variable       = VARIABLE_LEVEL_TOTAL,
+                            .default_active = FALSE
+                          },
+                          { .variable       = VARIABLE_LEVEL_TIME,
+                            .default_active = FALSE
+                          },
+                          { .variable       = VARIABLE_INPUT_LATENCY,
+                            .default_active = FALSE
+                          },
+                          { .variable       = VARIABLE_INPUT_LATENCY_95,
+                            .default_active = FALSE
+                          },
                           { .variable       = VARIABLE_ASSIGNED_THREADS,
                             .default_active = TRUE
                           },
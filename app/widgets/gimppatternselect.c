@@ -105,18 +105,18 @@ gimp_pattern_select_run_callback (GimpPdbDialog  *dialog,
                                   GError        **error)
 {
   GimpPattern    *pattern = GIMP_PATTERN (object);
+  GimpTempBuf    *mask    = gimp_pattern_get_mask (pattern);
   const Babl     *format;
   gpointer        data;
   GimpArray      *array;
   GimpValueArray *return_vals;
 
-  format = gimp_babl_compat_u8_format (
-    gimp_temp_buf_get_format (pattern->mask));
-  data   = gimp_temp_buf_lock (pattern->mask, format, GEGL_ACCESS_READ);
+  format = gimp_babl_compat_u8_format (gimp_temp_buf_get_format (mask));
+  data   = gimp_temp_buf_lock (mask, format, GEGL_ACCESS_READ);
 
   array = gimp_array_new (data,
-                          gimp_temp_buf_get_width         (pattern->mask) *
-                          gimp_temp_buf_get_height        (pattern->mask) *
+                          gimp_temp_buf_get_width         (mask) *
+                          gimp_temp_buf_get_height        (mask) *
                           babl_format_get_bytes_per_pixel (format),
                           TRUE);
 
@@ -126,9 +126,9 @@ gimp_pattern_select_run_callback (GimpPdbDialog  *dialog,
                                         NULL, error,
                                         dialog->callback_name,
                                         G_TYPE_STRING,         gimp_object_get_name (object),
-                                        G_TYPE_INT,            gimp_temp_buf_get_width  (pattern->mask),
-                                        G_TYPE_INT,            gimp_temp_buf_get_height (pattern->mask),
-                                        G_TYPE_INT,            babl_format_get_bytes_per_pixel (gimp_temp_buf_get_format (pattern->mask)),
+                                        G_TYPE_INT,            gimp_temp_buf_get_width  (mask),
+                                        G_TYPE_INT,            gimp_temp_buf_get_height (mask),
+                                        G_TYPE_INT,            babl_format_get_bytes_per_pixel (gimp_temp_buf_get_format (mask)),
                                         G_TYPE_INT,            array->length,
                                         GIMP_TYPE_UINT8_ARRAY, array->data,
                                         G_TYPE_BOOLEAN,        closing,
@@ -136,7 +136,7 @@ gimp_pattern_select_run_callback (GimpPdbDialog  *dialog,
 
   gimp_array_free (array);
 
-  gimp_temp_buf_unlock (pattern->mask, data);
+  gimp_temp_buf_unlock (mask, data);
 
   return return_vals;
 }
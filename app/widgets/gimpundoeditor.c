@@ -66,6 +66,7 @@ static void   gimp_undo_editor_set_context    (GimpDocked        *docked,
 
 static void   gimp_undo_editor_fill           (GimpUndoEditor    *editor);
 static void   gimp_undo_editor_clear          (GimpUndoEditor    *editor);
+static void   gimp_undo_editor_update_size    (GimpUndoEditor    *editor);
 
 static void   gimp_undo_editor_undo_event     (GimpImage         *image,
                                                GimpUndoEvent      event,
@@ -138,6 +139,17 @@ gimp_undo_editor_constructed (GObject *object)
   gtk_box_pack_start (GTK_BOX (undo_editor), undo_editor->view, TRUE, TRUE, 0);
   gtk_widget_show (undo_editor->view);
 
+  undo_editor->size_label = gtk_label_new (NULL);
+  gtk_label_set_xalign (GTK_LABEL (undo_editor->size_label), 0.0);
+  gtk_label_set_ellipsize (GTK_LABEL (undo_editor->size_label),
+                           PANGO_ELLIPSIZE_END);
+  gimp_label_set_attributes (GTK_LABEL (undo_editor->size_label),
+                             PANGO_ATTR_SCALE, PANGO_SCALE_SMALL,
+                             -1);
+  gtk_box_pack_start (GTK_BOX (undo_editor), undo_editor->size_label,
+                      FALSE, FALSE, 0);
+  gtk_widget_show (undo_editor->size_label);
+
   g_signal_connect (undo_editor->view, "select-items",
                     G_CALLBACK (gimp_undo_editor_select_items),
                     undo_editor);
@@ -319,6 +331,8 @@ gimp_undo_editor_fill (GimpUndoEditor *editor)
   g_signal_handlers_unblock_by_func (editor->view,
                                      gimp_undo_editor_select_items,
                                      editor);
+
+  gimp_undo_editor_update_size (editor);
 }
 
 static void
@@ -332,6 +346,37 @@ gimp_undo_editor_clear (GimpUndoEditor *editor)
     }
 
   g_clear_object (&editor->base_item);
+
+  gtk_label_set_text (GTK_LABEL (editor->size_label), NULL);
+}
+
+static void
+gimp_undo_editor_update_size (GimpUndoEditor *editor)
+{
+  GimpImage *image = GIMP_IMAGE_EDITOR (editor)->image;
+  gint64     memsize;
+  gint64     spilled_size;
+  gchar     *memsize_str;
+  gchar     *spilled_str;
+  gchar     *text;
+
+  if (! image || ! editor->container)
+    return;
+
+  memsize = gimp_image_undo_get_memsize (image, &spilled_size);
+
+  memsize_str = g_format_size (memsize);
+  spilled_str = g_format_size (spilled_size);
+
+  /* Translators: sizes of the undo history kept in memory and on disk */
+  text = g_strdup_printf (_("Undo memory: %s, on disk: %s"),
+                          memsize_str, spilled_str);
+
+  gtk_label_set_text (GTK_LABEL (editor->size_label), text);
+
+  g_free (text);
+  g_free (spilled_str);
+  g_free (memsize_str);
 }
 
 static void
@@ -401,7 +446,13 @@ gimp_undo_editor_undo_event (GimpImage      *image,
     case GIMP_UNDO_EVENT_UNDO_THAW:
       gimp_undo_editor_fill (editor);
       break;
+
+    case GIMP_UNDO_EVENT_UNDO_SPILLED:
+      /*  only the size label below changes  */
+      break;
     }
+
+  gimp_undo_editor_update_size (editor);
 }
 
 static gboolean
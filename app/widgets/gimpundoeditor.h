@@ -39,6 +39,7 @@ struct _GimpUndoEditor
   GimpContext     *context;
   GimpContainer   *container;
   GtkWidget       *view;
+  GtkWidget       *size_label;
   GimpViewSize     view_size;
 
   GimpUndo        *base_item;
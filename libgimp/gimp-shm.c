@@ -87,6 +87,10 @@ _gimp_shm_addr (void)
 void
 _gimp_shm_open (gint shm_ID)
 {
+  /*  a worker gets the same segment with every GP_CONFIG  */
+  if (_shm_addr && shm_ID == _shm_ID)
+    return;
+
   _shm_ID = shm_ID;
 
   if (_shm_ID != -1)
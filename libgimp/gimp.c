@@ -536,7 +536,10 @@ gimp_main (GType  plug_in_type,
   else if (_gimp_get_debug_flags () & GIMP_DEBUG_PID)
     g_log (G_LOG_DOMAIN, G_LOG_LEVEL_DEBUG, "Here I am!");
 
-  _gimp_plug_in_run (PLUG_IN);
+  if (strcmp (argv[ARG_MODE], "-worker") == 0)
+    _gimp_plug_in_run_worker (PLUG_IN);
+  else
+    _gimp_plug_in_run (PLUG_IN);
 
   gimp_close ();
 
@@ -1045,6 +1048,12 @@ _gimp_config (GPConfig *config)
   _export_comment       = config->export_comment;
   _num_processors       = config->num_processors;
   _default_display_id   = config->default_display_id;
+
+  /*  a worker gets GP_CONFIG before every run  */
+  g_clear_pointer (&_wm_class,       g_free);
+  g_clear_pointer (&_display_name,   g_free);
+  g_clear_pointer (&_icon_theme_dir, g_free);
+
   _wm_class             = g_strdup (config->wm_class);
   _display_name         = g_strdup (config->display_name);
   _monitor_number       = config->monitor_number;
@@ -28,6 +28,7 @@ G_BEGIN_DECLS
 void            _gimp_plug_in_query             (GimpPlugIn      *plug_in);
 void            _gimp_plug_in_init              (GimpPlugIn      *plug_in);
 void            _gimp_plug_in_run               (GimpPlugIn      *plug_in);
+void            _gimp_plug_in_run_worker        (GimpPlugIn      *plug_in);
 void            _gimp_plug_in_quit              (GimpPlugIn      *plug_in);
 
 GIOChannel    * _gimp_plug_in_get_read_channel  (GimpPlugIn      *plug_in);
@@ -179,7 +179,8 @@ static gboolean   gimp_plug_in_io_error_handler  (GIOChannel      *channel,
                                                   GIOCondition     cond,
                                                   gpointer         data);
 
-static void       gimp_plug_in_loop              (GimpPlugIn      *plug_in);
+static void       gimp_plug_in_loop              (GimpPlugIn      *plug_in,
+                                                  gboolean         worker);
 static void       gimp_plug_in_single_message    (GimpPlugIn      *plug_in);
 static void       gimp_plug_in_process_message   (GimpPlugIn      *plug_in,
                                                   GimpWireMessage *msg);
@@ -830,7 +831,20 @@ _gimp_plug_in_run (GimpPlugIn *plug_in)
                   gimp_plug_in_io_error_handler,
                   NULL);
 
-  gimp_plug_in_loop (plug_in);
+  gimp_plug_in_loop (plug_in, FALSE);
+}
+
+void
+_gimp_plug_in_run_worker (GimpPlugIn *plug_in)
+{
+  g_return_if_fail (GIMP_IS_PLUG_IN (plug_in));
+
+  g_io_add_watch (plug_in->priv->read_channel,
+                  G_IO_ERR | G_IO_HUP,
+                  gimp_plug_in_io_error_handler,
+                  NULL);
+
+  gimp_plug_in_loop (plug_in, TRUE);
 }
 
 void
@@ -1055,7 +1069,8 @@ gimp_plug_in_io_error_handler (GIOChannel   *channel,
 }
 
 static void
-gimp_plug_in_loop (GimpPlugIn *plug_in)
+gimp_plug_in_loop (GimpPlugIn *plug_in,
+                   gboolean    worker)
 {
   while (TRUE)
     {
@@ -1083,6 +1098,13 @@ gimp_plug_in_loop (GimpPlugIn *plug_in)
         case GP_PROC_RUN:
           gimp_plug_in_proc_run (plug_in, msg.data);
           gimp_wire_destroy (&msg);
+
+          /*  a worker stays around for the next GP_PROC_RUN, until
+           *  the core sends GP_QUIT or closes the pipe
+           */
+          if (worker)
+            continue;
+
           return;
 
         case GP_PROC_RETURN:
@@ -38,14 +38,55 @@ struct _GimpWireHandler
 };
 
 
-static GHashTable        *wire_ht         = NULL;
-static GimpWireIOFunc     wire_read_func  = NULL;
-static GimpWireIOFunc     wire_write_func = NULL;
-static GimpWireFlushFunc  wire_flush_func = NULL;
-static gboolean           wire_error_val  = FALSE;
+/*  Every message goes over the wire as one frame: a header of two
+ *  native-endian guint32, the message type and the payload length,
+ *  followed by the payload. The payload is assembled in memory before
+ *  it is written, and read in one go before it is parsed, so the
+ *  message handlers' many small reads and writes never hit the pipe.
+ */
+typedef struct
+{
+  guint32  type;
+  guint32  length;
+} GimpWireHeader;
+
+
+/*  frames at least this large bypass the writer's buffer  */
+#define GIMP_WIRE_DIRECT_SIZE  4096
+
+/*  frame buffers larger than this are not kept around for reuse  */
+#define GIMP_WIRE_KEEP_SIZE    (64 * 1024)
+
+
+static GHashTable        *wire_ht           = NULL;
+static GimpWireIOFunc     wire_read_func    = NULL;
+static GimpWireIOFunc     wire_write_func   = NULL;
+static GimpWireFlushFunc  wire_flush_func   = NULL;
+static gboolean           wire_error_val    = FALSE;
+
+static GByteArray        *wire_write_frame  = NULL;
+static gboolean           wire_writing      = FALSE;
+
+static guint8            *wire_read_frame   = NULL;
+static gsize              wire_read_size    = 0;
+static gsize              wire_read_length  = 0;
+static gsize              wire_read_pos     = 0;
+static gboolean           wire_reading      = FALSE;
+
 
+static void      gimp_wire_init          (void);
 
-static void  gimp_wire_init (void);
+static gboolean  gimp_wire_read_channel  (GIOChannel   *channel,
+                                          guint8       *buf,
+                                          gsize         count,
+                                          gpointer      user_data);
+static gboolean  gimp_wire_write_channel (GIOChannel   *channel,
+                                          const guint8 *buf,
+                                          gsize         count);
+static gboolean  gimp_wire_write_frame   (GIOChannel   *channel,
+                                          const guint8 *buf,
+                                          gsize         count,
+                                          gpointer      user_data);
 
 
 void
@@ -96,67 +137,23 @@ gimp_wire_read (GIOChannel *channel,
                 gsize       count,
                 gpointer    user_data)
 {
-  if (wire_read_func)
+  if (wire_reading)
     {
-      if (!(* wire_read_func) (channel, buf, count, user_data))
+      if (G_UNLIKELY (count > wire_read_length - wire_read_pos))
         {
-          /* Gives a confusing error message most of the time, disable:
-          g_warning ("%s: gimp_wire_read: error", g_get_prgname ());
-           */
+          g_warning ("%s: gimp_wire_read(): read past the end of the message",
+                     g_get_prgname ());
           wire_error_val = TRUE;
           return FALSE;
         }
-    }
-  else
-    {
-      GIOStatus  status;
-      GError    *error = NULL;
-      gsize      bytes;
 
-      while (count > 0)
-        {
-          do
-            {
-              bytes = 0;
-              status = g_io_channel_read_chars (channel,
-                                                (gchar *) buf, count,
-                                                &bytes,
-                                                &error);
-            }
-          while (G_UNLIKELY (status == G_IO_STATUS_AGAIN));
+      memcpy (buf, wire_read_frame + wire_read_pos, count);
+      wire_read_pos += count;
 
-          if (G_UNLIKELY (status != G_IO_STATUS_NORMAL))
-            {
-              if (error)
-                {
-                  g_warning ("%s: gimp_wire_read(): error: %s",
-                             g_get_prgname (), error->message);
-                  g_error_free (error);
-                }
-              else
-                {
-                  g_warning ("%s: gimp_wire_read(): error",
-                             g_get_prgname ());
-                }
-
-              wire_error_val = TRUE;
-              return FALSE;
-            }
-
-          if (G_UNLIKELY (bytes == 0))
-            {
-              g_warning ("%s: gimp_wire_read(): unexpected EOF",
-                         g_get_prgname ());
-              wire_error_val = TRUE;
-              return FALSE;
-            }
-
-          count -= bytes;
-          buf += bytes;
-        }
+      return TRUE;
     }
 
-  return TRUE;
+  return gimp_wire_read_channel (channel, buf, count, user_data);
 }
 
 gboolean
@@ -165,6 +162,13 @@ gimp_wire_write (GIOChannel   *channel,
                  gsize         count,
                  gpointer      user_data)
 {
+  if (wire_writing)
+    {
+      g_byte_array_append (wire_write_frame, buf, count);
+
+      return TRUE;
+    }
+
   if (wire_write_func)
     {
       if (!(* wire_write_func) (channel, (guint8 *) buf, count, user_data))
@@ -173,49 +177,11 @@ gimp_wire_write (GIOChannel   *channel,
           wire_error_val = TRUE;
           return FALSE;
         }
-    }
-  else
-    {
-      GIOStatus  status;
-      GError    *error = NULL;
-      gsize      bytes;
 
-      while (count > 0)
-        {
-          do
-            {
-              bytes = 0;
-              status = g_io_channel_write_chars (channel,
-                                                 (const gchar *) buf, count,
-                                                 &bytes,
-                                                 &error);
-            }
-          while (G_UNLIKELY (status == G_IO_STATUS_AGAIN));
-
-          if (G_UNLIKELY (status != G_IO_STATUS_NORMAL))
-            {
-              if (error)
-                {
-                  g_warning ("%s: gimp_wire_write(): error: %s",
-                             g_get_prgname (), error->message);
-                  g_error_free (error);
-                }
-              else
-                {
-                  g_warning ("%s: gimp_wire_write(): error",
-                             g_get_prgname ());
-                }
-
-              wire_error_val = TRUE;
-              return FALSE;
-            }
-
-          count -= bytes;
-          buf += bytes;
-        }
+      return TRUE;
     }
 
-  return TRUE;
+  return gimp_wire_write_channel (channel, buf, count);
 }
 
 gboolean
@@ -246,6 +212,7 @@ gimp_wire_read_msg (GIOChannel      *channel,
                     gpointer         user_data)
 {
   GimpWireHandler *handler;
+  GimpWireHeader   header;
 
   if (G_UNLIKELY (! wire_ht))
     g_error ("gimp_wire_read_msg: the wire protocol has not been initialized");
@@ -253,17 +220,53 @@ gimp_wire_read_msg (GIOChannel      *channel,
   if (wire_error_val)
     return !wire_error_val;
 
-  if (! _gimp_wire_read_int32 (channel, &msg->type, 1, user_data))
+  if (! gimp_wire_read_channel (channel,
+                                (guint8 *) &header, sizeof (header), user_data))
     return FALSE;
 
+  msg->type = header.type;
+
   handler = g_hash_table_lookup (wire_ht, &msg->type);
 
   if (G_UNLIKELY (! handler))
     g_error ("gimp_wire_read_msg: could not find handler for message: %d",
              msg->type);
 
+  if (header.length > wire_read_size)
+    {
+      g_free (wire_read_frame);
+
+      wire_read_frame = g_try_malloc (header.length);
+      wire_read_size  = wire_read_frame ? header.length : 0;
+
+      if (! wire_read_frame)
+        {
+          g_printerr ("%s: failed to allocate %u bytes\n",
+                      G_STRFUNC, header.length);
+          wire_error_val = TRUE;
+          return FALSE;
+        }
+    }
+
+  if (! gimp_wire_read_channel (channel,
+                                wire_read_frame, header.length, user_data))
+    return FALSE;
+
+  wire_read_length = header.length;
+  wire_read_pos    = 0;
+  wire_reading     = TRUE;
+
   (* handler->read_func) (channel, msg, user_data);
 
+  /*  anything the handler didn't read is skipped along with the frame  */
+  wire_reading = FALSE;
+
+  if (wire_read_size > GIMP_WIRE_KEEP_SIZE)
+    {
+      g_clear_pointer (&wire_read_frame, g_free);
+      wire_read_size = 0;
+    }
+
   return !wire_error_val;
 }
 
@@ -273,6 +276,8 @@ gimp_wire_write_msg (GIOChannel      *channel,
                      gpointer         user_data)
 {
   GimpWireHandler *handler;
+  GimpWireHeader   header;
+  gboolean         success;
 
   if (G_UNLIKELY (! wire_ht))
     g_error ("gimp_wire_write_msg: the wire protocol has not been initialized");
@@ -286,12 +291,35 @@ gimp_wire_write_msg (GIOChannel      *channel,
     g_error ("gimp_wire_write_msg: could not find handler for message: %d",
              msg->type);
 
-  if (! _gimp_wire_write_int32 (channel, &msg->type, 1, user_data))
-    return FALSE;
+  if (! wire_write_frame)
+    wire_write_frame = g_byte_array_new ();
+
+  /*  leave room for the header, it is filled in once the length is known  */
+  g_byte_array_set_size (wire_write_frame, sizeof (header));
+
+  wire_writing = TRUE;
 
   (* handler->write_func) (channel, msg, user_data);
 
-  return !wire_error_val;
+  wire_writing = FALSE;
+
+  if (wire_error_val)
+    return FALSE;
+
+  header.type   = msg->type;
+  header.length = wire_write_frame->len - sizeof (header);
+
+  memcpy (wire_write_frame->data, &header, sizeof (header));
+
+  success = gimp_wire_write_frame (channel,
+                                   wire_write_frame->data,
+                                   wire_write_frame->len,
+                                   user_data);
+
+  if (wire_write_frame->len > GIMP_WIRE_KEEP_SIZE)
+    g_clear_pointer (&wire_write_frame, g_byte_array_unref);
+
+  return success;
 }
 
 void
@@ -319,20 +347,8 @@ _gimp_wire_read_int64 (GIOChannel *channel,
 {
   g_return_val_if_fail (count >= 0, FALSE);
 
-  if (count > 0)
-    {
-      if (! _gimp_wire_read_int8 (channel,
-                                  (guint8 *) data, count * 8, user_data))
-        return FALSE;
-
-      while (count--)
-        {
-          *data = GUINT64_FROM_BE (*data);
-          data++;
-        }
-    }
-
-  return TRUE;
+  return _gimp_wire_read_int8 (channel,
+                               (guint8 *) data, count * 8, user_data);
 }
 
 gboolean
@@ -343,20 +359,8 @@ _gimp_wire_read_int32 (GIOChannel *channel,
 {
   g_return_val_if_fail (count >= 0, FALSE);
 
-  if (count > 0)
-    {
-      if (! _gimp_wire_read_int8 (channel,
-                                  (guint8 *) data, count * 4, user_data))
-        return FALSE;
-
-      while (count--)
-        {
-          *data = g_ntohl (*data);
-          data++;
-        }
-    }
-
-  return TRUE;
+  return _gimp_wire_read_int8 (channel,
+                               (guint8 *) data, count * 4, user_data);
 }
 
 gboolean
@@ -367,20 +371,8 @@ _gimp_wire_read_int16 (GIOChannel *channel,
 {
   g_return_val_if_fail (count >= 0, FALSE);
 
-  if (count > 0)
-    {
-      if (! _gimp_wire_read_int8 (channel,
-                                  (guint8 *) data, count * 2, user_data))
-        return FALSE;
-
-      while (count--)
-        {
-          *data = g_ntohs (*data);
-          data++;
-        }
-    }
-
-  return TRUE;
+  return _gimp_wire_read_int8 (channel,
+                               (guint8 *) data, count * 2, user_data);
 }
 
 gboolean
@@ -400,38 +392,10 @@ _gimp_wire_read_double (GIOChannel *channel,
                         gint        count,
                         gpointer    user_data)
 {
-  gdouble *t;
-  guint8   tmp[8];
-  gint     i;
-
   g_return_val_if_fail (count >= 0, FALSE);
 
-  t = (gdouble *) tmp;
-
-  for (i = 0; i < count; i++)
-    {
-#if (G_BYTE_ORDER == G_LITTLE_ENDIAN)
-      gint j;
-#endif
-
-      if (! _gimp_wire_read_int8 (channel, tmp, 8, user_data))
-        return FALSE;
-
-#if (G_BYTE_ORDER == G_LITTLE_ENDIAN)
-      for (j = 0; j < 4; j++)
-        {
-          guint8 swap;
-
-          swap       = tmp[j];
-          tmp[j]     = tmp[7 - j];
-          tmp[7 - j] = swap;
-        }
-#endif
-
-      data[i] = *t;
-    }
-
-  return TRUE;
+  return _gimp_wire_read_int8 (channel,
+                               (guint8 *) data, count * 8, user_data);
 }
 
 gboolean
@@ -500,21 +464,8 @@ _gimp_wire_write_int64 (GIOChannel    *channel,
 {
   g_return_val_if_fail (count >= 0, FALSE);
 
-  if (count > 0)
-    {
-      gint i;
-
-      for (i = 0; i < count; i++)
-        {
-          guint64 tmp = GUINT64_TO_BE (data[i]);
-
-          if (! _gimp_wire_write_int8 (channel,
-                                       (const guint8 *) &tmp, 8, user_data))
-            return FALSE;
-        }
-    }
-
-  return TRUE;
+  return _gimp_wire_write_int8 (channel,
+                                (const guint8 *) data, count * 8, user_data);
 }
 
 gboolean
@@ -525,21 +476,8 @@ _gimp_wire_write_int32 (GIOChannel    *channel,
 {
   g_return_val_if_fail (count >= 0, FALSE);
 
-  if (count > 0)
-    {
-      gint i;
-
-      for (i = 0; i < count; i++)
-        {
-          guint32 tmp = g_htonl (data[i]);
-
-          if (! _gimp_wire_write_int8 (channel,
-                                       (const guint8 *) &tmp, 4, user_data))
-            return FALSE;
-        }
-    }
-
-  return TRUE;
+  return _gimp_wire_write_int8 (channel,
+                                (const guint8 *) data, count * 4, user_data);
 }
 
 gboolean
@@ -550,21 +488,8 @@ _gimp_wire_write_int16 (GIOChannel    *channel,
 {
   g_return_val_if_fail (count >= 0, FALSE);
 
-  if (count > 0)
-    {
-      gint i;
-
-      for (i = 0; i < count; i++)
-        {
-          guint16 tmp = g_htons (data[i]);
-
-          if (! _gimp_wire_write_int8 (channel,
-                                       (const guint8 *) &tmp, 2, user_data))
-            return FALSE;
-        }
-    }
-
-  return TRUE;
+  return _gimp_wire_write_int8 (channel,
+                                (const guint8 *) data, count * 2, user_data);
 }
 
 gboolean
@@ -584,50 +509,10 @@ _gimp_wire_write_double (GIOChannel    *channel,
                          gint           count,
                          gpointer       user_data)
 {
-  gdouble *t;
-  guint8   tmp[8];
-  gint     i;
-#if (G_BYTE_ORDER == G_LITTLE_ENDIAN)
-  gint     j;
-#endif
-
   g_return_val_if_fail (count >= 0, FALSE);
 
-  t = (gdouble *) tmp;
-
-  for (i = 0; i < count; i++)
-    {
-      *t = data[i];
-
-#if (G_BYTE_ORDER == G_LITTLE_ENDIAN)
-      for (j = 0; j < 4; j++)
-        {
-          guint8 swap;
-
-          swap       = tmp[j];
-          tmp[j]     = tmp[7 - j];
-          tmp[7 - j] = swap;
-        }
-#endif
-
-      if (! _gimp_wire_write_int8 (channel, tmp, 8, user_data))
-        return FALSE;
-
-#if 0
-      {
-        gint k;
-
-        g_print ("Wire representation of %f:\t", data[i]);
-
-        for (k = 0; k < 8; k++)
-          g_print ("%02x ", tmp[k]);
-
-        g_print ("\n");
-      }
-#endif
-    }
-
-  return TRUE;
+  return _gimp_wire_write_int8 (channel,
+                                (const guint8 *) data, count * 8, user_data);
 }
 
 gboolean
@@ -673,6 +558,142 @@ _gimp_wire_write_color (GIOChannel    *channel,
                                   (gdouble *) data, 4 * count, user_data);
 }
 
+static gboolean
+gimp_wire_read_channel (GIOChannel *channel,
+                        guint8     *buf,
+                        gsize       count,
+                        gpointer    user_data)
+{
+  if (wire_read_func)
+    {
+      if (!(* wire_read_func) (channel, buf, count, user_data))
+        {
+          /* Gives a confusing error message most of the time, disable:
+          g_warning ("%s: gimp_wire_read: error", g_get_prgname ());
+           */
+          wire_error_val = TRUE;
+          return FALSE;
+        }
+    }
+  else
+    {
+      GIOStatus  status;
+      GError    *error = NULL;
+      gsize      bytes;
+
+      while (count > 0)
+        {
+          do
+            {
+              bytes = 0;
+              status = g_io_channel_read_chars (channel,
+                                                (gchar *) buf, count,
+                                                &bytes,
+                                                &error);
+            }
+          while (G_UNLIKELY (status == G_IO_STATUS_AGAIN));
+
+          if (G_UNLIKELY (status != G_IO_STATUS_NORMAL))
+            {
+              if (error)
+                {
+                  g_warning ("%s: gimp_wire_read(): error: %s",
+                             g_get_prgname (), error->message);
+                  g_error_free (error);
+                }
+              else
+                {
+                  g_warning ("%s: gimp_wire_read(): error",
+                             g_get_prgname ());
+                }
+
+              wire_error_val = TRUE;
+              return FALSE;
+            }
+
+          if (G_UNLIKELY (bytes == 0))
+            {
+              g_warning ("%s: gimp_wire_read(): unexpected EOF",
+                         g_get_prgname ());
+              wire_error_val = TRUE;
+              return FALSE;
+            }
+
+          count -= bytes;
+          buf += bytes;
+        }
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gimp_wire_write_channel (GIOChannel   *channel,
+                         const guint8 *buf,
+                         gsize         count)
+{
+  GIOStatus  status;
+  GError    *error = NULL;
+  gsize      bytes;
+
+  while (count > 0)
+    {
+      do
+        {
+          bytes = 0;
+          status = g_io_channel_write_chars (channel,
+                                             (const gchar *) buf, count,
+                                             &bytes,
+                                             &error);
+        }
+      while (G_UNLIKELY (status == G_IO_STATUS_AGAIN));
+
+      if (G_UNLIKELY (status != G_IO_STATUS_NORMAL))
+        {
+          if (error)
+            {
+              g_warning ("%s: gimp_wire_write(): error: %s",
+                         g_get_prgname (), error->message);
+              g_error_free (error);
+            }
+          else
+            {
+              g_warning ("%s: gimp_wire_write(): error",
+                         g_get_prgname ());
+            }
+
+          wire_error_val = TRUE;
+          return FALSE;
+        }
+
+      count -= bytes;
+      buf += bytes;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gimp_wire_write_frame (GIOChannel   *channel,
+                       const guint8 *buf,
+                       gsize         count,
+                       gpointer      user_data)
+{
+  /*  small frames go through the writer's buffer, so that several
+   *  messages can share one flush, large ones are written in one go
+   */
+  if (wire_write_func && count < GIMP_WIRE_DIRECT_SIZE)
+    return gimp_wire_write (channel, buf, count, user_data);
+
+  if (wire_flush_func && ! (* wire_flush_func) (channel, user_data))
+    {
+      wire_error_val = TRUE;
+      return FALSE;
+    }
+
+  return gimp_wire_write_channel (channel, buf, count);
+}
+
 static guint
 gimp_wire_hash (const guint32 *key)
 {
@@ -0,0 +1,238 @@
+/* A small benchmark for the plug-in wire protocol */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib-object.h>
+
+#ifndef G_OS_WIN32
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "gimpbasetypes.h"
+#include "gimpparamspecs.h"
+#include "gimpparasite.h"
+#include "gimpprotocol.h"
+#include "gimpwire.h"
+
+
+#define N_BYTES_TOTAL (64 * 1024 * 1024)
+
+
+#ifndef G_OS_WIN32
+
+static gboolean
+wire_flush (GIOChannel *channel,
+            gpointer    user_data)
+{
+  /*  the channels are unbuffered, there is nothing to flush  */
+  return TRUE;
+}
+
+static GIOChannel *
+wire_channel_new (gint fd)
+{
+  GIOChannel *channel = g_io_channel_unix_new (fd);
+
+  g_io_channel_set_encoding (channel, NULL, NULL);
+  g_io_channel_set_buffered (channel, FALSE);
+  g_io_channel_set_close_on_unref (channel, TRUE);
+
+  return channel;
+}
+
+/*  the writer runs in a child process, like a plug-in, so that it
+ *  doesn't share the wire's global state with the reader
+ */
+static void
+wire_writer (gint       fd,
+             GPProcRun *proc_run,
+             gint       n_runs)
+{
+  GIOChannel *channel = wire_channel_new (fd);
+  gint        i;
+
+  for (i = 0; i < n_runs; i++)
+    {
+      if (! gp_proc_run_write (channel, proc_run, NULL))
+        break;
+    }
+
+  g_io_channel_unref (channel);
+
+  _exit (i == n_runs ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+static gboolean
+wire_round_trip (gint n_floats)
+{
+  GPProcRun   proc_run;
+  GPParam     params[3];
+  GTimer     *timer;
+  gdouble    *floats;
+  gint        fds[2];
+  GIOChannel *channel;
+  pid_t       pid;
+  gint        status;
+  gint        n_runs;
+  gint        n_done  = 0;
+  gboolean    success = TRUE;
+  gdouble     elapsed;
+  gint        i;
+
+  floats = g_new (gdouble, n_floats);
+
+  for (i = 0; i < n_floats; i++)
+    floats[i] = i * 0.5;
+
+  params[0].param_type                = GP_PARAM_TYPE_INT;
+  params[0].type_name                 = "GimpRunMode";
+  params[0].data.d_int                = GIMP_RUN_NONINTERACTIVE;
+
+  params[1].param_type                = GP_PARAM_TYPE_FLOAT;
+  params[1].type_name                 = "gdouble";
+  params[1].data.d_float              = 42.0;
+
+  params[2].param_type                = GP_PARAM_TYPE_ARRAY;
+  params[2].type_name                 = "GimpFloatArray";
+  params[2].data.d_array.size         = n_floats * sizeof (gdouble);
+  params[2].data.d_array.data         = (guint8 *) floats;
+
+  proc_run.name     = "test-wire";
+  proc_run.n_params = G_N_ELEMENTS (params);
+  proc_run.params   = params;
+
+  n_runs = MAX (N_BYTES_TOTAL / (n_floats * sizeof (gdouble)), 16);
+  n_runs = MIN (n_runs, 100000);
+
+  if (pipe (fds) == -1)
+    {
+      g_printerr ("  pipe() failed\n");
+      g_free (floats);
+      return FALSE;
+    }
+
+  timer = g_timer_new ();
+
+  pid = fork ();
+
+  if (pid == -1)
+    {
+      g_printerr ("  fork() failed\n");
+      close (fds[0]);
+      close (fds[1]);
+      g_timer_destroy (timer);
+      g_free (floats);
+      return FALSE;
+    }
+
+  if (pid == 0)
+    {
+      close (fds[0]);
+      wire_writer (fds[1], &proc_run, n_runs);
+    }
+
+  close (fds[1]);
+
+  channel = wire_channel_new (fds[0]);
+
+  for (i = 0; i < n_runs; i++)
+    {
+      GimpWireMessage  msg;
+      GPProcRun       *run;
+
+      if (! gimp_wire_read_msg (channel, &msg, NULL))
+        {
+          g_printerr ("  reading message %d failed\n", i);
+          success = FALSE;
+          break;
+        }
+
+      run = msg.data;
+
+      success = (msg.type      == GP_PROC_RUN                       &&
+                 run->n_params == proc_run.n_params                 &&
+                 run->params[1].data.d_float == 42.0                &&
+                 run->params[2].data.d_array.size ==
+                 params[2].data.d_array.size                        &&
+                 ! memcmp (run->params[2].data.d_array.data, floats,
+                           params[2].data.d_array.size));
+
+      gimp_wire_destroy (&msg);
+
+      if (! success)
+        {
+          g_printerr ("  message %d arrived damaged\n", i);
+          break;
+        }
+
+      n_done++;
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+
+  /*  closing our end makes the writer fail and exit if we stopped
+   *  reading early
+   */
+  g_io_channel_unref (channel);
+
+  if (waitpid (pid, &status, 0) == -1 ||
+      ! WIFEXITED (status) || WEXITSTATUS (status) != EXIT_SUCCESS)
+    {
+      if (success)
+        g_printerr ("  the writer failed\n");
+
+      success = FALSE;
+    }
+
+  if (n_done > 0)
+    g_printerr ("  %8d floats: %6d messages in %.3f s, "
+                "%8.2f us per message, %7.1f MB/s\n",
+                n_floats, n_done, elapsed,
+                elapsed * 1000000.0 / n_done,
+                (gdouble) n_done * params[2].data.d_array.size /
+                elapsed / (1024.0 * 1024.0));
+
+  g_timer_destroy (timer);
+  g_free (floats);
+
+  gimp_wire_clear_error ();
+
+  return success;
+}
+
+#endif /* ! G_OS_WIN32 */
+
+int
+main (void)
+{
+#ifndef G_OS_WIN32
+  static const gint sizes[] = { 1, 16, 256, 4096, 65536, 1048576 };
+  gboolean          success = TRUE;
+  gint              i;
+
+  /*  a writer that outlives its reader gets EPIPE instead of dying  */
+  signal (SIGPIPE, SIG_IGN);
+
+  gp_init ();
+  gimp_wire_set_flusher (wire_flush);
+
+  g_printerr ("Testing GP_PROC_RUN round trips over a pipe...\n");
+
+  for (i = 0; i < G_N_ELEMENTS (sizes) && success; i++)
+    success = wire_round_trip (sizes[i]);
+
+  g_printerr ("\n");
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+#else
+  g_printerr ("Skipping the wire benchmark, it needs fork()\n");
+
+  return EXIT_SUCCESS;
+#endif
+}
@@ -58,6 +58,10 @@
  **/
 
 
+#define PIXELS_PER_THREAD (64 * 64)
+#define BAND_HEIGHT       256
+
+
 enum
 {
   PROGRESS,
@@ -73,12 +77,60 @@ struct _GimpColorTransformPrivate
   GimpColorProfile *dest_profile;
   const Babl       *dest_format;
 
+  GimpColorProfile *proof_profile;
+
   cmsHTRANSFORM     transform;
   const Babl       *fish;
+
+  /*  what is needed to create more copies of transform, since
+   *  cmsDoTransform() must not be called concurrently on one
+   */
+  cmsUInt32Number   lcms_src_format;
+  cmsUInt32Number   lcms_dest_format;
+  cmsUInt32Number   lcms_intent;
+  cmsUInt32Number   lcms_proof_intent;
+  cmsUInt32Number   lcms_flags;
+
+  GMutex            pool_mutex;
+  GCond             pool_cond;
+  GSList           *pool;
+  GSList           *copies;
+  gboolean          copy_failed;
 };
 
 
-static void   gimp_color_transform_finalize (GObject *object);
+typedef struct
+{
+  GimpColorTransform *transform;
+  const Babl         *src_format;
+  const guchar       *src_pixels;
+  const Babl         *dest_format;
+  guchar             *dest_pixels;
+} ProcessPixelsData;
+
+typedef struct
+{
+  GimpColorTransform *transform;
+  GeglBuffer         *src_buffer;
+  const Babl         *src_format;
+  GeglBuffer         *dest_buffer;
+  const Babl         *dest_format;
+  gint                offset_x;
+  gint                offset_y;
+} ProcessBufferData;
+
+
+static void          gimp_color_transform_finalize       (GObject                 *object);
+
+static cmsHTRANSFORM gimp_color_transform_acquire        (GimpColorTransform      *transform);
+static void          gimp_color_transform_release        (GimpColorTransform      *transform,
+                                                          cmsHTRANSFORM            lcms_transform);
+
+static void          gimp_color_transform_process_range  (gsize                    offset,
+                                                          gsize                    size,
+                                                          const ProcessPixelsData *data);
+static void          gimp_color_transform_process_area   (const GeglRectangle     *area,
+                                                          const ProcessBufferData *data);
 
 
 G_DEFINE_TYPE_WITH_PRIVATE (GimpColorTransform, gimp_color_transform,
@@ -135,6 +187,9 @@ static void
 gimp_color_transform_init (GimpColorTransform *transform)
 {
   transform->priv = gimp_color_transform_get_instance_private (transform);
+
+  g_mutex_init (&transform->priv->pool_mutex);
+  g_cond_init (&transform->priv->pool_cond);
 }
 
 static void
@@ -144,9 +199,19 @@ gimp_color_transform_finalize (GObject *object)
 
   g_clear_object (&transform->priv->src_profile);
   g_clear_object (&transform->priv->dest_profile);
+  g_clear_object (&transform->priv->proof_profile);
+
+  g_slist_free_full (transform->priv->copies,
+                     (GDestroyNotify) cmsDeleteTransform);
+  transform->priv->copies = NULL;
+
+  g_clear_pointer (&transform->priv->pool, g_slist_free);
 
   g_clear_pointer (&transform->priv->transform, cmsDeleteTransform);
 
+  g_mutex_clear (&transform->priv->pool_mutex);
+  g_cond_clear (&transform->priv->pool_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -261,13 +326,19 @@ gimp_color_transform_new (GimpColorProfile         *src_profile,
   src_lcms  = gimp_color_profile_get_lcms_profile (src_profile);
   dest_lcms = gimp_color_profile_get_lcms_profile (dest_profile);
 
+  priv->src_profile       = g_object_ref (src_profile);
+  priv->dest_profile      = g_object_ref (dest_profile);
+  priv->lcms_src_format   = lcms_src_format;
+  priv->lcms_dest_format  = lcms_dest_format;
+  priv->lcms_intent       = rendering_intent;
+  priv->lcms_flags        = flags | cmsFLAGS_COPY_ALPHA;
+
   lcms_error_clear ();
 
   priv->transform = cmsCreateTransform (src_lcms,  lcms_src_format,
                                         dest_lcms, lcms_dest_format,
-                                        rendering_intent,
-                                        flags |
-                                        cmsFLAGS_COPY_ALPHA);
+                                        priv->lcms_intent,
+                                        priv->lcms_flags);
 
   if (lcms_last_error)
     {
@@ -285,6 +356,10 @@ gimp_color_transform_new (GimpColorProfile         *src_profile,
       g_object_unref (transform);
       transform = NULL;
     }
+  else
+    {
+      priv->pool = g_slist_prepend (priv->pool, priv->transform);
+    }
 
   return transform;
 }
@@ -352,16 +427,25 @@ gimp_color_transform_new_proofing (GimpColorProfile         *src_profile,
   priv->dest_format = gimp_color_profile_get_lcms_format (dest_format,
                                                           &lcms_dest_format);
 
+  priv->src_profile       = g_object_ref (src_profile);
+  priv->dest_profile      = g_object_ref (dest_profile);
+  priv->proof_profile     = g_object_ref (proof_profile);
+  priv->lcms_src_format   = lcms_src_format;
+  priv->lcms_dest_format  = lcms_dest_format;
+  priv->lcms_intent       = display_intent;
+  priv->lcms_proof_intent = proof_intent;
+  priv->lcms_flags        = (flags                 |
+                             cmsFLAGS_SOFTPROOFING |
+                             cmsFLAGS_COPY_ALPHA);
+
   lcms_error_clear ();
 
   priv->transform = cmsCreateProofingTransform (src_lcms,  lcms_src_format,
                                                 dest_lcms, lcms_dest_format,
                                                 proof_lcms,
-                                                proof_intent,
-                                                display_intent,
-                                                flags                 |
-                                                cmsFLAGS_SOFTPROOFING |
-                                                cmsFLAGS_COPY_ALPHA);
+                                                priv->lcms_proof_intent,
+                                                priv->lcms_intent,
+                                                priv->lcms_flags);
 
   if (lcms_last_error)
     {
@@ -379,6 +463,10 @@ gimp_color_transform_new_proofing (GimpColorProfile         *src_profile,
       g_object_unref (transform);
       transform = NULL;
     }
+  else
+    {
+      priv->pool = g_slist_prepend (priv->pool, priv->transform);
+    }
 
   return transform;
 }
@@ -410,8 +498,7 @@ gimp_color_transform_process_pixels (GimpColorTransform *transform,
                                      gsize               length)
 {
   GimpColorTransformPrivate *priv;
-  gpointer                  *src;
-  gpointer                  *dest;
+  ProcessPixelsData          data;
 
   g_return_if_fail (GIMP_IS_COLOR_TRANSFORM (transform));
   g_return_if_fail (src_format != NULL);
@@ -426,57 +513,20 @@ gimp_color_transform_process_pixels (GimpColorTransform *transform,
    * src_format's and dest_format's encoding, and the transform's
    * input and output color spaces.
    */
-  src_format =
+  data.transform   = transform;
+  data.src_format  =
     babl_format_with_space ((const gchar *) src_format,
                             babl_format_get_space (priv->src_format));
-  dest_format =
+  data.src_pixels  = src_pixels;
+  data.dest_format =
     babl_format_with_space ((const gchar *) dest_format,
                             babl_format_get_space (priv->dest_format));
+  data.dest_pixels = dest_pixels;
 
-  if (src_format != priv->src_format)
-    {
-      src = g_malloc (length * babl_format_get_bytes_per_pixel (priv->src_format));
-
-      babl_process (babl_fish (src_format,
-                               priv->src_format),
-                    src_pixels, src, length);
-    }
-  else
-    {
-      src = (gpointer) src_pixels;
-    }
-
-  if (dest_format != priv->dest_format)
-    {
-      dest = g_malloc (length * babl_format_get_bytes_per_pixel (priv->dest_format));
-    }
-  else
-    {
-      dest = dest_pixels;
-    }
-
-  if (priv->transform)
-    {
-      cmsDoTransform (priv->transform, src, dest, length);
-    }
-  else
-    {
-      babl_process (priv->fish, src, dest, length);
-    }
-
-  if (src_format != priv->src_format)
-    {
-      g_free (src);
-    }
-
-  if (dest_format != priv->dest_format)
-    {
-      babl_process (babl_fish (priv->dest_format,
-                               dest_format),
-                    dest, dest_pixels, length);
-
-      g_free (dest);
-    }
+  gegl_parallel_distribute_range (
+    length, PIXELS_PER_THREAD,
+    (GeglParallelDistributeRangeFunc) gimp_color_transform_process_range,
+    &data);
 }
 
 /**
@@ -494,6 +544,10 @@ gimp_color_transform_process_pixels (GimpColorTransform *transform,
  * spaces are ignored. The transform always takes place between the
  * color spaces determined by @transform's color profiles.
  *
+ * The buffer is processed using all of GEGL's threads, the
+ * #GimpColorTransform::progress signal is always emitted from the
+ * calling thread.
+ *
  * Since: 2.10
  **/
 void
@@ -504,11 +558,10 @@ gimp_color_transform_process_buffer (GimpColorTransform  *transform,
                                      const GeglRectangle *dest_rect)
 {
   GimpColorTransformPrivate *priv;
-  const Babl                *src_format;
-  const Babl                *dest_format;
-  GeglBufferIterator        *iter;
+  ProcessBufferData          data;
+  GeglRectangle              rect;
   gint                       total_pixels;
-  gint                       done_pixels = 0;
+  gint                       y;
 
   g_return_if_fail (GIMP_IS_COLOR_TRANSFORM (transform));
   g_return_if_fail (GEGL_IS_BUFFER (src_buffer));
@@ -517,88 +570,65 @@ gimp_color_transform_process_buffer (GimpColorTransform  *transform,
   priv = transform->priv;
 
   if (src_rect)
-    {
-      total_pixels = src_rect->width * src_rect->height;
-    }
+    rect = *src_rect;
   else
-    {
-      total_pixels = (gegl_buffer_get_width  (src_buffer) *
-                      gegl_buffer_get_height (src_buffer));
-    }
+    rect = *gegl_buffer_get_extent (src_buffer);
+
+  if (! dest_rect)
+    dest_rect = gegl_buffer_get_extent (dest_buffer);
+
+  total_pixels = rect.width * rect.height;
 
   /* we must not do any babl color transforms when reading from
    * src_buffer or writing to dest_buffer, so construct formats with
    * the transform's expected input and output encoding and
    * src_buffer's and dest_buffers's color spaces.
    */
-  src_format  = gegl_buffer_get_format (src_buffer);
-  dest_format = gegl_buffer_get_format (dest_buffer);
-
-  src_format =
+  data.transform   = transform;
+  data.src_buffer  = src_buffer;
+  data.src_format  =
     babl_format_with_space ((const gchar *) priv->src_format,
-                            babl_format_get_space (src_format));
-  dest_format =
+                            babl_format_get_space (gegl_buffer_get_format (src_buffer)));
+  data.dest_buffer = dest_buffer;
+  data.dest_format =
     babl_format_with_space ((const gchar *) priv->dest_format,
-                            babl_format_get_space (dest_format));
+                            babl_format_get_space (gegl_buffer_get_format (dest_buffer)));
 
+  /* when converting in place, dest_rect is ignored, like it always
+   * was
+   */
   if (src_buffer != dest_buffer)
     {
-      iter = gegl_buffer_iterator_new (src_buffer, src_rect, 0,
-                                       src_format,
-                                       GEGL_ACCESS_READ,
-                                       GEGL_ABYSS_NONE, 2);
-
-      gegl_buffer_iterator_add (iter, dest_buffer, dest_rect, 0,
-                                dest_format,
-                                GEGL_ACCESS_WRITE,
-                                GEGL_ABYSS_NONE);
-
-      while (gegl_buffer_iterator_next (iter))
-        {
-          if (priv->transform)
-            {
-              cmsDoTransform (priv->transform,
-                              iter->items[0].data, iter->items[1].data, iter->length);
-            }
-          else
-            {
-              babl_process (priv->fish,
-                            iter->items[0].data, iter->items[1].data, iter->length);
-            }
-
-          done_pixels += iter->items[0].roi.width * iter->items[0].roi.height;
-
-          g_signal_emit (transform, gimp_color_transform_signals[PROGRESS], 0,
-                         (gdouble) done_pixels /
-                         (gdouble) total_pixels);
-        }
+      data.offset_x = dest_rect->x - rect.x;
+      data.offset_y = dest_rect->y - rect.y;
     }
   else
     {
-      iter = gegl_buffer_iterator_new (src_buffer, src_rect, 0,
-                                       src_format,
-                                       GEGL_ACCESS_READWRITE,
-                                       GEGL_ABYSS_NONE, 1);
+      data.offset_x = 0;
+      data.offset_y = 0;
+    }
 
-      while (gegl_buffer_iterator_next (iter))
-        {
-          if (priv->transform)
-            {
-              cmsDoTransform (priv->transform,
-                              iter->items[0].data, iter->items[0].data, iter->length);
-            }
-          else
-            {
-              babl_process (priv->fish,
-                            iter->items[0].data, iter->items[0].data, iter->length);
-            }
-
-          done_pixels += iter->items[0].roi.width * iter->items[0].roi.height;
-
-          g_signal_emit (transform, gimp_color_transform_signals[PROGRESS], 0,
-                         (gdouble) done_pixels /
-                         (gdouble) total_pixels);
-        }
+  /* process the rectangle in bands of rows, each band split among
+   * all threads, so "progress" is still emitted from the calling
+   * thread while the bands are worked on
+   */
+  for (y = 0; y < rect.height; y += BAND_HEIGHT)
+    {
+      GeglRectangle band;
+
+      band.x      = rect.x;
+      band.y      = rect.y + y;
+      band.width  = rect.width;
+      band.height = MIN (BAND_HEIGHT, rect.height - y);
+
+      gegl_parallel_distribute_area (
+        &band, PIXELS_PER_THREAD, GEGL_SPLIT_STRATEGY_AUTO,
+        (GeglParallelDistributeAreaFunc) gimp_color_transform_process_area,
+        &data);
+
+      g_signal_emit (transform, gimp_color_transform_signals[PROGRESS], 0,
+                     (gdouble) (y + band.height) * rect.width /
+                     (gdouble) total_pixels);
     }
 
   g_signal_emit (transform, gimp_color_transform_signals[PROGRESS], 0,
@@ -640,3 +670,214 @@ gimp_color_transform_can_gegl_copy (GimpColorProfile *src_profile,
 
   return FALSE;
 }
+
+
+/*  private functions  */
+
+static cmsHTRANSFORM
+gimp_color_transform_acquire (GimpColorTransform *transform)
+{
+  GimpColorTransformPrivate *priv = transform->priv;
+  cmsHTRANSFORM              lcms_transform;
+
+  g_mutex_lock (&priv->pool_mutex);
+
+  if (! priv->pool && ! priv->copy_failed)
+    {
+      cmsHPROFILE src_lcms;
+      cmsHPROFILE dest_lcms;
+
+      src_lcms  = gimp_color_profile_get_lcms_profile (priv->src_profile);
+      dest_lcms = gimp_color_profile_get_lcms_profile (priv->dest_profile);
+
+      if (priv->proof_profile)
+        {
+          cmsHPROFILE proof_lcms;
+
+          proof_lcms = gimp_color_profile_get_lcms_profile (priv->proof_profile);
+
+          lcms_transform =
+            cmsCreateProofingTransform (src_lcms,  priv->lcms_src_format,
+                                        dest_lcms, priv->lcms_dest_format,
+                                        proof_lcms,
+                                        priv->lcms_proof_intent,
+                                        priv->lcms_intent,
+                                        priv->lcms_flags);
+        }
+      else
+        {
+          lcms_transform =
+            cmsCreateTransform (src_lcms,  priv->lcms_src_format,
+                                dest_lcms, priv->lcms_dest_format,
+                                priv->lcms_intent,
+                                priv->lcms_flags);
+        }
+
+      if (lcms_transform)
+        {
+          priv->copies = g_slist_prepend (priv->copies, lcms_transform);
+
+          g_mutex_unlock (&priv->pool_mutex);
+
+          return lcms_transform;
+        }
+
+      priv->copy_failed = TRUE;
+    }
+
+  /*  if no more copies can be made, wait for another thread to
+   *  release one of the existing transforms
+   */
+  while (! priv->pool)
+    g_cond_wait (&priv->pool_cond, &priv->pool_mutex);
+
+  lcms_transform = priv->pool->data;
+  priv->pool     = g_slist_delete_link (priv->pool, priv->pool);
+
+  g_mutex_unlock (&priv->pool_mutex);
+
+  return lcms_transform;
+}
+
+static void
+gimp_color_transform_release (GimpColorTransform *transform,
+                              cmsHTRANSFORM       lcms_transform)
+{
+  GimpColorTransformPrivate *priv = transform->priv;
+
+  g_mutex_lock (&priv->pool_mutex);
+
+  priv->pool = g_slist_prepend (priv->pool, lcms_transform);
+
+  g_cond_signal (&priv->pool_cond);
+
+  g_mutex_unlock (&priv->pool_mutex);
+}
+
+static void
+gimp_color_transform_process_range (gsize                    offset,
+                                    gsize                    size,
+                                    const ProcessPixelsData *data)
+{
+  GimpColorTransformPrivate *priv = data->transform->priv;
+  const guchar              *src_pixels;
+  guchar                    *dest_pixels;
+  gpointer                   src;
+  gpointer                   dest;
+
+  src_pixels  = data->src_pixels +
+                offset * babl_format_get_bytes_per_pixel (data->src_format);
+  dest_pixels = data->dest_pixels +
+                offset * babl_format_get_bytes_per_pixel (data->dest_format);
+
+  if (data->src_format != priv->src_format)
+    {
+      src = g_malloc (size * babl_format_get_bytes_per_pixel (priv->src_format));
+
+      babl_process (babl_fish (data->src_format,
+                               priv->src_format),
+                    src_pixels, src, size);
+    }
+  else
+    {
+      src = (gpointer) src_pixels;
+    }
+
+  if (data->dest_format != priv->dest_format)
+    {
+      dest = g_malloc (size * babl_format_get_bytes_per_pixel (priv->dest_format));
+    }
+  else
+    {
+      dest = dest_pixels;
+    }
+
+  if (priv->transform)
+    {
+      cmsHTRANSFORM lcms_transform;
+
+      lcms_transform = gimp_color_transform_acquire (data->transform);
+
+      cmsDoTransform (lcms_transform, src, dest, size);
+
+      gimp_color_transform_release (data->transform, lcms_transform);
+    }
+  else
+    {
+      babl_process (priv->fish, src, dest, size);
+    }
+
+  if (data->src_format != priv->src_format)
+    {
+      g_free (src);
+    }
+
+  if (data->dest_format != priv->dest_format)
+    {
+      babl_process (babl_fish (priv->dest_format,
+                               data->dest_format),
+                    dest, dest_pixels, size);
+
+      g_free (dest);
+    }
+}
+
+static void
+gimp_color_transform_process_area (const GeglRectangle     *area,
+                                   const ProcessBufferData *data)
+{
+  GimpColorTransformPrivate *priv           = data->transform->priv;
+  cmsHTRANSFORM              lcms_transform = NULL;
+  GeglBufferIterator        *iter;
+  gint                       dest_index;
+
+  if (priv->transform)
+    lcms_transform = gimp_color_transform_acquire (data->transform);
+
+  if (data->src_buffer != data->dest_buffer)
+    {
+      iter = gegl_buffer_iterator_new (data->src_buffer, area, 0,
+                                       data->src_format,
+                                       GEGL_ACCESS_READ,
+                                       GEGL_ABYSS_NONE, 2);
+
+      gegl_buffer_iterator_add (iter, data->dest_buffer,
+                                GEGL_RECTANGLE (area->x + data->offset_x,
+                                                area->y + data->offset_y,
+                                                area->width,
+                                                area->height), 0,
+                                data->dest_format,
+                                GEGL_ACCESS_WRITE,
+                                GEGL_ABYSS_NONE);
+
+      dest_index = 1;
+    }
+  else
+    {
+      iter = gegl_buffer_iterator_new (data->src_buffer, area, 0,
+                                       data->src_format,
+                                       GEGL_ACCESS_READWRITE,
+                                       GEGL_ABYSS_NONE, 1);
+
+      dest_index = 0;
+    }
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      if (lcms_transform)
+        {
+          cmsDoTransform (lcms_transform,
+                          iter->items[0].data, iter->items[dest_index].data,
+                          iter->length);
+        }
+      else
+        {
+          babl_process (priv->fish,
+                        iter->items[0].data, iter->items[dest_index].data,
+                        iter->length);
+        }
+    }
+
+  if (lcms_transform)
+    gimp_color_transform_release (data->transform, lcms_transform);
+}
@@ -0,0 +1,169 @@
+/* throughput benchmark for gimp_color_transform_process_buffer(),
+ * comparing a single thread against all of GEGL's threads
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <babl/babl.h>
+#include <gegl.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include <glib-object.h>
+#include <cairo.h>
+
+#include "gimpcolor.h"
+
+
+#define WIDTH   4096
+#define HEIGHT  4096
+#define RUNS    3
+
+
+static GeglBuffer *
+create_src_buffer (const Babl *format)
+{
+  GeglBuffer *buffer;
+  guchar     *row;
+  gint        x, y;
+
+  buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT), format);
+
+  row = g_new (guchar, WIDTH * 4);
+
+  for (y = 0; y < HEIGHT; y++)
+    {
+      for (x = 0; x < WIDTH; x++)
+        {
+          row[4 * x + 0] = x;
+          row[4 * x + 1] = y;
+          row[4 * x + 2] = x ^ y;
+          row[4 * x + 3] = 255;
+        }
+
+      gegl_buffer_set (buffer, GEGL_RECTANGLE (0, y, WIDTH, 1), 0,
+                       format, row, GEGL_AUTO_ROWSTRIDE);
+    }
+
+  g_free (row);
+
+  return buffer;
+}
+
+static gdouble
+run_benchmark (GimpColorTransform *transform,
+               GeglBuffer         *src_buffer,
+               GeglBuffer         *dest_buffer,
+               gint                n_threads)
+{
+  gdouble best = 0.0;
+  gint    i;
+
+  g_object_set (gegl_config (),
+                "threads", n_threads,
+                NULL);
+
+  for (i = 0; i < RUNS; i++)
+    {
+      gint64  start;
+      gdouble seconds;
+
+      start = g_get_monotonic_time ();
+
+      gimp_color_transform_process_buffer (transform,
+                                           src_buffer,  NULL,
+                                           dest_buffer, NULL);
+
+      seconds = (g_get_monotonic_time () - start) / (gdouble) G_USEC_PER_SEC;
+
+      best = MAX (best, (WIDTH * HEIGHT) / seconds / 1000000.0);
+    }
+
+  g_print ("  %2d thread(s): %8.2f Mpixels/s\n", n_threads, best);
+
+  return best;
+}
+
+int
+main (void)
+{
+  GimpColorProfile   *src_profile;
+  GimpColorProfile   *dest_profile;
+  GimpColorTransform *transform;
+  const Babl         *format;
+  GeglBuffer         *src_buffer;
+  GeglBuffer         *serial_buffer;
+  GeglBuffer         *parallel_buffer;
+  guchar             *serial_data;
+  guchar             *parallel_data;
+  gint                n_threads;
+  gboolean            equal;
+
+  /* force lcms, babl would handle these matrix profiles itself */
+  g_setenv ("GIMP_COLOR_TRANSFORM_DISABLE_BABL", "1", TRUE);
+
+  gegl_init (NULL, NULL);
+
+  n_threads = g_get_num_processors ();
+
+  src_profile  = gimp_color_profile_new_rgb_srgb ();
+  dest_profile = gimp_color_profile_new_rgb_adobe ();
+  format       = babl_format ("R'G'B'A u8");
+
+  transform = gimp_color_transform_new (src_profile,  format,
+                                        dest_profile, format,
+                                        GIMP_COLOR_RENDERING_INTENT_PERCEPTUAL,
+                                        GIMP_COLOR_TRANSFORM_FLAGS_NOOPTIMIZE);
+
+  if (! transform)
+    {
+      g_print ("Could not create the color transform!\n");
+      return EXIT_FAILURE;
+    }
+
+  src_buffer      = create_src_buffer (format);
+  serial_buffer   = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                                     format);
+  parallel_buffer = gegl_buffer_new (GEGL_RECTANGLE (0, 0, WIDTH, HEIGHT),
+                                     format);
+
+  g_print ("\nConverting %dx%d pixels from sRGB to Adobe RGB ...\n",
+           WIDTH, HEIGHT);
+
+  run_benchmark (transform, src_buffer, serial_buffer,   1);
+  run_benchmark (transform, src_buffer, parallel_buffer, n_threads);
+
+  serial_data   = g_new (guchar, WIDTH * HEIGHT * 4);
+  parallel_data = g_new (guchar, WIDTH * HEIGHT * 4);
+
+  gegl_buffer_get (serial_buffer, NULL, 1.0, format,
+                   serial_data, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  gegl_buffer_get (parallel_buffer, NULL, 1.0, format,
+                   parallel_data, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  equal = ! memcmp (serial_data, parallel_data, WIDTH * HEIGHT * 4);
+
+  g_free (serial_data);
+  g_free (parallel_data);
+
+  g_object_unref (src_buffer);
+  g_object_unref (serial_buffer);
+  g_object_unref (parallel_buffer);
+  g_object_unref (transform);
+  g_object_unref (src_profile);
+  g_object_unref (dest_profile);
+
+  gegl_exit ();
+
+  if (! equal)
+    {
+      g_print ("Serial and parallel results differ!\n\n");
+      return EXIT_FAILURE;
+    }
+
+  g_print ("Serial and parallel results are identical.\n\n");
+
+  return EXIT_SUCCESS;
+}
@@ -50,6 +50,18 @@
  **/
 
 
+/*  The serializable properties of a type, looked up once per type
+ *  instead of once per deserialized object.
+ */
+typedef struct
+{
+  GObjectClass  *klass;
+  guint          n_properties;
+  guint          n_property_specs;
+  GParamSpec   **property_specs;
+} GimpConfigPropertyTable;
+
+
 /*
  *  All functions return G_TOKEN_RIGHT_PAREN on success,
  *  the GTokenType they would have expected but didn't get
@@ -102,6 +114,11 @@ static GTokenType  gimp_config_deserialize_any            (GValue     *value,
                                                            GScanner   *scanner);
 static GTokenType  gimp_config_skip_unknown_property      (GScanner   *scanner);
 
+static const GimpConfigPropertyTable *
+                     gimp_config_get_property_table    (GObjectClass *klass);
+static GimpConfigInterface *
+                     gimp_config_get_deserialize_iface (GParamSpec   *prop_spec);
+
 static inline gboolean  scanner_string_utf8_valid (GScanner    *scanner,
                                                    const gchar *token_name);
 
@@ -136,38 +153,39 @@ gimp_config_deserialize_properties (GimpConfig *config,
                                     GScanner   *scanner,
                                     gint        nest_level)
 {
-  GObjectClass  *klass;
-  GParamSpec   **property_specs;
-  guint          n_property_specs;
-  guint          i;
-  guint          scope_id;
-  guint          old_scope_id;
-  GTokenType     token;
+  const GimpConfigPropertyTable *table;
+  guint                          i;
+  guint                          scope_id;
+  guint                          old_scope_id;
+  GTokenType                     token;
 
   g_return_val_if_fail (GIMP_IS_CONFIG (config), FALSE);
 
-  klass = G_OBJECT_GET_CLASS (config);
-  property_specs = g_object_class_list_properties (klass, &n_property_specs);
+  table = gimp_config_get_property_table (G_OBJECT_GET_CLASS (config));
 
-  if (! property_specs)
+  if (table->n_properties == 0)
     return TRUE;
 
   scope_id = g_type_qname (G_TYPE_FROM_INSTANCE (config));
   old_scope_id = g_scanner_set_scope (scanner, scope_id);
 
-  for (i = 0; i < n_property_specs; i++)
+  /*  objects of the same type usually come in bunches, only register
+   *  the property symbols with the first one
+   */
+  if (table->n_property_specs > 0 &&
+      g_scanner_scope_lookup_symbol (scanner, scope_id,
+                                     table->property_specs[0]->name) !=
+      table->property_specs[0])
     {
-      GParamSpec *prop_spec = property_specs[i];
-
-      if (prop_spec->flags & GIMP_CONFIG_PARAM_SERIALIZE)
+      for (i = 0; i < table->n_property_specs; i++)
         {
+          GParamSpec *prop_spec = table->property_specs[i];
+
           g_scanner_scope_add_symbol (scanner, scope_id,
                                       prop_spec->name, prop_spec);
         }
     }
 
-  g_free (property_specs);
-
   g_object_freeze_notify (G_OBJECT (config));
 
   token = G_TOKEN_LEFT_PAREN;
@@ -243,8 +261,7 @@ gimp_config_deserialize_property (GimpConfig *config,
                                   GScanner   *scanner,
                                   gint        nest_level)
 {
-  GimpConfigInterface *config_iface = NULL;
-  GimpConfigInterface *parent_iface = NULL;
+  GimpConfigInterface *config_iface;
   GParamSpec          *prop_spec;
   GTokenType           token        = G_TOKEN_RIGHT_PAREN;
   GValue               value        = G_VALUE_INIT;
@@ -256,37 +273,9 @@ gimp_config_deserialize_property (GimpConfig *config,
 
   g_value_init (&value, prop_spec->value_type);
 
-  if (G_TYPE_IS_OBJECT (prop_spec->owner_type))
-    {
-      GTypeClass *owner_class = g_type_class_peek (prop_spec->owner_type);
-
-      config_iface = g_type_interface_peek (owner_class, GIMP_TYPE_CONFIG);
+  config_iface = gimp_config_get_deserialize_iface (prop_spec);
 
-      /*  We must call deserialize_property() *only* if the *exact* class
-       *  which implements it is param_spec->owner_type's class.
-       *
-       *  Therefore, we ask param_spec->owner_type's immediate parent class
-       *  for it's GimpConfigInterface and check if we get a different
-       *  pointer.
-       *
-       *  (if the pointers are the same, param_spec->owner_type's
-       *   GimpConfigInterface is inherited from one of it's parent classes
-       *   and thus not able to handle param_spec->owner_type's properties).
-       */
-      if (config_iface)
-        {
-          GTypeClass *owner_parent_class;
-
-          owner_parent_class = g_type_class_peek_parent (owner_class);
-
-          parent_iface = g_type_interface_peek (owner_parent_class,
-                                                GIMP_TYPE_CONFIG);
-        }
-    }
-
-  if (config_iface                       &&
-      config_iface != parent_iface       && /* see comment above */
-      config_iface->deserialize_property &&
+  if (config_iface &&
       config_iface->deserialize_property (config,
                                           prop_spec->param_id,
                                           &value,
@@ -1037,6 +1026,122 @@ gimp_config_deserialize_any (GValue     *value,
   return G_TOKEN_RIGHT_PAREN;
 }
 
+static const GimpConfigPropertyTable *
+gimp_config_get_property_table (GObjectClass *klass)
+{
+  static GQuark            quark = 0;
+  static GMutex            mutex;
+  GType                    type  = G_TYPE_FROM_CLASS (klass);
+  GimpConfigPropertyTable *table;
+
+  if (! quark)
+    quark = g_quark_from_static_string ("gimp-config-property-table");
+
+  table = g_type_get_qdata (type, quark);
+
+  /*  a dynamic type's class may have been finalized and created again,
+   *  with a new set of param specs
+   */
+  if (table && table->klass == klass)
+    return table;
+
+  g_mutex_lock (&mutex);
+
+  table = g_type_get_qdata (type, quark);
+
+  if (! table || table->klass != klass)
+    {
+      GParamSpec **property_specs;
+      guint        n_property_specs;
+      guint        i;
+
+      property_specs = g_object_class_list_properties (klass,
+                                                       &n_property_specs);
+
+      /*  an outdated table is leaked, other threads might still use it  */
+      table = g_new0 (GimpConfigPropertyTable, 1);
+
+      table->klass          = klass;
+      table->n_properties   = n_property_specs;
+      table->property_specs = g_new (GParamSpec *, n_property_specs);
+
+      for (i = 0; i < n_property_specs; i++)
+        {
+          GParamSpec *prop_spec = property_specs[i];
+
+          if (prop_spec->flags & GIMP_CONFIG_PARAM_SERIALIZE)
+            table->property_specs[table->n_property_specs++] = prop_spec;
+        }
+
+      g_free (property_specs);
+
+      g_type_set_qdata (type, quark, table);
+    }
+
+  g_mutex_unlock (&mutex);
+
+  return table;
+}
+
+static GimpConfigInterface *
+gimp_config_get_deserialize_iface (GParamSpec *prop_spec)
+{
+  static GQuark        quark = 0;
+  GimpConfigInterface *config_iface;
+  gpointer             data;
+
+  if (! quark)
+    quark = g_quark_from_static_string ("gimp-config-deserialize-iface");
+
+  /*  the param spec itself is cached, with no iface to use  */
+  data = g_param_spec_get_qdata (prop_spec, quark);
+
+  if (data)
+    return data == prop_spec ? NULL : data;
+
+  config_iface = NULL;
+
+  if (G_TYPE_IS_OBJECT (prop_spec->owner_type))
+    {
+      GTypeClass *owner_class = g_type_class_peek (prop_spec->owner_type);
+
+      config_iface = g_type_interface_peek (owner_class, GIMP_TYPE_CONFIG);
+
+      /*  We must call deserialize_property() *only* if the *exact* class
+       *  which implements it is param_spec->owner_type's class.
+       *
+       *  Therefore, we ask param_spec->owner_type's immediate parent class
+       *  for it's GimpConfigInterface and check if we get a different
+       *  pointer.
+       *
+       *  (if the pointers are the same, param_spec->owner_type's
+       *   GimpConfigInterface is inherited from one of it's parent classes
+       *   and thus not able to handle param_spec->owner_type's properties).
+       */
+      if (config_iface)
+        {
+          GTypeClass          *owner_parent_class;
+          GimpConfigInterface *parent_iface;
+
+          owner_parent_class = g_type_class_peek_parent (owner_class);
+
+          parent_iface = g_type_interface_peek (owner_parent_class,
+                                                GIMP_TYPE_CONFIG);
+
+          if (config_iface == parent_iface || /* see comment above */
+              ! config_iface->deserialize_property)
+            {
+              config_iface = NULL;
+            }
+        }
+    }
+
+  g_param_spec_set_qdata (prop_spec, quark,
+                          config_iface ? (gpointer) config_iface : prop_spec);
+
+  return config_iface;
+}
+
 static GTokenType
 gimp_config_skip_unknown_property (GScanner *scanner)
 {